@@ -0,0 +1,274 @@
+// Checks the single-pass TCrdc reconstruction against the old per-sample getters, and times both.
+//
+//   crdcCheck [nevents]
+//
+// Random CRDC pulses, a few samples on each pad around a random centre, with
+// some lone samples that fail IsGoodSample, are given pads with random
+// pedestals and linear or quadratic calibrations (and some pads without a
+// TChannel).  The max pad, its charge, X and Y from the TCrdc getters are
+// compared with the loops GetMaxPad and GetDispersiveX used to run, sample
+// by sample through TChannel::CalEnergy.  gRandom is reseeded before each,
+// so that both see the same dither.  Half way through, every TChannel is
+// recalibrated through its setters, and an already reconstructed TCrdc must
+// follow.  Exits non-zero if anything differs by more than the tolerance.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TRandom.h"
+#include "TString.h"
+
+#include "GValue.h"
+#include "TChannel.h"
+#include "TS800Hit.h"
+
+namespace {
+  const double tolerance = 1e-4; // relative, on X
+  const unsigned int crdc_address = 0x00580000;
+  const int num_pads = 224;
+  const unsigned int seed = 4357;
+
+  struct Result {
+    int maxpad;
+    int maxpad_sum;
+    float x;
+    float y;
+  };
+
+  void Calibrate(std::mt19937& gen) {
+    std::uniform_int_distribution<int> pedestal(0, 40);
+    std::uniform_real_distribution<double> gain(0.8, 1.2);
+    std::uniform_real_distribution<double> offset(-5, 5);
+    std::uniform_real_distribution<double> quad(-1e-5, 1e-5);
+    std::uniform_int_distribution<int> kind(0, 9);
+    for(int pad=0; pad<num_pads; pad++) {
+      if(pad%10 == 3) {
+        // No TChannel, the raw value is used.
+        continue;
+      }
+      TChannel* chan = TChannel::GetChannel(crdc_address + pad);
+      if(!chan) {
+        chan = new TChannel(Form("CRDC_PAD%03d", pad), crdc_address + pad);
+        TChannel::AddChannel(chan);
+      }
+      chan->SetPedestal(pedestal(gen));
+      if(kind(gen) == 0) {
+        chan->SetEnergyCoeff({offset(gen), gain(gen), quad(gen)});
+      } else {
+        chan->SetEnergyCoeff({offset(gen), gain(gen)});
+      }
+    }
+  }
+
+  void Fill(std::mt19937& gen, short id, TCrdc& crdc) {
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::normal_distribution<double> noise(0, 8);
+    crdc.Clear();
+    crdc.SetAddress(crdc_address);
+    crdc.SetId(id);
+    crdc.SetTime(400*uniform(gen));
+
+    double centre = 10 + (num_pads - 20)*uniform(gen);
+    double width  = 1 + 2*uniform(gen);
+    double height = 200 + 600*uniform(gen);
+    int sample = 0;
+    for(int pad = int(centre) - 10; pad <= int(centre) + 10; pad++) {
+      if(pad < 0 || pad >= num_pads) {
+        continue;
+      }
+      double charge = height*std::exp(-0.5*std::pow((pad + 0.5 - centre)/width, 2));
+      int nsamples = uniform(gen) < 0.1 ? 1 : 2 + int(3*uniform(gen));
+      for(int s=0; s<nsamples; s++) {
+        int value = std::max(0.0, charge + noise(gen));
+        crdc.AddPoint(pad, sample++, value);
+      }
+    }
+  }
+
+  // The old IsGoodSample, GetMaxPad, GetMaxPadSum, GetDispersiveX and GetNonDispersiveY,
+  //   with each sample calibrated once so that the dither is the same as Reconstruct's.
+  bool OldIsGoodSample(TCrdc& crdc, int i) {
+    int n = crdc.Size();
+    if (i == 0 && n>1) {
+      return crdc.GetChannel(i) == crdc.GetChannel(i+1);
+    } else if(i == n-1 && n>2) {
+      return crdc.GetChannel(i) == crdc.GetChannel(i-1);
+    } else if(n>2) {
+      return (crdc.GetChannel(i) == crdc.GetChannel(i-1) ||
+              (crdc.GetChannel(i) == crdc.GetChannel(i+1)));
+    }
+    return false;
+  }
+
+  Result OldPath(TCrdc& crdc) {
+    Result result = {-1, -1, float(std::sqrt(-1)), float(std::sqrt(-1))};
+    if(!crdc.Size()) {
+      return result;
+    }
+
+    std::vector<double> cal(crdc.Size());
+    int maxp = 0;
+    float maxd = 0;
+    for(int i = 0; i < crdc.Size(); i++){
+      if(!OldIsGoodSample(crdc, i)) {
+        continue;
+      }
+      TChannel *c = TChannel::GetChannel(crdc.Address(i));
+      if(c){
+        cal[i] = c->CalEnergy(crdc.GetData(i));
+      } else{
+        cal[i] = (double)crdc.GetData(i);
+      }
+      if(cal[i] > maxd) {
+        maxp = crdc.GetChannel(i);
+        maxd = cal[i];
+      }
+    }
+    result.maxpad = maxp;
+    result.maxpad_sum = maxd;
+
+    const char* slope_name  = crdc.GetId()==0 ? "CRDC1_X_SLOPE"  : "CRDC2_X_SLOPE";
+    const char* offset_name = crdc.GetId()==0 ? "CRDC1_X_OFFSET" : "CRDC2_X_OFFSET";
+    float x_slope  = GValue::Value(slope_name);
+    float x_offset = GValue::Value(offset_name);
+    if(std::isnan(x_slope))
+      x_slope = 1.0;
+    if(std::isnan(x_offset))
+      x_offset = 0.0;
+
+    const int GRAVITY_WIDTH = 14;
+    int lowpad = maxp - GRAVITY_WIDTH/2;
+    int highpad = lowpad + GRAVITY_WIDTH;
+    if (lowpad < 0){
+      lowpad = 0;
+    }
+    if (highpad >= num_pads){
+      highpad = num_pads-1;
+    }
+    double datasum = 0;
+    double weighted_sum = 0;
+    for(int i=0;i<crdc.Size();i++) {
+      if((crdc.GetChannel(i) < lowpad) || (crdc.GetChannel(i)>highpad) || !OldIsGoodSample(crdc, i)) {
+        continue;
+      }
+      datasum += cal[i];
+      weighted_sum += crdc.GetChannel(i)*cal[i];
+    }
+    double mean_chan = weighted_sum/datasum + 0.5;
+    result.x = mean_chan*x_slope + x_offset;
+
+    float y_slope  = GValue::Value(crdc.GetId()==0 ? "CRDC1_Y_SLOPE"  : "CRDC2_Y_SLOPE");
+    float y_offset = GValue::Value(crdc.GetId()==0 ? "CRDC1_Y_OFFSET" : "CRDC2_Y_OFFSET");
+    if(std::isnan(y_slope)) y_slope = 1.0;
+    if(std::isnan(y_offset)) y_offset = 0.0;
+    result.y = ((float)crdc.GetTime())*y_slope + y_offset;
+    return result;
+  }
+
+  Result NewPath(TCrdc& crdc) {
+    Result result;
+    result.maxpad     = crdc.GetMaxPad();
+    result.maxpad_sum = crdc.GetMaxPadSum();
+    result.x          = crdc.GetDispersiveX();
+    result.y          = crdc.GetNonDispersiveY();
+    return result;
+  }
+
+  // Number of values that differ between the two.
+  int Compare(const Result& old_result, const Result& new_result, double& max_diff) {
+    int failures = 0;
+    failures += old_result.maxpad != new_result.maxpad;
+    failures += old_result.maxpad_sum != new_result.maxpad_sum;
+    failures += old_result.y != new_result.y;
+    double diff = std::abs(double(old_result.x) - new_result.x)/(1 + std::abs(old_result.x));
+    max_diff = std::max(max_diff, diff);
+    failures += !(diff <= tolerance);
+    return failures;
+  }
+}
+
+int main(int argc, char** argv) {
+  int nevents = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+  GValue::SetReplaceValue("CRDC1_X_SLOPE", 2.54);
+  GValue::SetReplaceValue("CRDC1_X_OFFSET", -281.94);
+  GValue::SetReplaceValue("CRDC1_Y_SLOPE", -0.1);
+  GValue::SetReplaceValue("CRDC1_Y_OFFSET", 25);
+  GValue::SetReplaceValue("CRDC2_X_SLOPE", 2.54);
+  GValue::SetReplaceValue("CRDC2_X_OFFSET", -281.94);
+
+  std::mt19937 gen(2021);
+  Calibrate(gen);
+
+  int failures = 0;
+  double max_diff = 0;
+  TCrdc kept;
+  Fill(gen, 0, kept);
+  for(int half=0; half<2; half++) {
+    if(half == 1) {
+      // The TCrdc kept from before must see the new calibration.
+      Calibrate(gen);
+      gRandom->SetSeed(seed);
+      Result new_result = NewPath(kept);
+      gRandom->SetSeed(seed);
+      Result old_result = OldPath(kept);
+      if(Compare(old_result, new_result, max_diff)) {
+        std::cout << "A reconstructed TCrdc kept the calibration from before the TChannels changed"
+                  << std::endl;
+        failures++;
+      }
+    } else {
+      gRandom->SetSeed(seed);
+      NewPath(kept);
+    }
+
+    for(int i=0; i<nevents/2; i++) {
+      TCrdc crdc;
+      Fill(gen, i%2, crdc);
+      gRandom->SetSeed(seed + i);
+      Result new_result = NewPath(crdc);
+      gRandom->SetSeed(seed + i);
+      Result old_result = OldPath(crdc);
+      failures += Compare(old_result, new_result, max_diff) != 0;
+    }
+  }
+
+  // Timing, as the getters were called before: each old getter redid its own loop.
+  std::vector<TCrdc> events(std::min(nevents, 10000));
+  for(size_t i=0; i<events.size(); i++) {
+    Fill(gen, i%2, events[i]);
+  }
+  double check = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(auto& crdc : events) {
+    check += OldPath(crdc).maxpad;
+    Result result = OldPath(crdc);
+    check += result.x + OldPath(crdc).y;
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for(auto& crdc : events) {
+    Result result = NewPath(crdc);
+    check += result.maxpad + result.x + result.y;
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double old_time = std::chrono::duration<double>(mid - start).count();
+  double new_time = std::chrono::duration<double>(stop - mid).count();
+
+  std::cout << "events:        " << nevents << std::endl;
+  std::cout << "max deviation: " << max_diff << " in X, relative" << std::endl;
+  std::cout << "old getters:   " << events.size()/old_time << " events/s" << std::endl;
+  std::cout << "Reconstruct:   " << events.size()/new_time << " events/s" << std::endl;
+  std::cout << "checksum:      " << check << std::endl;
+
+  if(failures) {
+    std::cout << "FAILED, " << failures << " events differ, X tolerance is " << tolerance
+              << " relative" << std::endl;
+    return 1;
+  }
+  return 0;
+}
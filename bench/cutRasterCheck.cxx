@@ -0,0 +1,129 @@
+// Checks TCutRaster against TCutG::IsInside, and times both.
+//
+//   cutRasterCheck [npoints]
+//
+// Random star-shaped polygons, some of them closed and some with spikes, are
+// rasterised in groups of 1 to 12.  Random points, and points on and next to
+// the vertices, must get the same first cut from the raster as from asking
+// each TCutG in turn.  Then npoints points are classified against 12 PID-like
+// gates both ways.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TCutG.h"
+
+#include "TCutRaster.h"
+
+namespace {
+  int FirstInside(const std::vector<TCutG*>& cuts, double x, double y) {
+    for(size_t i=0; i<cuts.size(); i++) {
+      if(cuts[i]->IsInside(x, y)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main(int argc, char** argv) {
+  long npoints = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> uniform(0, 1);
+
+  long mismatches = 0;
+  long checked = 0;
+  for(int trial=0; trial<200; trial++) {
+    int ncuts = 1 + trial%12;
+    std::vector<TCutG*> cuts;
+    std::vector<const TCutG*> const_cuts;
+    for(int c=0; c<ncuts; c++) {
+      TCutG* cut = new TCutG(Form("cut%d_%d", trial, c));
+      int n = 3 + rng()%20;
+      double cx = 100*uniform(rng);
+      double cy = 50*uniform(rng);
+      for(int i=0; i<n; i++) {
+        double angle = 2*M_PI*i/n + 0.3*uniform(rng);
+        double r = (trial%5==0) ? ((i%2) ? 3 : 12) : 2 + 10*uniform(rng);
+        cut->SetPoint(i, cx + r*std::cos(angle), cy + r*std::sin(angle));
+      }
+      if(trial%7==0) {
+        cut->SetPoint(n, cut->GetX()[0], cut->GetY()[0]);
+      }
+      cuts.push_back(cut);
+      const_cuts.push_back(cut);
+    }
+
+    TCutRaster raster(const_cuts, 64 + trial, 64 + trial/2);
+    for(int k=0; k<20000; k++) {
+      double x = -20 + 140*uniform(rng);
+      double y = -20 +  90*uniform(rng);
+      if(k%4 == 0) {
+        TCutG* cut = cuts[rng()%ncuts];
+        int i = rng()%cut->GetN();
+        x = cut->GetX()[i];
+        y = cut->GetY()[i] + ((k%8 == 0) ? 1e-12 : 0);
+      }
+      if(raster.Classify(x, y) != FirstInside(cuts, x, y)) {
+        mismatches++;
+      }
+      checked++;
+    }
+
+    for(auto cut : cuts) {
+      delete cut;
+    }
+  }
+
+  std::vector<TCutG*> gates;
+  std::vector<const TCutG*> const_gates;
+  for(int c=0; c<12; c++) {
+    TCutG* gate = new TCutG(Form("gate%d", c));
+    for(int i=0; i<16; i++) {
+      double angle = 2*M_PI*i/16;
+      gate->SetPoint(i, 10 + 8*c + 4*std::cos(angle), 20 + 2*c + 6*std::sin(angle));
+    }
+    gates.push_back(gate);
+    const_gates.push_back(gate);
+  }
+  TCutRaster pid(const_gates);
+
+  std::vector<double> xs(npoints), ys(npoints);
+  for(long i=0; i<npoints; i++) {
+    xs[i] = 110*uniform(rng);
+    ys[i] = 10 + 40*uniform(rng);
+  }
+
+  long check = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(long i=0; i<npoints; i++) {
+    check += FirstInside(gates, xs[i], ys[i]);
+  }
+  double loop_time = Seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for(long i=0; i<npoints; i++) {
+    check -= pid.Classify(xs[i], ys[i]);
+  }
+  double raster_time = Seconds(start);
+
+  std::cout << "mismatches:     " << mismatches << " of " << checked << " points" << std::endl;
+  std::cout << "IsInside loop:  " << 1e9*loop_time/npoints << " ns/point (12 gates)" << std::endl;
+  std::cout << "raster:         " << 1e9*raster_time/npoints << " ns/point, "
+            << 100*pid.GetEdgeFraction() << "% edge cells" << std::endl;
+
+  if(mismatches || check) {
+    std::cout << "FAILED" << std::endl;
+    return 1;
+  }
+  return 0;
+}
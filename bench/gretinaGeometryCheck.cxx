@@ -0,0 +1,104 @@
+// Checks TGretinaGeometry against TGretina::CrystalToGlobal, and times both.
+//
+//   gretinaGeometryCheck [npoints]
+//
+// Needs GRUTSYS to be set, for crmat.dat.  Random points inside each
+// crystal are moved to the lab with non-zero GRETINA_X/Y/Z_OFFSET, through
+// the old path (offsets looked up by name, then TGretina::CrystalToGlobal)
+// and through the cached matrices.  The offsets are then changed, and the
+// cached matrices must follow.  Exits non-zero if any point differs by
+// more than the tolerance.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "GValue.h"
+#include "TGretina.h"
+#include "TGretinaGeometry.h"
+
+namespace {
+  const double tolerance = 1e-4; // cm
+
+  TVector3 OldPosition(int cryId, float x, float y, float z) {
+    double xoffset = GValue::Value("GRETINA_X_OFFSET");
+    if(std::isnan(xoffset))
+      xoffset=0.00;
+    double yoffset = GValue::Value("GRETINA_Y_OFFSET");
+    if(std::isnan(yoffset))
+      yoffset=0.00;
+    double zoffset = GValue::Value("GRETINA_Z_OFFSET");
+    if(std::isnan(zoffset))
+      zoffset=0.00;
+    return TGretina::CrystalToGlobal(cryId, x + xoffset, y + yoffset, z + zoffset);
+  }
+}
+
+int main(int argc, char** argv) {
+  int npoints = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+  GValue::SetReplaceValue("GRETINA_X_OFFSET", 0.125);
+  GValue::SetReplaceValue("GRETINA_Y_OFFSET", -0.25);
+  GValue::SetReplaceValue("GRETINA_Z_OFFSET", 0.5);
+
+  std::mt19937 gen(2021);
+  std::uniform_real_distribution<float> radial(-4, 4);
+  std::uniform_real_distribution<float> depth(0, 9);
+
+  int first = TGretinaGeometry::kFirstCrystal;
+  int last  = TGretinaGeometry::kFirstCrystal + TGretinaGeometry::kNumCrystals;
+  std::vector<int> cry(npoints*(last - first));
+  std::vector<float> x(cry.size()), y(cry.size()), z(cry.size());
+  for(size_t i=0; i<cry.size(); i++) {
+    cry[i] = first + i/npoints;
+    x[i] = radial(gen);
+    y[i] = radial(gen);
+    z[i] = depth(gen);
+  }
+
+  double max_diff = 0;
+  for(int pass=0; pass<2; pass++) {
+    if(pass == 1) {
+      GValue::SetReplaceValue("GRETINA_X_OFFSET", -0.375);
+      GValue::SetReplaceValue("GRETINA_Z_OFFSET", 1.0);
+    }
+    for(size_t i=0; i<cry.size(); i++) {
+      TVector3 old_pos = OldPosition(cry[i], x[i], y[i], z[i]);
+      TVector3 new_pos = TGretinaGeometry::IntPointToGlobal(cry[i], x[i], y[i], z[i]);
+      max_diff = std::max(max_diff, (old_pos - new_pos).Mag());
+    }
+  }
+
+  double check = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(size_t i=0; i<cry.size(); i++) {
+    check += OldPosition(cry[i], x[i], y[i], z[i]).Z();
+  }
+  auto mid = std::chrono::steady_clock::now();
+  std::vector<float> gx(npoints), gy(npoints), gz(npoints);
+  for(int c=first; c<last; c++) {
+    size_t offset = (c - first)*npoints;
+    TGretinaGeometry::Transform(c, true, &x[offset], &y[offset], &z[offset], npoints,
+                                gx.data(), gy.data(), gz.data());
+    check += gz[0];
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double old_time = std::chrono::duration<double>(mid - start).count();
+  double new_time = std::chrono::duration<double>(stop - mid).count();
+
+  std::cout << "points:        " << cry.size() << std::endl;
+  std::cout << "max deviation: " << max_diff << " cm" << std::endl;
+  std::cout << "old path:      " << cry.size()/old_time << " points/s" << std::endl;
+  std::cout << "batch:         " << cry.size()/new_time << " points/s" << std::endl;
+  std::cout << "checksum:      " << check << std::endl;
+
+  if(max_diff > tolerance) {
+    std::cout << "FAILED, tolerance is " << tolerance << " cm" << std::endl;
+    return 1;
+  }
+  return 0;
+}
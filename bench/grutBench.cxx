@@ -0,0 +1,1204 @@
+// Benchmarks the sorting pipeline on synthetic raw data.
+//
+//   grutBench dir [--generate] [--run] [options]
+//
+// --generate writes a raw file into dir for each of the --formats:
+//   mode2  bench_mode2.dat            GRETINA decomposed hits, GEB type 1
+//   mode3  GlobalRaw_bench_mode3.dat  GRETINA waveforms, GEB type 2
+//   s800   bench_s800.dat             S800 events, GEB type 5
+//   ddas   bench_ddas.evt             SeGA and JANUS, built NSCL events of DDAS fragments
+// along with bench_channels.cal and bench_detectors.env to unpack them.
+// --events, --multiplicity (mean hits per event) and --rate (mean events
+// per second, which spaces the timestamps) shape the data.  The same
+// options and --seed always give the same files.
+//
+// --run reads each file back and times the stages one at a time, on this
+// thread: raw read, time-sort, build, unpack (with the hits built by each
+// detector system), histogram fill (when --histos names a library) and
+// tree write.  Each stage takes the output of the one before from memory.
+// Then the whole pipeline is run from the file, on its own threads.
+// Without either flag, both are done.
+//
+// The results are written to dir/grut_bench.json (or --json) as
+//   {"schema": 1, "commit": ..., "config": {...},
+//    "runs": [{"format": ..., "file": ..., "file_bytes": ..., "raw_events": ..., "raw_bytes": ...,
+//              "stages": [{"stage": ..., "items_in": ..., "items_out": ..., "seconds": ...,
+//                          "events_per_second": ..., "mb_per_second": ...}, ...],
+//              "detectors": [{"system": ..., "calls": ..., "hits": ..., "seconds": ..., ...}, ...],
+//              "pipeline": {"seconds": ..., "events_per_second": ..., "mb_per_second": ...,
+//                           "stages": [{"name": ..., <TStageMetrics>}, ...]}}]}
+// events_per_second and mb_per_second are always of the raw events in the
+// file, so that the stages can be set against each other; items_in and
+// items_out are what the stage itself took and gave.  The raw file is read
+// from the page cache, once it has been read before.
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+
+#include "ArgParser.h"
+#include "DDASBanks.h"
+#include "GVersion.h"
+#include "StoppableThread.h"
+#include "TBuildProfile.h"
+#include "TBuildingLoop.h"
+#include "TChannel.h"
+#include "TCompiledHistograms.h"
+#include "TDataLoop.h"
+#include "TDetectorEnv.h"
+#include "TGRUTOptions.h"
+#include "TOrderedRawFile.h"
+#include "TPreserveGDirectory.h"
+#include "TRawEvent.h"
+#include "TRawSource.h"
+#include "TStageMetrics.h"
+#include "TTerminalLoop.h"
+#include "TUnpackedEvent.h"
+#include "TUnpackingLoop.h"
+#include "TWriteLoop.h"
+#include "ThreadsafeQueue.h"
+
+namespace {
+  struct Config {
+    std::string dir;
+    std::string formats;
+    long events;
+    double multiplicity;
+    double rate;
+    long seed;
+    int mode3_trace;
+    int ddas_trace;
+    long build_window;
+    bool time_sort;
+    std::string histos;
+    std::string json;
+  };
+
+  template<typename Func>
+  double Seconds(Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+  }
+
+  std::string Path(const Config& cfg, const std::string& name) {
+    return cfg.dir + "/" + name;
+  }
+
+  size_t FileSize(const std::string& filename) {
+    struct stat info;
+    if(stat(filename.c_str(), &info) != 0) {
+      return 0;
+    }
+    return info.st_size;
+  }
+
+  std::string Quote(const std::string& text) {
+    std::string output = "\"";
+    for(char c : text) {
+      if(c == '"' || c == '\\') {
+        output += '\\';
+      }
+      output += c;
+    }
+    return output + "\"";
+  }
+
+  /*****************************************************************************/
+  /* Synthetic data ************************************************************/
+  /*****************************************************************************/
+
+  // The std distributions differ between standard libraries, and the
+  //   files should not, so only the bits of the engine are used.
+  class BenchRandom {
+  public:
+    explicit BenchRandom(unsigned long seed) : engine(seed) { }
+
+    double Uniform() { return (engine() >> 11) * (1.0/9007199254740992.0); }
+    double Uniform(double low, double high) { return low + (high - low)*Uniform(); }
+    int Integer(int n) { return std::min(n-1, int(n*Uniform())); }
+    double Exponential(double mean) { return -mean*std::log(1 - Uniform()); }
+    double Gaus(double mean, double sigma) {
+      double u1 = 1 - Uniform();
+      double u2 = Uniform();
+      return mean + sigma*std::sqrt(-2*std::log(u1))*std::cos(2*M_PI*u2);
+    }
+    int Poisson(double mean) {
+      double limit = std::exp(-mean);
+      double product = Uniform();
+      int count = 0;
+      while(product > limit) {
+        product *= Uniform();
+        count++;
+      }
+      return count;
+    }
+
+  private:
+    std::mt19937_64 engine;
+  };
+
+  // Photopeaks, in keV, most gamma rays are drawn from.
+  const double gamma_lines[] = {121.8, 344.3, 511.0, 661.7, 778.9, 964.1, 1173.2, 1332.5, 1408.0};
+  const int n_gamma_lines = sizeof(gamma_lines)/sizeof(gamma_lines[0]);
+
+  double GammaEnergy(BenchRandom& rng) {
+    double line = gamma_lines[rng.Integer(n_gamma_lines)];
+    if(rng.Uniform() < 0.35) {
+      // Compton scattered out of the crystal.
+      return rng.Uniform(30, line);
+    }
+    return rng.Gaus(line, 1 + 0.001*line);
+  }
+
+  // Event times, in the clock ticks of the format.
+  class EventClock {
+  public:
+    EventClock(const Config& cfg, BenchRandom& rng, double ticks_per_second)
+      : rng(rng), mean_spacing(ticks_per_second/std::max(cfg.rate, 1e-3)),
+        time(long(ticks_per_second)) { }
+
+    long Next() {
+      time += std::max(1L, long(rng.Exponential(mean_spacing)));
+      return time;
+    }
+
+  private:
+    BenchRandom& rng;
+    double mean_spacing;
+    long time;
+  };
+
+  template<typename T>
+  void Append(std::vector<char>& buffer, const T& item) {
+    const char* data = (const char*)&item;
+    buffer.insert(buffer.end(), data, data + sizeof(T));
+  }
+
+  void WriteGEB(FILE* out, int type, long timestamp, const std::vector<char>& payload) {
+    TRawEvent::RawHeader header;
+    header.datum1 = type;
+    header.datum2 = payload.size();
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(&timestamp, sizeof(timestamp), 1, out);
+    fwrite(payload.data(), 1, payload.size(), out);
+  }
+
+  int Hits(const Config& cfg, BenchRandom& rng) {
+    return std::max(1, rng.Poisson(cfg.multiplicity));
+  }
+
+  // Hits of one event are spread over half the build window, and written
+  //   in the order they were made, so they are a little out of time order.
+  long Jitter(const Config& cfg, BenchRandom& rng) {
+    long spread = std::max(1L, cfg.build_window/4);
+    return rng.Integer(2*spread + 1) - spread;
+  }
+
+  int CrystalId(BenchRandom& rng) {
+    // Twelve quads, in holes 1 to 12.
+    return (1 + rng.Integer(12))*4 + rng.Integer(4);
+  }
+
+  void GenerateMode2(const Config& cfg, BenchRandom& rng, FILE* out) {
+    EventClock clock(cfg, rng, 1e8);
+    for(long i=0; i<cfg.events; i++) {
+      long time = clock.Next();
+      int ngamma = Hits(cfg, rng);
+      for(int g=0; g<ngamma; g++) {
+        TRawEvent::GEBBankType1 bank;
+        memset(&bank, 0, sizeof(bank));
+        double energy = GammaEnergy(rng);
+
+        bank.type       = 0xabcd5678;
+        bank.crystal_id = CrystalId(rng);
+        bank.num        = 1 + rng.Integer(4);
+        bank.tot_e      = energy;
+        for(int j=0; j<4; j++) {
+          bank.core_e[j] = int(rng.Gaus(energy*32, 20));
+        }
+        bank.timestamp  = time + Jitter(cfg, rng);
+        bank.trig_time  = bank.timestamp;
+        bank.t0         = rng.Gaus(-5, 2);
+        bank.cfd        = rng.Uniform(0, 10);
+        bank.chisq      = rng.Uniform(0.5, 5);
+        bank.norm_chisq = bank.chisq/rng.Uniform(1, 3);
+        bank.baseline   = rng.Gaus(0, 2);
+        bank.prestep    = rng.Gaus(0, 1);
+        bank.poststep   = energy;
+        bank.pad        = 0;
+
+        double left = energy;
+        for(int j=0; j<bank.num; j++) {
+          double e = (j == bank.num-1) ? left : left*rng.Uniform(0.2, 0.8);
+          left -= e;
+          TRawEvent::GEBInteractionPoint& point = bank.intpts[j];
+          point.x        = rng.Uniform(-35, 35);
+          point.y        = rng.Uniform(-35, 35);
+          point.z        = rng.Uniform(0, 90);
+          point.e        = e;
+          point.seg      = rng.Integer(36);
+          point.seg_ener = rng.Gaus(e, 2);
+        }
+
+        std::vector<char> payload;
+        Append(payload, bank);
+        WriteGEB(out, 1, bank.timestamp, payload);
+      }
+    }
+  }
+
+  // One Mode3 fragment, with every field byte-swapped as the digitizers write them.
+  void AppendMode3Fragment(std::vector<char>& payload, BenchRandom& rng, int crystal_id,
+                           int vme, int channel, long led, double energy, int trace) {
+    size_t total = sizeof(TRawEvent::GEBMode3Head) + sizeof(TRawEvent::GEBMode3Data) + 2*trace;
+
+    TRawEvent::GEBMode3Head head;
+    head.a2       = 0xaaaa;
+    head.a1       = 0xaaaa;
+    head.lengthGA = TRawEvent::SwapShort((total - 4)/4);
+    head.board_id = TRawEvent::SwapShort(((crystal_id/4) << 8) | ((crystal_id%4) << 6) | (vme << 4) | channel);
+    Append(payload, head);
+
+    int charge = int(energy*10) & 0x00ffffff;
+    TRawEvent::GEBMode3Data data;
+    memset(&data, 0, sizeof(data));
+    data.led_low     = led & 0xffff;
+    data.led_middle  = (led >> 16) & 0xffff;
+    data.led_high    = (led >> 32) & 0xffff;
+    data.cfd_low     = data.led_low;
+    data.cfd_middle  = data.led_middle;
+    data.cfd_high    = data.led_high;
+    data.energy_low  = charge & 0xffff;
+    data.energy_high = (charge >> 16) & 0xff;
+    TRawEvent::SwapMode3Data(data);
+    Append(payload, data);
+
+    // A step on a noisy baseline, in the word order TMode3Hit swaps back.
+    std::vector<short> wave(trace);
+    double baseline = rng.Gaus(200, 20);
+    int start = trace/3;
+    for(int i=0; i<trace; i++) {
+      double signal = (i < start) ? 0 : energy*std::exp(-(i - start)/2000.0);
+      wave[i] = short(baseline + signal + rng.Gaus(0, 3));
+    }
+    for(int i=0; i+1<trace; i+=2) {
+      unsigned short first  = TRawEvent::SwapShort(wave[i+1]);
+      unsigned short second = TRawEvent::SwapShort(wave[i]);
+      Append(payload, first);
+      Append(payload, second);
+    }
+  }
+
+  void GenerateMode3(const Config& cfg, BenchRandom& rng, FILE* out) {
+    EventClock clock(cfg, rng, 1e8);
+    for(long i=0; i<cfg.events; i++) {
+      long time = clock.Next();
+      int ngamma = Hits(cfg, rng);
+      for(int g=0; g<ngamma; g++) {
+        int crystal_id = CrystalId(rng);
+        double energy = GammaEnergy(rng);
+        long led = time + Jitter(cfg, rng);
+
+        // The core, and the segments that saw the charge.
+        std::vector<char> payload;
+        AppendMode3Fragment(payload, rng, crystal_id, 0, 9, led, energy, cfg.mode3_trace);
+        int nseg = 1 + rng.Integer(3);
+        for(int s=0; s<nseg; s++) {
+          AppendMode3Fragment(payload, rng, crystal_id, rng.Integer(4), rng.Integer(9),
+                              led + rng.Integer(4), energy/nseg, cfg.mode3_trace);
+        }
+        WriteGEB(out, 2, led, payload);
+      }
+    }
+  }
+
+  void AppendCRDC(std::vector<unsigned short>& packets, BenchRandom& rng, int id) {
+    std::vector<unsigned short> data;
+    data.push_back(id);
+    data.push_back(0);
+    data.push_back(0x5841);
+    double centroid = rng.Uniform(40, 180);
+    int npads = 8 + rng.Integer(5);
+    int first_pad = int(centroid) - npads/2;
+    for(int pad=first_pad; pad<first_pad+npads; pad++) {
+      double amplitude = 800*std::exp(-std::pow(pad - centroid, 2)/8);
+      for(int sample=0; sample<4; sample++) {
+        int value = std::max(0, std::min(1023, int(rng.Gaus(amplitude, 10))));
+        data.push_back(0x8000 | (sample << 6) | (pad & 0x3f));
+        data.push_back(((pad >> 6) << 10) | value);
+      }
+    }
+    data[1] = data.size();
+    // TS800::HandleCRDCPacket steps over one word before the anode.
+    data.push_back(0);
+    data.push_back(4);
+    data.push_back(0x5845);
+    data.push_back(rng.Integer(4096));
+    data.push_back(rng.Integer(4096));
+
+    packets.push_back(data.size() + 2);
+    packets.push_back(0x5840);
+    packets.insert(packets.end(), data.begin(), data.end());
+  }
+
+  void GenerateS800(const Config& cfg, BenchRandom& rng, FILE* out) {
+    EventClock clock(cfg, rng, 1e8);
+    for(long i=0; i<cfg.events; i++) {
+      long time = clock.Next();
+      std::vector<unsigned short> packets;
+
+      // Trigger.
+      packets.push_back(4);
+      packets.push_back(0x5801);
+      packets.push_back(0x0001);
+      packets.push_back(0x8000 | rng.Integer(4096));
+
+      // Mesytec TDC: ref, e1 up and down, xfp, obj and rf.
+      const int mtdc_channels[] = {15, 0, 1, 2, 3, 5};
+      packets.push_back(2 + 2*6);
+      packets.push_back(0x58f0);
+      for(int channel : mtdc_channels) {
+        packets.push_back(channel);
+        packets.push_back(int(rng.Gaus(30000, 200)) & 0xffff);
+      }
+
+      // Ion chamber, all 16 channels.
+      packets.push_back(2 + 2 + 16);
+      packets.push_back(0x5820);
+      packets.push_back(2 + 16);
+      packets.push_back(0x5821);
+      double de = rng.Uniform(500, 3000);
+      for(int channel=0; channel<16; channel++) {
+        packets.push_back((channel << 12) | (int(rng.Gaus(de, 30)) & 0x0fff));
+      }
+
+      AppendCRDC(packets, rng, 0);
+      AppendCRDC(packets, rng, 1);
+
+      TRawEvent::GEBS800Header header;
+      memset(&header, 0, sizeof(header));
+      // TS800::BuildHits reads packets up to 16 short of total_size.
+      header.total_size                   = packets.size() + 16;
+      header.total_size2                  = packets.size() + 16;
+      header.S800_packet                  = 0x5800;
+      header.S800_packet_size             = packets.size() + 14;
+      header.S800_version                 = 0x0005;
+      header.S800_timestamp_packet        = 0x5803;
+      header.S800_timestamp               = time;
+      header.S800_eventnumber_packet_size = 5;
+      header.S800_eventnumber_packet      = 0x5804;
+      header.S800_eventnumber_low         = i & 0xffff;
+      header.S800_eventnumber_middle      = (i >> 16) & 0xffff;
+      header.S800_eventnumber_high        = (i >> 32) & 0xffff;
+
+      std::vector<char> payload;
+      Append(payload, header);
+      for(auto word : packets) {
+        Append(payload, word);
+      }
+      WriteGEB(out, 5, time, payload);
+    }
+  }
+
+  // The DDAS channels, and their place in bench_channels.cal.
+  const int sega_detectors   = 16;
+  const int sega_channels    = 33;  // Core and 32 segments.
+  const int janus_detectors  = 2;
+  const int janus_rings      = 24;
+  const int janus_sectors    = 32;
+  const int janus_crate      = 3;
+  const int janus_source_id  = 4;
+
+  struct DDASChannel {
+    int crate;
+    int slot;
+    int channel;
+  };
+
+  DDASChannel SegaChannel(int detector, int segment) {
+    int index = detector*sega_channels + segment;
+    return DDASChannel{index/224, 2 + (index%224)/16, index%16};
+  }
+
+  DDASChannel JanusChannel(int detector, bool ring, int number) {
+    int index = detector*(janus_rings + janus_sectors) + (ring ? number : janus_rings + number);
+    return DDASChannel{janus_crate, 2 + index/16, index%16};
+  }
+
+  struct DDASFragment {
+    long timestamp;
+    int source_id;
+    std::vector<char> ring_item;
+  };
+
+  DDASFragment MakeDDASFragment(BenchRandom& rng, const DDASChannel& chan, int source_id,
+                                long time_ns, int energy, int trace) {
+    // 250 MHz modules count in 8 ns steps.
+    unsigned long clock = time_ns/8;
+
+    DDASHeader header;
+    header.size     = (sizeof(DDASHeader) + 2*trace)/2;
+    header.frequency = 250;
+    header.adc_bits = 16;
+    header.revision = 0;
+    header.status   = chan.channel | (chan.slot << 4) | (chan.crate << 8)
+                    | (4 << 12) | ((4 + trace/2) << 17);
+    header.time_low      = clock & 0xffffffff;
+    header.time_high_cfd = ((clock >> 32) & 0xffff) | (rng.Integer(16384) << 16);
+    header.energy_tracelength = (std::max(0, std::min(energy, 0xffff))) | (trace << 16);
+
+    std::vector<char> ddas;
+    Append(ddas, header);
+    double baseline = rng.Gaus(1000, 50);
+    for(int i=0; i<trace; i++) {
+      double signal = (i < trace/4) ? 0 : energy*0.1*std::exp(-(i - trace/4)/50.0);
+      unsigned short sample = (unsigned short)(baseline + signal + rng.Gaus(0, 3));
+      Append(ddas, sample);
+    }
+
+    TRawEvent::NSCLBodyHeader body_header;
+    body_header.body_header_size = sizeof(body_header);
+    body_header.timestamp = clock*8;
+    body_header.sourceid  = source_id;
+    body_header.barrier   = 0;
+
+    TRawEvent::RawHeader header_ring;
+    header_ring.datum1 = sizeof(header_ring) + sizeof(body_header) + ddas.size();
+    header_ring.datum2 = 30;  // PHYSICS_EVENT
+
+    DDASFragment fragment;
+    fragment.timestamp = body_header.timestamp;
+    fragment.source_id = source_id;
+    Append(fragment.ring_item, header_ring);
+    Append(fragment.ring_item, body_header);
+    fragment.ring_item.insert(fragment.ring_item.end(), ddas.begin(), ddas.end());
+    return fragment;
+  }
+
+  void GenerateDDAS(const Config& cfg, BenchRandom& rng, FILE* out) {
+    EventClock clock(cfg, rng, 1e9);
+    for(long i=0; i<cfg.events; i++) {
+      long time = clock.Next();
+      std::vector<DDASFragment> fragments;
+
+      // SeGA: a core and the segments that saw the charge, for each gamma ray.
+      int ngamma = Hits(cfg, rng);
+      for(int g=0; g<ngamma; g++) {
+        int detector = rng.Integer(sega_detectors);
+        double energy = GammaEnergy(rng);
+        DDASChannel core = SegaChannel(detector, 0);
+        fragments.push_back(MakeDDASFragment(rng, core, core.crate, time + rng.Integer(100),
+                                             int(2*energy), cfg.ddas_trace));
+        int nseg = 1 + rng.Integer(2);
+        for(int s=0; s<nseg; s++) {
+          DDASChannel seg = SegaChannel(detector, 1 + rng.Integer(32));
+          fragments.push_back(MakeDDASFragment(rng, seg, seg.crate, time + rng.Integer(100),
+                                               int(2*energy/nseg), cfg.ddas_trace));
+        }
+      }
+
+      // JANUS: a ring and a sector for most events.
+      if(rng.Uniform() < 0.75) {
+        int detector = rng.Integer(janus_detectors);
+        int charge = int(rng.Uniform(2000, 30000));
+        fragments.push_back(MakeDDASFragment(rng, JanusChannel(detector, true, rng.Integer(janus_rings)),
+                                             janus_source_id, time + rng.Integer(100),
+                                             charge, cfg.ddas_trace));
+        fragments.push_back(MakeDDASFragment(rng, JanusChannel(detector, false, rng.Integer(janus_sectors)),
+                                             janus_source_id, time + rng.Integer(100),
+                                             int(rng.Gaus(charge, 200)), cfg.ddas_trace));
+      }
+
+      // As the event builder gives them: in time order, each behind a fragment header.
+      std::stable_sort(fragments.begin(), fragments.end(),
+                       [](const DDASFragment& a, const DDASFragment& b) {
+                         return a.timestamp < b.timestamp;
+                       });
+      std::vector<char> body;
+      Append(body, int(0));
+      for(auto& fragment : fragments) {
+        TRawEvent::TNSCLFragmentHeader fragment_header;
+        fragment_header.timestamp    = fragment.timestamp;
+        fragment_header.sourceid     = fragment.source_id;
+        fragment_header.payload_size = fragment.ring_item.size();
+        fragment_header.barrier      = 0;
+        Append(body, fragment_header);
+        body.insert(body.end(), fragment.ring_item.begin(), fragment.ring_item.end());
+      }
+      *(int*)body.data() = body.size();
+
+      TRawEvent::NSCLBodyHeader body_header;
+      body_header.body_header_size = sizeof(body_header);
+      body_header.timestamp = fragments.front().timestamp;
+      body_header.sourceid  = 0;
+      body_header.barrier   = 0;
+
+      TRawEvent::RawHeader header;
+      header.datum1 = sizeof(header) + sizeof(body_header) + body.size();
+      header.datum2 = 30;  // PHYSICS_EVENT
+      fwrite(&header, sizeof(header), 1, out);
+      fwrite(&body_header, sizeof(body_header), 1, out);
+      fwrite(body.data(), 1, body.size(), out);
+    }
+  }
+
+  void WriteChannel(FILE* out, const std::string& name, unsigned int address, int position,
+                    const char* subposition, int segment, const char* system, double gain) {
+    fprintf(out, "%s {\n", name.c_str());
+    fprintf(out, "  Address: 0x%08x\n", address);
+    fprintf(out, "  Position: %i\n", position);
+    if(subposition) {
+      fprintf(out, "  Subposition: %s\n", subposition);
+    }
+    fprintf(out, "  Segment: %i\n", segment);
+    fprintf(out, "  System: %s\n", system);
+    fprintf(out, "  EnergyCoeff: 0 %g\n", gain);
+    fprintf(out, "}\n\n");
+  }
+
+  unsigned int Address(int system, const DDASChannel& chan) {
+    return (system << 24) | (chan.crate << 16) | (chan.slot << 8) | chan.channel;
+  }
+
+  void WriteSetupFiles(const Config& cfg) {
+    FILE* cal = fopen(Path(cfg, "bench_channels.cal").c_str(), "w");
+    for(int det=0; det<sega_detectors; det++) {
+      for(int seg=0; seg<sega_channels; seg++) {
+        char name[32];
+        snprintf(name, sizeof(name), "SEG%02iS%02i", det+1, seg);
+        WriteChannel(cal, name, Address(1, SegaChannel(det, seg)), det+1, NULL, seg, "SeGA", 0.5);
+      }
+    }
+    for(int det=0; det<janus_detectors; det++) {
+      for(int ring=0; ring<janus_rings; ring++) {
+        char name[32];
+        snprintf(name, sizeof(name), "JAN%02iF%02i", det, ring+1);
+        WriteChannel(cal, name, Address(5, JanusChannel(det, true, ring)), det, "F", ring+1, "JANUS", 0.25);
+      }
+      for(int sector=0; sector<janus_sectors; sector++) {
+        char name[32];
+        snprintf(name, sizeof(name), "JAN%02iB%02i", det, sector+1);
+        WriteChannel(cal, name, Address(5, JanusChannel(det, false, sector)), det, "B", sector+1, "JANUS", 0.25);
+      }
+    }
+    fclose(cal);
+
+    std::ofstream env(Path(cfg, "bench_detectors.env").c_str());
+    env << "# Detector environment of the grutBench files.\n\n"
+        << "Gretina:\n"
+        << "Mode3:\n"
+        << "S800: 5\n"
+        << "Sega: 0 1 2\n"
+        << "JanusDDAS: " << janus_source_id << "\n\n";
+  }
+
+  /*****************************************************************************/
+  /* The formats ***************************************************************/
+  /*****************************************************************************/
+
+  struct Format {
+    const char* name;
+    const char* filename;
+    kFileType file_type;
+    void (*generate)(const Config&, BenchRandom&, FILE*);
+  };
+
+  const Format formats[] = {
+    {"mode2", "bench_mode2.dat",           kFileType::GRETINA_MODE2, GenerateMode2},
+    {"mode3", "GlobalRaw_bench_mode3.dat", kFileType::GRETINA_MODE3, GenerateMode3},
+    {"s800",  "bench_s800.dat",            kFileType::GRETINA_MODE2, GenerateS800},
+    {"ddas",  "bench_ddas.evt",            kFileType::NSCL_EVT,      GenerateDDAS},
+  };
+
+  std::vector<const Format*> ChosenFormats(const Config& cfg) {
+    std::vector<const Format*> output;
+    std::stringstream ss(cfg.formats);
+    std::string name;
+    while(std::getline(ss, name, ',')) {
+      bool found = false;
+      for(auto& format : formats) {
+        if(name == format.name) {
+          output.push_back(&format);
+          found = true;
+        }
+      }
+      if(!found && name.length()) {
+        std::cerr << "Unknown format \"" << name << "\", skipping it" << std::endl;
+      }
+    }
+    return output;
+  }
+
+  void Generate(const Config& cfg) {
+    WriteSetupFiles(cfg);
+    for(auto format : ChosenFormats(cfg)) {
+      // Each format has its own stream, so that one does not change another.
+      BenchRandom rng(cfg.seed + 7919*(format - formats));
+      std::string filename = Path(cfg, format->filename);
+      FILE* out = fopen(filename.c_str(), "wb");
+      if(!out) {
+        std::cerr << "Could not write " << filename << std::endl;
+        continue;
+      }
+      format->generate(cfg, rng, out);
+      fclose(out);
+      std::cout << "Wrote " << filename << ", " << FileSize(filename)/1e6 << " MB" << std::endl;
+    }
+  }
+
+  /*****************************************************************************/
+  /* Stages ********************************************************************/
+  /*****************************************************************************/
+
+  // Gives back events already read, for the time-sort to take from.
+  class BenchMemorySource : public TRawEventSource {
+  public:
+    explicit BenchMemorySource(const std::vector<TRawEvent>& events)
+      : events(events), next(0) { }
+
+    virtual std::string SourceDescription(bool long_description=false) const { return "memory"; }
+    virtual std::string Status(bool long_description=false) const { return ""; }
+
+  private:
+    virtual int GetEvent(TRawEvent& event) {
+      if(next >= events.size()) {
+        return -1;
+      }
+      event = events[next++];
+      return event.GetTotalSize();
+    }
+
+    const std::vector<TRawEvent>& events;
+    size_t next;
+  };
+
+  // THistogramLoop, without the TGRUTint file handling.
+  class BenchHistogramLoop : public StoppableThread {
+  public:
+    BenchHistogramLoop(std::string name, TCompiledHistograms& histograms)
+      : StoppableThread(name), histograms(histograms),
+        input_queue(std::make_shared<ThreadsafeQueue<TUnpackedEvent*> >()),
+        output_queue(std::make_shared<ThreadsafeQueue<TUnpackedEvent*> >()) { }
+
+    std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> >& InputQueue() { return input_queue; }
+    std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> >& OutputQueue() { return output_queue; }
+
+    virtual size_t GetItemsPopped()  { return output_queue->ItemsPopped(); }
+    virtual size_t GetItemsPushed()  { return output_queue->ItemsPushed(); }
+    virtual size_t GetItemsCurrent() { return output_queue->Size(); }
+    virtual size_t GetRate()         { return 0; }
+
+  protected:
+    bool Iteration() {
+      TUnpackedEvent* event = NULL;
+      input_queue->Pop(event);
+      if(event) {
+        histograms.Fill(*event);
+        output_queue->Push(event);
+        return true;
+      } else if(input_queue->IsFinished()) {
+        output_queue->SetFinished();
+        return false;
+      }
+      return true;
+    }
+
+  private:
+    TCompiledHistograms& histograms;
+    std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> > input_queue;
+    std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> > output_queue;
+  };
+
+  // Items pushed to a loop before it is run; well short of the queue limit.
+  const size_t chunk_size = 10000;
+
+  template<typename T>
+  void Drain(std::shared_ptr<ThreadsafeQueue<T> >& queue, std::vector<T>& output) {
+    T item;
+    while(queue->Size()) {
+      queue->Pop(item);
+      output.push_back(item);
+    }
+  }
+
+  // Runs a loop on this thread, over every input.
+  template<typename Loop, typename In, typename Out>
+  void Drive(Loop* loop, const std::vector<In>& input, std::vector<Out>& output) {
+    auto& in = loop->InputQueue();
+    auto& out = loop->OutputQueue();
+    for(size_t i=0; i<input.size(); ) {
+      size_t end = std::min(input.size(), i + chunk_size);
+      for(; i<end; i++) {
+        in->Push(input[i]);
+      }
+      while(in->Size()) {
+        loop->Iteration();
+      }
+      Drain(out, output);
+    }
+    in->SetFinished();
+    while(loop->Iteration()) { }
+    Drain(out, output);
+  }
+
+  void DeleteLoop(StoppableThread* loop) {
+    loop->Stop();
+    loop->Join();
+    delete loop;
+  }
+
+  void PopAndDelete(std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> >& queue, int millisecond_wait) {
+    TUnpackedEvent* event = NULL;
+    if(queue->Pop(event, millisecond_wait) >= 0) {
+      delete event;
+    }
+  }
+
+  struct StageResult {
+    std::string stage;
+    size_t items_in;
+    size_t items_out;
+    double seconds;
+    bool skipped;
+  };
+
+  struct RunResult {
+    const Format* format;
+    std::string filename;
+    size_t file_bytes;
+    size_t raw_events;
+    size_t raw_bytes;
+    std::vector<StageResult> stages;
+    std::string detectors_json;
+    double pipeline_seconds;
+    std::string pipeline_stages_json;
+  };
+
+  std::string DetectorsJson(const TBuildProfile& before, const TBuildProfile& after) {
+    std::stringstream ss;
+    ss << "[";
+    bool first = true;
+    for(size_t i=0; i<after.GetNSystems(); i++) {
+      Long64_t calls = after.GetCalls(i), fragments = after.GetFragments(i);
+      Long64_t bytes = after.GetBytes(i), hits = after.GetHits(i);
+      double seconds = after.GetSeconds(i);
+      for(size_t j=0; j<before.GetNSystems(); j++) {
+        if(before.GetSystem(j) == after.GetSystem(i)) {
+          calls     -= before.GetCalls(j);
+          fragments -= before.GetFragments(j);
+          bytes     -= before.GetBytes(j);
+          hits      -= before.GetHits(j);
+          seconds   -= before.GetSeconds(j);
+        }
+      }
+      if(calls <= 0) {
+        continue;
+      }
+      ss << (first ? "" : ", ")
+         << "{\"system\": " << Quote(after.GetSystem(i))
+         << ", \"calls\": " << calls
+         << ", \"fragments\": " << fragments
+         << ", \"bytes\": " << bytes
+         << ", \"hits\": " << hits
+         << ", \"seconds\": " << seconds
+         << ", \"hits_per_second\": " << (seconds > 0 ? hits/seconds : 0)
+         << ", \"mb_per_second\": " << (seconds > 0 ? bytes/seconds/1e6 : 0)
+         << "}";
+      first = false;
+    }
+    ss << "]";
+    return ss.str();
+  }
+
+  void RunStages(const Config& cfg, RunResult& result) {
+    // Raw read.
+    std::vector<TRawEvent> raw;
+    TRawEventSource* source = TRawEventSource::EventSource(result.filename.c_str(), false, false,
+                                                           result.format->file_type);
+    double seconds = Seconds([&]() {
+        while(true) {
+          TRawEvent event;
+          if(source->Read(event) <= 0) {
+            break;
+          }
+          raw.push_back(event);
+        }
+      });
+    delete source;
+    result.raw_events = raw.size();
+    result.raw_bytes = 0;
+    for(auto& event : raw) {
+      result.raw_bytes += event.GetTotalSize();
+    }
+    result.stages.push_back({"read", raw.size(), raw.size(), seconds, false});
+
+    // Time-sort.
+    std::vector<TRawEvent> sorted;
+    sorted.reserve(raw.size());
+    seconds = Seconds([&]() {
+        TOrderedRawFile ordered(new BenchMemorySource(raw));
+        ordered.SetDepth(TGRUTOptions::Get()->TimeSortDepth());
+        while(true) {
+          TRawEvent event;
+          if(ordered.Read(event) <= 0) {
+            break;
+          }
+          sorted.push_back(event);
+        }
+      });
+    result.stages.push_back({"time_sort", raw.size(), sorted.size(), seconds, false});
+    raw.clear();
+
+    // Build.
+    std::vector<std::vector<TRawEvent> > built;
+    TBuildingLoop* build = TBuildingLoop::Get("bench_build");
+    build->SetBuildWindow(cfg.build_window);
+    seconds = Seconds([&]() { Drive(build, sorted, built); });
+    DeleteLoop(build);
+    result.stages.push_back({"build", sorted.size(), built.size(), seconds, false});
+    sorted.clear();
+
+    // Unpack, with the hits of each detector system from TBuildProfile.
+    std::vector<TUnpackedEvent*> unpacked;
+    TBuildProfile before = TBuildProfile::Snapshot();
+    TUnpackingLoop* unpack = TUnpackingLoop::Get("bench_unpack");
+    seconds = Seconds([&]() { Drive(unpack, built, unpacked); });
+    DeleteLoop(unpack);
+    result.detectors_json = DetectorsJson(before, TBuildProfile::Snapshot());
+    result.stages.push_back({"unpack", built.size(), unpacked.size(), seconds, false});
+    built.clear();
+
+    // Histogram fill.
+    if(cfg.histos.length()) {
+      TPreserveGDirectory preserve;
+      TFile* file = new TFile(Path(cfg, std::string("bench_hist_") + result.format->name + ".root").c_str(),
+                              "RECREATE");
+      TCompiledHistograms histograms(cfg.histos);
+      histograms.SetDefaultDirectory(file);
+      seconds = Seconds([&]() {
+          for(auto event : unpacked) {
+            histograms.Fill(*event);
+          }
+        });
+      file->cd();
+      histograms.Write();
+      file->Close();
+      delete file;
+      result.stages.push_back({"histogram", unpacked.size(), unpacked.size(), seconds, false});
+    } else {
+      result.stages.push_back({"histogram", 0, 0, 0, true});
+    }
+
+    // Tree write, on the loop's own thread, until the file is closed.
+    TWriteLoop* write = TWriteLoop::Get("bench_write",
+                                        Path(cfg, std::string("bench_tree_") + result.format->name + ".root"));
+    size_t written = unpacked.size();
+    seconds = Seconds([&]() {
+        auto& in = write->InputQueue();
+        auto& out = write->OutputQueue();
+        write->Resume();
+        for(auto event : unpacked) {
+          while(in->Size() > chunk_size) {
+            PopAndDelete(out, 10);
+          }
+          in->Push(event);
+          while(out->Size()) {
+            PopAndDelete(out, 0);
+          }
+        }
+        in->SetFinished();
+        while(!out->IsFinished() || out->Size()) {
+          PopAndDelete(out, 10);
+        }
+        write->Join();
+        delete write;
+      });
+    unpacked.clear();
+    result.stages.push_back({"write", written, written, seconds, false});
+  }
+
+  void RunPipeline(const Config& cfg, RunResult& result) {
+    TRawEventSource* source = TRawEventSource::EventSource(result.filename.c_str(), false, false,
+                                                           result.format->file_type);
+    if(cfg.time_sort) {
+      TOrderedRawFile* ordered = new TOrderedRawFile(source);
+      ordered->SetDepth(TGRUTOptions::Get()->TimeSortDepth());
+      source = ordered;
+    }
+
+    std::string name = std::string("bench_pipeline_") + result.format->name;
+    TDataLoop* input = TDataLoop::Get(name + "_1_input", source);
+    TBuildingLoop* build = TBuildingLoop::Get(name + "_2_build");
+    build->SetBuildWindow(cfg.build_window);
+    TUnpackingLoop* unpack = TUnpackingLoop::Get(name + "_3_unpack");
+    TWriteLoop* write = TWriteLoop::Get(name + "_4_write",
+                                        Path(cfg, std::string("bench_pipeline_") + result.format->name + ".root"));
+    TTerminalLoop* terminal = TTerminalLoop::Get(name + "_6_terminal");
+
+    build->InputQueue() = input->OutputQueue();
+    unpack->InputQueue() = build->OutputQueue();
+    write->InputQueue() = unpack->OutputQueue();
+
+    std::vector<StoppableThread*> loops = {input, build, unpack, write};
+
+    TFile* hist_file = NULL;
+    std::unique_ptr<TCompiledHistograms> histograms;
+    BenchHistogramLoop* hist = NULL;
+    if(cfg.histos.length()) {
+      TPreserveGDirectory preserve;
+      hist_file = new TFile(Path(cfg, name + "_hist.root").c_str(), "RECREATE");
+      histograms.reset(new TCompiledHistograms(cfg.histos));
+      histograms->SetDefaultDirectory(hist_file);
+      hist = new BenchHistogramLoop(name + "_5_hist", *histograms);
+      hist->InputQueue() = write->OutputQueue();
+      terminal->InputQueue() = hist->OutputQueue();
+      loops.push_back(hist);
+    } else {
+      terminal->InputQueue() = write->OutputQueue();
+    }
+    loops.push_back(terminal);
+
+    std::stringstream stages;
+    result.pipeline_seconds = Seconds([&]() {
+        for(auto it = loops.rbegin(); it != loops.rend(); it++) {
+          (*it)->Resume();
+        }
+        for(auto loop : loops) {
+          loop->Join();
+        }
+        for(size_t i=0; i<loops.size(); i++) {
+          stages << (i ? ", " : "")
+                 << "{\"name\": " << Quote(loops[i]->Name())
+                 << ", " << TStageMetrics::Json(loops[i]->Metrics().Get()) << "}";
+        }
+        // The tree is only complete once the file is closed.
+        delete write;
+      });
+    result.pipeline_stages_json = "[" + stages.str() + "]";
+
+    for(auto loop : loops) {
+      if(loop != write) {
+        delete loop;
+      }
+    }
+    if(hist_file) {
+      TPreserveGDirectory preserve;
+      hist_file->cd();
+      histograms->Write();
+      hist_file->Close();
+      delete hist_file;
+    }
+  }
+
+  /*****************************************************************************/
+  /* Reports *******************************************************************/
+  /*****************************************************************************/
+
+  std::string RunJson(const RunResult& result) {
+    double mb = result.raw_bytes/1e6;
+    std::stringstream ss;
+    ss << "{\"format\": " << Quote(result.format->name)
+       << ", \"file\": " << Quote(result.filename)
+       << ", \"file_bytes\": " << result.file_bytes
+       << ", \"raw_events\": " << result.raw_events
+       << ", \"raw_bytes\": " << result.raw_bytes
+       << ",\n   \"stages\": [";
+    for(size_t i=0; i<result.stages.size(); i++) {
+      const StageResult& stage = result.stages[i];
+      ss << (i ? ",\n              " : "")
+         << "{\"stage\": " << Quote(stage.stage);
+      if(stage.skipped) {
+        ss << ", \"skipped\": true}";
+        continue;
+      }
+      ss << ", \"items_in\": " << stage.items_in
+         << ", \"items_out\": " << stage.items_out
+         << ", \"seconds\": " << stage.seconds
+         << ", \"events_per_second\": " << (stage.seconds > 0 ? result.raw_events/stage.seconds : 0)
+         << ", \"mb_per_second\": " << (stage.seconds > 0 ? mb/stage.seconds : 0)
+         << "}";
+    }
+    ss << "],\n   \"detectors\": " << result.detectors_json;
+    double seconds = result.pipeline_seconds;
+    ss << ",\n   \"pipeline\": {\"seconds\": " << seconds
+       << ", \"events_per_second\": " << (seconds > 0 ? result.raw_events/seconds : 0)
+       << ", \"mb_per_second\": " << (seconds > 0 ? mb/seconds : 0)
+       << ", \"stages\": " << result.pipeline_stages_json
+       << "}}";
+    return ss.str();
+  }
+
+  std::string ConfigJson(const Config& cfg) {
+    std::stringstream ss;
+    ss << "{\"formats\": " << Quote(cfg.formats)
+       << ", \"events\": " << cfg.events
+       << ", \"multiplicity\": " << cfg.multiplicity
+       << ", \"rate\": " << cfg.rate
+       << ", \"seed\": " << cfg.seed
+       << ", \"mode3_trace\": " << cfg.mode3_trace
+       << ", \"ddas_trace\": " << cfg.ddas_trace
+       << ", \"build_window\": " << cfg.build_window
+       << ", \"time_sort\": " << (cfg.time_sort ? "true" : "false")
+       << ", \"histos\": " << Quote(cfg.histos)
+       << "}";
+    return ss.str();
+  }
+
+  void PrintRun(const RunResult& result) {
+    double mb = result.raw_bytes/1e6;
+    printf("%s: %zu events, %.1f MB\n", result.format->name, result.raw_events, mb);
+    auto print = [&](const std::string& stage, double seconds) {
+      printf("  %-12s %10.3f s %12.0f events/s %10.1f MB/s\n", stage.c_str(), seconds,
+             seconds > 0 ? result.raw_events/seconds : 0, seconds > 0 ? mb/seconds : 0);
+    };
+    for(auto& stage : result.stages) {
+      if(stage.skipped) {
+        printf("  %-12s %10s\n", stage.stage.c_str(), "skipped");
+      } else {
+        print(stage.stage, stage.seconds);
+      }
+    }
+    print("pipeline", result.pipeline_seconds);
+  }
+
+  void Run(const Config& cfg) {
+    TDetectorEnv::Get(Path(cfg, "bench_detectors.env").c_str());
+    TChannel::ReadCalFile(Path(cfg, "bench_channels.cal").c_str());
+
+    // Kept for the whole run, so that deleting the last loop of a stage never
+    //   waits for the status thread to finish.
+    TTerminalLoop* idle = TTerminalLoop::Get("bench_idle");
+
+    std::vector<RunResult> results;
+    for(auto format : ChosenFormats(cfg)) {
+      RunResult result;
+      result.format = format;
+      result.filename = Path(cfg, format->filename);
+      result.file_bytes = FileSize(result.filename);
+      if(!result.file_bytes) {
+        std::cerr << "Could not read " << result.filename << ", run with --generate first" << std::endl;
+        continue;
+      }
+      RunStages(cfg, result);
+      RunPipeline(cfg, result);
+      PrintRun(result);
+      results.push_back(result);
+    }
+
+    DeleteLoop(idle);
+
+    std::string json_name = cfg.json.length() ? cfg.json : Path(cfg, "grut_bench.json");
+    std::ofstream json(json_name.c_str());
+    json << "{\"schema\": 1"
+         << ", \"commit\": " << Quote(GRUT_GIT_COMMIT)
+         << ", \"time\": " << std::time(nullptr)
+         << ",\n \"config\": " << ConfigJson(cfg)
+         << ",\n \"runs\": [";
+    for(size_t i=0; i<results.size(); i++) {
+      json << (i ? ",\n  " : "\n  ") << RunJson(results[i]);
+    }
+    json << "]}\n";
+    std::cout << "Results written to " << json_name << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  if(!getenv("GRUTSYS")) {
+    std::cerr << "GRUTSYS is not set" << std::endl;
+    return 1;
+  }
+
+  Config cfg;
+  std::vector<std::string> positional;
+  bool generate = false;
+  bool run = false;
+  bool help = false;
+  bool waves = false;
+
+  ArgParser parser;
+  parser.default_option(&positional)
+    .description("Directory for the raw files and results");
+  parser.option("generate", &generate)
+    .description("Write the raw files");
+  parser.option("run", &run)
+    .description("Time the stages and the pipeline on the raw files");
+  parser.option("formats", &cfg.formats)
+    .description("Comma separated, from mode2, mode3, s800 and ddas")
+    .default_value("mode2,mode3,s800,ddas");
+  parser.option("events", &cfg.events)
+    .description("Events in each file")
+    .default_value(100000);
+  parser.option("multiplicity", &cfg.multiplicity)
+    .description("Mean hits per event, gamma rays for GRETINA and SeGA")
+    .default_value(3);
+  parser.option("rate", &cfg.rate)
+    .description("Mean events per second, which sets the timestamps")
+    .default_value(10000);
+  parser.option("seed", &cfg.seed)
+    .description("Random seed")
+    .default_value(1);
+  parser.option("mode3-trace", &cfg.mode3_trace)
+    .description("Samples in each Mode3 waveform")
+    .default_value(100);
+  parser.option("ddas-trace", &cfg.ddas_trace)
+    .description("Samples in each DDAS trace")
+    .default_value(0);
+  parser.option("build-window", &cfg.build_window)
+    .description("Build window, timestamp units")
+    .default_value(1000);
+  parser.option("t time-sort", &cfg.time_sort)
+    .description("Time-sort the input of the pipeline");
+  parser.option("histos", &cfg.histos)
+    .description("Histogram library to fill");
+  parser.option("json", &cfg.json)
+    .description("Results file, dir/grut_bench.json by default");
+  parser.option("w waves", &waves)
+    .description("Keep Mode3 and DDAS waveforms, as grutinizer -w");
+  parser.option("h help ?", &help)
+    .description("Show this help message");
+
+  try {
+    parser.parse(argc, argv);
+  } catch (ParseError& e) {
+    std::cerr << "ERROR: " << e.what() << "\n" << parser << std::endl;
+    return 1;
+  }
+  if(help || positional.size() != 1) {
+    std::cout << "Usage: " << argv[0] << " dir [options]\n" << parser << std::endl;
+    return help ? 0 : 1;
+  }
+  cfg.dir = positional[0];
+  // Waveform words are swapped in pairs.
+  cfg.mode3_trace += cfg.mode3_trace%2;
+  cfg.ddas_trace  += cfg.ddas_trace%2;
+  if(!generate && !run) {
+    generate = run = true;
+  }
+
+  const char* options[] = {argv[0], "-w"};
+  TGRUTOptions::Get(waves ? 2 : 1, (char**)options);
+
+  if(generate) {
+    Generate(cfg);
+  }
+  if(run) {
+    Run(cfg);
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+// Times GValue::Value(name) against a GValueHandle for the same value.
+//
+//   gvalueBench [nlookups]
+//
+// The handle resolves the name once and only again after the value table
+// has changed, so the second loop should be a plain load.  A value is
+// replaced half way through to check that the handle picks it up.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "GValue.h"
+
+int main(int argc, char** argv) {
+  long nlookups = argc > 1 ? std::atol(argv[1]) : 10000000;
+
+  GValue::SetReplaceValue("ATA_SHIFT", 0.25);
+  GValue::SetReplaceValue("BTA_SHIFT", -0.5);
+  GValue::SetReplaceValue("CRDC1_X_SLOPE", 2.54);
+  GValue::SetReplaceValue("CRDC1_X_OFFSET", -281.94);
+
+  GValueHandle ata_shift("ATA_SHIFT");
+  GValueHandle crdc1_x_slope("CRDC1_X_SLOPE");
+
+  double old_check = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(long i=0; i<nlookups; i++) {
+    old_check += GValue::Value("ATA_SHIFT") + GValue::Value("CRDC1_X_SLOPE");
+  }
+  auto mid = std::chrono::steady_clock::now();
+  double new_check = 0;
+  for(long i=0; i<nlookups; i++) {
+    new_check += ata_shift.Value() + crdc1_x_slope.Value();
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double old_time = std::chrono::duration<double>(mid - start).count();
+  double new_time = std::chrono::duration<double>(stop - mid).count();
+
+  GValue::SetReplaceValue("ATA_SHIFT", 1.5);
+  bool updated = ata_shift.Value() == 1.5;
+
+  std::cout << "lookups:       " << 2*nlookups << std::endl;
+  std::cout << "by name:       " << 2*nlookups/old_time << " lookups/s" << std::endl;
+  std::cout << "handle:        " << 2*nlookups/new_time << " lookups/s" << std::endl;
+  std::cout << "speedup:       " << old_time/new_time << std::endl;
+  std::cout << "checksums:     " << old_check << " " << new_check << std::endl;
+  std::cout << "update seen:   " << (updated ? "yes" : "NO") << std::endl;
+
+  return (updated && old_check == new_check) ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// Checks the compiled TInverseMap against TInverseMap::MapCalc, and times both.
+//
+//   inverseMapCheck invmap.inv [nevents] [degree]
+//
+// Random focal plane positions and angles, spread over the S800 focal plane,
+// are put through MapCalc one parameter at a time, as TS800Track did before,
+// and through the batch Calculate().  Exits non-zero if any of ata, bta,
+// yta or dta differs by more than the tolerance.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TInverseMap.h"
+
+namespace {
+  const double tolerance = 1e-5; // relative to the largest value of each parameter
+
+  float OldCalc(TInverseMap* map, int degree, int par, float xfp, float afp, float yfp, float bfp) {
+    float input[6];
+    input[0]  = - xfp / 1000.0;
+    input[1]  = - afp;
+    input[2]  =   yfp / 1000.0;
+    input[3]  =   bfp;
+    input[4]  =   0.0;
+    input[5]  =   0.0;
+    return map->MapCalc(degree, par, input);
+  }
+}
+
+int main(int argc, char** argv) {
+  if(argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " invmap.inv [nevents] [degree]" << std::endl;
+    return 1;
+  }
+  int nevents = argc > 2 ? std::atoi(argv[2]) : 1000000;
+  int degree  = argc > 3 ? std::atoi(argv[3]) : 6;
+
+  TInverseMap* map = TInverseMap::Get(argv[1]);
+  if(!map) {
+    return 1;
+  }
+
+  std::mt19937 gen(2021);
+  std::uniform_real_distribution<float> position(-250, 250); // mm
+  std::uniform_real_distribution<float> angle(-0.08, 0.08);  // rad
+  std::vector<float> xfp(nevents), afp(nevents), yfp(nevents), bfp(nevents);
+  for(int i=0; i<nevents; i++) {
+    xfp[i] = position(gen);
+    afp[i] = angle(gen);
+    yfp[i] = position(gen)/5;
+    bfp[i] = angle(gen);
+  }
+
+  // Parameter numbers of MapCalc, in the order ata, bta, yta, dta.
+  const int pars[4] = {0, 2, 1, 3};
+  const double scale[4] = {1, 1, 1000, 1};
+  const char* names[4] = {"ata", "bta", "yta", "dta"};
+  std::vector<float> old_out[4], new_out[4];
+  for(int p=0; p<4; p++) {
+    old_out[p].resize(nevents);
+    new_out[p].resize(nevents);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for(int i=0; i<nevents; i++) {
+    for(int p=0; p<4; p++) {
+      old_out[p][i] = scale[p]*OldCalc(map, degree, pars[p], xfp[i], afp[i], yfp[i], bfp[i]);
+    }
+  }
+  auto mid = std::chrono::steady_clock::now();
+  map->Calculate(degree, nevents, xfp.data(), afp.data(), yfp.data(), bfp.data(),
+                 new_out[0].data(), new_out[1].data(), new_out[2].data(), new_out[3].data());
+  auto stop = std::chrono::steady_clock::now();
+
+  bool failed = false;
+  for(int p=0; p<4; p++) {
+    double largest = 0;
+    double max_diff = 0;
+    for(int i=0; i<nevents; i++) {
+      largest  = std::max(largest, std::abs(double(old_out[p][i])));
+      max_diff = std::max(max_diff, std::abs(double(old_out[p][i]) - new_out[p][i]));
+    }
+    double relative = largest > 0 ? max_diff/largest : max_diff;
+    std::cout << names[p] << " max deviation: " << max_diff << " (" << relative << " relative)" << std::endl;
+    if(relative > tolerance) {
+      failed = true;
+    }
+  }
+
+  double old_time = std::chrono::duration<double>(mid - start).count();
+  double new_time = std::chrono::duration<double>(stop - mid).count();
+  std::cout << "events:        " << nevents << ", degree " << degree << std::endl;
+  std::cout << "MapCalc:       " << nevents/old_time << " events/s" << std::endl;
+  std::cout << "compiled:      " << nevents/new_time << " events/s" << std::endl;
+  std::cout << "speedup:       " << old_time/new_time << std::endl;
+
+  if(failed) {
+    std::cout << "FAILED, tolerance is " << tolerance << " relative" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+// Checks TKinematicsTable against TReaction, and times both.
+//
+//   kinematicsTableCheck [beam targ ebeam]
+//
+// Needs GRUTSYS to be set, for mass.dat.  For elastic scattering of beam on
+// targ, theta_cm, kinetic energy, beta and the partner angle of the ejectile
+// and the recoil are compared over the full range of lab angles.  Kinetic
+// energies are compared relative to the energy, or absolutely below 1 MeV.
+// Exits non-zero if any value differs by more than the tolerance.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "TKinematicsTable.h"
+
+namespace {
+  const double tolerance = 1e-5;
+}
+
+int main(int argc, char** argv) {
+  const char* beam = argc > 3 ? argv[1] : "78Kr";
+  const char* targ = argc > 3 ? argv[2] : "208Pb";
+  double ebeam     = argc > 3 ? std::atof(argv[3]) : 300.;
+
+  const TKinematicsTable& kin = TKinematicsTable::Get(beam, targ, beam, targ, ebeam);
+  TReaction& reac = kin.GetReaction();
+
+  const char* names[4] = { "theta_cm", "T_lab", "beta", "partner theta" };
+  double max_diff[4] = { 0, 0, 0, 0 };
+  int npoints = 0;
+  for(int part=2; part<4; part++) {
+    for(double theta=-3.14159; theta<3.14159; theta+=0.000731) {
+      double exact[4] = { reac.ConvertThetaLabToCm(theta, part),
+                          reac.GetTLab(theta, part),
+                          reac.AnalysisBetaFromThetaLab(theta, part),
+                          reac.ConvertThetaLab(theta, part, 5-part) };
+      double table[4] = { kin.ThetaCm(theta, part),
+                          kin.TLab(theta, part),
+                          kin.Beta(theta, part),
+                          kin.ConvertThetaLab(theta, part, 5-part) };
+      for(int q=0; q<4; q++) {
+        if(std::isnan(exact[q]) && std::isnan(table[q])) {
+          continue;
+        }
+        double diff = std::abs(exact[q] - table[q]);
+        if(q==1) {
+          diff /= std::max(1.0, std::abs(exact[q]));
+        }
+        if(!(diff <= max_diff[q])) {
+          max_diff[q] = diff;
+        }
+      }
+      npoints++;
+    }
+  }
+
+  const int ntimed = 2000000;
+  double check = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(int i=0; i<ntimed; i++) {
+    check += reac.GetTLab(-1 + i*1e-6, 2);
+  }
+  auto mid = std::chrono::steady_clock::now();
+  for(int i=0; i<ntimed; i++) {
+    check += kin.TLab(-1 + i*1e-6, 2);
+  }
+  auto stop = std::chrono::steady_clock::now();
+
+  double old_time = std::chrono::duration<double>(mid - start).count();
+  double new_time = std::chrono::duration<double>(stop - mid).count();
+
+  bool failed = false;
+  std::cout << beam << "(" << targ << ") at " << ebeam << " MeV, "
+            << npoints << " angles" << std::endl;
+  for(int q=0; q<4; q++) {
+    std::cout << "max deviation, " << names[q] << ": " << max_diff[q] << std::endl;
+    failed = failed || !(max_diff[q] <= tolerance);
+  }
+  std::cout << "TReaction:        " << 1e9*old_time/ntimed << " ns/call" << std::endl;
+  std::cout << "TKinematicsTable: " << 1e9*new_time/ntimed << " ns/call" << std::endl;
+  std::cout << "checksum:         " << check << std::endl;
+
+  if(failed) {
+    std::cout << "FAILED, tolerance is " << tolerance << std::endl;
+    return 1;
+  }
+  return 0;
+}
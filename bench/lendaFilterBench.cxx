@@ -0,0 +1,194 @@
+// Checks the allocation-free kernels in TLendaFilter against the std::vector
+// based filters, then times both.
+//
+//   lendaFilterBench [ntraces] [trace_length]
+//
+// Traces are synthetic, shaped like LENDA bar signals: a flat noisy
+// baseline, a fast rise and an exponential tail, peaking near the middle.
+// FastFilterKernel, FastFilterOpKernel and CFDKernel must give the same
+// values as FastFilter, FastFilterOp and CFD, for several filter lengths and
+// gaps, and the zero crossing kernels the same times as
+// GetZeroCrossingImprovedRMD and DoMatrixInversionAlgorithm.  Exits non-zero,
+// before any timing, if anything differs.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TLendaFilter.h"
+
+namespace {
+  const int FL = 3;
+  const int FG = 0;
+  const int CFD_delay = 2;
+  const int CFD_scale_factor = 0;
+
+  std::vector<std::vector<UShort_t> > MakeTraces(int ntraces, int length) {
+    std::mt19937 gen(12345);
+    std::normal_distribution<double> noise(0, 3);
+    std::uniform_real_distribution<double> amplitude(100, 8000);
+    std::uniform_real_distribution<double> jitter(-3, 3);
+
+    std::vector<std::vector<UShort_t> > traces(ntraces, std::vector<UShort_t>(length));
+    for(auto& trace : traces) {
+      double baseline = 400;
+      double amp = amplitude(gen);
+      double t0 = length/2 - 4 + jitter(gen);
+      for(int i = 0; i < length; i++) {
+        double value = baseline + noise(gen);
+        double t = i - t0;
+        if(t > 0) {
+          value += amp*(1 - std::exp(-t/1.5))*std::exp(-t/8.0);
+        }
+        trace[i] = value < 0 ? 0 : (value > 16383 ? 16383 : value);
+      }
+    }
+    return traces;
+  }
+
+  // Number of values of kernel that are not exactly those of vec.
+  int Differences(const std::vector<Double_t>& vec, const std::vector<Float_t>& kernel, int n) {
+    if(int(vec.size()) != n) {
+      return 1;
+    }
+    int failures = 0;
+    for(int i = 0; i < n; i++) {
+      failures += Float_t(vec[i]) != kernel[i];
+    }
+    return failures;
+  }
+
+  int CheckTraces(TLendaFilter& filter, std::vector<std::vector<UShort_t> >& traces, int length) {
+    const int filter_lengths[] = {1, 2, 3, 4, 8};
+    const int gaps[] = {0, 1, 3};
+    const int delays[] = {0, 1, 2, 5};
+    const int scales[] = {0, 1, 3};
+
+    int failures = 0;
+    std::vector<Double_t> fast_filter;
+    std::vector<Float_t> kernel_filter(length);
+    std::vector<Float_t> kernel_cfd(length);
+    for(size_t t = 0; t < traces.size() && t < 2000; t++) {
+      std::vector<UShort_t>& trace = traces[t];
+      for(int fl : filter_lengths) {
+        for(int fg : gaps) {
+          fast_filter.clear();
+          filter.FastFilterOp(trace, fast_filter, fl, fg);
+          int n = TLendaFilter::FastFilterOpKernel(trace.data(), length, fl, fg, kernel_filter.data());
+          failures += Differences(fast_filter, kernel_filter, n);
+
+          fast_filter.clear();
+          filter.FastFilter(trace, fast_filter, fl, fg);
+          n = TLendaFilter::FastFilterKernel(trace.data(), length, fl, fg, kernel_filter.data());
+          failures += Differences(fast_filter, kernel_filter, n);
+
+          for(int delay : delays) {
+            for(int scale : scales) {
+              std::vector<Double_t> cfd = filter.CFD(fast_filter, delay, scale);
+              TLendaFilter::CFDKernel(kernel_filter.data(), n, delay, scale, kernel_cfd.data());
+              failures += Differences(cfd, kernel_cfd, n);
+            }
+          }
+        }
+      }
+
+      fast_filter.clear();
+      filter.FastFilter(trace, fast_filter, FL, FG);
+      std::vector<Double_t> cfd = filter.CFD(fast_filter, CFD_delay, CFD_scale_factor);
+      TLendaFilter::FastFilterKernel(trace.data(), length, FL, FG, kernel_filter.data());
+      TLendaFilter::CFDKernel(kernel_filter.data(), length, CFD_delay, CFD_scale_factor, kernel_cfd.data());
+      Int_t begin = length/2 - 40;
+      Double_t resid;
+      Double_t kernel_resid;
+      Double_t linear = TLendaFilter::ZeroCrossingKernel(kernel_cfd.data(), begin, length, kernel_resid);
+      if(!std::isnan(linear)) {
+        Double_t vec_linear = filter.GetZeroCrossingImprovedRMD(cfd, begin, resid);
+        failures += vec_linear != linear || resid != kernel_resid;
+        failures += filter.DoMatrixInversionAlgorithm(cfd, (Int_t)linear) !=
+          TLendaFilter::ZeroCrossingCubicKernel(kernel_cfd.data(), length, (Int_t)linear);
+      }
+    }
+    return failures;
+  }
+
+  template<typename Func>
+  double TracesPerSecond(int ntraces, Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return ntraces/std::chrono::duration<double>(stop - start).count();
+  }
+}
+
+int main(int argc, char** argv) {
+  int ntraces = argc > 1 ? std::atoi(argv[1]) : 200000;
+  int length = argc > 2 ? std::atoi(argv[2]) : 200;
+  if(length < 100) {
+    std::cerr << "trace_length must be at least 100" << std::endl;
+    return 1;
+  }
+
+  std::vector<std::vector<UShort_t> > traces = MakeTraces(ntraces, length);
+  TLendaFilter filter;
+
+  int failures = CheckTraces(filter, traces, length);
+  if(failures) {
+    std::cout << "FAILED, " << failures << " kernel results differ from the std::vector path" << std::endl;
+    return 1;
+  }
+
+  double legacy_sum = 0;
+  double legacy_rate = TracesPerSecond(ntraces, [&]() {
+      std::vector<Double_t> fast_filter;
+      for(auto& trace : traces) {
+        fast_filter.clear();
+        filter.FastFilter(trace, fast_filter, FL, FG);
+        std::vector<Double_t> cfd = filter.CFD(fast_filter, CFD_delay, CFD_scale_factor);
+        Int_t max_spot = 0;
+        filter.GetMaxPulseHeight(trace, max_spot);
+        Int_t start = length/2 - 40;
+        Double_t time = filter.GetZeroCubic(cfd, start);
+        Double_t energy = filter.GetEnergy(trace, max_spot);
+        if(!std::isnan(time)) {
+          legacy_sum += time + energy;
+        }
+      }
+    });
+
+  double kernel_sum = 0;
+  double kernel_rate = TracesPerSecond(ntraces, [&]() {
+      std::vector<Float_t> fast_filter(length);
+      std::vector<Float_t> cfd(length);
+      for(auto& trace : traces) {
+        TLendaFilter::FastFilterKernel(trace.data(), length, FL, FG, fast_filter.data());
+        TLendaFilter::CFDKernel(fast_filter.data(), length, CFD_delay, CFD_scale_factor, cfd.data());
+        Int_t max_spot = 0;
+        for(int i = 1; i < length; i++) {
+          if(trace[i] > trace[max_spot]) {
+            max_spot = i;
+          }
+        }
+        Double_t resid;
+        Double_t linear = TLendaFilter::ZeroCrossingKernel(cfd.data(), length/2 - 40, length/2 + 40, resid);
+        Double_t time = std::isnan(linear) ? linear
+          : TLendaFilter::ZeroCrossingCubicKernel(cfd.data(), length, (Int_t)linear);
+        Double_t energy = TLendaFilter::GetEnergy(trace.data(), length, max_spot);
+        if(!std::isnan(time)) {
+          kernel_sum += time + energy;
+        }
+      }
+    });
+
+  std::cout << "traces:        " << ntraces << " x " << length << " samples" << std::endl;
+  std::cout << "kernels match the std::vector path on " << std::min(ntraces, 2000) << " traces" << std::endl;
+  std::cout << "vector path:   " << legacy_rate << " traces/s" << std::endl;
+  std::cout << "kernel path:   " << kernel_rate << " traces/s" << std::endl;
+  std::cout << "speedup:       " << kernel_rate/legacy_rate << std::endl;
+  // Printed so neither loop can be optimised away.
+  std::cout << "checksums:     " << legacy_sum << " " << kernel_sum << std::endl;
+
+  return 0;
+}
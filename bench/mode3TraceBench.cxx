@@ -0,0 +1,169 @@
+// Times Mode3 waveform processing on a GEB file, comparing the old
+// copy-and-swap path with TMode3TraceEngine.
+//
+//   mode3TraceBench file.dat [max_events] [repeats]
+//
+// All Mode3 fragments are read into memory first, so only the trace
+// handling is timed.  Both paths compute a baseline, pickoff and
+// trapezoid for every waveform.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "TGEBEvent.h"
+#include "TGRUTOptions.h"
+#include "TMode3Hit.h"
+#include "TMode3TraceEngine.h"
+#include "TRawEvent.h"
+#include "TRawSource.h"
+
+namespace {
+  const int baseline_samples = 20;
+  const int pickoff_samples  = 20;
+  const int rise = 20;
+  const int gap  = 10;
+
+  // The waveform handling of TMode3Hit::BuildFrom before TMode3TraceEngine.
+  std::vector<Short_t> OldWave(const TSmartBuffer& payload) {
+    auto header = (TRawEvent::GEBMode3Head*)payload.GetData();
+    size_t wave_bytes = header->GetLength()*4 - sizeof(TRawEvent::GEBMode3Head) + 4
+      - sizeof(TRawEvent::GEBMode3Data);
+    size_t wavesize = wave_bytes/sizeof(short);
+    std::vector<Short_t> waveform(wavesize);
+    memcpy((char*)&waveform[0], payload.GetData() + sizeof(TRawEvent::GEBMode3Head)
+           + sizeof(TRawEvent::GEBMode3Data), wave_bytes);
+    for(unsigned int i=0; i<wavesize; i+=2){
+      short tmp      = TRawEvent::SwapShort(waveform[i+1]);
+      waveform[i+1] = TRawEvent::SwapShort(waveform[i]);
+      waveform[i]   = tmp;
+    }
+    return waveform;
+  }
+
+  double OldAnalysis(const std::vector<Short_t>& wave) {
+    int n = wave.size();
+    if(n < 2*rise + gap) {
+      return 0;
+    }
+    double baseline = 0;
+    for(int i=0; i<baseline_samples; i++) {
+      baseline += wave[i];
+    }
+    baseline /= baseline_samples;
+    double pickoff = 0;
+    for(int i=n-pickoff_samples; i<n; i++) {
+      pickoff += wave[i];
+    }
+    pickoff = pickoff/pickoff_samples - baseline;
+    double best = -1e99;
+    for(int i=2*rise+gap; i<=n; i++) {
+      double value = 0;
+      for(int j=i-rise; j<i; j++) {
+        value += wave[j];
+      }
+      for(int j=i-2*rise-gap; j<i-rise-gap; j++) {
+        value -= wave[j];
+      }
+      best = std::max(best, value/rise);
+    }
+    return baseline + pickoff + best;
+  }
+
+  template<typename Func>
+  double Seconds(Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+  }
+}
+
+int main(int argc, char** argv) {
+  if(argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " file.dat [max_events] [repeats]" << std::endl;
+    return 1;
+  }
+  long max_events = argc > 2 ? std::atol(argv[2]) : -1;
+  int repeats = argc > 3 ? std::atoi(argv[3]) : 5;
+
+  // TMode3Hit::BuildFrom only keeps the waveform with -w.
+  const char* options[] = {argv[0], "-w"};
+  TGRUTOptions::Get(2, (char**)options);
+
+  TRawEventSource* source = TRawEventSource::EventSource(argv[1]);
+  std::vector<std::vector<TSmartBuffer> > events;
+  size_t total_bytes = 0;
+  size_t total_hits = 0;
+  TRawEvent raw;
+  while(source->Read(raw) > 0 && (max_events < 0 || long(events.size()) < max_events)) {
+    TGEBEvent geb(raw);
+    if(geb.GetEventType() != 2) {
+      continue;
+    }
+    TGEBMode3Event built(geb);
+    std::vector<TSmartBuffer> fragments;
+    for(size_t i=0; i<built.NumFragments(); i++) {
+      fragments.push_back(built.GetFragment(i).GetPayloadBuffer());
+      total_bytes += fragments.back().GetSize();
+    }
+    total_hits += fragments.size();
+    events.push_back(fragments);
+  }
+  delete source;
+
+  if(events.empty()) {
+    std::cerr << "No Mode3 events found in " << argv[1] << std::endl;
+    return 1;
+  }
+
+  double old_check = 0;
+  double old_time = Seconds([&]() {
+      for(int r=0; r<repeats; r++) {
+        for(auto& fragments : events) {
+          for(auto& payload : fragments) {
+            std::vector<Short_t> wave = OldWave(payload);
+            old_check += OldAnalysis(wave);
+          }
+        }
+      }
+    });
+
+  double new_check = 0;
+  TMode3TraceEngine engine;
+  engine.SetBaselineSamples(baseline_samples);
+  engine.SetPickoffSamples(pickoff_samples);
+  engine.SetTrapezoid(rise, gap);
+  std::vector<TMode3Hit> hits;
+  double new_time = Seconds([&]() {
+      for(int r=0; r<repeats; r++) {
+        for(auto& fragments : events) {
+          hits.resize(fragments.size());
+          for(size_t i=0; i<fragments.size(); i++) {
+            TSmartBuffer buf = fragments[i];
+            hits[i].BuildFrom(buf);
+          }
+          engine.Process(hits);
+          for(size_t i=0; i<engine.GetNumResults(); i++) {
+            const TMode3TraceResult& result = engine.GetResult(i);
+            if(engine.GetWaveSize(i) >= size_t(2*rise + gap)) {
+              new_check += result.baseline + result.pickoff + result.trapezoid;
+            }
+          }
+        }
+      }
+    });
+
+  double mb = repeats*total_bytes/1e6;
+  std::cout << "events:        " << events.size() << ", " << total_hits << " waveforms" << std::endl;
+  std::cout << "old path:      " << repeats*total_hits/old_time << " waveforms/s, "
+            << mb/old_time << " MB/s" << std::endl;
+  std::cout << "engine:        " << repeats*total_hits/new_time << " waveforms/s, "
+            << mb/new_time << " MB/s" << std::endl;
+  std::cout << "speedup:       " << old_time/new_time << std::endl;
+  std::cout << "checksums:     " << old_check << " " << new_check << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+// Times the construction of TNucleus objects from the in-memory mass table.
+//
+//   nucleusBench [nconstruct]
+//
+// Needs GRUTSYS to be set, for mass.dat and the .sou files.  The masses of a
+// few nuclei are first checked against a scan of mass.dat, the way every
+// TNucleus used to be built, then nconstruct nuclei are built by symbol and
+// by Z and N, and nconstruct/100 of 152Eu, which copies its transition list.
+// The old scan is timed on nconstruct/1000 lookups for comparison.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "TNucleus.h"
+
+namespace {
+  // Mass excess in keV of element (ex. 78Kr), scanned from mass.dat.
+  double ScanMassExcess(const std::string& element) {
+    std::ifstream infile(std::string(getenv("GRUTSYS")) + "/libraries/SourceData/mass.dat");
+    std::string line;
+    while(getline(infile,line)) {
+      if(line.length() < 1)
+        continue;
+      std::stringstream ss(line);
+      int n, z;
+      std::string sym_name;
+      double mass;
+      ss >> n >> z >> sym_name >> mass;
+      if(strcasecmp(element.c_str(), sym_name.c_str()) == 0)
+        return mass;
+    }
+    return std::sqrt(-1);
+  }
+
+  double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main(int argc, char** argv) {
+  long nconstruct = argc > 1 ? std::atol(argv[1]) : 1000000;
+
+  bool ok = true;
+  const char* names[] = { "p", "a", "12C", "c12", "48Ca", "78Kr", "Kr78", "152Eu", "208Pb", "238U" };
+  for(const char* name : names) {
+    TNucleus nuc(name);
+    std::string element = std::to_string(nuc.GetA()) + nuc.GetSymbol();
+    double expected = ScanMassExcess(element)/1000.;
+    if(!(std::abs(nuc.GetMassExcess() - expected) < 1e-9)) {
+      std::cout << name << ": mass excess " << nuc.GetMassExcess()
+                << " MeV, mass.dat has " << expected << " MeV" << std::endl;
+      ok = false;
+    }
+    TNucleus byzn(nuc.GetZ(), nuc.GetN());
+    if(byzn.GetMass() != nuc.GetMass()) {
+      std::cout << name << ": mass " << nuc.GetMass() << " MeV by symbol, "
+                << byzn.GetMass() << " MeV by Z and N" << std::endl;
+      ok = false;
+    }
+  }
+  int ntransitions = TNucleus("152Eu").GetNTransitions();
+  if(ntransitions == 0) {
+    std::cout << "152Eu: no transitions read from eu152.sou" << std::endl;
+    ok = false;
+  }
+
+  double check = 0;
+  long nold = std::max(1L, nconstruct/1000);
+  auto start = std::chrono::steady_clock::now();
+  for(long i=0; i<nold; i++) {
+    check += ScanMassExcess("78Kr");
+  }
+  double old_time = Seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for(long i=0; i<nconstruct; i++) {
+    TNucleus nuc("78Kr");
+    check += nuc.GetMass();
+  }
+  double symbol_time = Seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for(long i=0; i<nconstruct; i++) {
+    TNucleus nuc(36, 42);
+    check += nuc.GetMass();
+  }
+  double zn_time = Seconds(start);
+
+  long nsource = std::max(1L, nconstruct/100);
+  start = std::chrono::steady_clock::now();
+  for(long i=0; i<nsource; i++) {
+    TNucleus nuc("152Eu");
+    check += nuc.GetNTransitions();
+  }
+  double source_time = Seconds(start);
+
+  std::cout << "mass.dat scan:  " << 1e6*old_time/nold << " us/lookup" << std::endl;
+  std::cout << "by symbol:      " << 1e9*symbol_time/nconstruct << " ns/nucleus ("
+            << nconstruct << " in " << symbol_time << " s)" << std::endl;
+  std::cout << "by Z and N:     " << 1e9*zn_time/nconstruct << " ns/nucleus ("
+            << nconstruct << " in " << zn_time << " s)" << std::endl;
+  std::cout << "152Eu:          " << 1e9*source_time/nsource << " ns/nucleus, "
+            << ntransitions << " transitions" << std::endl;
+  std::cout << "checksum:       " << check << std::endl;
+
+  if(!ok) {
+    std::cout << "FAILED" << std::endl;
+    return 1;
+  }
+  return 0;
+}
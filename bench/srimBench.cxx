@@ -0,0 +1,90 @@
+// Compares the TSRIM range-energy table with the 1 um dE/dx stepper, and times both.
+//
+//   srimBench a_in_si [thickness_um] [nparticles]
+//
+// Needs GRUTSYS to be set, the file is read from $GRUTSYS/libraries/TSRIM.
+// Energies are spread over the upper 90% of the file.  A 1/64 um step is
+// used as the reference for both, since the 1 um stepper has its own error.
+// Both go through GetAdjustedEnergy, the stepper with the TSpline3 of the
+// file, as GetEnergy always has.  The table is also taken back up through
+// a negative thickness, which must give the energy it started from.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "TSRIM.h"
+
+namespace {
+  template<typename Func>
+  double Seconds(Func func) {
+    auto start = std::chrono::steady_clock::now();
+    func();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count();
+  }
+}
+
+int main(int argc, char** argv) {
+  if(argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " srimfile [thickness_um] [nparticles]" << std::endl;
+    return 1;
+  }
+  double thickness = argc > 2 ? std::atof(argv[2]) : 10.0;
+  int nparticles   = argc > 3 ? std::atoi(argv[3]) : 10000;
+
+  TSRIM srim(argv[1]);
+  if(!srim.GetEnergyLossGraph()) {
+    return 1;
+  }
+
+  std::mt19937 gen(2021);
+  std::uniform_real_distribution<double> log_energy(std::log(srim.GetEmax()) - std::log(10.0),
+                                                    std::log(srim.GetEmax()));
+  std::vector<double> energy(nparticles), distance(nparticles, thickness);
+  for(int i=0; i<nparticles; i++) {
+    energy[i] = std::exp(log_energy(gen));
+  }
+
+  std::vector<double> stepped(nparticles), table(nparticles);
+  srim.GetAdjustedEnergy(nparticles, energy.data(), distance.data(), table.data()); // warm up
+  double step_time = Seconds([&]() {
+      for(int i=0; i<nparticles; i++) {
+        stepped[i] = srim.GetAdjustedEnergy(energy[i], distance[i], 1.0);
+      }
+    });
+  double table_time = Seconds([&]() {
+      srim.GetAdjustedEnergy(nparticles, energy.data(), distance.data(), table.data());
+    });
+
+  // Reference on a subset, it is slow.
+  int nref = std::min(nparticles, 200);
+  double max_step_diff = 0, max_table_diff = 0;
+  for(int i=0; i<nref; i++) {
+    double reference = srim.GetAdjustedEnergy(energy[i], distance[i], 1.0/64);
+    double lost = std::max(energy[i] - reference, 1e-9);
+    max_step_diff  = std::max(max_step_diff,  std::abs(stepped[i] - reference)/lost);
+    max_table_diff = std::max(max_table_diff, std::abs(table[i]   - reference)/lost);
+  }
+
+  double max_return_diff = 0;
+  for(int i=0; i<nparticles; i++) {
+    double back = srim.GetAdjustedEnergy(table[i], -distance[i]);
+    if(energy[i] < srim.GetEmax() && table[i] > 0) {
+      max_return_diff = std::max(max_return_diff, std::abs(back - energy[i])/energy[i]);
+    }
+  }
+
+  std::cout << "particles:     " << nparticles << ", " << thickness << " um" << std::endl;
+  std::cout << "1 um stepper:  " << nparticles/step_time << " particles/s, "
+            << max_step_diff << " max error relative to energy lost" << std::endl;
+  std::cout << "range table:   " << nparticles/table_time << " particles/s, "
+            << max_table_diff << " max error relative to energy lost" << std::endl;
+  std::cout << "speedup:       " << step_time/table_time << std::endl;
+  std::cout << "round trip:    " << max_return_diff << " max error relative to energy" << std::endl;
+
+  return 0;
+}
@@ -1,6 +1,17 @@
 // To make a new filter, copy this file under a new name in the "filter" directory.
 // The "FilterCondition" function should return a boolean value.
 // The boolean indicates whether the event should be kept or not.
+//
+// An optional "PreFilterCondition" is called first, before the event is
+//   unpacked.  obj.GetFragmentCount(kDetectorSystems::GRETINA) and
+//   obj.GetRawData() look at the raw fragments, and obj.GetDetector<T>()
+//   unpacks only T.  Events it rejects are never unpacked, but with it the
+//   unpacking of the others moves onto the filter thread.
+//
+//   extern "C"
+//   bool PreFilterCondition(TRuntimeObjects& obj) {
+//     return obj.GetFragmentCount(kDetectorSystems::GRETINA) >= 2;
+//   }
 
 #include "TRuntimeObjects.h"
 
@@ -6,6 +6,7 @@
 #include "TObject.h"
 
 #include "TSmartBuffer.h"
+#include "TTraceView.h"
 
 #define CHANNELIDMASK             0xF  // Bits 0-3 inclusive
 #define SLOTIDMASK               0xF0  // Bits 4-7 inclusive
@@ -52,6 +53,7 @@ public:
     }
     if(GetTraceLength()){
       trace = (unsigned short*)buf.GetData();
+      trace_buf = buf;
       buf.Advance(GetTraceLength()*sizeof(unsigned short));
     }
   }
@@ -150,6 +152,7 @@ public:
   int GetEnergy()                  const { return (header->energy_tracelength & LOWER16BITMASK);       }
   int GetTraceLength()             const { return (header->energy_tracelength & BIT30TO16MASK) >> 16; }
   int GetTraceOverflow()           const { return (header->energy_tracelength & BIT31MASK) >> 31; }
+  TTraceView GetTraceView()        const { return TTraceView(trace_buf, GetTraceLength()); }
   int GetEnergySum(int i)	   const { if(HasEnergySum()) return energy_sum->energy_sum[i];
                                            else return -2;					       }
   int GetQDCSum(int i)	           const { if(HasQDCSum()) return qdc_sum->qdc_sum[i];
@@ -182,6 +185,7 @@ public:
 private:
   HeaderType* header;
   TSmartBuffer buf;
+  TSmartBuffer trace_buf;
   ClassDef(TDDASEvent, 0);
 };
 #endif /* _DDASDATAFORMAT_H_ */
@@ -0,0 +1,96 @@
+#ifndef GFITPOOL_H
+#define GFITPOOL_H
+
+#include <string>
+#include <vector>
+
+class TH1;
+
+/// Fits many independent peaks at once, on a pool of threads.
+/**
+  Each task is a window of a 1D histogram, or of one row or column of a
+    2D histogram.  Every thread has its own fit function and its own
+    histogram, which is refilled with the window of each task it takes.
+    Neither is kept in gDirectory or gROOT, and the source histograms are
+    only read, so nothing is left behind by a fit.
+
+  Every fit has its own ROOT::Fit::Fitter and Minuit2 minimizer, with its
+    own options, so the global TVirtualFitter and its settings are never
+    used.  Without Minuit2 the fits are done one at a time.
+
+  The photopeak model is that of GPeak, and the gaus model that of GGaus.
+    kAnalyticPhotoPeak fits the photopeak model with GPhotoPeakFitter
+    rather than TF1, seeding it from each window.
+
+  \code
+  GFitPool pool;
+  for(int y=1; y<=gains->GetNbinsY(); y++) {
+    pool.AddProjection(y, gains, TH1::kXaxis, y, 1320, 1345);
+  }
+  std::vector<GFitPool::Result> results = pool.Fit();
+  GFitPool::SetGains(results, 1332.5);
+  TChannel::WriteCalFile("gains.cal");
+  \endcode
+ */
+class GFitPool {
+public:
+  enum EModel { kPhotoPeak, kGaus, kAnalyticPhotoPeak };
+
+  struct Result {
+    int index;              ///< As given to Add.
+    unsigned int address;   ///< TChannel address, the index unless set.
+    bool valid;             ///< False if the fit failed, or the window had too few counts.
+    double low;
+    double high;
+    double counts;          ///< Counts in the window.
+    double centroid;
+    double centroid_err;
+    double fwhm;
+    double fwhm_err;
+    double area;            ///< Area of the fit peak.
+    double area_err;
+    double sum;             ///< Counts in the window, less the fit background.
+    double sum_err;
+    double chi2;
+    int ndf;
+  };
+
+  /// nthreads of 0 uses every core.
+  explicit GFitPool(EModel model=kPhotoPeak, int nthreads=0);
+
+  /// Adds the window low to high of hist.
+  void Add(int index, const TH1* hist, double low, double high);
+  /// Adds the window low to high of row (axis TH1::kXaxis) or column
+  /// (TH1::kYaxis) bin of the 2D hist, a TH2 or a GH2.
+  void AddProjection(int index, const TH1* hist, int axis, int bin, double low, double high);
+
+  size_t Size() const { return fTasks.size(); }
+  void Clear() { fTasks.clear(); }
+
+  /// Fits every task, windows with fewer than min_counts are left invalid.
+  /// The results are in the order the tasks were added.
+  std::vector<Result> Fit(double min_counts=10);
+
+  /// Sets the gain of the TChannel at the address of each valid result,
+  /// so the centroid is at energy.  Returns the number of channels set.
+  static int SetGains(const std::vector<Result>& results, double energy);
+  static void Print(const std::vector<Result>& results);
+
+private:
+  struct Task {
+    int index;
+    const TH1* hist;
+    int axis;
+    int bin;
+    double low;
+    double high;
+  };
+
+  class Worker;
+
+  EModel fModel;
+  int fThreads;
+  std::vector<Task> fTasks;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef GPHOTOPEAKFITTER_H
+#define GPHOTOPEAKFITTER_H
+
+#include <vector>
+
+class TH1;
+
+/// Likelihood fit of GRootFunctions::PhotoPeakBG, with analytic gradients.
+/**
+  The model and its parameters are those of GPeak: a gaussian and a
+    skewed gaussian sharing height, centroid and sigma, a step under the
+    peak and a flat background.  The model and its derivatives with
+    respect to every parameter are evaluated together over all bins of
+    the window, and the Poisson likelihood is minimised by
+    Levenberg-Marquardt, with the Fisher information of the analytic
+    Jacobian in place of the second derivatives.  The covariance is the
+    inverse of the Fisher information at the minimum.
+
+  Seed() guesses every parameter and its limits from the window: the
+    background and step from its ends, the height and centroid from the
+    highest bin above the background, and sigma from the width at half
+    height.  A centroid found beforehand, by TSpectrum for example, can
+    be given to pick the peak.
+
+  GPeak::Fit uses it with the "analytic" option, or always if
+    GRUT.PeakFitter is set to analytic; GFitPool::kAnalyticPhotoPeak
+    fits many windows with it at once.
+ */
+class GPhotoPeakFitter {
+public:
+  enum EParameter { kHeight, kCentroid, kSigma, kR, kBeta, kStep, kOffset, kNPars };
+
+  /// The GPeak names of the parameters.
+  static const char* ParName(int i);
+
+  /// Model at n points, and its derivatives (n rows of kNPars) if jacobian is not null.
+  static void Evaluate(const double* x, int n, const double* par, double* value, double* jacobian=0);
+
+  GPhotoPeakFitter();
+
+  /// Bin centres and contents of the window to fit.
+  void SetData(const double* x, const double* counts, int n);
+  /// The bins of hist from low to high.
+  void SetData(const TH1* hist, double low, double high);
+  int GetN() const { return fX.size(); }
+
+  /// Guesses every parameter and its limits from the data.
+  bool Seed(double centroid=0);
+
+  void SetParameter(int i, double value)         { fPar.at(i) = value; }
+  void SetParLimits(int i, double low, double high);
+  void FixParameter(int i, double value)         { fPar.at(i) = value; fFixed.at(i) = true; }
+  void ReleaseParameter(int i)                   { fFixed.at(i) = false; }
+
+  /// Fits from the parameters set, true if it converged.
+  bool Fit(int max_iterations=200);
+
+  double GetParameter(int i) const    { return fPar.at(i); }
+  double GetParError(int i) const     { return fErr.at(i); }
+  double GetCovariance(int i, int j) const { return fCov.at(i*kNPars + j); }
+  const double* GetParameters() const { return fPar.data(); }
+  /// Row-major kNPars x kNPars, zero for fixed parameters.
+  const double* GetCovariance() const { return fCov.data(); }
+
+  /// Likelihood ratio chi^2, 2*sum(mu - n + n*log(n/mu)).
+  double GetChisquare() const { return fChi2; }
+  int GetNDF() const          { return fNDF; }
+  int GetIterations() const   { return fIterations; }
+  bool IsValid() const        { return fValid; }
+
+  double Eval(double x) const;
+
+private:
+  double NegLogLikelihood(const std::vector<double>& par, std::vector<double>& mu) const;
+  void Clamp(std::vector<double>& par) const;
+
+  std::vector<double> fX;
+  std::vector<double> fN;
+
+  std::vector<double> fPar;
+  std::vector<double> fLow;
+  std::vector<double> fHigh;
+  std::vector<bool>   fFixed;
+
+  std::vector<double> fErr;
+  std::vector<double> fCov;
+  double fChi2;
+  int fNDF;
+  int fIterations;
+  bool fValid;
+};
+
+#endif
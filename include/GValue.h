@@ -1,11 +1,22 @@
 #ifndef TGRUTVARIABLE_H
 #define TGRUTVARIABLE_H
 
+#include <atomic>
+#include <cmath>
 #include <map>
+#include <string>
 
 #include "TList.h"
 #include "TNamed.h"
 
+/// A named calibration value, read from .val files or root files.
+/**
+  The values are kept in a map by name, which is locked, so that values
+    can be looked up by a thread sorting events while a .val file is read.
+  A GValue is never removed from the map, and reading a file updates the
+    existing object.  Its value is read and set without any locking, so a
+    value changed while events are sorted may not be seen right away.
+ */
 class GValue : public TNamed {
 public:
   enum EPriority {
@@ -20,10 +31,10 @@ public:
   GValue(const char *name,double value, GValue::EPriority priority=kUser);
   GValue(const GValue &val);
 
-  double GetValue() { return fValue; }
+  double GetValue() const { return fValue; }
   const char *GetInfo()   const { return info.c_str(); }
 
-  void SetValue(double value) { fValue = value; }
+  void SetValue(double value) { fValue = value; fGeneration++; }
   void SetInfo(const char *temp) { info.assign(temp); }
 
   static int ReadValFile(const char *filename="",Option_t *opt="replace");
@@ -38,14 +49,7 @@ public:
   static double Value(std::string);
   static std::string Info(std::string);
 
-  static TList* AllValues() {
-    TList* output = new TList;
-    output->SetOwner(false);
-    for(auto& item : fValueVector){
-      output->Add(item.second);
-    }
-    return output;
-  }
+  static TList* AllValues();
 
 
   //Add value into static vector fValueVector
@@ -59,7 +63,11 @@ public:
   virtual void Copy(TObject &obj) const;
   //virtual bool Notify();
 
-  static int Size()  { return fValueVector.size(); }
+  static int Size();
+  // Locked lookup of an upper-case name, used by GValueHandle.
+  static GValue* Resolve(const std::string& upper_name);
+  // Changes whenever any value is added or set, so cached values can be checked cheaply.
+  static unsigned int Generation() { return fGeneration; }
   std::string PrintToString() const;
   static std::string  WriteToBuffer(Option_t *opt="");
 
@@ -71,6 +79,7 @@ private:
   std::string info;
   static GValue *fDefaultValue;
   static std::map<std::string,GValue*> fValueVector;
+  static std::atomic<unsigned int> fGeneration; //!
   static int  ParseInputData(const std::string input, EPriority priority,
 			     Option_t *opt="");
   static void trim(std::string *, const std::string &trimChars=" \f\n\r\t\v");
@@ -78,4 +87,52 @@ private:
   ClassDef(GValue,1);
 };
 
+/// A GValue name, resolved once.
+/**
+  Meant for values read per event or per hit, kept as a static:
+  \code
+  static GValueHandle crdc1_x_slope("CRDC1_X_SLOPE");
+  double slope = crdc1_x_slope.Value();
+  \endcode
+
+  Once the GValue exists, the handle points straight at it, so a read is a
+    single load without any locking, and sees the value change when a new
+    .val file is read.
+  The pointer and the generation it was looked up in are atomic, so one
+    handle can be shared by threads, as a function-static handle in a
+    detector getter is when a chain is replayed on several threads.
+  GValue objects are never removed, and reading a file updates the
+    existing object, so the pointer stays valid.
+  Until the GValue exists, Value() returns NaN, like GValue::Value, and
+    the name is looked up again only when a value has been added.
+ */
+class GValueHandle {
+public:
+  GValueHandle(const char* name);
+
+  double Value() const {
+    GValue* value = fValue.load(std::memory_order_acquire);
+    if(!value && fGeneration.load(std::memory_order_relaxed) != GValue::Generation()) {
+      value = Resolve();
+    }
+    return value ? value->GetValue() : std::sqrt(-1);
+  }
+
+  /// Value, or def if the value is not set.
+  double Value(double def) const {
+    double value = Value();
+    return std::isnan(value) ? def : value;
+  }
+
+  bool IsSet() const { return !std::isnan(Value()); }
+  const std::string& GetName() const { return fName; }
+
+private:
+  GValue* Resolve() const;
+
+  std::string fName;
+  mutable std::atomic<GValue*> fValue;
+  mutable std::atomic<unsigned int> fGeneration;
+};
+
 #endif
@@ -5,6 +5,8 @@
 #include <atomic>
 #include <condition_variable>
 #include <thread>
+
+#include "TStageMetrics.h"
 #endif
 
 #include <string>
@@ -51,6 +53,16 @@ public:
 
   static void Print();
 
+#ifndef __CINT__
+  const TStageMetrics& Metrics() const { return metrics; }
+#endif
+  /// Metrics of every stage, as the JSON served by TMetricsServer.
+  static std::string MetricsJson();
+  /// Table of the stage metrics, with the busiest stage named.
+  static void PrintProfile();
+  /// Whether StopAll prints the profile.
+  static void SetProfile(bool profile) { profile_at_exit = profile; }
+
 #ifndef __CINT__
   static std::thread status_thread;
 #endif
@@ -60,6 +72,7 @@ public:
   static void join_status_thread();
   static void status_out_loop();
   static void status_out();
+  static bool profile_at_exit;
 
 
 protected:
@@ -87,6 +100,7 @@ private:
   std::atomic_bool paused;
   std::condition_variable paused_wait;
   std::mutex pause_mutex;
+  TStageMetrics metrics;
 #endif
 
   ClassDef(StoppableThread, 1);
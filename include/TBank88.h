@@ -17,6 +17,7 @@ public:
 
   virtual void Copy(TObject& obj) const;
   virtual void Clear(Option_t *opt = "");
+  virtual void MaterializeTraces();
   //virtual void Compare(const TObject&) const;
   virtual void Print(Option_t *opt = "") const;
 
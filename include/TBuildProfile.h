@@ -0,0 +1,65 @@
+#ifndef _TBUILDPROFILE_H_
+#define _TBUILDPROFILE_H_
+
+#include <string>
+#include <vector>
+
+#include "TNamed.h"
+
+#include "TGRUTTypes.h"
+
+/// Time spent building the hits of each detector system.
+/**
+  TUnpackedEvent counts, for every detector system it builds, the calls
+    to Build, the raw fragments and bytes handed to it, and the hits it
+    made.  One call in GRUT.BuildProfileSample (16 by default) of each
+    system is timed with the CPU timestamp counter, and the total time
+    scaled up from those.  The counters are always on, and cost a few
+    atomic increments per system per event.
+
+  Snapshot() copies the counters so far into a TBuildProfile, which is
+    written to the histogram file as "BuildProfile":
+  \code
+  BuildProfile->Print();
+  \endcode
+ */
+class TBuildProfile : public TNamed {
+public:
+  TBuildProfile();
+  ~TBuildProfile() { }
+
+  /// Counts a call to build the system, and returns its start time if it is to be timed, or 0.
+  static unsigned long long Start(kDetectorSystems system);
+  static void Stop(kDetectorSystems system, unsigned long long start,
+                   size_t fragments, size_t bytes, size_t hits);
+
+  /// The counters so far, of each system built at least once.
+  static TBuildProfile Snapshot();
+  /// Snapshot as a JSON array.
+  static std::string Json();
+
+  size_t GetNSystems() const { return fSystems.size(); }
+  const std::string& GetSystem(size_t i) const { return fSystems.at(i); }
+  Long64_t GetCalls(size_t i)     const { return fCalls.at(i); }
+  Long64_t GetFragments(size_t i) const { return fFragments.at(i); }
+  Long64_t GetBytes(size_t i)     const { return fBytes.at(i); }
+  Long64_t GetHits(size_t i)      const { return fHits.at(i); }
+  /// Estimated seconds in Build, scaled up from the timed calls.
+  double GetSeconds(size_t i)     const { return fSeconds.at(i); }
+
+  virtual void Print(Option_t* opt = "") const;
+  virtual void Clear(Option_t* opt = "");
+
+private:
+  std::vector<std::string> fSystems;
+  std::vector<Long64_t> fCalls;
+  std::vector<Long64_t> fFragments;
+  std::vector<Long64_t> fBytes;
+  std::vector<Long64_t> fHits;
+  std::vector<double> fSeconds;
+  int fSampleInterval;
+
+  ClassDef(TBuildProfile, 1);
+};
+
+#endif /* _TBUILDPROFILE_H_ */
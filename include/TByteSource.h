@@ -87,6 +87,18 @@ private:
 };
 
 
+class TZstdByteSource : public TPipeByteSource {
+public:
+  TZstdByteSource(const std::string& filename);
+  ~TZstdByteSource() { }
+
+  virtual std::string SourceDescription(bool long_description=false) const;
+
+private:
+  std::string fFilename;
+};
+
+
 class TRingByteSource : public TPipeByteSource {
 public:
   TRingByteSource(const std::string& ringname);
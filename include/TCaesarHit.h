@@ -58,7 +58,8 @@ public:
       track = (TVector3*)&BeamUnitVec;
     }
     if (beta == -1){
-      beta = GValue::Value("BETA");
+      static GValueHandle beta_value("BETA");
+      beta = beta_value.Value();
     }
 
     if (!beta || beta == -1){
@@ -2,6 +2,8 @@
 #define _TCALIBRATORS_H_
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include <TNamed.h>
 #include <TGraphErrors.h>
@@ -40,9 +42,12 @@ public:
   int AddData(TH1* source_data, TNucleus* source,
                double sigma=2.0,double threshold=0.05,bool rm_bg=false,double error=0.001);
 
+  /// Sets the energy coefficients of channel from the last Fit,
+  /// shifted to apply to the charge less the channel pedestal.
   void UpdateTChannel(TChannel* channel);
 
-  void Fit(int order=1,bool zerozero=false); 
+  /// opt "Q" fits quietly, and prints nothing.
+  void Fit(int order=1,bool zerozero=false,Option_t *opt=""); 
   double GetParameter(int i=0) const;
   double GetEffParameter(int i=0) const;
 
@@ -54,6 +59,33 @@ public:
     std::string nucleus;
   };
 
+  /// Calibration of one channel, by CalibrateChannels.
+  struct ChannelFit {
+    unsigned int address;
+    bool valid;                 ///< False if too few peaks were matched and fit.
+    std::vector<double> coeff;  ///< Energy of the charge, as the fit.
+    std::vector<Peak> peaks;
+    double rms_residual;        ///< Of the calibrated peak energies, in keV.
+    double max_residual;
+  };
+
+  /// Calibrates every channel of a source run at once.
+  /**
+    Peaks of each charge histogram are found and matched against the
+      lines of each source, as AddData, one channel per thread.  The
+      matched peaks of every channel are then fit together on a
+      GFitPool, and a polynomial of order fit to each channel.  The
+      TChannel of each calibrated address, if any, is updated.
+      nthreads of 0 uses every core.
+   */
+  static std::vector<ChannelFit> CalibrateChannels(const std::map<unsigned int,TH1*>& data,
+                                                   const std::vector<std::string>& sources,
+                                                   int order=1,double sigma=2.0,double threshold=0.05,
+                                                   int nthreads=0);
+  /// Residuals of each channel and of each line over all channels,
+  /// also written to filename if given.
+  static std::string ResidualReport(const std::vector<ChannelFit>& fits,const char *filename="");
+
   void AddPeak(double cent,double eng,std::string nuc,double a=0.0,double inten=0.0);
   Peak GetPeak(UInt_t i) const { return fPeaks.at(i); }
  
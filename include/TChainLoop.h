@@ -6,6 +6,7 @@
 #endif
 
 #include <map>
+#include <memory>
 
 #include "TChain.h"
 #include "TClass.h"
@@ -15,8 +16,32 @@
 #include "ThreadsafeQueue.h"
 #include "TUnpackedEvent.h"
 
+class TCompiledHistograms;
+class THistogramLoop;
 class TUnpackedEvent;
 
+/// Reads the entries of a TChain back into TUnpackedEvents.
+/**
+  By default the chain is read entry by entry on this thread, and the
+    events are pushed downstream in order.
+
+  In replay mode, set with more than one replay thread and a histogram
+    loop, the chain is split into the clusters of its trees and the
+    clusters are read on the replay threads, each with its own TFile,
+    TTree and branch addresses.  Each thread fills its own shard of the
+    compiled histograms, and the shards are added into the histogram
+    loop once the chain has been read, or the loop is stopped.  Nothing
+    is pushed downstream, so replay mode is only for histogramming; the
+    histograms can not be viewed until they are merged.
+
+  The shards share the histogram library, so MakeHistograms must not
+    keep state of its own between calls.
+
+  With branch selection on, only the branches the histograms use are
+    read, as given by TCompiledHistograms::GetUsedBranches.  Every branch
+    is read until that is known, and any detector the histograms ask for
+    later is read from then on.
+ */
 class TChainLoop : public StoppableThread {
 public:
   static TChainLoop* Get(std::string name="",TChain *chain=0);
@@ -40,6 +65,15 @@ public:
   bool GetSelfStopping() const { return fSelfStopping; }
   void Restart();
 
+  /// Threads reading the chain in replay mode; 1 reads it on this thread.
+  void SetReplayThreads(int nthreads) { fReplayThreads = nthreads; }
+  int  GetReplayThreads() const { return fReplayThreads; }
+  /// The loop whose histograms are filled in replay mode.
+  void SetHistogramLoop(THistogramLoop* loop) { histogram_loop = loop; }
+  /// Whether to read only the branches used by the histograms of the histogram loop.
+  void SetSelectBranches(bool select) { fSelectBranches = select; }
+  bool GetSelectBranches() const { return fSelectBranches; }
+
 protected:
   bool Iteration();
 
@@ -57,9 +91,34 @@ private:
 #endif
 
   bool fSelfStopping;
+  int  fReplayThreads;
+  THistogramLoop* histogram_loop;
+  bool fSelectBranches;
+  size_t fBranchesVersion;
+  long fSelectedAt;
 
   int SetupChain();
+  static TUnpackedEvent* CollectDetectors(const std::map<TClass*, TDetector**>& detectors);
+  static std::map<TClass*, TDetector**> SelectBranches(TTree* tree, TCompiledHistograms& histograms,
+                                                       const std::map<TClass*, TDetector**>& detectors,
+                                                       bool verbose);
+  /// Names the detectors read in after but not in before, which missed the entries read in between.
+  static void WarnLateBranches(const std::map<TClass*, TDetector**>& before,
+                               const std::map<TClass*, TDetector**>& after,
+                               long missed);
   std::map<TClass*, TDetector**> det_map;
+  std::map<TClass*, TDetector**> read_map;
+
+#ifndef __CINT__
+  struct Replay;
+
+  bool ReplayIteration();
+  void StartReplay();
+  void FinishReplay();
+  void ReplayRanges(size_t ishard);
+
+  std::unique_ptr<Replay> replay;
+#endif
 
   ClassDef(TChainLoop, 0);
 };
@@ -1,6 +1,7 @@
 #ifndef _TCHANNEL__H_
 #define _TCHANNEL__H_
 
+#include <atomic>
 #include <cfloat>
 #include <iostream>
 #include <string>
@@ -19,6 +20,10 @@ public:
   static bool RemoveChannel(TChannel&);
   static int DeleteAllChannels();
   static int Size() { return fChannelMap.size(); }
+  /// Changes whenever channels are added, removed, read from a cal file,
+  /// or any channel is changed through a setter.
+  /// Lets callers cache per-address lookups and rebuild them only when needed.
+  static unsigned int Generation() { return fGeneration; }
   static int ReadCalFile(const char* filename="",Option_t *opt="replace");
   static int WriteCalFile(std::string filename="",Option_t *opt="");
 
@@ -48,14 +53,15 @@ public:
   double       GetPedestal() const         { return pedestal; }
 
 
-  void SetAddress(unsigned int temp) { address = temp; }
+  void SetAddress(unsigned int temp) { address = temp; fGeneration++; }
   void SetName(const char *temp)     {
     TNamed::SetNameTitle(temp,temp);
     UnpackMnemonic(temp);
+    fGeneration++;
   }
-  void SetInfo(const char *temp) { info.assign(temp); }
-  void SetNumber(int temp) { number = temp; }
-  void SetPedestal(int value) { pedestal = value; }
+  void SetInfo(const char *temp) { info.assign(temp); fGeneration++; }
+  void SetNumber(int temp) { number = temp; fGeneration++; }
+  void SetPedestal(int value) { pedestal = value; fGeneration++; }
 
   void ClearCalibrations();
 
@@ -71,9 +77,9 @@ public:
   double CalTime(int tdc, double timestamp=-DBL_MAX) const;
   double CalTime(double tdc, double timestamp=-DBL_MAX) const;
 
-  void SetEfficiencyCoeff(std::vector<double> tmp) { efficiency_coeff = tmp; }
+  void SetEfficiencyCoeff(std::vector<double> tmp) { efficiency_coeff = tmp; fGeneration++; }
   std::vector<double> GetEfficiencyCoeff() const { return efficiency_coeff; }
-  void AddEfficiencyCoeff(double tmp) { efficiency_coeff.push_back(tmp); }
+  void AddEfficiencyCoeff(double tmp) { efficiency_coeff.push_back(tmp); fGeneration++; }
   void ClearEfficiencyCoeff();
   double CalEfficiency(double energy) const;
 
@@ -132,6 +138,7 @@ public:
 //  static std::map<unsigned int,TChannel*> fChannelMap;
   static std::unordered_map<unsigned int,TChannel*> fChannelMap;
   static TChannel *fDefaultChannel;
+  static std::atomic<unsigned int> fGeneration; //!
 
   ClassDef(TChannel,2);
 };
@@ -20,6 +20,14 @@ public:
   TCompiledFilter(std::string libname);
 
   bool MatchesCondition(TUnpackedEvent& event);
+  /// PreFilterCondition of the library, true if it has none.
+  /**
+    The event may not be unpacked yet.  GetDetector<T>() unpacks only T,
+      and GetFragmentCount and GetRawData look at the raw fragments
+      without unpacking anything.  Events it rejects are never unpacked.
+   */
+  bool MatchesPreCondition(TUnpackedEvent& event);
+  bool HasPreFilter() const { return pre_func; }
   void Load(std::string libname);
   void Reload();
 
@@ -37,6 +45,7 @@ private:
   std::shared_ptr<DynamicLibrary> library;
 #endif
   bool (*func)(TRuntimeObjects&);
+  bool (*pre_func)(TRuntimeObjects&);
   time_t last_modified;
   time_t last_checked;
 
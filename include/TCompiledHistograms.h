@@ -2,10 +2,12 @@
 #define _TCOMPILEDHISTOGRAMS_H_
 
 #ifndef __CINT__
+#include <atomic>
 #include <mutex>
 #endif
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "TObject.h"
 #include "TList.h"
@@ -38,8 +40,29 @@ public:
 
   void AddCutFile(TFile* cut_file);
 
+  /// The same library, with its own histograms in dir and its own gates from the same cut files.
+  TCompiledHistograms* MakeShard(TDirectory* dir);
+  /// Adds the histograms of other to these, copying any that are not here yet.
+  void Merge(TCompiledHistograms& other);
+
   void Write();
 
+  /// Changes whenever the list of GetUsedBranches changes; 0 while it is not known yet.
+  size_t UsedBranchesVersion() const { return used_branches_version; }
+  /// Branches the histograms read, as SetBranchStatus patterns; returns UsedBranchesVersion.
+  /**
+    If the library has
+    \code
+    extern "C" void UsedBranches(std::vector<std::string>& branches);
+    \endcode
+    its list is used.  It may name detector classes ("TGretina") or
+    members of them ("TGretina.gretina_hits.fCoreEnergy").
+    Otherwise every branch is read, unless GRUT.BranchWarmUp is set to a
+    number of events: the list is then the detector classes MakeHistograms
+    has asked for in that many events, added to if it asks for any other
+    later.  A detector only used in rarer events is not read until then.
+   */
+  size_t GetUsedBranches(std::vector<std::string>& branches);
 
 private:
   void swap_lib(TCompiledHistograms& other);
@@ -52,11 +75,19 @@ private:
   std::mutex mutex;
 #endif
   void (*func)(TRuntimeObjects&);
+  void (*used_branches)(std::vector<std::string>&);
   time_t last_modified;
   time_t last_checked;
 
   int check_every;
 
+  long warm_up_events;
+  long events_filled;
+  size_t requested_detectors;
+#ifndef __CINT__
+  std::atomic_size_t used_branches_version;
+#endif
+
   TList objects;
   TList gates;
   std::vector<TFile*> cut_files;
@@ -0,0 +1,72 @@
+#ifndef TCUTRASTER_H
+#define TCUTRASTER_H
+
+#include <cstddef>
+#include <vector>
+
+class TCutG;
+
+/// Rasterised inside test for one or more TCutG polygons.
+/**
+  The bounding box of the cuts is split into a grid of cells.  A cell
+    that no edge comes within a cell of is wholly inside or outside each
+    cut, and holds the index of the first cut it is inside, or -1.  Only
+    in the cells along the edges are the polygons themselves tested, so
+    the answer is always the same as asking each TCutG::IsInside in turn.
+
+  The cuts are not copied.  If one is moved or deleted, make a new raster.
+
+  \code
+  TCutRaster pid(cuts);
+  int isotope = pid.Classify(tof, de);    // first cut (x,y) is inside, or -1
+  \endcode
+ */
+class TCutRaster {
+public:
+  /// Grid of nx by ny cells; 0 takes GRUT.CutRasterSize from .rootrc (256 by default).
+  explicit TCutRaster(const TCutG* cut, int nx=0, int ny=0);
+  explicit TCutRaster(const std::vector<const TCutG*>& cuts, int nx=0, int ny=0);
+
+  /// Index of the first cut that (x,y) is inside, -1 if none.
+  int Classify(double x, double y) const {
+    if(!(x >= fXmin && x <= fXmax && y >= fYmin && y <= fYmax)) {
+      return -1;
+    }
+    int ix = int((x - fXmin)*fXScale);
+    int iy = int((y - fYmin)*fYScale);
+    short label = fLabels[(iy < fNy ? iy : fNy-1)*fNx + (ix < fNx ? ix : fNx-1)];
+    return (label < -1) ? ClassifyExact(x, y, kFirstEdge - label) : label;
+  }
+  /// Whether (x,y) is inside the first (or only) cut.
+  bool IsInside(double x, double y) const { return Classify(x, y) == 0; }
+
+  /// Classify for n points at once.
+  void Classify(size_t n, const double* x, const double* y, int* index) const;
+
+  int GetNx() const { return fNx; }
+  int GetNy() const { return fNy; }
+  size_t GetNCuts() const { return fCuts.size(); }
+  /// Fraction of the cells that are tested against the polygons.
+  double GetEdgeFraction() const;
+
+private:
+  // Labels from kFirstEdge down mark a cell with an edge of cut kFirstEdge-label.
+  enum { kFirstEdge = -2 };
+  enum CellState { kOutside, kInside, kOnEdge };
+
+  void Build(int nx, int ny);
+  void MarkEdges(const TCutG* cut, std::vector<char>& state) const;
+  int ClassifyExact(double x, double y, size_t first) const;
+
+  struct Box { double xmin, xmax, ymin, ymax; };
+
+  std::vector<const TCutG*> fCuts;
+  std::vector<Box> fBoxes;
+  std::vector<short> fLabels;
+  int fNx;
+  int fNy;
+  double fXmin, fXmax, fYmin, fYmax;
+  double fXScale, fYScale;
+};
+
+#endif /* TCUTRASTER_H */
@@ -34,6 +34,13 @@ public:
 
   virtual size_t Size() const { return (size_t)fSize; }
 
+  /// Copies any trace views held by the hits into the hits themselves.
+  /**
+     Called before the detector is written to a TTree,
+       since views into the raw buffer are not persistent.
+   */
+  virtual void MaterializeTraces() { }
+
 
   Long_t Timestamp() const { return fTimestamp; }
   void   SetTimestamp(Long_t timestamp)  { fTimestamp = timestamp; }
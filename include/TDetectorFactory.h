@@ -1,6 +1,8 @@
 #ifndef _TDETECTORFACTORY_H_
 #define _TDETECTORFACTORY_H_
 
+#include "TClass.h"
+
 class TDetector;
 
 class TDetectorFactoryBase {
@@ -9,6 +11,7 @@ public:
 
   virtual TDetector* construct() = 0;
   virtual bool is_instance(TDetector* det) = 0;
+  virtual TClass* get_class() = 0;
 };
 
 template<typename T>
@@ -21,6 +24,10 @@ public:
   virtual bool is_instance(TDetector* det) {
     return dynamic_cast<T*>(det);
   }
+
+  virtual TClass* get_class() {
+    return T::Class();
+  }
 };
 
 #endif /* _TDETECTORFACTORY_H_ */
@@ -31,6 +31,9 @@ public:
 
   void AddCutFile(TFile* cut_file);
 
+  /// Whether the filter has a PreFilterCondition, so that unpacking can wait for it.
+  bool HasPreFilter() const { return compiled_filter.HasPreFilter(); }
+
   virtual void ClearQueue();
 
   size_t GetItemsPopped()  { return output_queue->ItemsPopped(); }
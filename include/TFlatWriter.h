@@ -0,0 +1,78 @@
+#ifndef TFLATWRITER_H
+#define TFLATWRITER_H
+
+#include "Rtypes.h"
+
+class TTree;
+class TUnpackedEvent;
+
+/// Flat per-event and per-hit tables, written next to or instead of EventTree.
+/**
+  Every number is its own branch of a fixed-size type, so a reader can
+    enable only the columns it needs, and a loop over a column needs
+    nothing but the basket it is in.
+
+  "FlatEvents" has one entry per event:
+    event, timestamp, gretina_n, s800, s800_timestamp,
+    ata, bta, dta, yta, xfp0, xfp1, yfp0, yfp1, afp, bfp
+  The S800 columns are NaN when there was no S800 in the event.
+
+  "FlatGretinaHits" has one entry per GRETINA hit:
+    event, timestamp, crystal_id, core_energy, x, y, z, time
+
+  The event column is the index of the event in the sort and joins the
+    two tables.  With one write thread both tables are in event order,
+    so the hits of an event start at the sum of gretina_n over the
+    events before it.
+
+  The trees are made in gDirectory when the writer is constructed.
+ */
+class TFlatWriter {
+public:
+  /// Basket size 0 and compression -1 keep the ROOT defaults.
+  TFlatWriter(int basket_size=0, int compression=-1);
+
+  /// Fills one entry of FlatEvents and one of FlatGretinaHits per hit; returns the bytes filled.
+  Long64_t Fill(TUnpackedEvent& event, Long64_t index);
+
+  /// Writes both trees to their directory.
+  void Write();
+
+  TTree* GetEventTable()   const { return fEvents; }
+  TTree* GetGretinaTable() const { return fGretinaHits; }
+
+private:
+  TFlatWriter(const TFlatWriter&);
+  TFlatWriter& operator=(const TFlatWriter&);
+
+  void Column(TTree* tree, const char* name, void* address, char type);
+
+  struct EventRow {
+    Long64_t event;
+    Long64_t timestamp;
+    Int_t    gretina_n;
+    Int_t    s800;
+    Long64_t s800_timestamp;
+    Float_t  ata, bta, dta, yta;
+    Float_t  xfp0, xfp1, yfp0, yfp1;
+    Float_t  afp, bfp;
+  };
+
+  struct GretinaRow {
+    Long64_t event;
+    Long64_t timestamp;
+    Int_t    crystal_id;
+    Float_t  core_energy;
+    Float_t  x, y, z;
+    Double_t time;
+  };
+
+  TTree* fEvents;
+  TTree* fGretinaHits;
+  EventRow   fEventRow;
+  GretinaRow fGretinaRow;
+  int fBasketSize;
+  int fCompression;
+};
+
+#endif /* TFLATWRITER_H */
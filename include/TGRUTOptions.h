@@ -33,11 +33,22 @@ public:
   std::string InputRing() { return input_ring; }
   std::string CompiledHistogramFile() { return compiled_histogram_file; }
   std::string CompiledFilterFile() { return compiled_filter_file; }
+  const std::string& MetricsSocket()                { return metrics_socket; }
 
   const std::vector<std::string>& OptionFiles() { return options_file; }
 
   int BuildWindow() const { return fBuildWindow; }
 
+  int WriteThreads()        const { return fWriteThreads; }
+  int ReplayThreads()       const { return fReplayThreads; }
+  bool ReadAllBranches()    const { return fReadAllBranches; }
+  bool Profile()            const { return fProfile; }
+  int BasketSize()          const { return fBasketSize; }
+  int Compression()         const { return fCompression; }
+  int AutoFlush()           const { return fAutoFlush; }
+  bool WriteObjectTree()    const { return fWriteObjectTree; }
+  bool WriteFlatTables()    const { return fWriteFlatTables; }
+
   bool ExitAfterSorting()   const { return fExitAfterSorting; }
   bool ShowedHelp()         const { return fHelp; }
   bool ShowedVersion()      const { return fShowedVersion; }
@@ -91,6 +102,7 @@ private:
 
   std::string detector_environment;
   std::string compiled_histogram_file;
+  std::string metrics_socket;
   std::string compiled_filter_file;
   std::string s800_inverse_map_file;
 
@@ -115,6 +127,16 @@ private:
 
   int fBuildWindow;
 
+  int fWriteThreads;
+  int fReplayThreads;
+  bool fReadAllBranches;
+  bool fProfile;
+  int fBasketSize;
+  int fCompression;
+  int fAutoFlush;
+  bool fWriteObjectTree;
+  bool fWriteFlatTables;
+
   bool fShouldExit;
 
   bool fLongFileDescription;
@@ -9,6 +9,7 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <memory>
 
 #include "TObject.h"
 #include "TList.h"
@@ -18,6 +19,8 @@
 #include "TMarker.h"
 
 #include "TNucleus.h"
+#include "TCutRaster.h"
+
 class TGates : public TObject{
 
  private:
@@ -43,6 +46,8 @@ class TGates : public TObject{
   double GetMass(int);						//Returns Mass of beam in GateList
 
   int GateID(float, float);					//Returns position in vector
+  void GateID(size_t n, const float* x, const float* y, int* id); //GateID for n points at once
+  void Compile();						//Rasterises the gates; call again after changing one
   int Size() { return (int)GateList.size(); }
  private:
   int fNPid;
@@ -55,6 +60,12 @@ class TGates : public TObject{
   TCutG*  gate2D;
   std::vector<std::pair<TNucleus*,TCutG*> > GateList;
 
+#ifndef __CINT__
+  std::unique_ptr<TCutRaster> fPIDRaster;			//! all gates, when none are 1D
+  std::vector<std::unique_ptr<TCutRaster> > fGateRasters;	//! each 2D gate, otherwise
+  std::unique_ptr<TCutRaster> fGate2DRaster;			//! gate2D
+#endif
+
 ClassDef(TGates,1);				// Creates a nucleus with corresponding nuclear information
 };
 
@@ -15,6 +15,7 @@ public:
   virtual TGenericDDASHit& GetDDASHit(int i);
   virtual TDetectorHit& GetHit(int i);
   virtual void InsertHit(const TDetectorHit&);
+  virtual void MaterializeTraces();
 
   // Allows for looping over all hits with for(auto& hit : ddas) { }
   std::vector<TGenericDDASHit>::iterator begin() { return ddas_hits.begin(); }
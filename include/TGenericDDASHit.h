@@ -2,6 +2,7 @@
 #define _TGENERICDDASHIT_H_
 
 #include "TDetectorHit.h"
+#include "TTraceView.h"
 #include "TMath.h"
 
 
@@ -13,10 +14,13 @@ public:
   virtual void Clear(Option_t *opt = "");
   virtual void Print(Option_t *opt = "") const;
 
-  std::vector<unsigned short>* GetTrace()     { return &fTrace; }
+  std::vector<unsigned short>* GetTrace()     { MaterializeTrace(); return &fTrace; }
+  const TTraceView& GetTraceView() const      { return fTraceView; }
 
   void SetTime(double time)            { fTime = time; }
   void SetTrace(unsigned int trace_length, const unsigned short* trace);
+  void SetTrace(const TTraceView& trace) { fTrace.clear(); fTraceView = trace; }
+  void MaterializeTrace();
   void SetExtTime(long timestamp)  { fExtTime = timestamp; }
 
   virtual Int_t Charge() const;
@@ -28,6 +32,7 @@ public:
 
   protected:
     std::vector<unsigned short> fTrace;
+    TTraceView fTraceView; //!
     long fExtTime;
   ClassDef(TGenericDDASHit,4);
 };
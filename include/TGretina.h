@@ -36,6 +36,7 @@ public:
 
   void PrintHit(int i){ gretina_hits.at(i).Print(); }
 
+  // See TGretinaGeometry for the precomputed and batch versions.
   static TVector3 CrystalToGlobal(int cryId,Float_t localX=0,Float_t localY=0,Float_t localZ=0);
   static TVector3 GetSegmentPosition(int cryid,int segment); //return the position of the segemnt in the lab system
   static TVector3 GetCrystalPosition(int cryid); //return the position of the crysal in the lab system
@@ -99,6 +100,8 @@ private:
   std::vector<TGretinaHit> gretina_hits;
   mutable std::vector<TGretinaHit> addback_hits; //!
 
+  friend class TGretinaGeometry;
+
   static Float_t crmat[32][4][4][4];
   static Float_t m_segpos[2][36][3];
   static void SetGretNeighbours();
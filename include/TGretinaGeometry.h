@@ -0,0 +1,65 @@
+#ifndef TGRETINAGEOMETRY_H
+#define TGRETINAGEOMETRY_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <TVector3.h>
+
+class TGretinaHit;
+
+/// Crystal to lab transforms for GRETINA, precomputed.
+/**
+  The rotation matrices from crmat.dat are stored as float 3x4 matrices,
+    one after the other in a single array indexed by crystal id.
+  A second set of matrices has the GRETINA_X/Y/Z_OFFSET values folded
+    into the translation, so an interaction point is moved to the lab
+    with a single multiply-add per coordinate.
+  The offsets are looked up again only when a GValue has changed, for
+    instance after a .val file is read; the old tables are freed once
+    every thread has moved on to the new ones.
+
+  The batch transforms loop over the structure-of-arrays interaction
+    points of TGretinaHit and can be vectorised by the compiler.
+ */
+class TGretinaGeometry {
+public:
+  enum { kFirstCrystal = 4, kNumCrystals = 128 };
+
+  /// Lab position of a point in crystal coordinates, same as TGretina::CrystalToGlobal.
+  static TVector3 CrystalToGlobal(int cryId, float x, float y, float z);
+
+  /// Lab position of an interaction point, with the GRETINA offsets applied.
+  static TVector3 IntPointToGlobal(int cryId, float x, float y, float z);
+
+  /// Lab positions of all interaction points of one hit, returns the number written.
+  static size_t TransformHit(const TGretinaHit& hit, float* gx, float* gy, float* gz);
+
+  /// Lab positions of all interaction points of all hits, one hit after the other.
+  /**
+    If first is given, first[i] is the index of the first point of hits[i],
+      and first[hits.size()] the total number of points.
+   */
+  static size_t TransformHits(const std::vector<TGretinaHit>& hits,
+                              std::vector<float>& gx, std::vector<float>& gy, std::vector<float>& gz,
+                              std::vector<int>* first = 0);
+
+  /// Applies the 3x4 matrix of cryId to n points.
+  static void Transform(int cryId, bool with_offsets, const float* x, const float* y, const float* z,
+                        size_t n, float* gx, float* gy, float* gz);
+
+private:
+  struct Tables {
+    float matrix[kNumCrystals][12];
+    float shifted[kNumCrystals][12];
+    unsigned int generation;
+  };
+
+  /// The tables for the current GValues, valid until this thread calls Get() again.
+  static const Tables& Get();
+  static std::shared_ptr<const Tables> Build(unsigned int generation);
+  static const float* Matrix(int cryId, bool with_offsets);
+};
+
+#endif /* TGRETINAGEOMETRY_H */
@@ -109,6 +109,60 @@ struct intpnt_compare_wedge {
 
 #endif
 
+/// Interaction points of a TGretinaHit, stored as a structure of arrays.
+/**
+  Fixed capacity and no virtual functions, so copying a hit copies this
+    as a single block of memory, and loops over one coordinate of all
+    points can be vectorised.
+  Not written to file: TGretinaHit streams the points as a
+    std::vector<interaction_point>, and a read rule rebuilds this from it.
+  The capacity covers both the MAX_INTPTS points given by decomp and the
+    points gathered by nearest-neighbour addback.
+ */
+class TGretinaIntPoints {
+  public:
+    enum { kCapacity = MAXHPGESEGMENTS };
+
+    TGretinaIntPoints() : fN(0) { }
+
+    int  size()  const { return fN;      }
+    bool empty() const { return fN == 0; }
+    bool full()  const { return fN >= kCapacity; }
+    void clear()       { fN = 0; }
+
+    /// Appends a point, returns false if there is no room left.
+    bool push_back(int seg, float x, float y, float z, float energy, float fraction) {
+      if(full()) {
+        return false;
+      }
+      fSeg[fN]  = seg;
+      fX[fN]    = x;
+      fY[fN]    = y;
+      fZ[fN]    = z;
+      fEng[fN]  = energy;
+      fFrac[fN] = fraction;
+      fN++;
+      return true;
+    }
+
+    interaction_point at(int i) const {
+      return interaction_point(fSeg[i],fX[i],fY[i],fZ[i],fEng[i],fFrac[i]);
+    }
+
+    void Sort();                      ///< Same ordering as interaction_point::operator<
+    void KeepFirst(int segment_mod);  ///< Keeps the first point of each fSeg%segment_mod
+
+    Int_t   fN;
+    Int_t   fSeg[kCapacity];
+    Float_t fX[kCapacity];
+    Float_t fY[kCapacity];
+    Float_t fZ[kCapacity];
+    Float_t fEng[kCapacity];
+    Float_t fFrac[kCapacity];
+
+  ClassDefNV(TGretinaIntPoints,1)
+};
+
 class TGretinaHit : public TDetectorHit {
 
 public:
@@ -148,7 +202,7 @@ public:
   void  Print(Option_t *opt="") const;
   void  Clear(Option_t *opt="");
 
-  Int_t Size()  const { return fSegments.size();  }
+  Int_t Size()  const { return fIntPoints.size();  }
 
   double GetX() const { return GetPosition().X(); }
   double GetY() const { return GetPosition().Y(); }
@@ -177,7 +231,7 @@ public:
     return 0;
   }
 
-  bool HasInteractions() { return !fSegments.empty(); }
+  bool HasInteractions() { return !fIntPoints.empty(); }
 
   bool operator<(const TGretinaHit &rhs) const { return fCoreEnergy > rhs.fCoreEnergy; }
 
@@ -188,11 +242,12 @@ public:
 
 
   Int_t    NumberOfInteractions()        const { return fNumberOfInteractions; }
-  Int_t    GetNSegments()                const { return (int)fSegments.size(); }
+  Int_t    GetNSegments()                const { return (int)fIntPoints.size(); }
   Int_t    GetSegmentId(int i=-1)        const { if(i>=GetNSegments()||GetNSegments()==0) return -1;
-                                                 if(i==-1) return fSegments.at(0).fSeg;
-                                                 else	   return fSegments.at(i).fSeg;  }
-  Float_t  GetSegmentEng(const int &i)   const { return fSegments.at(i).fEng;  }
+                                                 if(i==-1) return fIntPoints.fSeg[0];
+                                                 else	   return fIntPoints.fSeg[i];  }
+  Float_t  GetSegmentEng(const int &i)   const { return fIntPoints.fEng[i];  }
+  const TGretinaIntPoints& GetIntPoints() const { return fIntPoints; }
 
   TVector3 GetIntPosition(unsigned int i)   const;  // position of the ith segment, Global coor.
   TVector3 GetLocalPosition(unsigned int i) const;  // position of the ith segment, Local coor.
@@ -211,6 +266,9 @@ public:
   bool IsClean() const { return !fPad; }
 
 private:
+  // Copies fIntPoints into fSegments; called wherever the points change.
+  void StoreIntPoints();
+
 /* All possible decomp information and
  * where is is stored:
  * -------------------
@@ -248,6 +306,8 @@ private:
 
   std::vector<TGretinaHit> fSingles;
   bool fSetFirstSingles = false;
+  TGretinaIntPoints fIntPoints; //!
+  // The copy of fIntPoints written to file, kept in step by StoreIntPoints().
   std::vector<interaction_point> fSegments;
   static double fSmearWidth;
   static bool fSmear;
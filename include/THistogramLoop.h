@@ -29,8 +29,15 @@ public:
 
   void AddCutFile(TFile* cut_file);
 
+  /// Histograms of the same library in dir, to be filled on another thread.
+  TCompiledHistograms* MakeShard(TDirectory* dir);
+  /// Adds the histograms of a shard to these, opening the output file if needed.
+  void MergeShard(TCompiledHistograms& shard);
+
   void Write();
 
+  TCompiledHistograms* GetCompiledHistograms() { return &compiled_histograms; }
+
   virtual void ClearQueue();
 
   TList* GetObjects();
@@ -2,6 +2,7 @@
 #define TINVERSEMAP_H_
 
 #include<map>
+#include<vector>
 
 #include <TNamed.h>
 #include <iostream>
@@ -25,6 +26,18 @@ class TInverseMap : public TNamed {
     float Dta(int degree, double xfp, double afp, double yfp, double bfp) const;
     float Dta(int,const TS800*);
 
+    /// All four target parameters from one evaluation of the compiled map.
+    /**
+      Same units as Ata(), Bta(), Yta() and Dta(): xfp and yfp in mm,
+        afp and bfp in radians, yta returned in mm.
+     */
+    void Calculate(int degree, double xfp, double afp, double yfp, double bfp,
+                   float& ata, float& bta, float& yta, float& dta) const;
+    /// Calculate() for n events, any of the outputs may be null.
+    void Calculate(int degree, size_t n, const float* xfp, const float* afp, const float* yfp, const float* bfp,
+                   float* ata, float* bta, float* yta, float* dta) const;
+
+    /// Reference evaluation straight from the rows of the map file.
     float MapCalc(int,int,float*) const;
     int Size() {
 	std::cout << "MAP" << std::endl;
@@ -44,6 +57,10 @@ class TInverseMap : public TNamed {
     static TInverseMap *fInverseMap;
 
     bool ReadMapFile(const char *filename);
+    void Compile();
+    void EvalMonomials(const float* input, double* mono) const;
+    const double* Monomials(double xfp, double afp, double yfp, double bfp) const;
+    float EvalPar(int degree, int par, const double* mono) const;
 
     struct InvMapRow{
       double coefficient;
@@ -52,6 +69,20 @@ class TInverseMap : public TNamed {
     };
     //data cleared on reset; i.e. Read new inverse map.
     std::map<int,std::vector<InvMapRow> > fMap;
+
+    // The map compiled at load time.  Every distinct product of the four
+    //   inputs is one monomial, built from an earlier one times one input,
+    //   so all monomials of an event cost one multiply each and are shared
+    //   by the four parameters.
+    enum { kNumPars = 4 };
+    struct CompiledTerm {
+      double coefficient;
+      int    order;
+      int    monomial;
+    };
+    std::vector<int> fMonoParent; //!
+    std::vector<int> fMonoInput;  //!
+    std::vector<CompiledTerm> fTerms[kNumPars]; //!
     float  fBrho;
     int    fMass;
     int    fCharge;
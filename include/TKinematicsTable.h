@@ -0,0 +1,72 @@
+#ifndef TKINEMATICSTABLE_H
+#define TKINEMATICSTABLE_H
+
+/** \addtogroup Fitting Fitting & Analysis
+ *  @{
+ */
+
+#include <memory>
+#include <vector>
+
+#include "TReaction.h"
+
+/// Tabulated two body kinematics for per-hit reconstruction.
+/**
+  Holds a TReaction together with theta_cm, kinetic energy and beta of each
+    particle, tabulated against the lab angle from -pi to pi.  Negative lab
+    angles select the second solution, as in TReaction::ConvertThetaLabToCm.
+  A lookup is a linear interpolation between two table entries.  Where that
+    is not good to about 1e-6 (relative, or absolute below 1), the value is
+    calculated directly instead: within two table steps of the maximum lab
+    angle, where theta_cm has a square-root edge, in the step across zero,
+    where the solution changes, next to angles the particle cannot reach,
+    and in any step where the midpoint misses by more than the tolerance.
+
+  Tables are built once per reaction and shared; Get() never frees them, so
+    the reference can be kept, and they are only read after being built, so
+    any thread may use them.
+
+  \code
+  const TKinematicsTable& kin = TKinematicsTable::Get("78Kr","208Pb","78Kr","208Pb",300.);
+  double tlab = kin.TLab(theta_lab, 2);
+  \endcode
+ */
+class TKinematicsTable {
+public:
+  /// Table for the reaction, read from mass.dat the first time only.  Energies in MeV.
+  static const TKinematicsTable& Get(const char* beam, const char* targ, const char* ejec, const char* reco,
+                                     double ebeam, double ex3=0.0, bool inverse=false);
+  /// Table with the same masses, beam energy and excitation as reac.
+  static const TKinematicsTable& Get(TReaction& reac);
+
+  TReaction& GetReaction() const { return *fReaction; }
+
+  /// Same as TReaction::ConvertThetaLabToCm.
+  double ThetaCm(double theta_lab, int part=2) const { return Lookup(kThetaCm, theta_lab, part); }
+  /// Same as TReaction::GetTLab, kinetic energy in MeV.
+  double TLab(double theta_lab, int part=2) const    { return Lookup(kTLab, theta_lab, part); }
+  /// Same as TReaction::AnalysisBetaFromThetaLab.
+  double Beta(double theta_lab, int part=2) const    { return Lookup(kBeta, theta_lab, part); }
+  /// Same as TReaction::ConvertThetaLab.
+  double ConvertThetaLab(double theta_lab_a, int parta, int partb) const;
+
+private:
+  enum Quantity { kThetaCm, kTLab, kBeta, kNumQuantities };
+  enum { kPoints = 4097 };
+  static constexpr double kTolerance = 1e-6;
+
+  explicit TKinematicsTable(TReaction* reac);
+  TKinematicsTable(const TKinematicsTable&);
+  TKinematicsTable& operator=(const TKinematicsTable&);
+
+  double Exact(Quantity q, double theta_lab, int part) const;
+  double Lookup(Quantity q, double theta_lab, int part) const;
+
+  std::unique_ptr<TReaction> fReaction;
+  std::vector<double> fTable[kNumQuantities][4];
+  std::vector<char>   fExactCell[4];
+  double fThetaMax[4];
+  double fStep;
+};
+/*! @} */
+#endif /* TKINEMATICSTABLE_H */
@@ -13,6 +13,7 @@ class TLenda : public TDetector {
 
     void Copy(TObject& obj) const;
     virtual void Clear(Option_t* opt = "");
+    virtual void MaterializeTraces();
 //    virtual void Print(Option_t* opt = "") const;
 
     void InsertHit(const TDetectorHit&) {   }
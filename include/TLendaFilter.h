@@ -18,6 +18,18 @@ class TLendaFilter : public TDetectorHit {
     std::vector<Double_t> CFD(std::vector <Double_t> &fFastFilter, Double_t CFD_delay, Double_t CFD_scale_factor);
     std::vector<Double_t> CFDOp(std::vector <Double_t> &fFastFilter, Double_t CFD_delay, Double_t CFD_scale_factor);
 
+    // Kernels working in caller-provided buffers, no allocation is done.
+    // Vectorised with AVX2 when the CPU supports it, scalar otherwise.
+    // FastFilterKernel, FastFilterOpKernel and CFDKernel give exactly the values of
+    //   FastFilter, FastFilterOp and CFD, in Float_t.
+    static Int_t FastFilterKernel(const UShort_t* trace, Int_t length, Int_t FL, Int_t FG, Float_t* filter);///<FastFilter, filter must hold length values; returns the number written, 0 for traces under 20 samples
+    static Int_t FastFilterOpKernel(const UShort_t* trace, Int_t length, Int_t FL, Int_t FG, Float_t* filter);///<FastFilterOp, filter must hold 0.3*length+1 values; returns the number written
+    static void CFDKernel(const Float_t* filter, Int_t length, Int_t CFD_delay, Int_t CFD_scale_factor, Float_t* cfd);///<CFD, for CFD_delay >= 0
+    static Double_t ZeroCrossingKernel(const Float_t* cfd, Int_t begin, Int_t end, Double_t &resid);///<Linear interpolation of the first +/- crossing in [begin,end), as GetZeroCrossingImprovedRMD; NaN if there is none
+    static Double_t ZeroCrossingCubicKernel(const Float_t* cfd, Int_t length, Int_t SpotAbove);///<Cubic through SpotAbove-1..SpotAbove+2, solved in closed form
+    static void CubicThroughPoints(const Double_t y[4], Double_t coeffs[4]);///<Coefficients of t^0..t^3, for points at t=-1,0,1,2
+    static Double_t SolveCubicZero(const Double_t coeffs[4]);///<Zero of the cubic in [0,1]
+
     Double_t GetZeroCrossing(std::vector <Double_t> &CFDVec, Int_t &NZero, Double_t &resid);
     Double_t GetZeroCrossingImprovedRMD(std::vector <Double_t> &CFDVec, Int_t &MaxTrace, Double_t &resid);
     Double_t GetZeroCrossingImproved(std::vector <Double_t> &CFDVec,Int_t &MaxTrace, Double_t &resid);
@@ -37,6 +49,7 @@ class TLendaFilter : public TDetectorHit {
     Double_t GetZeroFitCubic(std::vector <Double_t> &);
     Double_t fitTrace(std::vector <UShort_t> &,Double_t, Double_t );
     Double_t GetEnergy(std::vector <UShort_t> &trace,Int_t MaxSpot);
+    static Double_t GetEnergy(const UShort_t* trace, Int_t traceLength, Int_t MaxSpot);
     Double_t GetEnergyRMD(std::vector <UShort_t> &trace,Int_t MaxSpot);///<Integrates trace around maximum using asymmetric limits (better suited for slow signals with long decay tails)
     std::vector<Double_t> GetEnergyHighRate(const std::vector <UShort_t> & trace,std::vector<Int_t> &PeakSpots,std::vector<Double_t>& theUnderShoots,Double_t & MaxValueOut,Int_t & MaxIndexOut);
     Double_t GetGate(std::vector <UShort_t> &trace, int start, int L);
@@ -3,6 +3,7 @@
 
 #include <TVector3.h>
 #include <TDetectorHit.h>
+#include <TTraceView.h>
 #include <TGraph.h>
 #include <TF1.h>
 #include <TFitResult.h>
@@ -12,16 +13,19 @@ class TLendaHit : public TDetectorHit {
     TLendaHit() { }
     ~TLendaHit() { }
 
-    virtual void Copy(TObject& obj) const        { TDetectorHit::Copy(obj); }
+    virtual void Copy(TObject& obj) const;
     virtual void Clear(Option_t *opt = "");//    { TDetectorHit::Clear(opt); }
     virtual void Print(Option_t *opt = "") const { TDetectorHit::Print(opt); }
 
-    std::vector<unsigned short>* GetTrace()   	{ return &fTrace; }
+    std::vector<unsigned short>* GetTrace()   	{ MaterializeTrace(); return &fTrace; }
+    const TTraceView& GetTraceView() const      { return fTraceView; }
 //    std::vector<Double_t>* GetFF()  		{ return &fFastFilter; }
 
     void SetTrace(unsigned int trace_length, const unsigned short* trace);
+    void SetTrace(const TTraceView& trace) { fTrace.clear(); fTraceView = trace; }
+    void MaterializeTrace();
 
-    int Size() { return fTrace.size(); }
+    int Size() { return fTraceView.empty() ? fTrace.size() : fTraceView.size(); }
 
     void SetPosArray(int arr_pos) { fArrayPosition = arr_pos; }
     void SetPosSeg(int seg_pos) { fSegmentPosition = seg_pos; }
@@ -44,6 +48,7 @@ class TLendaHit : public TDetectorHit {
 
   private:
     std::vector<unsigned short> fTrace;
+    TTraceView fTraceView; //!
     int fDetector;
     int fArrayPosition;
     int fSegmentPosition;
@@ -0,0 +1,29 @@
+#ifndef _TMETRICSSERVER_H_
+#define _TMETRICSSERVER_H_
+
+#include <string>
+
+/// Serves StoppableThread::MetricsJson on a Unix socket.
+/**
+  Each connection is sent the current metrics of every stage, as one
+    JSON document, and closed.  For example,
+  \code
+  socat - UNIX-CONNECT:/tmp/grut_metrics.sock
+  \endcode
+
+  The same document is written to $GRUTSYS/.grut_metrics.json with the
+    thread status, every 2 s.
+ */
+class TMetricsServer {
+public:
+  /// Listens on the socket at path, replacing any old socket file there.
+  static bool Start(const std::string& path);
+  static void Stop();
+  static bool IsRunning();
+
+private:
+  TMetricsServer() { }
+  static void Serve(int listen_fd);
+};
+
+#endif /* _TMETRICSSERVER_H_ */
@@ -18,6 +18,7 @@ public:
   virtual void Copy(TObject& obj) const;
   virtual void Print(Option_t *opt = "all") const;
   virtual void Clear(Option_t *opt = "");
+  virtual void MaterializeTraces();
   virtual size_t Size() const { return mode3_hits.size(); }
 
   virtual void          InsertHit(const TDetectorHit& hit);
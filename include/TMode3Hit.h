@@ -1,17 +1,20 @@
 #ifndef TMODE3HIT_H
 #define TMODE3HIT_H
 
+#include <atomic>
+
 #include "TDetector.h"
 #include "TDetectorHit.h"
+#include "TSmartBuffer.h"
 //#include "TGretinaHit.h"
 
 #define MAXTRACE 1024
 
-class TSmartBuffer;
-
 class TMode3Hit : public TDetectorHit {
 public:
   TMode3Hit();
+  TMode3Hit(const TMode3Hit& hit) : TDetectorHit() { hit.Copy(*this); }
+  TMode3Hit& operator=(const TMode3Hit& hit) { hit.Copy(*this); return *this; }
   ~TMode3Hit();
 
   virtual void Copy(TObject& obj) const;
@@ -21,7 +24,7 @@ public:
 
   //virtual void          InsertHit(const TDetectorHit& hit) { return;       }
   //virtual TDetectorHit& GetHit(const int &i=0)             { return hit; }
-  virtual size_t  Size()  const { return waveform.size();     }
+  virtual size_t  Size()  const { return HasRawWave() ? fRawWave.GetSize()/sizeof(Short_t) : waveform.size(); }
   double AverageWave(int samples=-1) const;
 
   void     BuildFrom(TSmartBuffer& buf);
@@ -33,7 +36,14 @@ public:
   Int_t    GetSegmentId() const { return GetVME()*10 + GetChannel(); }
   Int_t    GetAbsSegId()  const { return GetCrystal()*40 + GetSegmentId() ; }
   Int_t    GetCrystalId() const { return GetHole()*4 + GetCrystal(); }
-  const std::vector<Short_t>& GetWave() const { return waveform; }
+  const std::vector<Short_t>& GetWave() const;
+
+  // The waveform is kept in the raw buffer, unswapped, until GetWave() or
+  //   MaterializeWave() is called; TMode3 and TBank88 do so before being written.
+  // The swap is done once, under a lock, so a hit may be shared between threads.
+  bool HasRawWave() const { return fRawWave.GetSize(); }
+  const TSmartBuffer& GetRawWave() const { return fRawWave; }
+  void MaterializeWave() const;
 
   Long_t   GetLed()       const { return led; }
   Long_t   GetCfd()       const { return cfd; }
@@ -69,7 +79,9 @@ private:
   Int_t  wavesize; // In 16-bit elements
   Long_t led;
   Long_t cfd;
-  std::vector<Short_t> waveform;
+  mutable std::vector<Short_t> waveform;
+  TSmartBuffer fRawWave; //!
+  mutable std::atomic<bool> fWaveSwapped; //! waveform holds the swapped fRawWave
   UShort_t dt1;    // time diff between this led and previous (last) led
   UShort_t dt2;    // time diff between previous and previous-previouss (yep.) led
 
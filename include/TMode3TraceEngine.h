@@ -0,0 +1,70 @@
+#ifndef TMODE3TRACEENGINE_H
+#define TMODE3TRACEENGINE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Rtypes.h"
+
+class TMode3Hit;
+
+/// Quantities extracted from a single Mode3 waveform.
+struct TMode3TraceResult {
+  Int_t    crystal_id;
+  Int_t    segment_id;
+  Double_t baseline;  ///< Mean of the leading baseline samples.
+  Double_t pickoff;   ///< Mean of the trailing pickoff samples, minus the baseline.
+  Double_t trapezoid; ///< Maximum of the trapezoidal filter, in ADC units.
+};
+
+/// Batch processing of GRETINA Mode3 waveforms.
+/**
+  Mode3 waveforms are stored as big-endian 32-bit words, each holding two
+    samples in reverse order, so converting them is a byte reversal of each word.
+  This is done with SIMD shuffles straight from the raw TSmartBuffer.
+
+  Process() unpacks every waveform of an event into a single contiguous
+    buffer and computes the baseline, pickoff and trapezoid energies of
+    all segments in one pass.
+  The buffers are reused between calls, so no memory is allocated per hit
+    once the engine has seen its largest event.
+  Results and waveforms stay valid until the next call to Process().
+ */
+class TMode3TraceEngine {
+public:
+  TMode3TraceEngine();
+
+  /// Converts nsamples raw Mode3 samples into host order.
+  /**
+    nsamples is expected to be even, as the samples come in 32-bit words.
+   */
+  static void SwapWave(const char* raw, size_t nsamples, Short_t* output);
+
+  void SetBaselineSamples(int samples) { fBaselineSamples = samples; }
+  void SetPickoffSamples(int samples)  { fPickoffSamples  = samples; }
+  void SetTrapezoid(int rise, int gap) { fRise = rise; fGap = gap;   }
+
+  size_t Process(const TMode3Hit* hits, size_t nhits);
+  size_t Process(const std::vector<TMode3Hit>& hits);
+
+  size_t GetNumResults() const { return fResults.size(); }
+  const TMode3TraceResult& GetResult(size_t i) const { return fResults[i]; }
+
+  const Short_t* GetWave(size_t i)    const { return fWaves.data() + fWaveStart[i]; }
+  size_t         GetWaveSize(size_t i) const { return fWaveStart[i+1] - fWaveStart[i]; }
+
+private:
+  void ProcessWave(const Short_t* wave, size_t nsamples, TMode3TraceResult& result);
+
+  int fBaselineSamples;
+  int fPickoffSamples;
+  int fRise;
+  int fGap;
+
+  std::vector<Short_t> fWaves;
+  std::vector<size_t> fWaveStart;
+  std::vector<Int_t> fSums;
+  std::vector<TMode3TraceResult> fResults;
+};
+
+#endif /* TMODE3TRACEENGINE_H */
@@ -5,6 +5,13 @@
 #include <fstream>
 #include <string>
 
+#ifndef __CINT__
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 #include <zlib.h>
 
 #include "TObject.h"
@@ -12,6 +19,24 @@
 class TRawEvent;
 class TUnpackedEvent;
 
+/// Writes raw events back out, in the format they were read in.
+/**
+  Events are copied into one of two large, page-aligned buffers.  When
+    a buffer fills, it is handed to a writer thread, and the other one
+    is filled in the meantime, so that the caller only waits on the disk
+    if it gets a whole buffer ahead of it.
+
+  The output is compressed according to the extension: ".gz" with zlib,
+    on the writer thread, or ".zst" through a zstd process.  Either can
+    be read back in as an input file.  If zstd exits with an error, it is
+    reported when the file is closed, and the writes that failed before
+    then have made IsGood false.
+
+  The buffer size, in MB, can be set in .rootrc:
+  \code
+  GRUT.RawOutBufferMB:  16
+  \endcode
+ */
 class TRawFileOut : public TObject {
 public:
   TRawFileOut();
@@ -19,10 +44,24 @@ public:
   ~TRawFileOut();
 
   void Open(const std::string& filename);
+  /// Writes out what is buffered, waits for it, and closes the file.
+  void Close();
 
   void Write(TRawEvent& event);
   void Write(TUnpackedEvent& event);
 
+  /// Hands the buffered events to the writer thread, and waits until they are written.
+  void Flush();
+
+  bool IsOpen() const { return raw_file_out || gzip_file_out; }
+  /// False once a write has failed.
+  bool IsGood() const;
+
+  /// Bytes given to Write so far, before compression.
+  size_t GetBytesWritten() const { return bytes_total; }
+  /// Seconds the caller has spent waiting for the writer thread.
+  double GetSecondsWaiting() const { return seconds_waiting; }
+
 private:
   // Because CINT doesn't understand C++11.
   // Once we switch to ROOT6, the __CINT__ workaround can be removed.
@@ -31,14 +70,39 @@ private:
 #else
   TRawFileOut(const TRawFileOut&) = delete;
 #endif
-  void swap(TRawFileOut& other);
   void WriteBytes(const char* data, size_t size);
 
   void WriteUnbuiltEvent(TUnpackedEvent& event);
   void WriteBuiltNSCLEvent(TUnpackedEvent& event);
 
+  bool AllocateBuffers();
+  void HandOff();
+  void WriterLoop();
+  void WriteOut(const char* data, size_t size);
+
   FILE* raw_file_out;
   gzFile* gzip_file_out;
+  bool is_pipe;
+
+  char* buffers[2];
+  size_t buffer_capacity;
+  // The buffer being filled, and how much of it is.
+  int    fill_index;
+  size_t fill_size;
+
+  size_t bytes_total;
+  double seconds_waiting;
+
+#ifndef __CINT__
+  std::thread writer;
+  std::mutex writer_mutex;
+  std::condition_variable writer_cv;
+  // Bytes in buffers[pending_index] waiting to be written, 0 when the writer is free.
+  int    pending_index;
+  size_t pending_size;
+  bool stop_writer;
+  std::atomic_bool write_failed;
+#endif
 
   ClassDef(TRawFileOut, 0);
 };
@@ -59,6 +59,10 @@ public:
 
   // returns reaction input parameters
   TNucleus *GetNucleus(int part);
+#ifndef __CINT__
+  std::shared_ptr<TNucleus> GetNucleusPtr(int part) { return fNuc[part]; }
+#endif
+  double GetEBeam() { return fTBeam; } // as given to the constructor
   double GetM(int part) {  return fM[part]; }
   double GetExc() { return fExc; }
   double GetQVal() { return fQVal; }
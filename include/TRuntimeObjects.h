@@ -3,12 +3,16 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <set>
+#include <functional>
 #include <cmath>
 
 #include "TCutG.h"
 #include "TDirectory.h"
 #include "TList.h"
 
+#include "TCutRaster.h"
 #include "TUnpackedEvent.h"
 
 class TH1;
@@ -43,13 +47,35 @@ public:
   /// Returns a pointer to the detector of type T
   template<typename T>
   T* GetDetector(){
+    RequestDetector(T::Class_Name());
     return detectors->GetDetector<T>();
   }
-  TDetector *GetDetector(std::string dname) const { 
+  TDetector *GetDetector(std::string dname) const {
+    RequestDetector(dname.c_str());
     return detectors->GetDetector(dname);
   }
 
+  /// Number of raw fragments of the system in the event, unpacked or not; 0 when replaying a tree.
+  size_t GetFragmentCount(kDetectorSystems system) const {
+    return detectors->GetFragmentCount(system);
+  }
+  /// Raw fragments of the event, by system; empty when replaying a tree.
+  std::map<kDetectorSystems, std::vector<TRawEvent> >& GetRawData() {
+    return detectors->GetRawData();
+  }
+
+  /// Names of the detector classes asked for so far, whether or not they were in the event.
+  const std::set<std::string, std::less<> >& GetRequestedDetectors() const { return requested_detectors; }
+
+  /// The cut of that name from the cut files; each name is only looked up once.
   TCutG* GetCut(const std::string& name);
+  /// The cut of that name, rasterised on first use; NULL if there is no such cut.
+  const TCutRaster* GetCutRaster(const std::string& name);
+  /// Whether (x,y) is inside the cut of that name, false if there is no such cut.
+  bool IsInside(const std::string& name, double x, double y) {
+    const TCutRaster* raster = GetCutRaster(name);
+    return raster && raster->IsInside(x, y);
+  }
 
   TList& GetObjects();
   TList& GetGates();
@@ -301,6 +327,13 @@ public:
   void SetDetectors(TUnpackedEvent *det) { detectors = det; }
 
 private:
+  // Called for every GetDetector; only a name not seen before is copied.
+  void RequestDetector(const char* name) const {
+    if(requested_detectors.find(name) == requested_detectors.end()) {
+      requested_detectors.insert(name);
+    }
+  }
+
   static std::map<std::string,TRuntimeObjects*> fRuntimeMap;
   TUnpackedEvent *detectors;
   TList* objects;
@@ -309,7 +342,13 @@ private:
 
   TDirectory* directory;
 
+  mutable std::set<std::string, std::less<> > requested_detectors; //!
 
+#ifndef __CINT__
+  size_t cut_files_searched; //!
+  std::map<std::string, TCutG*> cut_registry; //!
+  std::map<std::string, std::unique_ptr<TCutRaster> > cut_rasters; //!
+#endif
 
   ClassDef(TRuntimeObjects, 0);
 };
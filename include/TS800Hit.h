@@ -123,15 +123,16 @@ class TCrdc : public TDetectorHit {
     int  Size()        const { return channel.size(); }
     int  GetNSamples() const { return sample.size(); }
 
-    void SetId(short id)    { fId = id;  }
+    void SetId(short id)    { fId = id; fReconstructed = false; }
     void SetAnode(short an) {anode = an; }
-    void SetTime(short ti)  {time = ti;  }
+    void SetTime(short ti)  {time = ti; fReconstructed = false; }
 
 
     int  Address(int i) const { return TDetectorHit::Address() + channel.at(i); }
     void AddPoint(int chan,int samp,int dat) { channel.push_back(chan);
                                                sample.push_back(samp);
-                                               data.push_back(dat);    }
+                                               data.push_back(dat);
+                                               fReconstructed = false; }
     int GetChannel(int i) const    { if(i>=Size()) return -1; return channel.at(i);    }
     int GetSample(int i)  const    { if(i>=Size()) return -1; return sample.at(i);     }
     int GetData(int i)    const    { if(i>=Size()) return -1; return data.at(i);       }
@@ -144,9 +145,22 @@ class TCrdc : public TDetectorHit {
     float GetNonDispersiveY(int);
 
     int GetMaxPad() const;
-    int GetMaxPadFast() const;
     int GetMaxPadSum() const;
 
+    /// Centre of gravity of the cluster around the max pad, in pads.
+    float GetPadCentroid() const;
+    /// RMS width of the cluster around the max pad, in pads.
+    float GetClusterWidth() const;
+    /// Calibrated charge summed over the cluster around the max pad.
+    float GetClusterCharge() const;
+
+    /// Calibrates every sample once and fills the cached cluster quantities.
+    /**
+      Called from the getters above, and again only once the data, the
+        TChannels or the GValues have changed.
+     */
+    void Reconstruct() const;
+
     virtual void Copy(TObject&) const;
     virtual void Print(Option_t *opt="") const;
     virtual void Clear(Option_t *opt="");
@@ -165,8 +179,19 @@ class TCrdc : public TDetectorHit {
 
     unsigned short anode;
     unsigned short time;
-    mutable bool has_cached_dispersive_x; //!
-    mutable double cached_dispersive_x; //!
+
+    int CalibratePads(double* pad_charge, double& max_charge) const;
+
+    mutable bool  fReconstructed;    //!
+    mutable unsigned int fChannelGeneration; //!
+    mutable unsigned int fValueGeneration;   //!
+    mutable int   fMaxPad;           //!
+    mutable float fMaxPadCharge;     //!
+    mutable float fPadCentroid;      //!
+    mutable float fClusterWidth;     //!
+    mutable float fClusterCharge;    //!
+    mutable float fDispersiveX;      //!
+    mutable float fNonDispersiveY;   //!
 
   ClassDef(TCrdc,1)
 };
@@ -5,8 +5,6 @@
 #include <iostream>
 #include <vector>
 
-#include <map>
-#include <utility>
 
 #include "TGraph.h"
 #include "TSpline.h"
@@ -20,10 +18,19 @@ public:
 
   void ReadEnergyLossFile(const char* filename, double emax = -1.0, double emin = 0.0,bool printfile = true);
 
-  double GetAdjustedEnergy(double energy_keV, double distance_um, double stepsize = dx);
-  double GetEnergyLost(double energy_keV, double distance_um, double stepsize = dx) {
+  // Energy left after distance_um, from the range-energy table.
+  // A positive stepsize steps through the target with the dE/dx spline instead.
+  double GetAdjustedEnergy(double energy_keV, double distance_um, double stepsize = 0) const;
+  double GetEnergyLost(double energy_keV, double distance_um, double stepsize = 0) const {
     return energy_keV-GetAdjustedEnergy(energy_keV, distance_um, stepsize);
   }
+  // GetAdjustedEnergy for n particles, output may be the same array as energy_keV.
+  void GetAdjustedEnergy(size_t n, const double* energy_keV, const double* distance_um, double* output) const;
+
+  // Distance (um) for the ion to slow from energy_keV to the lowest tabulated energy.
+  double GetRange(double energy_keV) const;
+  // Inverse of GetRange.
+  double GetEnergyAtRange(double range_um) const;
 
   double GetEnergy(double energy_keV, double dist_um);
   double GetEnergyChange(double energy_keV, double dist_um) {
@@ -56,7 +63,18 @@ private:
   double Emin, Emax, Xmin, Xmax;
   static const double dx; // um [sets accuracy of energy loss E vs X functions]
 
-  std::map<std::pair<double,double>,double> AdjustedEnergyMap;
+  void BuildRangeTable(double emin, double emax);
+  int TableIndex(double energy_keV) const;
+  double EnergyAtRange(double range_um, int hint) const;
+  double GetSteppedEnergy(double energy_keV, double distance_um, double stepsize) const;
+
+  // Range-energy table, equal steps in log(E).  Filled once when the file is
+  // read and only read afterwards, so it can be shared between threads.
+  std::vector<double> fTableE;    // keV
+  std::vector<double> fTableR;    // um, range from fTableE[0]
+  std::vector<double> fTableDEdX; // keV/um, at fTableE
+  double fTableLogEmin;
+  double fTableLogStep;
 
   ClassDef(TSRIM,0)
 };
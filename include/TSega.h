@@ -21,6 +21,8 @@ public:
 
   void SortHitsByTimestamp();
 
+  virtual void MaterializeTraces();
+
   virtual void SetRunStart(unsigned int unix_time);
 
   static TVector3 GetSegmentPosition(int detnum, int segnum);
@@ -37,6 +39,7 @@ private:
   virtual int BuildHits(std::vector<TRawEvent>& raw_data);
   static void LoadDetectorPositions();
   static void LoadSegmentMaps();
+  void RecycleTraces();
 
   std::vector<TSegaHit> sega_hits;
 
@@ -3,6 +3,7 @@
 
 #include "TDetectorHit.h"
 #include "TSegaSegmentHit.h"
+#include "TTraceView.h"
 
 #include "TMath.h"
 
@@ -34,12 +35,17 @@ public:
   }
 
   std::vector<unsigned short>* GetTrace(int segnum=0);
+  unsigned int GetTraceLength() const { return fTraceView.empty() ? fTrace.size() : fTraceView.size(); }
 
   void SetCFDFail(int cfdbit) { fCfdFail = cfdbit; }
   int GetCFDFail() const { return fCfdFail; }
 
 //  void SetTime(double time)            { fTime = time; }
   void SetTrace(unsigned int trace_length, const unsigned short* trace);
+  void SetTrace(const TTraceView& trace) { fTrace.clear(); fTraceView = trace; }
+  void MaterializeTrace(std::vector<unsigned short> buffer = std::vector<unsigned short>());
+  void ReleaseTrace(std::vector<unsigned short>& output) { output.clear(); output.swap(fTrace); fTraceView.Clear(); }
+  const TTraceView& GetTraceView() const { return fTraceView; }
 
   void SetEnergySumBool(bool sum = false) {fEsum = sum; }
   bool HasEnergySum() const {return fEsum; }
@@ -67,6 +73,7 @@ public:
 
 private:
   std::vector<unsigned short> fTrace;
+  TTraceView fTraceView; //!
   std::vector<TSegaSegmentHit> fSegments;
   int fEnSum[4];
   bool fEsum;
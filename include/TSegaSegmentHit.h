@@ -2,6 +2,7 @@
 #define _TSEGASEGMENTHIT_H_
 
 #include "TDetectorHit.h"
+#include "TTraceView.h"
 
 #define MAX_TRACE_LENGTH 100
 
@@ -17,9 +18,14 @@ public:
 
   int GetSegnum() const;
 
-  std::vector<unsigned short>& GetTrace() { return fTrace; }
+  std::vector<unsigned short>& GetTrace() { MaterializeTrace(); return fTrace; }
+  unsigned int GetTraceLength() const { return fTraceView.empty() ? fTrace.size() : fTraceView.size(); }
 
   void SetTrace(unsigned int trace_length, const unsigned short* trace);
+  void SetTrace(const TTraceView& trace) { fTrace.clear(); fTraceView = trace; }
+  void MaterializeTrace(std::vector<unsigned short> buffer = std::vector<unsigned short>());
+  void ReleaseTrace(std::vector<unsigned short>& output) { output.clear(); output.swap(fTrace); fTraceView.Clear(); }
+  const TTraceView& GetTraceView() const { return fTraceView; }
 
   int GetSlot() const;
   int GetCrate() const;
@@ -27,6 +33,7 @@ public:
 
 private:
   std::vector<unsigned short> fTrace;
+  TTraceView fTraceView; //!
 
   ClassDef(TSegaSegmentHit,3);
 };
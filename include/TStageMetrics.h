@@ -0,0 +1,92 @@
+#ifndef _TSTAGEMETRICS_H_
+#define _TSTAGEMETRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/// Timing of one pipeline stage, kept by the thread that runs it.
+/**
+  StoppableThread::Loop times each Iteration.  The ThreadsafeQueue calls
+    made during it are charged to the stage of the calling thread: time
+    spent waiting for an item to pop (starved) or for room to push
+    (backed up), and the number of items moved.  An iteration that moved
+    an item counts as one event, and the rest of its time as busy, with
+    its length going into a log2 latency histogram.  Iterations that
+    moved nothing are idle.
+
+  All counters can be read from other threads while the stage runs.
+ */
+class TStageMetrics {
+public:
+  TStageMetrics();
+
+  /// Metrics of the stage running on this thread, or nullptr.
+  static TStageMetrics*& Current() {
+    static thread_local TStageMetrics* current = nullptr;
+    return current;
+  }
+
+  void BeginIteration();
+  void EndIteration();
+
+  void AddPopWait(std::chrono::steady_clock::duration wait)  { AddWait(pop_wait_ns, wait); }
+  void AddPushWait(std::chrono::steady_clock::duration wait) { AddWait(push_wait_ns, wait); }
+  void ItemPopped() { items_in++;  moved_item = true; }
+  void ItemPushed() { items_out++; moved_item = true; }
+
+  enum { kLatencyBins = 40 };
+
+  struct Snapshot {
+    uint64_t events;
+    uint64_t items_in;
+    uint64_t items_out;
+    double elapsed_seconds;
+    double busy_seconds;
+    double idle_seconds;
+    double pop_wait_seconds;
+    double push_wait_seconds;
+    uint64_t latency[kLatencyBins];
+
+    double EventsPerSecond() const { return elapsed_seconds > 0 ? events/elapsed_seconds : 0; }
+    double BusyFraction() const    { return elapsed_seconds > 0 ? busy_seconds/elapsed_seconds : 0; }
+    /// Upper edge of the latency bin holding quantile q, in seconds.
+    double LatencyQuantile(double q) const;
+  };
+  Snapshot Get() const;
+
+  /// Upper edge of latency bin i, in nanoseconds.
+  static double LatencyBinEdge(int bin) { return double(uint64_t(1) << bin); }
+
+  /// JSON object of the snapshot, without the stage name.
+  static std::string Json(const Snapshot& snap);
+
+private:
+  TStageMetrics(const TStageMetrics&) = delete;
+  TStageMetrics& operator=(const TStageMetrics&) = delete;
+
+  void AddWait(std::atomic<uint64_t>& total, std::chrono::steady_clock::duration wait) {
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+    total += ns;
+    waited_ns += ns;
+  }
+
+  // Only touched by the stage's own thread.
+  std::chrono::steady_clock::time_point iteration_start;
+  uint64_t waited_ns;
+  bool moved_item;
+
+  std::atomic<int64_t>  first_ns;
+  std::atomic<int64_t>  last_ns;
+  std::atomic<uint64_t> events;
+  std::atomic<uint64_t> items_in;
+  std::atomic<uint64_t> items_out;
+  std::atomic<uint64_t> busy_ns;
+  std::atomic<uint64_t> idle_ns;
+  std::atomic<uint64_t> pop_wait_ns;
+  std::atomic<uint64_t> push_wait_ns;
+  std::atomic<uint64_t> latency[kLatencyBins];
+};
+
+#endif /* _TSTAGEMETRICS_H_ */
@@ -0,0 +1,51 @@
+#ifndef _TTRACEVIEW_H_
+#define _TTRACEVIEW_H_
+
+#include <vector>
+
+#include "TSmartBuffer.h"
+
+/// A non-owning view of an ADC trace inside a raw data buffer.
+/**
+  TTraceView refers to the samples of a trace where they sit in the raw
+    TSmartBuffer, without copying them.
+  Since TSmartBuffer is reference-counted, the raw buffer stays alive for
+    as long as any view of it exists.
+
+  Hits keep a view until the trace is explicitly requested, or until the
+    hit is written to a TTree, at which point the samples are copied into
+    the hit's own std::vector.
+ */
+class TTraceView {
+public:
+  TTraceView() : fLength(0) { }
+
+  /// Constructs a view of the first trace_length samples of buf.
+  TTraceView(const TSmartBuffer& buf, size_t trace_length)
+    : fBuffer(buf.BufferSubset(0, trace_length*sizeof(unsigned short))),
+      fLength(fBuffer.GetSize()/sizeof(unsigned short)) { }
+
+  void Clear() {
+    fBuffer.Clear();
+    fLength = 0;
+  }
+
+  size_t size() const { return fLength; }
+  bool   empty() const { return fLength == 0; }
+
+  const unsigned short* data()  const { return (const unsigned short*)fBuffer.GetData(); }
+  const unsigned short* begin() const { return data(); }
+  const unsigned short* end()   const { return data() + fLength; }
+  unsigned short operator[](size_t i) const { return data()[i]; }
+
+  /// Copies the samples into output, reusing its capacity.
+  void CopyTo(std::vector<unsigned short>& output) const {
+    output.assign(begin(), end());
+  }
+
+private:
+  TSmartBuffer fBuffer;
+  size_t fLength;
+};
+
+#endif /* _TTRACEVIEW_H_ */
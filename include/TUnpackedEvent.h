@@ -4,6 +4,7 @@
 #ifndef __CINT__
 #include <type_traits>
 #endif
+#include <set>
 
 #include "TClass.h"
 
@@ -11,6 +12,12 @@
 #include "TGRUTTypes.h"
 #include "TRawEvent.h"
 
+/// The detectors of one event, and the raw fragments they are built from.
+/**
+  Build() unpacks every system with raw data.  Until then, GetDetector<T>()
+    unpacks only the systems that make a T, the first time it is asked
+    for, so a filter can look at one detector without paying for the rest.
+ */
 class TUnpackedEvent {
 public:
   TUnpackedEvent();
@@ -25,7 +32,14 @@ public:
   void AddRawData(const TRawEvent& event, kDetectorSystems detector);
   void ClearRawData();
 
+  /// Unpacks every system not unpacked yet.
   void Build();
+  /// Whether there are raw fragments not unpacked yet.
+  bool HasUnbuiltData() const { return built_systems.size() < raw_data_map.size(); }
+  /// Number of raw fragments of the system, whether unpacked or not.
+  size_t GetFragmentCount(kDetectorSystems system) const;
+
+  /// Applies to the detectors built so far, and to any built later.
   void SetRunStart(unsigned int unix_time);
 
   int Size() { return detectors.size(); }
@@ -34,9 +48,14 @@ public:
 
 private:
   TDetector* GetDetector(kDetectorSystems detector, bool make_if_not_found = false);
+  TDetector* BuildSystem(kDetectorSystems detector);
+  TDetector* BuildDetector(TClass* cls);
 
   std::vector<TDetector*> detectors;
   std::map<kDetectorSystems, std::vector<TRawEvent> > raw_data_map;
+  std::set<kDetectorSystems> built_systems;
+  unsigned int run_start;
+  bool has_run_start;
 };
 
 #ifndef __CINT__
@@ -51,6 +70,13 @@ T* TUnpackedEvent::GetDetector(bool make_if_not_found) {
     }
   }
 
+  if(HasUnbuiltData()) {
+    T* output = dynamic_cast<T*>(BuildDetector(T::Class()));
+    if(output){
+      return output;
+    }
+  }
+
   if(make_if_not_found) {
     T* output = new T;
     detectors.push_back(output);
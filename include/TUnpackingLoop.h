@@ -35,6 +35,10 @@ public:
   size_t GetItemsCurrent() { return output_queue->Size();        }
   size_t GetRate()         { return 0; }
 
+  /// Pass events on before unpacking them, for a pre-filter further down to unpack.
+  void SetDeferBuild(bool defer) { fDeferBuild = defer; }
+  bool GetDeferBuild() const { return fDeferBuild; }
+
 private:
   TUnpackingLoop(std::string name);
   TUnpackingLoop(const TUnpackingLoop& other);
@@ -52,6 +56,7 @@ private:
   TUnpackedEvent* fOutputEvent;
 
   unsigned int fRunStart;
+  bool fDeferBuild;
 
 #ifndef __CINT__
   std::shared_ptr<ThreadsafeQueue<std::vector<TRawEvent> > > input_queue;
@@ -1,7 +1,13 @@
 #ifndef _TWRITELOOP_H_
 #define _TWRITELOOP_H_
 
+#ifndef __CINT__
+#include <chrono>
+#endif
+
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "TClass.h"
 #include "TTree.h"
@@ -10,6 +16,30 @@
 #include "ThreadsafeQueue.h"
 #include "TUnpackedEvent.h"
 
+/// Writes the unpacked detectors to "EventTree", one branch per TDetector class.
+/**
+  Branches are declared before the first event is written, one for each
+    detector system in the TDetectorEnv, so that no branch has to be
+    back-filled later.  A detector class that shows up anyway is added
+    when it is first seen, and back-filled as before.
+
+  Basket size, compression and auto-flush apply to every branch, and can
+    be set per branch in .rootrc:
+  \code
+  GRUT.BasketSize.TGretina:   256000
+  GRUT.Compression.TGretina:  404
+  \endcode
+
+  The tree format selects EventTree, the flat tables of TFlatWriter,
+    or both, in the same file.
+
+  With more than one write thread, each thread fills its own tree in a
+    TBufferMerger file, which merges them into the output file.  Events
+    are still passed on in the order they came in, but the entry order
+    in the tree is only kept within each auto-flush cluster.
+    A merged tree cannot be given a branch later, so with write threads
+    every detector class that can be unpacked has a branch from the start.
+ */
 class TWriteLoop : public StoppableThread {
 public:
   static TWriteLoop* Get(std::string name="", std::string output_filename="");
@@ -25,27 +55,76 @@ public:
 
   void Write();
 
+  /// Whether to write EventTree, and the flat FlatEvents/FlatGretinaHits tables.
+  void SetTreeFormat(bool object_tree, bool flat_tables);
+  /// Number of threads filling trees; 1 fills the one tree from this thread.
+  void SetWriteThreads(int nthreads);
+  /// Basket size in bytes for new branches, 0 for the ROOT default.
+  void SetBasketSize(int bytes)             { fBasketSize = bytes; }
+  /// ROOT compression setting (ex. 404 for LZ4 level 4), -1 for the file default.
+  void SetCompression(int setting)          { fCompression = setting; }
+  /// As TTree::SetAutoFlush, 0 for the ROOT default.
+  void SetAutoFlush(Long64_t autoflush)     { fAutoFlush = autoflush; }
+
+  int      GetWriteThreads() const { return fWriteThreads; }
+  int      GetBasketSize()   const { return fBasketSize; }
+  int      GetCompression()  const { return fCompression; }
+  Long64_t GetAutoFlush()    const { return fAutoFlush; }
+
+  /// Bytes serialised into the trees so far, before compression.
+  double GetBytesFilled() const;
+  /// Uncompressed MB/s since the first event.
+  double GetMBPerSecond() const;
+
+  virtual std::string Status();
+
   size_t GetItemsPushed()  { return items_handled; }
   size_t GetItemsPopped()  { return 0; }
   size_t GetItemsCurrent() { return 0;      }
-  size_t GetRate()         { return 0; }
+  size_t GetRate()         { return size_t(GetMBPerSecond()); }
 
 protected:
   bool Iteration();
 
 private:
   TWriteLoop(std::string name, std::string output_file);
+
+  void Setup();
+  void DeclareBranches();
   void AddBranch(TClass* cls);
 
   void WriteEvent(TUnpackedEvent& event);
+  void PrintSummary(double bytes_filled);
+
+  std::string output_filename;
   TFile* output_file;
   TTree* event_tree;
-  std::map<TClass*, TDetector**> det_map;
-  std::map<TClass*, TDetector*> default_dets;
+
+  bool     fObjectTree;
+  bool     fFlatTables;
+  int      fWriteThreads;
+  int      fBasketSize;
+  int      fCompression;
+  Long64_t fAutoFlush;
+  bool     fIsSetup;
 
   size_t items_handled;
 
 #ifndef __CINT__
+  struct TreeFiller;
+  struct Parallel;
+
+  TreeFiller* NewFiller();
+  bool ParallelIteration(TUnpackedEvent* event);
+  void PassOnWritten(bool wait_for_all);
+  void StopWriteThreads();
+
+  std::vector<std::unique_ptr<TreeFiller> > fillers;
+  std::unique_ptr<Parallel> parallel;
+  std::vector<TClass*> branch_classes;
+
+  std::chrono::steady_clock::time_point start_time;
+
   std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> > input_queue;
   std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> > output_queue;
 #endif
@@ -10,6 +10,8 @@
 #include <condition_variable>
 #include <mutex>
 #include <queue>
+
+#include "TStageMetrics.h"
 #endif
 
 #include "TRawEvent.h"
@@ -65,8 +67,16 @@ ThreadsafeQueue<T>::~ThreadsafeQueue() { }
 template<typename T>
 int ThreadsafeQueue<T>::Push(T obj) {
   std::unique_lock<std::mutex> lock(mutex);
+  TStageMetrics* metrics = TStageMetrics::Current();
   if(queue.size() > max_queue_size){
+    auto start = std::chrono::steady_clock::now();
     can_push.wait(lock);
+    if(metrics) {
+      metrics->AddPushWait(std::chrono::steady_clock::now() - start);
+    }
+  }
+  if(metrics) {
+    metrics->ItemPushed();
   }
 
   items_pushed++;
@@ -80,13 +90,22 @@ int ThreadsafeQueue<T>::Push(T obj) {
 template<typename T>
 int ThreadsafeQueue<T>::Pop(T& output, int millisecond_wait) {
   std::unique_lock<std::mutex> lock(mutex);
-  if(!queue.size()){
+  TStageMetrics* metrics = TStageMetrics::Current();
+  // Nothing more will come once finished, so there is no point in waiting.
+  if(!queue.size() && !is_finished){
+    auto start = std::chrono::steady_clock::now();
     can_pop.wait_for(lock, std::chrono::milliseconds(millisecond_wait));
+    if(metrics) {
+      metrics->AddPopWait(std::chrono::steady_clock::now() - start);
+    }
   }
 
   if(!queue.size()){
     return -1;
   }
+  if(metrics) {
+    metrics->ItemPopped();
+  }
 
   output = queue.front();
   queue.pop();
@@ -123,7 +142,10 @@ bool ThreadsafeQueue<T>::IsFinished() const {
 
 template<typename T>
 void ThreadsafeQueue<T>::SetFinished(bool finished) {
+  std::unique_lock<std::mutex> lock(mutex);
   is_finished = finished;
+  // Wakes anyone waiting to pop, rather than leaving them to time out.
+  can_pop.notify_all();
 }
 #endif /* __CINT__ */
 
@@ -0,0 +1,423 @@
+#include <GFitPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include <TROOT.h>
+#include <TH1.h>
+#include <TF1.h>
+#include <Fit/BinData.h>
+#include <Fit/Fitter.h>
+#include <Fit/FitResult.h>
+#include <Math/Factory.h>
+#include <Math/Minimizer.h>
+#include <Math/MinimizerOptions.h>
+#include <Math/WrappedMultiTF1.h>
+
+#include "GPhotoPeakFitter.h"
+#include "GRootFunctions.h"
+#include "Globals.h"
+#include "TChannel.h"
+
+namespace {
+  // gaus(0)+pol1(3), as GGaus, without a TFormula.
+  Double_t GausBG(Double_t *dim, Double_t *par) {
+    double arg = (dim[0] - par[1])/par[2];
+    return par[0]*std::exp(-0.5*arg*arg) + par[3] + par[4]*dim[0];
+  }
+
+  const int kPhotoPeakPars = 7;
+  const int kGausPars      = 5;
+}
+
+/// Fit function and window histogram of one thread.
+class GFitPool::Worker {
+public:
+  Worker(EModel model)
+    : model(model),
+      window("GFitPool_window", "", 1, 0, 1),
+      func(model!=kGaus ? "GFitPool_photopeakbg" : "GFitPool_gausbg",
+           model!=kGaus ? GRootFunctions::PhotoPeakBG : GausBG,
+           0, 1, model!=kGaus ? kPhotoPeakPars : kGausPars, 1, TF1::EAddToList::kNo) {
+    window.SetDirectory(0);
+    window.Sumw2();
+  }
+
+  Result Fit(const Task& task, double min_counts);
+
+  /// Minimizer of each fit; Minuit2 unless it is not available.
+  static ROOT::Math::MinimizerOptions options;
+
+private:
+  void FillWindow(const Task& task);
+  void InitParams();
+  bool FitFunction(ROOT::Fit::FitResult& fitres);
+  double Peak(double x, const double* par) const;
+  double Background(double x, const double* par) const;
+  double PeakSum(const double* par) const;
+
+  EModel model;
+  TH1D window;
+  TF1 func;
+  GPhotoPeakFitter fitter;
+};
+
+ROOT::Math::MinimizerOptions GFitPool::Worker::options;
+
+void GFitPool::Worker::FillWindow(const Task& task) {
+  const TAxis* axis = (task.axis==TH1::kYaxis) ? task.hist->GetYaxis() : task.hist->GetXaxis();
+  int binlow  = std::max(1, axis->FindBin(task.low));
+  int binhigh = std::min(axis->GetNbins(), axis->FindBin(task.high));
+  if(binhigh < binlow) {
+    binhigh = binlow;
+  }
+
+  // SetBins empties the window, and keeps it out of any directory.
+  window.SetBins(binhigh - binlow + 1, axis->GetBinLowEdge(binlow), axis->GetBinUpEdge(binhigh));
+  // Read through TH1, which GH2 is built on rather than TH2.
+  const TH1* hist2 = (task.bin > 0) ? task.hist : 0;
+  for(int i=binlow; i<=binhigh; i++) {
+    double content, error;
+    if(!hist2) {
+      content = task.hist->GetBinContent(i);
+      error   = task.hist->GetBinError(i);
+    } else if(task.axis==TH1::kYaxis) {
+      content = hist2->GetBinContent(task.bin, i);
+      error   = hist2->GetBinError(task.bin, i);
+    } else {
+      content = hist2->GetBinContent(i, task.bin);
+      error   = hist2->GetBinError(i, task.bin);
+    }
+    window.SetBinContent(i - binlow + 1, content);
+    window.SetBinError(i - binlow + 1, error);
+  }
+  func.SetRange(window.GetXaxis()->GetXmin(), window.GetXaxis()->GetXmax());
+}
+
+void GFitPool::Worker::InitParams() {
+  // The guesses of GPeak::InitParams and GGaus::InitParams, from the ends of the window.
+  int nbins = window.GetNbinsX();
+  double xlow  = window.GetXaxis()->GetXmin();
+  double xhigh = window.GetXaxis()->GetXmax();
+  int nedge = std::min(5, nbins);
+  double highy = 0;
+  double lowy  = 0;
+  for(int x=0; x<nedge; x++) {
+    highy += window.GetBinContent(1 + x);
+    lowy  += window.GetBinContent(nbins - x);
+  }
+  highy /= nedge;
+  lowy  /= nedge;
+  if(lowy > highy) std::swap(lowy,highy);
+
+  double largestx = 0.0;
+  double largesty = 0.0;
+  for(int i=1; i<=nbins; i++) {
+    if(window.GetBinContent(i) > largesty) {
+      largesty = window.GetBinContent(i);
+      largestx = window.GetXaxis()->GetBinCenter(i);
+    }
+  }
+  double sigma = (largestx*.01)/2.35;
+
+  if(model!=kGaus) {
+    double step = (largesty > 0) ? (highy-lowy)/largesty*50 : 0;
+    double offset = lowy;
+
+    func.SetParLimits(0, 0, largesty*2);
+    func.SetParLimits(1, xlow, xhigh);
+    func.SetParLimits(2, 0.1, xhigh - xlow);
+    func.SetParLimits(3, 0.0, 40);
+    func.SetParLimits(4, 0.01, 5);
+    func.SetParLimits(5, 0.0, step + step);
+    func.SetParLimits(6, offset-0.5*offset, offset+offset);
+
+    func.SetParameter(0, largesty);
+    func.SetParameter(1, largestx);
+    func.SetParameter(2, sigma);
+    func.SetParameter(3, 5.);
+    func.SetParameter(4, 1.);
+    func.SetParameter(5, step);
+    func.SetParameter(6, offset);
+
+    func.SetParError(0, 0.10 * largesty);
+    func.SetParError(1, 0.25);
+    func.SetParError(2, 0.10 * sigma);
+    func.SetParError(3, 5);
+    func.SetParError(4, 0.5);
+    func.SetParError(5, 0.10 * step);
+    func.SetParError(6, 0.10 * offset);
+  } else {
+    func.SetParLimits(0, 0, largesty*2);
+    func.SetParLimits(1, xlow, xhigh);
+    func.SetParLimits(2, 0, xhigh - xlow);
+
+    func.SetParameter(0, largesty);
+    func.SetParameter(1, largestx);
+    func.SetParameter(2, sigma);
+    func.SetParameter(3, lowy);
+    func.SetParameter(4, 0);
+
+    func.SetParError(0, 0.10 * largesty);
+    func.SetParError(1, 0.25);
+    func.SetParError(2, 0.10 * sigma);
+  }
+}
+
+double GFitPool::Worker::Peak(double x, const double* par) const {
+  double p[kPhotoPeakPars];
+  std::copy(par, par + func.GetNpar(), p);
+  if(model!=kGaus) {
+    return GRootFunctions::PhotoPeak(&x, p);
+  }
+  double arg = (x - p[1])/p[2];
+  return p[0]*std::exp(-0.5*arg*arg);
+}
+
+double GFitPool::Worker::Background(double x, const double* par) const {
+  if(model!=kGaus) {
+    double spar[4] = {par[0], par[1], par[2], par[5]};
+    return GRootFunctions::StepFunction(&x, spar) + par[6];
+  }
+  return par[3] + par[4]*x;
+}
+
+double GFitPool::Worker::PeakSum(const double* par) const {
+  double sum = 0;
+  for(int i=1; i<=window.GetNbinsX(); i++) {
+    sum += Peak(window.GetXaxis()->GetBinCenter(i), par);
+  }
+  return sum;
+}
+
+bool GFitPool::Worker::FitFunction(ROOT::Fit::FitResult& fitres) {
+  // A Poisson likelihood fit, as TH1::Fit with "L", but with a Fitter and
+  //   minimizer of its own rather than the global TVirtualFitter.
+  ROOT::Fit::BinData data(window.GetNbinsX(), 1);
+  for(int i=1; i<=window.GetNbinsX(); i++) {
+    data.Add(window.GetXaxis()->GetBinCenter(i), window.GetBinContent(i));
+  }
+
+  ROOT::Math::WrappedMultiTF1 wrapped(func, 1);
+  ROOT::Fit::Fitter fitter;
+  fitter.Config().SetMinimizerOptions(options);
+  fitter.SetFunction(wrapped, false);
+  for(int i=0; i<func.GetNpar(); i++) {
+    ROOT::Fit::ParameterSettings& settings = fitter.Config().ParSettings(i);
+    double low, high;
+    func.GetParLimits(i, low, high);
+    // As TF1: equal limits fix the parameter, unless both are zero.
+    if(low*high != 0 && low >= high) {
+      settings.Fix();
+    } else if(low < high) {
+      settings.SetLimits(low, high);
+    }
+    double step = func.GetParError(i);
+    settings.SetStepSize(step > 0 ? step : 0.1*std::abs(func.GetParameter(i)) + 0.01);
+  }
+
+  if(!fitter.LikelihoodFit(data, true)) {
+    return false;
+  }
+  fitres = fitter.Result();
+  if(!fitres.IsValid()) {
+    return false;
+  }
+  func.SetParameters(fitres.GetParams());
+  func.SetParErrors(fitres.GetErrors());
+  return true;
+}
+
+GFitPool::Result GFitPool::Worker::Fit(const Task& task, double min_counts) {
+  Result result;
+  result.index    = task.index;
+  result.address  = task.index;
+  result.valid    = false;
+  result.low      = task.low;
+  result.high     = task.high;
+  result.centroid = result.centroid_err = 0;
+  result.fwhm     = result.fwhm_err     = 0;
+  result.area     = result.area_err     = 0;
+  result.sum      = result.sum_err      = 0;
+  result.chi2     = 0;
+  result.ndf      = 0;
+
+  FillWindow(task);
+  result.counts = window.Integral();
+  if(result.counts < min_counts) {
+    return result;
+  }
+
+  // Parameters, errors and covariance of the fit, from TF1 or GPhotoPeakFitter.
+  const double* par;
+  std::function<double(int,int)> covariance;
+  ROOT::Fit::FitResult fitres;
+  if(model==kAnalyticPhotoPeak) {
+    int nbins = window.GetNbinsX();
+    fitter.SetData(&window, window.GetXaxis()->GetBinCenter(1), window.GetXaxis()->GetBinCenter(nbins));
+    if(!fitter.Seed() || !fitter.Fit()) {
+      return result;
+    }
+    par = fitter.GetParameters();
+    covariance = [this](int i, int j) { return fitter.GetCovariance(i,j); };
+    result.centroid_err = fitter.GetParError(GPhotoPeakFitter::kCentroid);
+    result.fwhm_err     = fitter.GetParError(GPhotoPeakFitter::kSigma)*2.3548;
+    result.chi2         = fitter.GetChisquare();
+    result.ndf          = fitter.GetNDF();
+  } else {
+    InitParams();
+    if(!FitFunction(fitres) && !FitFunction(fitres)) {
+      return result;
+    }
+    par = func.GetParameters();
+    covariance = [&fitres](int i, int j) { return fitres.CovMatrix(i,j); };
+    result.centroid_err = func.GetParError(1);
+    result.fwhm_err     = func.GetParError(2)*2.3548;
+    result.chi2         = fitres.Chi2();
+    result.ndf          = fitres.Ndf();
+  }
+
+  result.valid    = true;
+  result.centroid = par[1];
+  result.fwhm     = par[2]*2.3548;
+
+  // The peak is summed over the bins, with the error from the covariance
+  //   of its own parameters.
+  int npeak = (model!=kGaus) ? 5 : 3;
+  result.area = PeakSum(par);
+  std::vector<double> p(par, par + func.GetNpar());
+  std::vector<double> gradient(npeak);
+  for(int i=0; i<npeak; i++) {
+    double h = 1e-4*std::max(std::abs(p[i]), 1e-3);
+    p[i] += h;
+    gradient[i] = (PeakSum(p.data()) - result.area)/h;
+    p[i] = par[i];
+  }
+  double variance = 0;
+  for(int i=0; i<npeak; i++) {
+    for(int j=0; j<npeak; j++) {
+      variance += gradient[i]*gradient[j]*covariance(i,j);
+    }
+  }
+  result.area_err = std::sqrt(std::max(variance, 0.0));
+
+  double background = 0;
+  for(int i=1; i<=window.GetNbinsX(); i++) {
+    background += Background(window.GetXaxis()->GetBinCenter(i), par);
+  }
+  result.sum     = result.counts - background;
+  result.sum_err = std::sqrt(result.counts);
+  return result;
+}
+
+GFitPool::GFitPool(EModel model, int nthreads)
+  : fModel(model), fThreads(nthreads) {
+  if(fThreads <= 0) {
+    fThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+void GFitPool::Add(int index, const TH1* hist, double low, double high) {
+  if(!hist) return;
+  if(low>high) std::swap(low,high);
+  fTasks.push_back({index, hist, TH1::kXaxis, 0, low, high});
+}
+
+void GFitPool::AddProjection(int index, const TH1* hist, int axis, int bin, double low, double high) {
+  if(!hist || bin < 1) return;
+  if(low>high) std::swap(low,high);
+  fTasks.push_back({index, hist, (axis==TH1::kYaxis) ? TH1::kYaxis : TH1::kXaxis, bin, low, high});
+}
+
+std::vector<GFitPool::Result> GFitPool::Fit(double min_counts) {
+  std::vector<Result> results(fTasks.size());
+  if(fTasks.empty()) {
+    return results;
+  }
+
+  // Each fit has a Fitter and minimizer of its own, and Minuit2 is
+  //   thread safe.  Should Minuit2 be missing, the fits fall back to the
+  //   default minimizer, which may be TMinuit and its global gMinuit, and
+  //   are done one at a time.
+  Worker::options = ROOT::Math::MinimizerOptions();
+  Worker::options.SetMaxFunctionCalls(100000);
+  Worker::options.SetMaxIterations(100000);
+  Worker::options.SetPrintLevel(0);
+  std::unique_ptr<ROOT::Math::Minimizer> minuit2(ROOT::Math::Factory::CreateMinimizer("Minuit2", "Migrad"));
+  bool thread_safe = (fModel==kAnalyticPhotoPeak) || minuit2;
+  if(minuit2) {
+    Worker::options.SetMinimizerType("Minuit2");
+    Worker::options.SetMinimizerAlgorithm("Migrad");
+  }
+
+  int nthreads = thread_safe ? std::min(size_t(fThreads), fTasks.size()) : 1;
+  if(nthreads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+
+  std::vector<std::unique_ptr<Worker> > workers;
+  bool add_directory = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(false);
+  for(int i=0; i<nthreads; i++) {
+    workers.emplace_back(new Worker(fModel));
+  }
+  TH1::AddDirectory(add_directory);
+
+  std::atomic<size_t> next(0);
+  auto work = [&](Worker* worker) {
+    size_t i;
+    while((i = next++) < fTasks.size()) {
+      results[i] = worker->Fit(fTasks[i], min_counts);
+    }
+  };
+
+  if(nthreads == 1) {
+    work(workers[0].get());
+  } else {
+    std::vector<std::thread> threads;
+    for(auto& worker : workers) {
+      threads.emplace_back(work, worker.get());
+    }
+    for(auto& thread : threads) {
+      thread.join();
+    }
+  }
+  return results;
+}
+
+int GFitPool::SetGains(const std::vector<Result>& results, double energy) {
+  int set = 0;
+  for(auto& result : results) {
+    if(!result.valid || result.centroid <= 0) {
+      continue;
+    }
+    TChannel* chan = TChannel::GetChannel(result.address);
+    if(!chan) {
+      continue;
+    }
+    chan->SetEnergyCoeff({0, energy/result.centroid});
+    set++;
+  }
+  return set;
+}
+
+void GFitPool::Print(const std::vector<Result>& results) {
+  printf("%6s %12s %10s %9s %12s %10s %12s %9s\n",
+         "index", "centroid", "+/-", "fwhm", "area", "+/-", "sum", "chi2/ndf");
+  for(auto& result : results) {
+    if(!result.valid) {
+      printf(DRED "%6i   not fit, %.0f counts in %.1f to %.1f" RESET_COLOR "\n",
+             result.index, result.counts, result.low, result.high);
+      continue;
+    }
+    printf("%6i %12.3f %10.3f %9.3f %12.1f %10.1f %12.1f %9.2f\n",
+           result.index, result.centroid, result.centroid_err, result.fwhm,
+           result.area, result.area_err, result.sum,
+           result.ndf ? result.chi2/result.ndf : 0.);
+  }
+}
@@ -14,6 +14,7 @@
 #include <GH2.h>
 #include <GH1D.h>
 #include <GPeak.h>
+#include <GFitPool.h>
 #include <GRootCommands.h>
 
 #include "TROOT.h"
@@ -3061,39 +3062,30 @@ GH1 *GH2::GetNext(TObject *obj,int direction) const {
 
 std::map<int,double> GH2::FitSummary(double low,double high,int axis,Option_t *opt) const {
   std::map<int,double> chan_area;
-  int binlow,binhigh;
   if(low>high)
     std::swap(low,high);
 
   //switch on option 
   //TF1 *fit = PhotoPeakFitNormBG(h,low,high,"");
 
+  // Every row (or column) is fit at once, on its own thread.
+  GFitPool pool;
   switch(axis) {
     case kXaxis:
       printf(" project onto x...\n");
-      binlow  = this->GetXaxis()->FindBin(low);
-      binhigh = this->GetXaxis()->FindBin(high);
-      for(int y=1;y<=this->GetNbinsY();y++) {
-        GH1D *p = this->ProjectionX("_px",y,y);//binlow,binhigh);
-        if(p->Integral(binlow,binhigh)<10)
-          continue;
-        GPeak *peak = PhotoPeakFitNormBG(p,low,high,"");
-        chan_area[y] = peak->GetSum();
-      }
+      for(int y=1;y<=this->GetNbinsY();y++)
+        pool.AddProjection(y,this,kXaxis,y,low,high);
       break;
     case kYaxis:
       printf(" project onto y...\n");
-      binlow  = this->GetYaxis()->FindBin(low);
-      binhigh = this->GetYaxis()->FindBin(high);
-      for(int x=1;x<=this->GetNbinsY();x++) {
-        GH1D *p = this->ProjectionY("_py",x,x);//binlow,binhigh);
-        if(p->Integral(binlow,binhigh)<10)
-          continue;
-        GPeak *peak = PhotoPeakFitNormBG(p,low,high,"");
-        chan_area[x] = peak->GetSum();
-      }
+      for(int x=1;x<=this->GetNbinsX();x++)
+        pool.AddProjection(x,this,kYaxis,x,low,high);
       break;
   }
+  for(auto& result : pool.Fit(10)) {
+    if(result.valid)
+      chan_area[result.index] = result.sum;
+  }
 
   std::map<int,double>::iterator it;
   printf("\n  %s  sum for %.02f to %.02f \n\n",this->GetName(),low,high);
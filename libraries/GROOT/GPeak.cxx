@@ -4,13 +4,49 @@
 #include <TFitResult.h>
 #include <TFitResultPtr.h>
 #include <TH1.h>
+#include <TMatrixDSym.h>
+#include <TEnv.h>
 
 #include "Globals.h"
+#include "GPhotoPeakFitter.h"
 #include "GRootFunctions.h"
 #include "GCanvas.h"
 
 ClassImp(GPeak)
 
+namespace {
+  // Fits peak to fithist with GPhotoPeakFitter, seeded from the histogram
+  //   near the current centroid.  Parameters fixed in peak stay fixed.
+  bool FitAnalytic(GPeak& peak, TH1 *fithist, TMatrixDSym& CovMat) {
+    double xlow,xhigh;
+    peak.GetRange(xlow,xhigh);
+
+    GPhotoPeakFitter fitter;
+    fitter.SetData(fithist,xlow,xhigh);
+    if(!fitter.Seed(peak.GetParameter(1))) {
+      return false;
+    }
+    for(int i=0; i<GPhotoPeakFitter::kNPars; i++) {
+      double low,high;
+      peak.GetParLimits(i,low,high);
+      if(low*high!=0 && low>=high) {
+        fitter.FixParameter(i,peak.GetParameter(i));
+      }
+    }
+    bool valid = fitter.Fit();
+
+    for(int i=0; i<GPhotoPeakFitter::kNPars; i++) {
+      peak.SetParameter(i,fitter.GetParameter(i));
+      peak.SetParError(i,fitter.GetParError(i));
+    }
+    peak.SetChisquare(fitter.GetChisquare());
+    peak.SetNDF(fitter.GetNDF());
+    CovMat.ResizeTo(GPhotoPeakFitter::kNPars,GPhotoPeakFitter::kNPars);
+    CovMat.SetMatrixArray(fitter.GetCovariance());
+    return valid;
+  }
+}
+
 GPeak::GPeak(Double_t cent,Double_t xlow,Double_t xhigh,Option_t *opt)
       : TF1("photopeakbg",GRootFunctions::PhotoPeakBG,xlow,xhigh,7),
         fBGFit("background",GRootFunctions::StepBG,xlow,xhigh,6)  {
@@ -200,21 +236,45 @@ Bool_t GPeak::Fit(TH1 *fithist,Option_t *opt) {
     options.ReplaceAll("no-print","");
   }
 
-  if(fithist->GetSumw2()->fN!=fithist->GetNbinsX()+2) fithist->Sumw2();
-
-  TFitResultPtr fitres = fithist->Fit(this,Form("%sLRSME",options.Data()));
+  bool analytic = options.Contains("analytic") ||
+                  !strcmp(gEnv->GetValue("GRUT.PeakFitter",""),"analytic");
+  if(options.Contains("analytic")) {
+    options.ReplaceAll("analytic","");
+  }
 
-  printf("chi^2/NDF = %.02f\n",this->GetChisquare()/(double)this->GetNDF());
+  if(fithist->GetSumw2()->fN!=fithist->GetNbinsX()+2) fithist->Sumw2();
 
-  if(!fitres.Get()->IsValid()) {
-    printf(RED  "fit has failed, trying refit... " RESET_COLOR);
-    fithist->GetListOfFunctions()->Last()->Delete();
-    fitres = fithist->Fit(this,Form("%sLRSME",options.Data()));
-    if( fitres.Get()->IsValid() ) {
-      printf(DGREEN " refit passed!" RESET_COLOR "\n");
-    } else {
-      printf(DRED " refit also failed :( " RESET_COLOR "\n");
+  TMatrixDSym CovMat;
+  if(analytic) {
+    bool valid = FitAnalytic(*this,fithist,CovMat);
+    printf("chi^2/NDF = %.02f\n",this->GetChisquare()/(double)this->GetNDF());
+    if(!valid) {
+      printf(DRED "analytic fit has failed :( " RESET_COLOR "\n");
+    }
+    // As TH1::Fit, replace any earlier fit of this peak.
+    TObject *previous = fithist->GetListOfFunctions()->FindObject(GetName());
+    if(previous) {
+      fithist->GetListOfFunctions()->Remove(previous);
+      delete previous;
+    }
+    fithist->GetListOfFunctions()->Add(Clone());
+  } else {
+    TFitResultPtr fitres = fithist->Fit(this,Form("%sLRSME",options.Data()));
+
+    printf("chi^2/NDF = %.02f\n",this->GetChisquare()/(double)this->GetNDF());
+
+    if(!fitres.Get()->IsValid()) {
+      printf(RED  "fit has failed, trying refit... " RESET_COLOR);
+      fithist->GetListOfFunctions()->Last()->Delete();
+      fitres = fithist->Fit(this,Form("%sLRSME",options.Data()));
+      if( fitres.Get()->IsValid() ) {
+        printf(DGREEN " refit passed!" RESET_COLOR "\n");
+      } else {
+        printf(DRED " refit also failed :( " RESET_COLOR "\n");
+      }
     }
+    CovMat.ResizeTo(GetNpar(),GetNpar());
+    CovMat = fitres->GetCovarianceMatrix();
   }
 
   Double_t xlow,xhigh;
@@ -229,7 +289,6 @@ Bool_t GPeak::Fit(TH1 *fithist,Option_t *opt) {
   tmppeak->SetRange(xlow, xhigh); //This will help get the true area of the gaussian 200 ~ infinity in a gaus
   tmppeak->SetName("tmppeak");
 
-  TMatrixDSym CovMat = fitres->GetCovarianceMatrix();
   fDArea = (tmppeak->IntegralError(xlow, xhigh, tmppeak->GetParameters(), CovMat.GetMatrixArray()))/fithist->GetBinWidth(1);
 
   double bgpars[5];
@@ -0,0 +1,446 @@
+#include <GPhotoPeakFitter.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <TH1.h>
+
+namespace {
+  const double kSqrt2     = std::sqrt(2.0);
+  const double kTwoSqrtPi = 2.0/std::sqrt(M_PI);
+
+  // exp(z*z)*erfc(z), for z >= 0, which stays finite where erfc underflows.
+  double Erfcx(double z) {
+    if(z < 26) {
+      return std::exp(z*z)*std::erfc(z);
+    }
+    double z2 = 1/(z*z);
+    return (1 - z2/2 + 3*z2*z2/4 - 15*z2*z2*z2/8)/(z*std::sqrt(M_PI));
+  }
+
+  // Solves a x = b for the m x m matrix a, with partial pivoting.  a and b are overwritten.
+  bool Solve(std::vector<double>& a, std::vector<double>& b, int m) {
+    for(int col=0; col<m; col++) {
+      int pivot = col;
+      for(int row=col+1; row<m; row++) {
+        if(std::abs(a[row*m + col]) > std::abs(a[pivot*m + col])) {
+          pivot = row;
+        }
+      }
+      if(a[pivot*m + col] == 0) {
+        return false;
+      }
+      if(pivot != col) {
+        for(int k=0; k<m; k++) {
+          std::swap(a[col*m + k], a[pivot*m + k]);
+        }
+        std::swap(b[col], b[pivot]);
+      }
+      for(int row=col+1; row<m; row++) {
+        double factor = a[row*m + col]/a[col*m + col];
+        for(int k=col; k<m; k++) {
+          a[row*m + k] -= factor*a[col*m + k];
+        }
+        b[row] -= factor*b[col];
+      }
+    }
+    for(int row=m-1; row>=0; row--) {
+      double sum = b[row];
+      for(int k=row+1; k<m; k++) {
+        sum -= a[row*m + k]*b[k];
+      }
+      b[row] = sum/a[row*m + row];
+    }
+    return true;
+  }
+
+  // Eigenvalues and vectors (columns of v) of the symmetric m x m matrix a, by Jacobi rotations.
+  void Eigen(std::vector<double> a, int m, std::vector<double>& values, std::vector<double>& v) {
+    v.assign(m*m, 0);
+    for(int i=0; i<m; i++) v[i*m + i] = 1;
+    for(int sweep=0; sweep<50; sweep++) {
+      double off = 0;
+      for(int p=0; p<m; p++) {
+        for(int q=p+1; q<m; q++) off += a[p*m + q]*a[p*m + q];
+      }
+      if(off < 1e-30) break;
+      for(int p=0; p<m; p++) {
+        for(int q=p+1; q<m; q++) {
+          if(a[p*m + q] == 0) continue;
+          double theta = (a[q*m + q] - a[p*m + p])/(2*a[p*m + q]);
+          double t = (theta >= 0 ? 1 : -1)/(std::abs(theta) + std::sqrt(theta*theta + 1));
+          double c = 1/std::sqrt(t*t + 1);
+          double s = t*c;
+          for(int k=0; k<m; k++) {
+            double akp = a[k*m + p], akq = a[k*m + q];
+            a[k*m + p] = c*akp - s*akq;
+            a[k*m + q] = s*akp + c*akq;
+          }
+          for(int k=0; k<m; k++) {
+            double apk = a[p*m + k], aqk = a[q*m + k];
+            a[p*m + k] = c*apk - s*aqk;
+            a[q*m + k] = s*apk + c*aqk;
+          }
+          for(int k=0; k<m; k++) {
+            double vkp = v[k*m + p], vkq = v[k*m + q];
+            v[k*m + p] = c*vkp - s*vkq;
+            v[k*m + q] = s*vkp + c*vkq;
+          }
+        }
+      }
+    }
+    values.resize(m);
+    for(int i=0; i<m; i++) values[i] = a[i*m + i];
+  }
+}
+
+const char* GPhotoPeakFitter::ParName(int i) {
+  static const char* names[kNPars] = {"Height", "centroid", "sigma", "R", "beta", "step", "bg_offset"};
+  return (i >= 0 && i < kNPars) ? names[i] : "";
+}
+
+void GPhotoPeakFitter::Evaluate(const double* x, int n, const double* par, double* value, double* jacobian) {
+  // height*(1-R/100)*g + height*R/100*S + height*step/100*T + offset, with
+  //   g = exp(-a^2), S = exp(u/beta)*erfc(a+b), T = erfc(a),
+  //   u = x-centroid, a = u/(sigma*sqrt(2)), b = sigma/(beta*sqrt(2)).
+  const double height = par[kHeight];
+  const double cent   = par[kCentroid];
+  const double sigma  = par[kSigma];
+  const double R      = par[kR]/100.0;
+  const double beta   = par[kBeta];
+  const double step   = par[kStep]/100.0;
+  const double offset = par[kOffset];
+
+  const double b = sigma/(beta*kSqrt2);
+  const double eb = std::exp(-b*b);
+
+  for(int i=0; i<n; i++) {
+    double u = x[i] - cent;
+    double a = u/(sigma*kSqrt2);
+    double g = std::exp(-a*a);
+    double z = a + b;
+    // exp(u/beta - z^2) is exp(-a^2 - b^2).
+    double S = (z > 0) ? g*eb*Erfcx(z) : std::exp(u/beta)*std::erfc(z);
+    double T = std::erfc(a);
+
+    value[i] = height*((1-R)*g + R*S + step*T) + offset;
+
+    if(jacobian) {
+      // D = -exp(u/beta)*d(erfc(z))/dz
+      double D = kTwoSqrtPi*g*eb;
+
+      double dg_dc = g*u/(sigma*sigma);
+      double dg_ds = dg_dc*u/sigma;
+      double dS_dc = -S/beta + D/(sigma*kSqrt2);
+      double dS_ds = D*(u/(sigma*sigma*kSqrt2) - 1/(beta*kSqrt2));
+      double dS_db = -u/(beta*beta)*S + D*sigma/(beta*beta*kSqrt2);
+      double dT_dc = kTwoSqrtPi*g/(sigma*kSqrt2);
+      double dT_ds = dT_dc*u/sigma;
+
+      double* row = jacobian + i*kNPars;
+      row[kHeight]   = (1-R)*g + R*S + step*T;
+      row[kCentroid] = height*((1-R)*dg_dc + R*dS_dc + step*dT_dc);
+      row[kSigma]    = height*((1-R)*dg_ds + R*dS_ds + step*dT_ds);
+      row[kR]        = height*(S - g)/100.0;
+      row[kBeta]     = height*R*dS_db;
+      row[kStep]     = height*T/100.0;
+      row[kOffset]   = 1;
+    }
+  }
+}
+
+GPhotoPeakFitter::GPhotoPeakFitter()
+  : fPar(kNPars, 0), fLow(kNPars, 0), fHigh(kNPars, 0), fFixed(kNPars, false),
+    fErr(kNPars, 0), fCov(kNPars*kNPars, 0),
+    fChi2(0), fNDF(0), fIterations(0), fValid(false) {
+  fPar[kSigma] = 1;
+  fPar[kBeta]  = 1;
+}
+
+void GPhotoPeakFitter::SetData(const double* x, const double* counts, int n) {
+  fX.assign(x, x + n);
+  fN.assign(counts, counts + n);
+}
+
+void GPhotoPeakFitter::SetData(const TH1* hist, double low, double high) {
+  fX.clear();
+  fN.clear();
+  if(!hist) return;
+  if(low>high) std::swap(low,high);
+  int binlow  = std::max(1, hist->GetXaxis()->FindBin(low));
+  int binhigh = std::min(hist->GetNbinsX(), hist->GetXaxis()->FindBin(high));
+  for(int i=binlow; i<=binhigh; i++) {
+    fX.push_back(hist->GetXaxis()->GetBinCenter(i));
+    fN.push_back(hist->GetBinContent(i));
+  }
+}
+
+void GPhotoPeakFitter::SetParLimits(int i, double low, double high) {
+  if(low>high) std::swap(low,high);
+  fLow.at(i)  = low;
+  fHigh.at(i) = high;
+}
+
+bool GPhotoPeakFitter::Seed(double centroid) {
+  int n = fX.size();
+  if(n < 5) {
+    return false;
+  }
+  double width = (fX.back() - fX.front())/(n - 1);
+
+  // Background and step from the ends of the window.
+  int nedge = std::max(1, std::min(5, n/5));
+  double left = 0;
+  double right = 0;
+  for(int i=0; i<nedge; i++) {
+    left  += fN[i];
+    right += fN[n-1-i];
+  }
+  left  /= nedge;
+  right /= nedge;
+  double offset = std::min(left, right);
+
+  // The highest bin, or the highest near the centroid given.
+  int peak = 0;
+  if(centroid > fX.front() && centroid < fX.back()) {
+    int guess = std::min(n-1, std::max(0, int((centroid - fX.front())/width + 0.5)));
+    peak = guess;
+    for(int i=std::max(0, guess-3); i<=std::min(n-1, guess+3); i++) {
+      if(fN[i] > fN[peak]) peak = i;
+    }
+  } else {
+    for(int i=1; i<n; i++) {
+      if(fN[i] > fN[peak]) peak = i;
+    }
+  }
+  double maximum = fN[peak];
+  double height = std::max(maximum - offset, 1.0);
+
+  // Centroid from a parabola through the top three bins.
+  double cent = fX[peak];
+  if(peak > 0 && peak < n-1) {
+    double curve = fN[peak-1] - 2*fN[peak] + fN[peak+1];
+    if(curve < 0) {
+      cent += width*0.5*(fN[peak-1] - fN[peak+1])/curve;
+    }
+  }
+
+  // Sigma from the full width at half height.
+  double half = offset + height/2;
+  double xlow = fX.front();
+  double xhigh = fX.back();
+  for(int i=peak; i>0; i--) {
+    if(fN[i-1] < half) {
+      xlow = fX[i-1] + width*(half - fN[i-1])/std::max(fN[i] - fN[i-1], 1e-9);
+      break;
+    }
+  }
+  for(int i=peak; i<n-1; i++) {
+    if(fN[i+1] < half) {
+      xhigh = fX[i+1] - width*(half - fN[i+1])/std::max(fN[i] - fN[i+1], 1e-9);
+      break;
+    }
+  }
+  double sigma = (xhigh - xlow)/2.3548;
+  if(!(sigma > 0.5*width)) {
+    sigma = std::max(0.5*width, (cent*.01)/2.35);
+  }
+
+  double step = std::max(0.0, left - right)/height*50;
+
+  double range = fX.back() - fX.front() + width;
+  fPar[kHeight]   = height;
+  fPar[kCentroid] = cent;
+  fPar[kSigma]    = sigma;
+  fPar[kR]        = 5.;
+  fPar[kBeta]     = std::min(5.0, std::max(0.01, sigma/2));
+  fPar[kStep]     = step;
+  fPar[kOffset]   = offset;
+
+  SetParLimits(kHeight,   0, 2*maximum + 1);
+  SetParLimits(kCentroid, fX.front() - width/2, fX.back() + width/2);
+  SetParLimits(kSigma,    0.1*width, range);
+  SetParLimits(kR,        0.0, 40);
+  SetParLimits(kBeta,     0.01, 5);
+  SetParLimits(kStep,     0.0, std::max(2*step, 1.0));
+  SetParLimits(kOffset,   0.0, std::max(2*std::max(left, right), 1.0));
+  return true;
+}
+
+void GPhotoPeakFitter::Clamp(std::vector<double>& par) const {
+  for(int i=0; i<kNPars; i++) {
+    if(fLow[i] < fHigh[i]) {
+      par[i] = std::min(fHigh[i], std::max(fLow[i], par[i]));
+    }
+  }
+  // Both are divided by.
+  par[kSigma] = std::max(par[kSigma], 1e-6);
+  par[kBeta]  = std::max(par[kBeta], 1e-6);
+}
+
+double GPhotoPeakFitter::NegLogLikelihood(const std::vector<double>& par, std::vector<double>& mu) const {
+  int n = fX.size();
+  Evaluate(fX.data(), n, par.data(), mu.data());
+  double nll = 0;
+  for(int i=0; i<n; i++) {
+    if(mu[i] <= 0) {
+      if(fN[i] > 0) return std::numeric_limits<double>::infinity();
+      continue;
+    }
+    nll += mu[i] - fN[i]*std::log(mu[i]);
+  }
+  return std::isfinite(nll) ? nll : std::numeric_limits<double>::infinity();
+}
+
+bool GPhotoPeakFitter::Fit(int max_iterations) {
+  int n = fX.size();
+  fValid = false;
+  fIterations = 0;
+  std::fill(fErr.begin(), fErr.end(), 0);
+  std::fill(fCov.begin(), fCov.end(), 0);
+
+  std::vector<int> free;
+  for(int i=0; i<kNPars; i++) {
+    if(!fFixed[i]) free.push_back(i);
+  }
+  int m = free.size();
+  if(n <= m || m == 0) {
+    return false;
+  }
+
+  Clamp(fPar);
+  std::vector<double> mu(n), trial_mu(n), jacobian(n*kNPars);
+  std::vector<double> grad(m), fisher(m*m), a(m*m), delta(m);
+  std::vector<double> trial(kNPars);
+
+  // Gradient and Fisher information of the likelihood at par.
+  auto information = [&](const std::vector<double>& par) {
+    Evaluate(fX.data(), n, par.data(), mu.data(), jacobian.data());
+    std::fill(grad.begin(), grad.end(), 0);
+    std::fill(fisher.begin(), fisher.end(), 0);
+    for(int i=0; i<n; i++) {
+      double model = std::max(mu[i], 1e-6);
+      double residual = 1 - fN[i]/model;
+      const double* row = &jacobian[i*kNPars];
+      for(int k=0; k<m; k++) {
+        double jk = row[free[k]];
+        grad[k] += residual*jk;
+        for(int l=0; l<=k; l++) {
+          fisher[k*m + l] += jk*row[free[l]]/model;
+        }
+      }
+    }
+    for(int k=0; k<m; k++) {
+      for(int l=0; l<k; l++) {
+        fisher[l*m + k] = fisher[k*m + l];
+      }
+    }
+  };
+
+  double nll = NegLogLikelihood(fPar, mu);
+  if(!std::isfinite(nll)) {
+    return false;
+  }
+
+  double lambda = 1e-3;
+  bool converged = false;
+  for(fIterations=0; fIterations<max_iterations && !converged; fIterations++) {
+    information(fPar);
+
+    bool accepted = false;
+    while(!accepted && lambda < 1e12) {
+      a = fisher;
+      for(int k=0; k<m; k++) {
+        a[k*m + k] = fisher[k*m + k]*(1 + lambda) + 1e-12;
+        delta[k] = -grad[k];
+      }
+      if(Solve(a, delta, m)) {
+        // A step past a limit goes halfway to it instead, so a parameter
+        //   is not thrown onto a limit where the likelihood is flat.
+        trial = fPar;
+        for(int k=0; k<m; k++) {
+          int i = free[k];
+          trial[i] += delta[k];
+          if(fLow[i] < fHigh[i]) {
+            if(trial[i] < fLow[i])  trial[i] = fLow[i]  + 0.5*(fPar[i] - fLow[i]);
+            if(trial[i] > fHigh[i]) trial[i] = fHigh[i] - 0.5*(fHigh[i] - fPar[i]);
+          }
+        }
+        Clamp(trial);
+        double trial_nll = NegLogLikelihood(trial, trial_mu);
+        if(trial_nll < nll) {
+          converged = (nll - trial_nll) < 1e-9*(1 + std::abs(nll));
+          fPar = trial;
+          nll = trial_nll;
+          lambda = std::max(lambda/10, 1e-12);
+          accepted = true;
+          continue;
+        }
+      }
+      lambda *= 10;
+    }
+    // No step in any direction lowers the likelihood, so this is the minimum.
+    if(!accepted) {
+      converged = true;
+    }
+  }
+
+  // Covariance from the Fisher information at the minimum.  As with MINUIT,
+  //   parameters left at a limit count as fixed.  Combinations the data
+  //   cannot tell apart, such as height against R when the tail is as
+  //   narrow as the gaussian, are left out rather than given errors of
+  //   1e16 that swamp everything derived from the covariance.
+  information(fPar);
+  std::vector<int> known;
+  for(int k=0; k<m; k++) {
+    int i = free[k];
+    bool at_limit = (fLow[i] < fHigh[i]) &&
+      (fPar[i] - fLow[i] < 1e-3*(fHigh[i] - fLow[i]) || fHigh[i] - fPar[i] < 1e-3*(fHigh[i] - fLow[i]));
+    if(!at_limit && fisher[k*m + k] > 0) known.push_back(k);
+  }
+  int mk = known.size();
+  std::vector<double> scale(mk), scaled(mk*mk), values, vectors;
+  for(int r=0; r<mk; r++) {
+    scale[r] = 1/std::sqrt(fisher[known[r]*m + known[r]]);
+  }
+  for(int r=0; r<mk; r++) {
+    for(int c=0; c<mk; c++) {
+      scaled[r*mk + c] = fisher[known[r]*m + known[c]]*scale[r]*scale[c];
+    }
+  }
+  Eigen(scaled, mk, values, vectors);
+  double largest = mk ? *std::max_element(values.begin(), values.end()) : 0;
+  for(int r=0; r<mk; r++) {
+    for(int c=0; c<mk; c++) {
+      double sum = 0;
+      for(int e=0; e<mk; e++) {
+        if(values[e] > 1e-9*largest) {
+          sum += vectors[r*mk + e]*vectors[c*mk + e]/values[e];
+        }
+      }
+      fCov[free[known[r]]*kNPars + free[known[c]]] = sum*scale[r]*scale[c];
+    }
+  }
+  for(int i=0; i<kNPars; i++) {
+    fErr[i] = std::sqrt(std::max(fCov[i*kNPars + i], 0.0));
+  }
+
+  fChi2 = 0;
+  for(int i=0; i<n; i++) {
+    double model = std::max(mu[i], 1e-300);
+    fChi2 += 2*(model - fN[i]);
+    if(fN[i] > 0) {
+      fChi2 += 2*fN[i]*std::log(fN[i]/model);
+    }
+  }
+  fNDF = n - m;
+  fValid = converged && std::isfinite(fChi2);
+  return fValid;
+}
+
+double GPhotoPeakFitter::Eval(double x) const {
+  double value;
+  Evaluate(&x, 1, fPar.data(), &value);
+  return value;
+}
@@ -7,6 +7,7 @@
 #include <utility>
 #include <fstream>
 #include <sstream>
+#include <mutex>
 
 #include <TBuffer.h>
 
@@ -14,6 +15,14 @@
 //std::map<unsigned int, GValue*> GValue::fValueMap;
 GValue *GValue::fDefaultValue = new GValue("GValue",sqrt(-1));
 std::map<std::string,GValue*> GValue::fValueVector;
+std::atomic<unsigned int> GValue::fGeneration(0);
+
+namespace {
+  // Guards fValueVector, which a thread sorting events may look values up in
+  // while value files are being loaded.  The GValue objects themselves are not
+  // locked: their values are read and set without synchronisation.
+  std::mutex value_map_mutex;
+}
 
 GValue::GValue()
   : fValue(0.00), fPriority(kUnset) { }
@@ -41,20 +50,47 @@ void GValue::Copy(TObject &obj) const {
   TNamed::Copy(obj);
   ((GValue&)obj).fValue = fValue;
   ((GValue&)obj).fPriority = fPriority;
+  fGeneration++;
+}
+
+GValue* GValue::Resolve(const std::string& upper_name) {
+  std::lock_guard<std::mutex> lock(value_map_mutex);
+  auto it = fValueVector.find(upper_name);
+  return it == fValueVector.end() ? 0 : it->second;
+}
+
+GValueHandle::GValueHandle(const char* name)
+  : fName(name), fValue(0), fGeneration(-1) {
+  std::transform(fName.begin(),fName.end(),fName.begin(),::toupper);
+}
+
+GValue* GValueHandle::Resolve() const {
+  // Generation first, so a value added during the lookup is tried again next time.
+  // Threads resolving at once find the same GValue, so either store is right.
+  unsigned int generation = GValue::Generation();
+  GValue* value = GValue::Resolve(fName);
+  if(value) {
+    fValue.store(value, std::memory_order_release);
+  } else {
+    fGeneration.store(generation, std::memory_order_relaxed);
+  }
+  return value;
 }
 
 double GValue::Value(std::string name) {
   std::transform(name.begin(),name.end(),name.begin(),::toupper);
-  if(!fValueVector.count(name))
+  GValue* value = Resolve(name);
+  if(!value)
     return sqrt(-1);
-  return fValueVector.at(name)->GetValue();
+  return value->GetValue();
 }
 
 std::string GValue::Info(std::string name) {
   std::transform(name.begin(),name.end(),name.begin(),::toupper);
-  if(!fValueVector.count(name))
+  GValue* value = Resolve(name);
+  if(!value)
     return "";
-  return fValueVector.at(name)->GetInfo();
+  return value->GetInfo();
 }
 
 void GValue::SetReplaceValue(std::string name, double value,
@@ -72,12 +108,9 @@ void GValue::SetReplaceValue(std::string name, double value,
 
 GValue* GValue::FindValue(std::string name){
   std::transform(name.begin(),name.end(),name.begin(),::toupper);
-  GValue* value = 0;
   if(!name.length())
     return GetDefaultValue();
-  if(fValueVector.count(name))
-    value = fValueVector[name];
-  return value;
+  return Resolve(name);
 
 }
 
@@ -125,11 +158,33 @@ bool GValue::AddValue(GValue* value, Option_t *opt) {
     value = 0;
     return false;
   } else {
-    fValueVector[temp_string] = value;   //.push_back(value);
+    std::lock_guard<std::mutex> lock(value_map_mutex);
+    if(!fValueVector.insert(std::make_pair(temp_string, value)).second) {
+      // Added by another thread since FindValue.
+      value->ReplaceValue(fValueVector[temp_string]);
+      delete value;
+      return true;
+    }
+    fGeneration++;
     return true;
   }
 }
 
+TList* GValue::AllValues() {
+  std::lock_guard<std::mutex> lock(value_map_mutex);
+  TList* output = new TList;
+  output->SetOwner(false);
+  for(auto& item : fValueVector){
+    output->Add(item.second);
+  }
+  return output;
+}
+
+int GValue::Size() {
+  std::lock_guard<std::mutex> lock(value_map_mutex);
+  return fValueVector.size();
+}
+
 
 std::string GValue::PrintToString() const {
 
@@ -147,6 +202,7 @@ void GValue::Print(Option_t *opt) const {
 }
 
 int GValue::WriteValFile(std::string filename,Option_t *opt) {
+  std::lock_guard<std::mutex> lock(value_map_mutex);
   std::map<std::string,GValue*>::iterator it;
   //std::string filebuffer;
   if(filename.length()) {
@@ -168,7 +224,8 @@ int GValue::WriteValFile(std::string filename,Option_t *opt) {
 
 std::string GValue::WriteToBuffer(Option_t *opt) {
   std::string buffer="";
-  if(!GValue::Size())
+  std::lock_guard<std::mutex> lock(value_map_mutex);
+  if(fValueVector.empty())
     return buffer;
   std::map<std::string,GValue*>::iterator it;
   for(it = fValueVector.begin();it!=fValueVector.end();it++) {
@@ -4,6 +4,10 @@
 
 #include "TNSCLEvent.h"
 
+static GValueHandle target_shift_x("TARGET_SHIFT_X");
+static GValueHandle target_shift_y("TARGET_SHIFT_Y");
+static GValueHandle target_shift_z("TARGET_SHIFT_Z");
+
 #define FERA_TIME_ID        0x2301
 #define FERA_ENERGY_ID      0x2302
 #define FERA_TIMESTAMP_ID   0x2303
@@ -472,17 +476,17 @@ TVector3 TCaesar::GetPosition(int ring,int det) {
   double y = detector_positions[ring][det][1];
   double z = detector_positions[ring][det][2];
 
-  double shift = GValue::Value("TARGET_SHIFT_X");
+  double shift = target_shift_x.Value();
   if(!std::isnan(shift)) {
     x -= shift;
   }
 
-  shift = GValue::Value("TARGET_SHIFT_Y");
+  shift = target_shift_y.Value();
   if(!std::isnan(shift)) {
     y -= shift;
   }
 
-  shift = GValue::Value("TARGET_SHIFT_Z");
+  shift = target_shift_z.Value();
   if(!std::isnan(shift)) {
     z -= shift;
   }
@@ -3,6 +3,8 @@
 #include <GValue.h>
 #include <TMath.h>
 
+static GValueHandle beta_value("beta");
+
 TFSUHit::TFSUHit() { }
 
 TFSUHit::~TFSUHit() { }
@@ -32,7 +34,7 @@ TVector3 TFSUHit::GetPosition() const {
 
 double TFSUHit::GetDoppler(const TVector3 *recoil_vector) const {
   //insert some checks that positions and betas are actually set.....
-  double beta = GValue::Value("beta");
+  double beta = beta_value.Value();
   double gamma = 1/(sqrt(1-pow(beta,2)));
   if(recoil_vector==0) {
      recoil_vector = &BeamUnitVec;
@@ -41,6 +41,15 @@ void TGenericDDAS::Clear(Option_t* opt){
   ddas_hits.clear();
 }
 
+/*******************************************************************************/
+/* Copies traces out of the raw buffer before writing **************************/
+/*******************************************************************************/
+void TGenericDDAS::MaterializeTraces() {
+  for(auto& hit : ddas_hits) {
+    hit.MaterializeTrace();
+  }
+}
+
 /*******************************************************************************/
 /* Functions to call DDAS hits *************************************************/
 /*******************************************************************************/
@@ -100,7 +109,7 @@ int TGenericDDAS::BuildHits(std::vector<TRawEvent>& raw_data) {
     hit.SetExtTime(ddasevt.GetExtTimestamp());
     hit.SetTime(ddasevt.GetTime()); // Timestamp + CFD
     hit.SetCFDTime(ddasevt.GetCFDTime()); // CFD ONLY
-    hit.SetTrace(ddasevt.GetTraceLength(), ddasevt.trace);
+    hit.SetTrace(ddasevt.GetTraceView());
     ddas_hits.push_back(hit);
     fSize++;
   }
@@ -17,6 +17,7 @@ void TGenericDDASHit::Copy(TObject& obj) const{
   TDetectorHit::Copy(obj);
   TGenericDDASHit& ddas = (TGenericDDASHit&)obj;
   ddas.fTrace = fTrace;
+  ddas.fTraceView = fTraceView;
 }
 
 /*******************************************************************************/
@@ -24,6 +25,8 @@ void TGenericDDASHit::Copy(TObject& obj) const{
 /*******************************************************************************/
 void TGenericDDASHit::Clear(Option_t *opt) {
   TDetectorHit::Clear(opt);
+  fTrace.clear();
+  fTraceView.Clear();
 }
 
 /*******************************************************************************/
@@ -37,11 +40,23 @@ void TGenericDDASHit::Print(Option_t *opt) const {
 /* Sets trace information if present in data ***********************************/
 /*******************************************************************************/
 void TGenericDDASHit::SetTrace(unsigned int trace_length, const unsigned short* trace) {
+  fTraceView.Clear();
   fTrace.clear();
   fTrace.reserve(trace_length);
   copy(trace,trace+trace_length,back_inserter(fTrace));
 }
 
+/*******************************************************************************/
+/* Copies a trace view into the hit, only done when needed *********************/
+/*******************************************************************************/
+void TGenericDDASHit::MaterializeTrace() {
+  if(fTraceView.empty()) {
+    return;
+  }
+  fTraceView.CopyTo(fTrace);
+  fTraceView.Clear();
+}
+
 /*******************************************************************************/
 /* Returns DDAS crate/slot channel number **************************************/
 /*******************************************************************************/
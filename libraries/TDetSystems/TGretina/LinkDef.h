@@ -10,7 +10,9 @@
 #pragma link C++ class interaction_point+;
 //#pragma link C++ class TInteractionPoint+;
 //#pragma link C++ class std::vector<TInteractionPoint>+;
+#pragma link C++ class TGretinaIntPoints+;
 #pragma link C++ class TGretinaHit+;
+#pragma read sourceClass="TGretinaHit" targetClass="TGretinaHit" version="[1-]" source="std::vector<interaction_point> fSegments" target="fIntPoints" code="{ fIntPoints.clear(); for(const auto& pnt : onfile.fSegments) { fIntPoints.push_back(pnt.fSeg,pnt.fX,pnt.fY,pnt.fZ,pnt.fEng,pnt.fFrac); } }"
 #pragma link C++ class std::vector<TGretinaHit>+;
 #pragma link C++ class TGretina+;
 #pragma link C++ class TMode3Hit+;
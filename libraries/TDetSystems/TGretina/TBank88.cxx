@@ -39,10 +39,10 @@ int TBank88::BuildHits(std::vector<TRawEvent>& raw_data){
   for(auto& event : raw_data){
     TGEBEvent* geb = (TGEBEvent*)&event;
     SetTimestamp(geb->GetTimestamp());
-    TMode3Hit hit;
+    channels.emplace_back();
     TSmartBuffer buf = geb->GetPayloadBuffer();
-    hit.BuildFrom(buf);
-    InsertHit(hit);
+    channels.back().BuildFrom(buf);
+    fSize++;
   }
   if(Size()) {
     SetTimestamp(channels.at(0).GetLed());
@@ -50,6 +50,15 @@ int TBank88::BuildHits(std::vector<TRawEvent>& raw_data){
   return Size();
 }
 
+/*******************************************************************************/
+/* Swaps waveforms still held in the raw buffer ********************************/
+/*******************************************************************************/
+void TBank88::MaterializeTraces() {
+  for(auto& hit : channels) {
+    hit.MaterializeWave();
+  }
+}
+
 /*******************************************************************************/
 /* Blank Print Function ********************************************************/
 /*******************************************************************************/
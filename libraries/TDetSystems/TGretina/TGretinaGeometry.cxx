@@ -0,0 +1,140 @@
+#include "TGretinaGeometry.h"
+
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+#include "GValue.h"
+#include "TGretina.h"
+#include "TGretinaHit.h"
+
+/*******************************************************************************/
+/* Builds the matrices, again whenever a GValue has changed ********************/
+/*******************************************************************************/
+const TGretinaGeometry::Tables& TGretinaGeometry::Get() {
+  // Each thread holds on to the tables it last used, so that older tables
+  //   are freed once no thread can still be reading them.
+  static thread_local std::shared_ptr<const Tables> local;
+  unsigned int generation = GValue::Generation();
+  if(local && local->generation == generation) {
+    return *local;
+  }
+
+  static std::mutex tables_mutex;
+  static std::shared_ptr<const Tables> current;
+  std::lock_guard<std::mutex> lock(tables_mutex);
+  if(!current || current->generation != generation) {
+    current = Build(generation);
+  }
+  local = current;
+  return *local;
+}
+
+std::shared_ptr<const TGretinaGeometry::Tables> TGretinaGeometry::Build(unsigned int generation) {
+  TGretina::SetCRMAT();
+
+  double offset[3] = { GValue::Value("GRETINA_X_OFFSET"),
+                       GValue::Value("GRETINA_Y_OFFSET"),
+                       GValue::Value("GRETINA_Z_OFFSET") };
+  for(int i=0; i<3; i++) {
+    if(std::isnan(offset[i])) {
+      offset[i] = 0.00;
+    }
+  }
+
+  auto tables = std::make_shared<Tables>();
+  tables->generation = generation;
+  for(int index=0; index<kNumCrystals; index++) {
+    int detectorPosition = index/4;
+    int crystalNumber    = index%4;
+    for(int row=0; row<3; row++) {
+      const Float_t* m = TGretina::crmat[detectorPosition][crystalNumber][row];
+      for(int col=0; col<4; col++) {
+        tables->matrix[index][4*row+col]  = m[col];
+        tables->shifted[index][4*row+col] = m[col];
+      }
+      tables->shifted[index][4*row+3] = m[3] + m[0]*offset[0] + m[1]*offset[1] + m[2]*offset[2];
+    }
+  }
+  return tables;
+}
+
+const float* TGretinaGeometry::Matrix(int cryId, bool with_offsets) {
+  int index = cryId - kFirstCrystal;
+  if(index < 0 || index >= kNumCrystals) {
+    return 0;
+  }
+  const Tables& tables = Get();
+  return with_offsets ? tables.shifted[index] : tables.matrix[index];
+}
+
+/*******************************************************************************/
+/* Single point transforms *****************************************************/
+/*******************************************************************************/
+TVector3 TGretinaGeometry::CrystalToGlobal(int cryId, float x, float y, float z) {
+  float gx, gy, gz;
+  Transform(cryId, false, &x, &y, &z, 1, &gx, &gy, &gz);
+  return TVector3(gx, gy, gz);
+}
+
+TVector3 TGretinaGeometry::IntPointToGlobal(int cryId, float x, float y, float z) {
+  float gx, gy, gz;
+  Transform(cryId, true, &x, &y, &z, 1, &gx, &gy, &gz);
+  return TVector3(gx, gy, gz);
+}
+
+/*******************************************************************************/
+/* Batch transforms ************************************************************/
+/*******************************************************************************/
+void TGretinaGeometry::Transform(int cryId, bool with_offsets, const float* x, const float* y, const float* z,
+                                 size_t n, float* gx, float* gy, float* gz) {
+  const float* m = Matrix(cryId, with_offsets);
+  if(!m) {
+    for(size_t i=0; i<n; i++) {
+      gx[i] = gy[i] = gz[i] = std::nan("");
+    }
+    return;
+  }
+
+  const float m00 = m[0], m01 = m[1], m02 = m[2],  m03 = m[3];
+  const float m10 = m[4], m11 = m[5], m12 = m[6],  m13 = m[7];
+  const float m20 = m[8], m21 = m[9], m22 = m[10], m23 = m[11];
+  for(size_t i=0; i<n; i++) {
+    gx[i] = m00*x[i] + m01*y[i] + m02*z[i] + m03;
+    gy[i] = m10*x[i] + m11*y[i] + m12*z[i] + m13;
+    gz[i] = m20*x[i] + m21*y[i] + m22*z[i] + m23;
+  }
+}
+
+size_t TGretinaGeometry::TransformHit(const TGretinaHit& hit, float* gx, float* gy, float* gz) {
+  const TGretinaIntPoints& points = hit.GetIntPoints();
+  Transform(hit.GetCrystalId(), true, points.fX, points.fY, points.fZ, points.size(), gx, gy, gz);
+  return points.size();
+}
+
+size_t TGretinaGeometry::TransformHits(const std::vector<TGretinaHit>& hits,
+                                       std::vector<float>& gx, std::vector<float>& gy, std::vector<float>& gz,
+                                       std::vector<int>* first) {
+  size_t total = 0;
+  for(auto& hit : hits) {
+    total += hit.GetIntPoints().size();
+  }
+  gx.resize(total);
+  gy.resize(total);
+  gz.resize(total);
+  if(first) {
+    first->resize(hits.size() + 1);
+  }
+
+  size_t pos = 0;
+  for(size_t i=0; i<hits.size(); i++) {
+    if(first) {
+      (*first)[i] = pos;
+    }
+    pos += TransformHit(hits[i], gx.data() + pos, gy.data() + pos, gz.data() + pos);
+  }
+  if(first) {
+    (*first)[hits.size()] = pos;
+  }
+  return total;
+}
@@ -2,15 +2,19 @@
 
 #include <algorithm>
 #include <cmath>
-#include <set>
 
 #include <TRandom.h>
 
 #include "GValue.h"
 #include "TGEBEvent.h"
 #include "TGretina.h"
+#include "TGretinaGeometry.h"
 #include "TS800.h"
 
+static GValueHandle target_x_offset("TARGET_X_OFFSET");
+static GValueHandle target_y_offset("TARGET_Y_OFFSET");
+static GValueHandle target_z_offset("TARGET_Z_OFFSET");
+
 TGretinaHit::TGretinaHit(){ Clear(); }
 
 TGretinaHit::~TGretinaHit(){ }
@@ -32,7 +36,8 @@ void TGretinaHit::Copy(TObject &rhs) const {
   ((TGretinaHit&)rhs).fCoreCharge[2]  = fCoreCharge[2];
   ((TGretinaHit&)rhs).fCoreCharge[3]  = fCoreCharge[3];
   ((TGretinaHit&)rhs).fNumberOfInteractions = fNumberOfInteractions;
-  ((TGretinaHit&)rhs).fSegments       = fSegments;
+  ((TGretinaHit&)rhs).fIntPoints       = fIntPoints;
+  ((TGretinaHit&)rhs).fSegments        = fSegments;
   ((TGretinaHit&)rhs).fAB	      = fAB;
   ((TGretinaHit&)rhs).fChisq          = fChisq;
   ((TGretinaHit&)rhs).fNormChisq      = fNormChisq;
@@ -121,23 +126,18 @@ void TGretinaHit::BuildFrom(TSmartBuffer& buf){
 
   fNumberOfInteractions = raw.num;
   fPad = raw.pad;
-  for(int i=0; i<fNumberOfInteractions; i++) {
-    try {
-      interaction_point pnt;
-      pnt.fSeg = raw.intpts[i].seg;
-      pnt.fX   = raw.intpts[i].x;
-      pnt.fY   = raw.intpts[i].y;
-      pnt.fZ   = raw.intpts[i].z;
-      pnt.fFrac   = raw.intpts[i].e;
-      pnt.fEng = raw.intpts[i].seg_ener;
-      fSegments.push_back(pnt);
-    } catch(...) {
-      std::cout << "in try catch block!" << std::endl;
-    }
-
+  int npoints = std::min(fNumberOfInteractions, MAX_INTPTS);
+  for(int i=0; i<npoints; i++) {
+    fIntPoints.push_back(raw.intpts[i].seg,
+                        raw.intpts[i].x,
+                        raw.intpts[i].y,
+                        raw.intpts[i].z,
+                        raw.intpts[i].seg_ener,
+                        raw.intpts[i].e);
   }
   fTOffset = raw.intpts[MAX_INTPTS-1].z;
-  std::sort(fSegments.begin(),fSegments.end());
+  fIntPoints.Sort();
+  StoreIntPoints();
   //  Print("all");
 }
 
@@ -145,20 +145,11 @@ void TGretinaHit::BuildFrom(TSmartBuffer& buf){
 /* Returns position vector based on interaction point **************************/
 /*******************************************************************************/
 TVector3 TGretinaHit::GetIntPosition(unsigned int i) const {
-  if(i<fSegments.size()){
-    double xoffset = GValue::Value("GRETINA_X_OFFSET");
-    if(std::isnan(xoffset))
-      xoffset=0.00;
-    double yoffset = GValue::Value("GRETINA_Y_OFFSET");
-    if(std::isnan(yoffset))
-      yoffset=0.00;
-    double zoffset = GValue::Value("GRETINA_Z_OFFSET");
-    if(std::isnan(zoffset))
-      zoffset=0.00;
-    TVector3 v = TGretina::CrystalToGlobal(fCrystalId,fSegments.at(i).fX + xoffset,
-        fSegments.at(i).fY + yoffset,
-        fSegments.at(i).fZ + zoffset);
-    return v;
+  if(int(i)<fIntPoints.size()){
+    // GRETINA_X/Y/Z_OFFSET are folded into the cached crystal matrices.
+    return TGretinaGeometry::IntPointToGlobal(fCrystalId,fIntPoints.fX[i],
+        fIntPoints.fY[i],
+        fIntPoints.fZ[i]);
   } else {
     return TDetectorHit::BeamUnitVec;
   }
@@ -167,10 +158,10 @@ TVector3 TGretinaHit::GetIntPosition(unsigned int i) const {
 /* Returns vector for loacl position within the crystal ************************/
 /*******************************************************************************/
 TVector3 TGretinaHit::GetLocalPosition(unsigned int i) const {
-  if(i<fSegments.size()){
-    return TVector3(fSegments.at(i).fX,
-        fSegments.at(i).fY,
-        fSegments.at(i).fZ);
+  if(int(i)<fIntPoints.size()){
+    return TVector3(fIntPoints.fX[i],
+        fIntPoints.fY[i],
+        fIntPoints.fZ[i]);
   } else {
     return TVector3(0,0,1);
   }
@@ -191,11 +182,11 @@ double TGretinaHit::GetDoppler(double beta,const TVector3 *vec, int EngRange) co
   double gamma = 1/(sqrt(1-pow(beta,2)));
 
   TVector3 gret_pos = GetPosition();
-  double xoffset = GValue::Value("TARGET_X_OFFSET");
+  double xoffset = target_x_offset.Value();
   if(std::isnan(xoffset)) xoffset=0.00;
-  double yoffset = GValue::Value("TARGET_Y_OFFSET");
+  double yoffset = target_y_offset.Value();
   if(std::isnan(yoffset)) yoffset=0.00;
-  double zoffset = GValue::Value("TARGET_Z_OFFSET");
+  double zoffset = target_z_offset.Value();
   if(std::isnan(zoffset)) zoffset=0.00;
 
   gret_pos.SetX(gret_pos.X() - xoffset);
@@ -220,11 +211,11 @@ double TGretinaHit::GetDopplerYta(double beta, double yta, const TVector3 *vec,
     vec = &BeamUnitVec;
   }
   //Target offsets determine new reference point in lab frame
-  double xoffset = GValue::Value("TARGET_X_OFFSET");
+  double xoffset = target_x_offset.Value();
   if(std::isnan(xoffset)) xoffset=0.00;
-  double yoffset = GValue::Value("TARGET_Y_OFFSET");
+  double yoffset = target_y_offset.Value();
   if(std::isnan(yoffset)) yoffset=0.00;
-  double zoffset = GValue::Value("TARGET_Z_OFFSET");
+  double zoffset = target_z_offset.Value();
   if(std::isnan(zoffset)) zoffset=0.00;
   return GetDopplerYta(beta, yta, xoffset, yoffset, zoffset, vec, EngRange);
 }
@@ -265,22 +256,26 @@ void TGretinaHit::NNAdd(const TGretinaHit& rhs) {
 
   // S.G. - Does it make sense to add interactions points from other crystal?
   // Fill all interaction points
-  for(unsigned int i=0; i<rhs.fSegments.size(); i++){
+  for(int i=0; i<rhs.fIntPoints.size(); i++){
     if(fNumberOfInteractions >= MAXHPGESEGMENTS){
       break;
     }
-    fSegments.push_back(rhs.fSegments[i]);
+    if(!fIntPoints.push_back(rhs.fIntPoints.fSeg[i], rhs.fIntPoints.fX[i], rhs.fIntPoints.fY[i],
+                            rhs.fIntPoints.fZ[i], rhs.fIntPoints.fEng[i], rhs.fIntPoints.fFrac[i])) {
+      break;
+    }
     fNumberOfInteractions++;
   }
+  StoreIntPoints();
 }
 
 /*******************************************************************************/
 /* Returns position vector based on final interaction point ********************/
 /*******************************************************************************/
 TVector3 TGretinaHit::GetLastPosition() const {
-  if(fSegments.size()<1)
+  if(fIntPoints.size()<1)
     return TDetectorHit::BeamUnitVec;
-  return GetIntPosition(fSegments.size()-1);
+  return GetIntPosition(fIntPoints.size()-1);
 }
 
 /*******************************************************************************/
@@ -302,12 +297,12 @@ void TGretinaHit::Print(Option_t *opt) const {
       std::cout << "\tCharge[" << i << "]:       \t" << fCoreCharge[i] << std::endl;
   }
   std::cout << "\tErrorCode:       \t" << fPad                         << std::endl;
-  std::cout << "\tInteractions:    \t" << fSegments.size()             << std::endl;
+  std::cout << "\tInteractions:    \t" << fIntPoints.size()             << std::endl;
 
   if(!strcmp(opt,"all")) {
-    for(int i=0;i<fNumberOfInteractions;i++) {
+    for(int i=0;i<fIntPoints.size();i++) {
       printf("\t\t");
-      fSegments.at(i).Print();
+      fIntPoints.at(i).Print();
     }
   }
   std::cout << "------------------------------"  << std::endl;
@@ -329,6 +324,7 @@ void TGretinaHit::Clear(Option_t *opt) {
   fTOffset = sqrt(-1);
   fPad  = 0;
   fNumberOfInteractions = 0;
+  fIntPoints.clear();
   fSegments.clear();
 }
 
@@ -340,29 +336,80 @@ void TGretinaHit::Clear(Option_t *opt) {
 /*******************************************************************************/
 void TGretinaHit::TrimSegments(int type) {
   if(type==0) {
-    std::set<interaction_point,intpnt_compare> pset;
-    for(auto x=fSegments.begin();x!=fSegments.end();x++) {
-      pset.insert(*x);
-    }
-    fSegments.clear();
-    for(auto x=pset.begin();x!=pset.end();x++) {
-      fSegments.push_back(*x);
-    }
-    std::sort(fSegments.begin(),fSegments.end());
-    fNumberOfInteractions = fSegments.size();
+    fIntPoints.KeepFirst(0);
+    fIntPoints.Sort();
+    fNumberOfInteractions = fIntPoints.size();
   } else if (type==1) {
-    std::set<interaction_point,intpnt_compare_wedge> pset;
-    for(auto x=fSegments.begin();x!=fSegments.end();x++) {
-      pset.insert(*x);
+    fIntPoints.KeepFirst(6);
+    for(int i=0; i<fIntPoints.size(); i++) {
+      fIntPoints.fSeg[i] = fIntPoints.fSeg[i]%6;
+    }
+    fIntPoints.Sort();
+    fNumberOfInteractions = fIntPoints.size();
+  }
+  StoreIntPoints();
+}
+
+/*******************************************************************************/
+/* Copies the interaction points into the streamed vector **********************/
+/*******************************************************************************/
+void TGretinaHit::StoreIntPoints() {
+  fSegments.clear();
+  for(int i=0; i<fIntPoints.size(); i++) {
+    fSegments.push_back(fIntPoints.at(i));
+  }
+}
+
+/*******************************************************************************/
+/* TGretinaIntPoints ***********************************************************/
+/*******************************************************************************/
+void TGretinaIntPoints::Sort() {
+  int order[kCapacity];
+  for(int i=0; i<fN; i++) {
+    order[i] = i;
+  }
+  std::sort(order, order+fN, [this](int a, int b) {
+      if(fEng[a]!=fEng[b]) {
+        return fEng[a]>fEng[b];
+      }
+      if(fSeg[a]==fSeg[b]) {
+        return fFrac[a]>fFrac[b];
+      }
+      return fSeg[a]<fSeg[b];
+    });
+
+  TGretinaIntPoints sorted;
+  for(int i=0; i<fN; i++) {
+    int j = order[i];
+    sorted.push_back(fSeg[j],fX[j],fY[j],fZ[j],fEng[j],fFrac[j]);
+  }
+  *this = sorted;
+}
+
+void TGretinaIntPoints::KeepFirst(int segment_mod) {
+  int kept = 0;
+  for(int i=0; i<fN; i++) {
+    int key = segment_mod ? fSeg[i]%segment_mod : fSeg[i];
+    bool seen = false;
+    for(int j=0; j<kept; j++) {
+      int other = segment_mod ? fSeg[j]%segment_mod : fSeg[j];
+      if(other == key) {
+        seen = true;
+        break;
+      }
     }
-    fSegments.clear();
-    for(auto x=pset.begin();x!=pset.end();x++) {
-      fSegments.push_back(*x);
-      fSegments.back().fSeg = (fSegments.back().fSeg%6);
+    if(seen) {
+      continue;
     }
-    std::sort(fSegments.begin(),fSegments.end());
-    fNumberOfInteractions = fSegments.size();
+    fSeg[kept]  = fSeg[i];
+    fX[kept]    = fX[i];
+    fY[kept]    = fY[i];
+    fZ[kept]    = fZ[i];
+    fEng[kept]  = fEng[i];
+    fFrac[kept] = fFrac[i];
+    kept++;
   }
+  fN = kept;
 }
 
 /*******************************************************************************/
@@ -416,7 +463,7 @@ void TInteractionPoint::Copy(const TInteractionPoint &IP) {
 }
 
 TVector3 TInteractionPoint::GetPosition(int xtal) const {
-  return TGretina::CrystalToGlobal(xtal, fLPosition.X(), fLPosition.Y(), fLPosition.Z());
+  return TGretinaGeometry::CrystalToGlobal(xtal, fLPosition.X(), fLPosition.Y(), fLPosition.Z());
 }
 
 
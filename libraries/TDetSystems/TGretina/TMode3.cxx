@@ -37,20 +37,32 @@ int TMode3::BuildHits(std::vector<TRawEvent>& raw_data){
   if(raw_data.size()<1)
     return Size();
   long smallest_time = 0x3fffffffffffffff;
+  mode3_hits.reserve(mode3_hits.size() + raw_data.size());
   for(auto& event : raw_data){
     if(event.GetTimestamp()<smallest_time)
       smallest_time=event.GetTimestamp();
-    TMode3Hit hit;
+    // Built in place, so the waveform is never copied.
+    mode3_hits.emplace_back();
+    TMode3Hit& hit = mode3_hits.back();
     TSmartBuffer buf = event.GetPayloadBuffer();
     hit.BuildFrom(buf);
     hit.SetTimestamp(event.GetTimestamp());
-    InsertHit(hit);
+    fSize++;
   }
   SetTimestamp(smallest_time);
   std::sort(mode3_hits.begin(),mode3_hits.end());
   return Size();
 }
 
+/*******************************************************************************/
+/* Swaps waveforms still held in the raw buffer ********************************/
+/*******************************************************************************/
+void TMode3::MaterializeTraces() {
+  for(auto& hit : mode3_hits) {
+    hit.MaterializeWave();
+  }
+}
+
 /*******************************************************************************/
 /* Basic Print Function ********************************************************/
 /*******************************************************************************/
@@ -1,14 +1,18 @@
 #include "TMode3Hit.h"
+
+#include <mutex>
+
 #include "TRandom.h"
 #include "TGEBEvent.h"
 #include "TGRUTOptions.h"
 #include "TChannel.h"
+#include "TMode3TraceEngine.h"
 
 ClassImp(TMode3Hit)
 
 bool TMode3Hit::fExtractWaves = true;
 
-TMode3Hit::TMode3Hit(){ }
+TMode3Hit::TMode3Hit() : fWaveSwapped(false) { }
 
 TMode3Hit::~TMode3Hit() { }
 
@@ -43,20 +47,38 @@ void TMode3Hit::BuildFrom(TSmartBuffer& buf){
 
   size_t wave_bytes = header->GetLength()*4 - sizeof(*header) + 4 - sizeof(*data);
   if(read_waveform){
-    size_t wavesize = wave_bytes/sizeof(short);
-    waveform.resize(wavesize);
-
-    memcpy((char*)&waveform[0], buf.GetData(), wave_bytes);
-
-    for(unsigned int i=0; i<wavesize; i+=2){
-      short tmp      = TRawEvent::SwapShort(waveform[i+1]);
-      waveform[i+1] = TRawEvent::SwapShort(waveform[i]);
-      waveform[i]   = tmp;
-    }
+    // Swapped into waveform only when asked for, see MaterializeWave.
+    fRawWave = buf.BufferSubset(0, wave_bytes);
+    wavesize = fRawWave.GetSize()/sizeof(short);
   }
   buf.Advance(wave_bytes);
 }
 
+/*******************************************************************************/
+/* Byte-swaps the raw waveform into waveform ***********************************/
+/*******************************************************************************/
+void TMode3Hit::MaterializeWave() const {
+  if(fWaveSwapped.load(std::memory_order_acquire)) {
+    return;
+  }
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  if(fWaveSwapped.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // fRawWave is kept until Clear(), so GetRawWave() stays valid for other readers.
+  if(fRawWave.GetSize()) {
+    waveform.resize(fRawWave.GetSize()/sizeof(Short_t));
+    TMode3TraceEngine::SwapWave(fRawWave.GetData(), waveform.size(), waveform.data());
+  }
+  fWaveSwapped.store(true, std::memory_order_release);
+}
+
+const std::vector<Short_t>& TMode3Hit::GetWave() const {
+  MaterializeWave();
+  return waveform;
+}
+
 /*******************************************************************************/
 /* Copies hit ******************************************************************/
 /*******************************************************************************/
@@ -67,7 +89,15 @@ void TMode3Hit::Copy(TObject& obj) const {
   mode3.board_id = board_id;
   mode3.led      = led;
   mode3.cfd      = cfd;
-  mode3.waveform = waveform;
+  mode3.dt1      = dt1;
+  mode3.dt2      = dt2;
+  mode3.charge0  = charge0;
+  mode3.charge1  = charge1;
+  mode3.charge2  = charge2;
+  mode3.wavesize = wavesize;
+  mode3.waveform = GetWave();
+  mode3.fRawWave = fRawWave;
+  mode3.fWaveSwapped.store(true, std::memory_order_release);
 }
 
 
@@ -92,23 +122,40 @@ void TMode3Hit::Clear(Option_t *opt) {
   charge1  = -1;
   charge2  = -1;
 
+  wavesize = 0;
   waveform.clear();
+  fRawWave.Clear();
+  fWaveSwapped.store(false, std::memory_order_release);
 }
 
 /*******************************************************************************/
 /* Returns the average of mode3 wave *******************************************/
 /*******************************************************************************/
 double TMode3Hit::AverageWave(int samples) const {
-  if(waveform.size() == 0) {
+  int size = Size();
+  if(size == 0) {
     return 0.0;
   }
   if(samples < 0 ||
-     samples > int(waveform.size())) {
-    samples = waveform.size();
+     samples > size) {
+    samples = size;
   }
-  double sum = 0.0;
+
+  const Short_t* wave = waveform.data();
+  if(HasRawWave() && !fWaveSwapped.load(std::memory_order_acquire)) {
+    // Swap only what is needed, without touching the hit.
+    static thread_local std::vector<Short_t> swapped;
+    int nswap = std::min(samples + samples%2, size);
+    if(int(swapped.size()) < nswap) {
+      swapped.resize(nswap);
+    }
+    TMode3TraceEngine::SwapWave(fRawWave.GetData(), nswap, swapped.data());
+    wave = swapped.data();
+  }
+
+  long sum = 0;
   for(int i=0;i<samples;i++) {
-    sum += waveform[i];
+    sum += wave[i];
   }
   return sum / ((double)samples);
 }
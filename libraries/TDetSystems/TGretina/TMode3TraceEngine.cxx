@@ -0,0 +1,169 @@
+#include "TMode3TraceEngine.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MODE3_TRACE_SIMD
+#endif
+
+#include "TMode3Hit.h"
+
+namespace {
+  void SwapScalar(const char* raw, size_t nwords, Short_t* output) {
+    for(size_t i=0; i<nwords; i++) {
+      UInt_t word;
+      memcpy(&word, raw + 4*i, 4);
+      word = __builtin_bswap32(word);
+      memcpy(output + 2*i, &word, 4);
+    }
+  }
+
+#ifdef MODE3_TRACE_SIMD
+  __attribute__((target("ssse3")))
+  size_t SwapSSSE3(const char* raw, size_t nwords, Short_t* output) {
+    const __m128i mask = _mm_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+    size_t i = 0;
+    for(; i + 4 <= nwords; i += 4) {
+      __m128i words = _mm_loadu_si128((const __m128i*)(raw + 4*i));
+      _mm_storeu_si128((__m128i*)(output + 2*i), _mm_shuffle_epi8(words, mask));
+    }
+    return i;
+  }
+
+  __attribute__((target("avx2")))
+  size_t SwapAVX2(const char* raw, size_t nwords, Short_t* output) {
+    const __m256i mask = _mm256_setr_epi8(3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+                                          3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+    size_t i = 0;
+    for(; i + 8 <= nwords; i += 8) {
+      __m256i words = _mm256_loadu_si256((const __m256i*)(raw + 4*i));
+      _mm256_storeu_si256((__m256i*)(output + 2*i), _mm256_shuffle_epi8(words, mask));
+    }
+    return i;
+  }
+
+  int SimdLevel() {
+    static const int level = __builtin_cpu_supports("avx2")  ? 2 :
+                             __builtin_cpu_supports("ssse3") ? 1 : 0;
+    return level;
+  }
+#endif
+}
+
+TMode3TraceEngine::TMode3TraceEngine()
+  : fBaselineSamples(20), fPickoffSamples(20), fRise(20), fGap(10) { }
+
+/*******************************************************************************/
+/* Byte-swaps a raw Mode3 waveform *********************************************/
+/*******************************************************************************/
+void TMode3TraceEngine::SwapWave(const char* raw, size_t nsamples, Short_t* output) {
+  size_t nwords = nsamples/2;
+  size_t done = 0;
+#ifdef MODE3_TRACE_SIMD
+  switch(SimdLevel()) {
+  case 2:
+    done = SwapAVX2(raw, nwords, output);
+    break;
+  case 1:
+    done = SwapSSSE3(raw, nwords, output);
+    break;
+  default:
+    break;
+  }
+#endif
+  SwapScalar(raw + 4*done, nwords - done, output + 2*done);
+
+  if(nsamples%2) {
+    UShort_t sample;
+    memcpy(&sample, raw + 4*nwords, 2);
+    output[nsamples-1] = __builtin_bswap16(sample);
+  }
+}
+
+/*******************************************************************************/
+/* Unpacks and processes every waveform of an event ****************************/
+/*******************************************************************************/
+size_t TMode3TraceEngine::Process(const std::vector<TMode3Hit>& hits) {
+  return Process(hits.data(), hits.size());
+}
+
+size_t TMode3TraceEngine::Process(const TMode3Hit* hits, size_t nhits) {
+  fWaveStart.resize(nhits + 1);
+  fResults.resize(nhits);
+
+  size_t total = 0;
+  for(size_t i=0; i<nhits; i++) {
+    fWaveStart[i] = total;
+    total += hits[i].Size();
+  }
+  fWaveStart[nhits] = total;
+  if(fWaves.size() < total) {
+    fWaves.resize(total);
+  }
+
+  for(size_t i=0; i<nhits; i++) {
+    const TMode3Hit& hit = hits[i];
+    Short_t* wave = fWaves.data() + fWaveStart[i];
+    size_t nsamples = GetWaveSize(i);
+    if(hit.HasRawWave()) {
+      SwapWave(hit.GetRawWave().GetData(), nsamples, wave);
+    } else if(nsamples) {
+      const std::vector<Short_t>& swapped = hit.GetWave();
+      std::copy(swapped.begin(), swapped.end(), wave);
+    }
+
+    TMode3TraceResult& result = fResults[i];
+    result.crystal_id = hit.GetCrystalId();
+    result.segment_id = hit.GetSegmentId();
+    ProcessWave(wave, nsamples, result);
+  }
+
+  return nhits;
+}
+
+/*******************************************************************************/
+/* Baseline, pickoff and trapezoid from one waveform ***************************/
+/*******************************************************************************/
+void TMode3TraceEngine::ProcessWave(const Short_t* wave, size_t nsamples, TMode3TraceResult& result) {
+  result.baseline  = 0;
+  result.pickoff   = 0;
+  result.trapezoid = 0;
+  if(nsamples == 0) {
+    return;
+  }
+
+  // Running sums, so that every window below is a difference of two entries.
+  if(fSums.size() < nsamples + 1) {
+    fSums.resize(nsamples + 1);
+  }
+  Int_t* sums = fSums.data();
+  sums[0] = 0;
+  for(size_t i=0; i<nsamples; i++) {
+    sums[i+1] = sums[i] + wave[i];
+  }
+
+  int n = nsamples;
+  int nbase = std::min(fBaselineSamples, n);
+  if(nbase > 0) {
+    result.baseline = double(sums[nbase])/nbase;
+  }
+
+  int npick = std::min(fPickoffSamples, n);
+  if(npick > 0) {
+    result.pickoff = double(sums[n] - sums[n-npick])/npick - result.baseline;
+  }
+
+  // Leading window is wave[i-rise..i-1], the trailing window ends rise+gap samples earlier.
+  int first = 2*fRise + fGap;
+  if(fRise > 0 && first <= n) {
+    Int_t best = std::numeric_limits<Int_t>::min();
+    for(int i=first; i<=n; i++) {
+      Int_t value = (sums[i] - sums[i-fRise]) - (sums[i-fRise-fGap] - sums[i-2*fRise-fGap]);
+      best = std::max(best, value);
+    }
+    result.trapezoid = double(best)/fRise;
+  }
+}
@@ -14,9 +14,21 @@
 #include "TRawEvent.h"
 #include "TChannel.h"
 #include "GValue.h"
+#include "TKinematicsTable.h"
 #include "TReaction.h"
 #include "TSRIM.h"
 
+static GValueHandle global_thresh_low("GLOBAL_THRESH_LOW");
+static GValueHandle global_thresh_high("GLOBAL_THRESH_HIGH");
+static GValueHandle ewin("EWIN");
+static GValueHandle tdiff("TDIFF");
+static GValueHandle twohit_thresh_sec("TWOHIT_THRESH_SEC");
+static GValueHandle twohit_thresh_ring("TWOHIT_THRESH_RING");
+static GValueHandle target_thickness("TARGET_THICKNESS");
+static GValueHandle target_density("TARGET_DENSITY");
+static GValueHandle targetthick_value("targetthick");
+static GValueHandle beamenergy_value("beamenergy");
+
 /*******************************************************************************/
 /* TJanusDDAS ******************************************************************/
 /* Legacy class for unpacking JANUS (2 S3 Detectors) in DDAS electronics *******/
@@ -161,16 +173,16 @@ void TJanusDDAS::BuildCorrelatedHits() {
   //int minimum_charge = 1000;
   //int maximum_charge = 30000;
 
-  int minimum_charge = GValue::Value("GLOBAL_THRESH_LOW");
-  int maximum_charge = GValue::Value("GLOBAL_THRESH_HIGH");
+  int minimum_charge = global_thresh_low.Value();
+  int maximum_charge = global_thresh_high.Value();
 
   //32768 is max ADC number, 10000 (ns) was the width of the NSCL Event Builder window
   //These get changed later
   //double EWin = 33000; // dE/E condition
   //double TDiff = 11000; // timimg window (ns)
 
-  double EWin = GValue::Value("EWIN");
-  double TDiff = GValue::Value("TDIFF");
+  double EWin = ewin.Value();
+  double TDiff = tdiff.Value();
 
   for(size_t x=0;x<janus_channels.size();x++){
     TJanusDDASHit chan(janus_channels.at(x));
@@ -281,17 +293,17 @@ void TJanusDDAS::BuildCorrelatedHits() {
     for(size_t j=0;j<sectors.size();j++){
       broken=false;
       if(used_sectors.at(j) /*|| std::fabs(sectors.at(j).Timestamp() - Tref) >  TDiff*/
-	 || sectors.at(j).Charge() < GValue::Value("TWOHIT_THRESH_SEC"))
+	 || sectors.at(j).Charge() < twohit_thresh_sec.Value())
 	{continue;}
       for(size_t i=0;i<rings.size();i++) {
-	if(used_rings.at(i) || rings.at(i).Charge() < GValue::Value("TWOHIT_THRESH_RING") //ring charge cut
+	if(used_rings.at(i) || rings.at(i).Charge() < twohit_thresh_ring.Value() //ring charge cut
 	 //|| std::fabs(rings.at(i).Timestamp() - Tref) >  TDiff
 	   || rings.at(i).GetDetnum() != sectors.at(j).GetDetnum()
 	   || std::fabs(rings.at(i).Timestamp() - sectors.at(j).Timestamp()) > TDiff)
 	  {continue;}
 	for(size_t k=j+1;k<sectors.size();k++) {
 	  if(!used_sectors.at(k) //&& std::fabs(sectors.at(k).Timestamp() - Tref) <  TDiff
-	     && sectors.at(k).Charge() > GValue::Value("TWOHIT_THRESH_SEC") //sector charge cut
+	     && sectors.at(k).Charge() > twohit_thresh_sec.Value() //sector charge cut
 	     && rings.at(i).GetDetnum() == sectors.at(k).GetDetnum()
 	     && std::fabs(sectors.at(j).GetSector() - sectors.at(k).GetSector()) > 1
 	     && std::fabs(sectors.at(j).GetSector() - sectors.at(k).GetSector()) < 31
@@ -848,18 +860,18 @@ double TJanusDDAS::GetBeta(double theta, TReaction& reac, int part, TSRIM& srim,
   if(sol2)
     {theta *= -1;}
   
-  double post_energy_MeV = reac.GetTLab(theta,part);
+  double post_energy_MeV = TKinematicsTable::Get(reac).TLab(theta,part);
 
   // Factors of 1e3 are because TNucleus and TReaction use MeV, while TSRIM uses keV
   if(dE) {
 
     double thickness;
     // (mg/cm^2) / (mg/cm^3) * (10^4 um/cm)
-    if(std::isnan(GValue::Value("TARGET_THICKNESS")) || std::isnan(GValue::Value("TARGET_DENSITY"))) {
+    if(std::isnan(target_thickness.Value()) || std::isnan(target_density.Value())) {
       thickness = (0.92/11342.0) * 10000; //standard lead target
     }
     else {
-      thickness = (GValue::Value("TARGET_THICKNESS") / GValue::Value("TARGET_DENSITY")) * 10000.0;
+      thickness = (target_thickness.Value() / target_density.Value()) * 10000.0;
     }
     
     double distance_travelled = (thickness/2.0)/std::abs(std::cos(theta));
@@ -941,7 +953,7 @@ double TJanusDDAS::Reconstruct(double theta, TReaction& reaction, int det_pt, in
   
   if(s2)
     {theta*=-1;}
-  return reaction.ConvertThetaLab(theta,det_pt,recon_pt);
+  return TKinematicsTable::Get(reaction).ConvertThetaLab(theta,det_pt,recon_pt);
   
 }
 
@@ -971,9 +983,9 @@ double TJanusDDAS::Reconstruct(double theta, const char *beamname, const char *t
   static auto beam = std::make_shared<TNucleus>(beamname);
   static auto targ = std::make_shared<TNucleus>(targetname);
   static TSRIM srim(srimfile); 
-  double thickness = ( GValue::Value("targetthick") / 11342.0) * 1e4; // (0.75 mg/cm^2) / (11342 mg/cm^3) * (10^4 um/cm)
+  double thickness = ( targetthick_value.Value() / 11342.0) * 1e4; // (0.75 mg/cm^2) / (11342 mg/cm^3) * (10^4 um/cm)
 
-  double energy_mid = srim.GetAdjustedEnergy(GValue::Value("beamenergy")*1e3, thickness*0.5)/1e3;
+  double energy_mid = srim.GetAdjustedEnergy(beamenergy_value.Value()*1e3, thickness*0.5)/1e3;
 
   TReaction reac_mid(beam, targ, beam, targ, energy_mid);
 
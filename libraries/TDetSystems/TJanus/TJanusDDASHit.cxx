@@ -7,6 +7,12 @@
 
 #include "TRandom.h"
 
+static GValueHandle janus_x_offset("Janus_X_offset");
+static GValueHandle janus_y_offset("Janus_Y_offset");
+static GValueHandle janus_z_offset("Janus_Z_offset");
+static GValueHandle targetthick_value("targetthick");
+static GValueHandle beamenergy_value("beamenergy");
+
 TJanusDDASHit::TJanusDDASHit(const TJanusDDASHit& hit) {
   hit.Copy(*this);
 }
@@ -108,9 +114,9 @@ bool TJanusDDASHit::IsSector() const {
 TVector3 TJanusDDASHit::GetPosition(bool before, bool apply_array_offset) const {
   TVector3 output = TJanusDDAS::GetPosition(GetDetnum(), GetRing(), GetSector(), before);
   if(apply_array_offset) {
-    output += TVector3(GValue::Value("Janus_X_offset"),
-                       GValue::Value("Janus_Y_offset"),
-                       GValue::Value("Janus_Z_offset"));
+    output += TVector3(janus_x_offset.Value(),
+                       janus_y_offset.Value(),
+                       janus_z_offset.Value());
   }
   return output;
 }
@@ -166,12 +172,12 @@ double TJanusDDASHit::Reconstruct(const char *beamname, const char *targetname,
   static auto beam = std::make_shared<TNucleus>(beamname);   // "78Kr");
   static auto targ = std::make_shared<TNucleus>(targetname); // "208Pb");
   static TSRIM srim(srimfile); 
-  double thickness = ( GValue::Value("targetthick") / 11342.0) * 1e4; // (0.75 mg/cm^2) / (11342 mg/cm^3) * (10^4 um/cm)
+  double thickness = ( targetthick_value.Value() / 11342.0) * 1e4; // (0.75 mg/cm^2) / (11342 mg/cm^3) * (10^4 um/cm)
 
   //double collision_pos = gRandom->Uniform();
 
-  //double collision_energy = srim.GetAdjustedEnergy(GValue::Value("beamenergy")*1e3, thickness*collision_pos)/1e3;
-  double energy_mid = srim.GetAdjustedEnergy(GValue::Value("beamenergy")*1e3, thickness*0.5)/1e3;
+  //double collision_energy = srim.GetAdjustedEnergy(beamenergy_value.Value()*1e3, thickness*collision_pos)/1e3;
+  double energy_mid = srim.GetAdjustedEnergy(beamenergy_value.Value()*1e3, thickness*0.5)/1e3;
 
   //TReaction reac(beam, targ, beam, targ, collision_energy);
   TReaction reac_mid(beam, targ, beam, targ, energy_mid);
@@ -5,6 +5,10 @@
 #include "GValue.h"
 #include "TJanus.h"
 
+static GValueHandle janus_x_offset("Janus_X_offset");
+static GValueHandle janus_y_offset("Janus_Y_offset");
+static GValueHandle janus_z_offset("Janus_Z_offset");
+
 
 /*******************************************************************************/
 /* Copies hit ******************************************************************/
@@ -50,8 +54,8 @@ TVector3 TJanusHit::GetPosition(bool smear, bool apply_array_offset) const {
   if(GetDetnum() == 0) secdown = true;
   TVector3 output = TJanus::GetPosition(GetRing() - 1, GetSector() - 1, GetDefaultDistance(), secdown, smear);
   if(apply_array_offset) {
-    if(!std::isnan(GValue::Value("Janus_X_offset")) && !std::isnan(GValue::Value("Janus_Y_offset")) && !std::isnan(GValue::Value("Janus_Z_offset"))) {
-      output += TVector3(GValue::Value("Janus_X_offset"), GValue::Value("Janus_Y_offset"), GValue::Value("Janus_Z_offset"));
+    if(!std::isnan(janus_x_offset.Value()) && !std::isnan(janus_y_offset.Value()) && !std::isnan(janus_z_offset.Value())) {
+      output += TVector3(janus_x_offset.Value(), janus_y_offset.Value(), janus_z_offset.Value());
     }
   }
   return output;
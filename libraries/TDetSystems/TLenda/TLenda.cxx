@@ -27,6 +27,18 @@ void TLenda::Clear(Option_t* opt){
   ref_hits.clear();
 }
 
+void TLenda::MaterializeTraces() {
+  for(auto& hit : top_hits) {
+    hit.MaterializeTrace();
+  }
+  for(auto& hit : bottom_hits) {
+    hit.MaterializeTrace();
+  }
+  for(auto& hit : ref_hits) {
+    hit.MaterializeTrace();
+  }
+}
+
 int TLenda::BuildHits(std::vector<TRawEvent>& raw_data) {
   for(auto& event : raw_data){
     SetTimestamp(event.GetTimestamp());
@@ -61,7 +73,7 @@ int TLenda::BuildHits(std::vector<TRawEvent>& raw_data) {
       hit.SetCFDFail(ddas.GetCFDFailBit());
 //std::cout << ddas.GetCFDTime() << "\t" << hit.CFDTime() << std::endl;
 //std::cout << ddas.GetCFDTrig() << "\t" << hit.GetCFDFail() << std::endl;
-      hit.SetTrace(ddas.GetTraceLength(), ddas.trace);
+      hit.SetTrace(ddas.GetTraceView());
 
       hit.SetPosArray(chan->GetArrayPosition());
       hit.SetPosSeg(chan->GetSegment());
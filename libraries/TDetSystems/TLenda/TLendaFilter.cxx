@@ -1,7 +1,224 @@
 #include <TLendaFilter.h>
 
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LENDA_FILTER_AVX2
+#endif
+
 ClassImp(TLendaFilter)
 
+namespace {
+  // FastFilter and FastFilterOp add trace[i], not trace[j], once for each sample j
+  //   of the leading window and subtract it once for each sample of the trailing
+  //   window, both clipped at the start of the trace.  The filter is therefore
+  //   trace[i] times the difference of the two window lengths.
+  Int_t WindowWeight(Int_t i, Int_t FL, Int_t FG) {
+    int lead  = i - std::max(i - (FL - 1), 0) + 1;
+    int trail = (i - (FL + FG)) - std::max(i - (2*FL + FG - 1), 0);
+    return std::max(lead, 0) - std::max(trail, 0);
+  }
+
+  void ScaleScalar(const UShort_t* trace, Int_t n, Float_t weight, Float_t* out) {
+    for(int i = 0; i < n; i++) {
+      out[i] = weight*trace[i];
+    }
+  }
+
+  void CFDScalar(const Float_t* filter, Int_t begin, Int_t length, Int_t delay, Float_t weight, Float_t* cfd) {
+    for(int i = begin; i < length; i++) {
+      cfd[i] = filter[i] - filter[i-delay]*weight;
+    }
+  }
+
+#ifdef LENDA_FILTER_AVX2
+  __attribute__((target("avx2")))
+  void ScaleAVX2(const UShort_t* trace, Int_t n, Float_t weight, Float_t* out) {
+    __m256 scale = _mm256_set1_ps(weight);
+    int i = 0;
+    for(; i + 8 <= n; i += 8) {
+      __m256i samples = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(trace + i)));
+      _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+    }
+    ScaleScalar(trace + i, n - i, weight, out + i);
+  }
+
+  __attribute__((target("avx2,fma")))
+  void CFDAVX2(const Float_t* filter, Int_t begin, Int_t length, Int_t delay, Float_t weight, Float_t* cfd) {
+    __m256 neg_weight = _mm256_set1_ps(-weight);
+    int i = begin;
+    for(; i + 8 <= length; i += 8) {
+      __m256 current = _mm256_loadu_ps(filter + i);
+      __m256 delayed = _mm256_loadu_ps(filter + i - delay);
+      _mm256_storeu_ps(cfd + i, _mm256_fmadd_ps(delayed, neg_weight, current));
+    }
+    CFDScalar(filter, i, length, delay, weight, cfd);
+  }
+
+  bool HasAVX2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return has_avx2;
+  }
+#endif
+
+  // out[i-begin] = WindowWeight(i)*trace[i] for i in [begin,end).  The weight only
+  //   changes while the windows are clipped, so the rest is a single scale.
+  void WeightedTrace(const UShort_t* trace, Int_t begin, Int_t end, Int_t FL, Int_t FG, Float_t* out) {
+    int steady = std::max(begin, std::min(end, std::max(std::max(2*FL + FG - 1, FL - 1), 0)));
+    for(int i = begin; i < steady; i++) {
+      out[i-begin] = WindowWeight(i, FL, FG)*trace[i];
+    }
+    if(steady >= end) {
+      return;
+    }
+    Float_t weight = WindowWeight(steady, FL, FG);
+#ifdef LENDA_FILTER_AVX2
+    if(HasAVX2()) {
+      ScaleAVX2(trace + steady, end - steady, weight, out + (steady - begin));
+      return;
+    }
+#endif
+    ScaleScalar(trace + steady, end - steady, weight, out + (steady - begin));
+  }
+}
+
+Int_t TLendaFilter::FastFilterKernel(const UShort_t* trace, Int_t length, Int_t FL, Int_t FG, Float_t* filter) {
+  if(length < 20) {
+    return 0;
+  }
+  int start = std::min(std::max(2*FL + FG - 1, 0), length);
+  std::fill(filter, filter + start, 0.f);
+  WeightedTrace(trace, start, length, FL, FG, filter + start);
+  return length;
+}
+
+Int_t TLendaFilter::FastFilterOpKernel(const UShort_t* trace, Int_t length, Int_t FL, Int_t FG, Float_t* filter) {
+  if(length < 20) {
+    return 0;
+  }
+  // Same window as FastFilterOp, filter[0] is the value at trace[start].
+  int start = length/2 - 0.15*length;
+  int end   = length/2 + 0.15*length;
+  WeightedTrace(trace, start, end, FL, FG, filter);
+  return end - start;
+}
+
+void TLendaFilter::CFDKernel(const Float_t* filter, Int_t length, Int_t CFD_delay, Int_t CFD_scale_factor, Float_t* cfd) {
+  int start = std::min(CFD_delay, length);
+  std::fill(cfd, cfd + start, 0.f);
+  Float_t weight = 1.0/std::pow(2, CFD_scale_factor + 1);
+
+#ifdef LENDA_FILTER_AVX2
+  if(HasAVX2()) {
+    CFDAVX2(filter, start, length, CFD_delay, weight, cfd);
+    return;
+  }
+#endif
+  CFDScalar(filter, start, length, CFD_delay, weight, cfd);
+}
+
+Double_t TLendaFilter::ZeroCrossingKernel(const Float_t* cfd, Int_t begin, Int_t end, Double_t &residual) {
+  for(int i = std::max(begin, 0); i < end - 1; i++) {
+    if(cfd[i] >= 0 && cfd[i + 1] < 0) {
+      // In Double_t, as GetZeroCrossingImprovedRMD.
+      Double_t above = cfd[i];
+      Double_t below = cfd[i + 1];
+      residual = above;
+      return i + above / (above + std::abs(below));
+    }
+  }
+  return sqrt(-1);
+}
+
+Double_t TLendaFilter::ZeroCrossingCubicKernel(const Float_t* cfd, Int_t length, Int_t SpotAbove) {
+  if(SpotAbove < 1 || SpotAbove + 2 >= length) {
+    return sqrt(-1);
+  }
+  Double_t y[4] = {cfd[SpotAbove-1], cfd[SpotAbove], cfd[SpotAbove+1], cfd[SpotAbove+2]};
+  Double_t coeffs[4];
+  CubicThroughPoints(y, coeffs);
+  return SpotAbove + SolveCubicZero(coeffs);
+}
+
+void TLendaFilter::CubicThroughPoints(const Double_t y[4], Double_t coeffs[4]) {
+  // Lagrange interpolation through t = -1, 0, 1, 2, replaces the 4x4 matrix inversion.
+  coeffs[0] = y[1];
+  coeffs[1] = -y[0]/3.0 - y[1]/2.0 + y[2] - y[3]/6.0;
+  coeffs[2] =  y[0]/2.0 - y[1] + y[2]/2.0;
+  coeffs[3] = -y[0]/6.0 + y[1]/2.0 - y[2]/2.0 + y[3]/6.0;
+}
+
+Double_t TLendaFilter::SolveCubicZero(const Double_t coeffs[4]) {
+  const Double_t a = coeffs[0];
+  const Double_t b = coeffs[1];
+  const Double_t c = coeffs[2];
+  const Double_t d = coeffs[3];
+  const Double_t scale = std::abs(a) + std::abs(b) + std::abs(c) + std::abs(d);
+  if(scale == 0) {
+    return 0;
+  }
+
+  Double_t roots[3];
+  int nroots = 0;
+  if(std::abs(d) > 1e-12*scale) {
+    // Depressed cubic u^3 + p*u + q = 0, with t = u - A/3.
+    Double_t A = c/d;
+    Double_t B = b/d;
+    Double_t C = a/d;
+    Double_t p = B - A*A/3.0;
+    Double_t q = 2.0*A*A*A/27.0 - A*B/3.0 + C;
+    Double_t disc = q*q/4.0 + p*p*p/27.0;
+    if(disc > 0) {
+      Double_t sq = std::sqrt(disc);
+      roots[nroots++] = std::cbrt(-q/2.0 + sq) + std::cbrt(-q/2.0 - sq) - A/3.0;
+    } else if(p == 0) {
+      roots[nroots++] = -A/3.0;
+    } else {
+      Double_t r = 2.0*std::sqrt(-p/3.0);
+      Double_t phi = std::acos(std::max(-1.0, std::min(1.0, 3.0*q/(p*r))))/3.0;
+      for(int k = 0; k < 3; k++) {
+        roots[nroots++] = r*std::cos(phi - 2.0*TMath::Pi()*k/3.0) - A/3.0;
+      }
+    }
+  } else if(std::abs(c) > 1e-12*scale) {
+    Double_t disc = b*b - 4.0*c*a;
+    if(disc >= 0) {
+      Double_t q = -0.5*(b + std::copysign(std::sqrt(disc), b));
+      roots[nroots++] = q/c;
+      if(q != 0) {
+        roots[nroots++] = a/q;
+      }
+    }
+  } else if(b != 0) {
+    roots[nroots++] = -a/b;
+  }
+
+  Double_t best = sqrt(-1);
+  for(int i = 0; i < nroots; i++) {
+    // Polish, the closed forms lose precision when terms cancel.
+    Double_t t = roots[i];
+    for(int iter = 0; iter < 2; iter++) {
+      Double_t deriv = b + t*(2.0*c + t*3.0*d);
+      if(deriv == 0) {
+        break;
+      }
+      t -= (a + t*(b + t*(c + t*d)))/deriv;
+    }
+    if(t >= -1e-9 && t <= 1 + 1e-9 && !(t >= best)) {
+      best = std::max(0.0, std::min(1.0, t));
+    }
+  }
+
+  if(std::isnan(best)) {
+    // No crossing between the two points; the old bisection ended at
+    // whichever end the sign of the cubic pushed it to.
+    best = (a > 0) ? 1 : 0;
+  }
+  return best;
+}
+
 
 void TLendaFilter::FastFilter(std::vector<UShort_t> &fTrace, std::vector<Double_t> &fFastFilter, int FL, int FG) {
   if(fTrace.size() < 20){
@@ -221,48 +438,15 @@ double TLendaFilter::getFunc(std::vector<double> &Coeffs, double x){
 }
 
 Double_t TLendaFilter::DoMatrixInversionAlgorithm(const std::vector <Double_t> & CFD, Int_t theSpotAbove){
-
-  Double_t x[4];
-  TMatrixT<Double_t> Y(4,1);//a column vector
+  //first point is the one before zerocrossing
+  Double_t y[4];
   for (int i = 0; i < 4; i++) {
-    x[i]= theSpotAbove - 1+ i; //first point is the one before zerocrossing
-    Y[i][0] = CFD.at(theSpotAbove - 1 + i);
-  }
-
-  TMatrixT<Double_t> A(4,4);//declare 4 by 4 matrix
-  for (int row = 0; row < 4; row++) {
-    for (int col = 0; col < 4; col++) {
-      A[row][col]= pow(x[row], 3 - col);
-    }
+    y[i] = CFD.at(theSpotAbove - 1 + i);
   }
 
-  TMatrixT<Double_t> invertA = A.Invert();
-  TMatrixT<Double_t> Coeffs(4,1);
-  Coeffs = invertA * Y;
-
-  //the x[1] is theSpot above so start there
-  bool notDone = true;
-  double left = x[1];//initial above
-  double right = x[2];//initial below
-  double valUp = getFunc(Coeffs,left);
-  double valDown = getFunc(Coeffs,right);
-
-  int loopCount=0;
-  while(notDone) {
-    loopCount++;
-    if (TMath::Abs(TMath::Abs(valUp) - TMath::Abs(valDown)) < 0.001) notDone = false;
-    double mid = (left+right)/2.0;
-    double midVal = getFunc(Coeffs,mid);
-    if(midVal > 0) left = mid;
-    else right = mid;
-    valUp = getFunc(Coeffs,left);
-    valDown = getFunc(Coeffs,right);
-    if(loopCount > 30){ //kill stuck loop
-      notDone=false;
-      left = sqrt(-1);
-    }
-  }
-  return left;
+  Double_t coeffs[4];
+  CubicThroughPoints(y, coeffs);
+  return theSpotAbove + SolveCubicZero(coeffs);
 }
 
 std::vector <Double_t> TLendaFilter::GetMatrixInversionAlgorithmCoeffients(const std::vector <Double_t> & CFD, Int_t &ReturnSpotAbove) {
@@ -284,29 +468,20 @@ std::vector <Double_t> TLendaFilter::GetMatrixInversionAlgorithmCoeffients(const
   int theSpotAbove = zeroCrossings[max];
   ReturnSpotAbove = theSpotAbove;
 
-  Double_t x[4];
-  TMatrixT<Double_t> Y(4,1);//a column vector
-
+  Double_t y[4];
   for(int i = 0; i < 4; i++){
-    x[i]= theSpotAbove - 1 + i; //first point is the one before zerocrossing
-    Y[i][0] = CFD.at(theSpotAbove - 1 + i);
-  }
-
-  TMatrixT<Double_t> A(4,4);//declare 4 by 4 matrix
-
-  for(int row = 0; row < 4; row++){
-    for(int col = 0; col < 4; col++){
-      A[row][col]= pow(x[row], 3 - col);
-    }
-  }
-
-  TMatrixT<Double_t> invertA = A.Invert();
-  TMatrixT<Double_t> Coeffs(4,1);
-  Coeffs = invertA * Y;
-  std::vector <Double_t> retVec;
-  for (int i = 0; i < 4; i++){
-    retVec.push_back(Coeffs[i][0]);
-  }
+    y[i] = CFD.at(theSpotAbove - 1 + i); //first point is the one before zerocrossing
+  }
+  Double_t c[4];
+  CubicThroughPoints(y, c);
+
+  // Shift from t = x - theSpotAbove back to x, highest power first.
+  Double_t s = theSpotAbove;
+  std::vector <Double_t> retVec(4);
+  retVec[0] = c[3];
+  retVec[1] = c[2] - 3*c[3]*s;
+  retVec[2] = c[1] - 2*c[2]*s + 3*c[3]*s*s;
+  retVec[3] = c[0] - c[1]*s + c[2]*s*s - c[3]*s*s*s;
   return retVec;
 }
 
@@ -463,6 +638,10 @@ Double_t TLendaFilter::fitTrace(std::vector <UShort_t> & trace,Double_t sigma,Do
 }
 
 Double_t TLendaFilter::GetEnergy(std::vector <UShort_t> &trace,Int_t MaxSpot) {
+  return GetEnergy(trace.data(), trace.size(), MaxSpot);
+}
+
+Double_t TLendaFilter::GetEnergy(const UShort_t* trace, Int_t traceLength, Int_t MaxSpot) {
 
   ////////////////////////////////////////////////////////////////////////////
   // Slightly more complicated algorithm for getting energy of pulse.       //
@@ -478,7 +657,6 @@ Double_t TLendaFilter::GetEnergy(std::vector <UShort_t> &trace,Int_t MaxSpot) {
 
   Double_t signalIntegral=0;
 
-  int traceLength = trace.size();
   int LengthForBackGround = 0.2 * traceLength;
 
   Int_t windowForEnergy = 20;
@@ -490,8 +668,8 @@ Double_t TLendaFilter::GetEnergy(std::vector <UShort_t> &trace,Int_t MaxSpot) {
   }
 
   for ( int i = 0 ; i < LengthForBackGround; i++){
-    sumBegin = sumBegin + trace.at(i);
-    sumEnd = sumEnd + trace.at(traceLength - 1 - i);
+    sumBegin = sumBegin + trace[i];
+    sumEnd = sumEnd + trace[traceLength - 1 - i];
   }
 
   Double_t BackGround;
@@ -511,7 +689,7 @@ Double_t TLendaFilter::GetEnergy(std::vector <UShort_t> &trace,Int_t MaxSpot) {
   }
 
   for (int i = MaxSpot - windowForEnergy; i < MaxSpot + windowForEnergy; i++) {
-    signalIntegral = trace.at(i) + signalIntegral;
+    signalIntegral = trace[i] + signalIntegral;
   }
 
   if(signalIntegral - BackGround * (2 * windowForEnergy) > 0) {
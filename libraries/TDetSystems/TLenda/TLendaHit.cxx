@@ -3,15 +3,32 @@
 ClassImp(TLendaHit)
 
 
+void TLendaHit::Copy(TObject& obj) const {
+  TDetectorHit::Copy(obj);
+  TLendaHit& hit = (TLendaHit&)obj;
+  hit.fTrace = fTrace;
+  hit.fTraceView = fTraceView;
+}
+
 void TLendaHit::SetTrace(unsigned int trace_length, const unsigned short* trace) {
+  fTraceView.Clear();
   fTrace.clear();
   fTrace.reserve(trace_length);
   copy(trace,trace+trace_length,back_inserter(fTrace));
 }
 
+void TLendaHit::MaterializeTrace() {
+  if(fTraceView.empty()) {
+    return;
+  }
+  fTraceView.CopyTo(fTrace);
+  fTraceView.Clear();
+}
+
 void TLendaHit::Clear(Option_t *opt) {
   TDetectorHit::Clear(opt);
   fTrace.clear();
+  fTraceView.Clear();
 }
 
 int TLendaHit::GetCrate() const {
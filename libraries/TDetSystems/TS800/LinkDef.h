@@ -15,6 +15,7 @@
 #pragma link C++ class TTof+;
 #pragma link C++ class TMTof+;
 #pragma link C++ class TCrdc+;
+#pragma read sourceClass="TCrdc" targetClass="TCrdc" source="" target="fReconstructed" code="{ fReconstructed = false; }"
 #pragma link C++ class TScintillator+;
 #pragma link C++ class TIonChamber+;
 
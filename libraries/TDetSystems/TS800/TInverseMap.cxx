@@ -1,6 +1,9 @@
 
 #include <TInverseMap.h>
 
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <fstream>
 #include <cstdio>
 #include <unistd.h>
@@ -83,9 +86,101 @@ bool TInverseMap::ReadMapFile(const char *filename) {
     //printf("%i\t%s\n",index,line.c_str());
 
   }
+  Compile();
   return true;
 }
 
+/*******************************************************************************/
+/* Turns the rows of the map file into a monomial table ************************/
+/*******************************************************************************/
+void TInverseMap::Compile() {
+  fMonoParent.clear();
+  fMonoInput.clear();
+  for(int par=0; par<kNumPars; par++) {
+    fTerms[par].clear();
+  }
+
+  // Monomial 0 is the constant term.
+  std::map<std::array<int,4>,int> index;
+  std::vector<std::array<int,4> > monomials;
+  index[{{0,0,0,0}}] = 0;
+  monomials.push_back({{0,0,0,0}});
+  fMonoParent.push_back(-1);
+  fMonoInput.push_back(-1);
+
+  // Adds a monomial after the one it is built from, so that a single
+  //   forward pass fills the table.
+  std::function<int(const std::array<int,4>&)> add = [&](const std::array<int,4>& exp) {
+    auto it = index.find(exp);
+    if(it != index.end()) {
+      return it->second;
+    }
+    int input = 0;
+    while(exp[input] == 0) {
+      input++;
+    }
+    std::array<int,4> lower = exp;
+    lower[input]--;
+    int parent = add(lower);
+    int id = monomials.size();
+    index[exp] = id;
+    monomials.push_back(exp);
+    fMonoParent.push_back(parent);
+    fMonoInput.push_back(input);
+    return id;
+  };
+
+  for(auto& it : fMap) {
+    int par = it.first;
+    if(par < 0 || par >= kNumPars) {
+      continue;
+    }
+    for(auto& row : it.second) {
+      std::array<int,4> exp;
+      for(int i=0; i<4; i++) {
+        // Negative powers are not in any map from COSY; MapCalc would use pow().
+        exp[i] = std::max(row.exp[i], 0);
+      }
+      CompiledTerm term;
+      term.coefficient = row.coefficient;
+      term.order       = row.order;
+      term.monomial    = add(exp);
+      fTerms[par].push_back(term);
+    }
+  }
+}
+
+void TInverseMap::EvalMonomials(const float* input, double* mono) const {
+  mono[0] = 1.0;
+  for(size_t i=1; i<fMonoParent.size(); i++) {
+    mono[i] = mono[fMonoParent[i]]*input[fMonoInput[i]];
+  }
+}
+
+// Inputs as in the table below, in a buffer owned by the calling thread.
+const double* TInverseMap::Monomials(double xfp, double afp, double yfp, double bfp) const {
+  float input[4];
+  input[0]  = - xfp / 1000.0;
+  input[1]  = - afp;
+  input[2]  =   yfp / 1000.0;
+  input[3]  =   bfp;
+  thread_local std::vector<double> mono;
+  mono.resize(fMonoParent.size());
+  EvalMonomials(input, mono.data());
+  return mono.data();
+}
+
+float TInverseMap::EvalPar(int degree, int par, const double* mono) const {
+  const std::vector<CompiledTerm>& terms = fTerms[par];
+  double cumul = 0.0;
+  for(size_t i=0; i<terms.size(); i++) {
+    // Stops at the first higher order row, as MapCalc does.
+    if(degree < terms[i].order) break;
+    cumul += terms[i].coefficient*mono[terms[i].monomial];
+  }
+  return cumul;
+}
+
 void TInverseMap::Print(Option_t *opt) const {
   printf("%s\n",info.c_str());
   printf("\tBrho = %.04f\t",fBrho);
@@ -136,102 +231,67 @@ void TInverseMap::Print(Option_t *opt) const {
 // We transform S800 angle into GRETINA.
 
 float TInverseMap::Ata(int order, double xfp, double afp, double yfp, double bfp) const {
-  float input[6];
-  input[0]  = - xfp / 1000.0;
-  input[1]  = - afp;
-  input[2]  =   yfp / 1000.0;
-  input[3]  =   bfp;
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  return MapCalc(order, 0, input);
+  return EvalPar(order, 0, Monomials(xfp, afp, yfp, bfp));
 }
 
 float TInverseMap::Bta(int order, double xfp, double afp, double yfp, double bfp) const {
-  float input[6];
-  input[0]  = - xfp / 1000.0;
-  input[1]  = - afp;
-  input[2]  =   yfp / 1000.0;
-  input[3]  =   bfp;
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  return MapCalc(order, 2, input);
+  return EvalPar(order, 2, Monomials(xfp, afp, yfp, bfp));
 }
 
 float TInverseMap::Yta(int order, double xfp, double afp, double yfp, double bfp) const {
-  float input[6];
-  input[0]  = - xfp / 1000.0;
-  input[1]  = - afp;
-  input[2]  =   yfp / 1000.0;
-  input[3]  =   bfp;
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  return MapCalc(order, 1, input)*1000;
+  return EvalPar(order, 1, Monomials(xfp, afp, yfp, bfp))*1000;
 }
 
 float TInverseMap::Dta(int order, double xfp, double afp, double yfp, double bfp) const {
-  float input[6];
-  input[0]  = - xfp / 1000.0;
-  input[1]  = - afp;
-  input[2]  =   yfp / 1000.0;
-  input[3]  =   bfp;
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  return MapCalc(order, 3, input);
+  return EvalPar(order, 3, Monomials(xfp, afp, yfp, bfp));
 }
 
 float TInverseMap::Ata(int order, const TS800 *s800) {
-  float input[6];
-  input[0]  = - s800->GetXFP() / 1000.0;
-  input[1]  = - s800->GetAFP();
-  input[2]  =   s800->GetYFP() / 1000.0;
-  input[3]  =   s800->GetBFP();
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  int par = 0; // ATA
-  return MapCalc(order,par,input);
+  return Ata(order, s800->GetXFP(), s800->GetAFP(), s800->GetYFP(), s800->GetBFP());
 }
 
 float TInverseMap::Bta(int order, const TS800 *s800) {
-  float input[6];
-  input[0]  = - s800->GetXFP() / 1000.0;
-  input[1]  = - s800->GetAFP();
-  input[2]  =   s800->GetYFP() / 1000.0;
-  input[3]  =   s800->GetBFP();
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  int par = 2; // BTA
-  return MapCalc(order,par,input);
+  return Bta(order, s800->GetXFP(), s800->GetAFP(), s800->GetYFP(), s800->GetBFP());
 }
 
 float TInverseMap::Yta(int order, const TS800 *s800) {
-  float input[6];
-  input[0]  = - s800->GetXFP() / 1000.0;
-  input[1]  = - s800->GetAFP();
-  input[2]  =   s800->GetYFP() / 1000.0;
-  input[3]  =   s800->GetBFP();
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  int par = 1; // YTA
-  // *1000, because the map returns the value in meters.
-  return MapCalc(order,par,input)*1000;
+  return Yta(order, s800->GetXFP(), s800->GetAFP(), s800->GetYFP(), s800->GetBFP());
 }
 
 float TInverseMap::Dta(int order, const TS800 *s800) {
-  float input[6];
-  input[0]  = - s800->GetXFP() / 1000.0;
-  input[1]  = - s800->GetAFP();
-  input[2]  =   s800->GetYFP() / 1000.0;
-  input[3]  =   s800->GetBFP();
-  input[4]  =   0.0;
-  input[5]  =   0.0;
-  int par = 3; // DTA
-  return MapCalc(order,par,input);
+  return Dta(order, s800->GetXFP(), s800->GetAFP(), s800->GetYFP(), s800->GetBFP());
+}
+
+void TInverseMap::Calculate(int order, double xfp, double afp, double yfp, double bfp,
+                            float& ata, float& bta, float& yta, float& dta) const {
+  const double* mono = Monomials(xfp, afp, yfp, bfp);
+  ata = EvalPar(order, 0, mono);
+  yta = EvalPar(order, 1, mono)*1000;
+  bta = EvalPar(order, 2, mono);
+  dta = EvalPar(order, 3, mono);
+}
+
+void TInverseMap::Calculate(int order, size_t n, const float* xfp, const float* afp, const float* yfp,
+                            const float* bfp, float* ata, float* bta, float* yta, float* dta) const {
+  std::vector<double> mono(fMonoParent.size());
+  for(size_t i=0; i<n; i++) {
+    float input[4];
+    input[0]  = - xfp[i] / 1000.0;
+    input[1]  = - afp[i];
+    input[2]  =   yfp[i] / 1000.0;
+    input[3]  =   bfp[i];
+    EvalMonomials(input, mono.data());
+    if(ata) ata[i] = EvalPar(order, 0, mono.data());
+    if(yta) yta[i] = EvalPar(order, 1, mono.data())*1000;
+    if(bta) bta[i] = EvalPar(order, 2, mono.data());
+    if(dta) dta[i] = EvalPar(order, 3, mono.data());
+  }
 }
 
 float TInverseMap::MapCalc(int order,int par,float *input) const {
   float cumul         = 0.0;
   float multiplicator = 0.0;
-  std::vector<InvMapRow> vec = fMap.at(par);
+  const std::vector<InvMapRow>& vec = fMap.at(par);
   for(unsigned int x=0; x<vec.size();x++) {
     if(order<vec.at(x).order) break;
     multiplicator = 1.0;
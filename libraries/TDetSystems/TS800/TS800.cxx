@@ -11,12 +11,25 @@
 #include "TGRUTOptions.h"
 #include "TInverseMap.h"
 
+static GValueHandle ata_shift("ATA_SHIFT");
+static GValueHandle bta_shift("BTA_SHIFT");
+static GValueHandle yta_shift("YTA_SHIFT");
+static GValueHandle dta_shift("DTA_SHIFT");
+static GValueHandle objtac_tof_corr_afp("OBJTAC_TOF_CORR_AFP");
+static GValueHandle objtac_tof_corr_xfp("OBJTAC_TOF_CORR_XFP");
+static GValueHandle xfptac_tof_corr_afp("XFPTAC_TOF_CORR_AFP");
+static GValueHandle xfptac_tof_corr_xfp("XFPTAC_TOF_CORR_XFP");
+static GValueHandle obj_tof_corr_afp("OBJ_TOF_CORR_AFP");
+static GValueHandle obj_tof_corr_xfp("OBJ_TOF_CORR_XFP");
+static GValueHandle xfp_tof_corr_afp("XFP_TOF_CORR_AFP");
+static GValueHandle xfp_tof_corr_xfp("XFP_TOF_CORR_XFP");
+static GValueHandle obj_mtof_corr_afp("OBJ_MTOF_CORR_AFP");
+static GValueHandle obj_mtof_corr_xfp("OBJ_MTOF_CORR_XFP");
+static GValueHandle xfp_mtof_corr_afp("XFP_MTOF_CORR_AFP");
+static GValueHandle xfp_mtof_corr_xfp("XFP_MTOF_CORR_XFP");
 
 bool TS800::fGlobalReset =false;
 
-static double f_mafp_cor = GValue::Value("OBJ_MTOF_CORR_AFP");
-static double f_mxfp_cor = GValue::Value("OBJ_MTOF_CORR_XFP");
-
 /*******************************************************************************/
 /* TS800 ***********************************************************************/
 /* For the unpacking and storage of the S800 and its ancillary detectors *******/
@@ -52,16 +65,16 @@ void TS800::Copy(TObject& obj) const {
 /*******************************************************************************/
 Float_t TS800::GetAta(int i) const {
   float ata = TInverseMap::Get()->Ata(i,this);
-  if(!std::isnan(GValue::Value("ATA_SHIFT"))) {
-    ata += GValue::Value("ATA_SHIFT");
+  if(!std::isnan(ata_shift.Value())) {
+    ata += ata_shift.Value();
   }
   return ata;
 }
 
 Float_t TS800::GetAta(float xfp, float afp, float yfp, float bfp, int i) const {
   float ata = TInverseMap::Get()->Ata(i, xfp, afp, yfp, bfp);
-  if(!std::isnan(GValue::Value("ATA_SHIFT"))) {
-    ata += GValue::Value("ATA_SHIFT");
+  if(!std::isnan(ata_shift.Value())) {
+    ata += ata_shift.Value();
   }
   return ata;
 }
@@ -71,16 +84,16 @@ Float_t TS800::GetAta(float xfp, float afp, float yfp, float bfp, int i) const {
 /*******************************************************************************/
 Float_t TS800::GetBta(int i) const {
   float bta = TInverseMap::Get()->Bta(i,this);
-  if(!std::isnan(GValue::Value("BTA_SHIFT"))) {
-    bta += GValue::Value("BTA_SHIFT");
+  if(!std::isnan(bta_shift.Value())) {
+    bta += bta_shift.Value();
   }
   return bta;
 }
 
 Float_t TS800::GetBta(float xfp, float afp, float yfp, float bfp, int i) const {
   float bta = TInverseMap::Get()->Bta(i, xfp, afp, yfp, bfp);
-  if(!std::isnan(GValue::Value("BTA_SHIFT"))) {
-    bta += GValue::Value("BTA_SHIFT");
+  if(!std::isnan(bta_shift.Value())) {
+    bta += bta_shift.Value();
   }
   return bta;
 }
@@ -90,16 +103,16 @@ Float_t TS800::GetBta(float xfp, float afp, float yfp, float bfp, int i) const {
 /*******************************************************************************/
 Float_t TS800::GetYta(int i) const {
   float yta = TInverseMap::Get()->Yta(i,this);
-  if(!std::isnan(GValue::Value("YTA_SHIFT"))) {
-    yta += GValue::Value("YTA_SHIFT");
+  if(!std::isnan(yta_shift.Value())) {
+    yta += yta_shift.Value();
   }
   return yta;
 }
 
 Float_t TS800::GetYta(float xfp, float afp, float yfp, float bfp, int i) const {
   float yta = TInverseMap::Get()->Yta(i, xfp, afp, yfp, bfp);
-  if(!std::isnan(GValue::Value("YTA_SHIFT"))) {
-    yta += GValue::Value("YTA_SHIFT");
+  if(!std::isnan(yta_shift.Value())) {
+    yta += yta_shift.Value();
   }
   return yta;
 }
@@ -109,16 +122,16 @@ Float_t TS800::GetYta(float xfp, float afp, float yfp, float bfp, int i) const {
 /*******************************************************************************/
 Float_t TS800::GetDta(int i) const {
   float dta = TInverseMap::Get()->Dta(i,this);
-  if(!std::isnan(GValue::Value("DTA_SHIFT"))) {
-    dta += GValue::Value("DTA_SHIFT");
+  if(!std::isnan(dta_shift.Value())) {
+    dta += dta_shift.Value();
   }
   return dta;
 }
 
 Float_t TS800::GetDta(float xfp, float afp, float yfp, float bfp, int i) const {
   float dta = TInverseMap::Get()->Dta(i, xfp, afp, yfp, bfp);
-  if(!std::isnan(GValue::Value("DTA_SHIFT"))) {
-    dta += GValue::Value("DTA_SHIFT");
+  if(!std::isnan(dta_shift.Value())) {
+    dta += dta_shift.Value();
   }
   return dta;
 }
@@ -680,33 +693,31 @@ float TS800::GetXF_E1Raw() const {
 }
 
 float TS800::GetCorrTOF_OBJTAC() const {
-  double afp_cor = GValue::Value("OBJTAC_TOF_CORR_AFP");
-  double xfp_cor = GValue::Value("OBJTAC_TOF_CORR_XFP");
+  double afp_cor = objtac_tof_corr_afp.Value();
+  double xfp_cor = objtac_tof_corr_xfp.Value();
   return GetTofE1_TAC(afp_cor,xfp_cor);
 }
 
 float TS800::GetCorrTOF_XFPTAC() const {
-  double afp_cor = GValue::Value("XFPTAC_TOF_CORR_AFP");
-  double xfp_cor = GValue::Value("XFPTAC_TOF_CORR_XFP");
+  double afp_cor = xfptac_tof_corr_afp.Value();
+  double xfp_cor = xfptac_tof_corr_xfp.Value();
   return GetTofXFPE1_TAC(afp_cor,xfp_cor);
 }
 
 float TS800::GetCorrTOF_OBJ() const {
-  double afp_cor = GValue::Value("OBJ_TOF_CORR_AFP");
-  double xfp_cor = GValue::Value("OBJ_TOF_CORR_XFP");
+  double afp_cor = obj_tof_corr_afp.Value();
+  double xfp_cor = obj_tof_corr_xfp.Value();
   return GetTofE1_TDC(afp_cor,xfp_cor);
 }
 
 float TS800::GetCorrTOF_XFP() const {
-  double afp_cor = GValue::Value("XFP_TOF_CORR_AFP");
-  double xfp_cor = GValue::Value("XFP_TOF_CORR_XFP");
+  double afp_cor = xfp_tof_corr_afp.Value();
+  double xfp_cor = xfp_tof_corr_xfp.Value();
   return GetTofXFP_E1_TDC(afp_cor,xfp_cor);
 }
 
 float TS800::GetCorrTOF_OBJ_MESY(int i) const {
-  f_mafp_cor = GValue::Value("OBJ_MTOF_CORR_AFP");
-  f_mxfp_cor = GValue::Value("OBJ_MTOF_CORR_XFP");
-  return GetTofE1_MTDC(f_mafp_cor,f_mxfp_cor,i);
+  return GetTofE1_MTDC(obj_mtof_corr_afp.Value(),obj_mtof_corr_xfp.Value(),i);
 }
 /*******************************************************************************/
 /* End of Tof Functions ********************************************************/
@@ -801,8 +812,8 @@ float TS800::GetTofE1_MTDC(float c1,float c2,int i) const {
 /* Should use more general GetMTofCorr() ***************************************/
 /*******************************************************************************/
 double TS800::GetMTofObjE1() const {
-  double afp_cor = GValue::Value("OBJ_MTOF_CORR_AFP");
-  double xfp_cor = GValue::Value("OBJ_MTOF_CORR_XFP");
+  double afp_cor = obj_mtof_corr_afp.Value();
+  double xfp_cor = obj_mtof_corr_xfp.Value();
   static int line_displayed = 0;
   if(std::isnan(afp_cor) || std::isnan(xfp_cor)) {
     if(line_displayed < 10) {
@@ -826,8 +837,8 @@ double TS800::GetMTofObjE1(double afp_cor, double xfp_cor) const {
 /* Should use more general GetMTofCorr() ***************************************/
 /*******************************************************************************/
 double TS800::GetMTofXfpE1() const {
-  double afp_cor = GValue::Value("XFP_MTOF_CORR_AFP");
-  double xfp_cor = GValue::Value("XFP_MTOF_CORR_XFP");
+  double afp_cor = xfp_mtof_corr_afp.Value();
+  double xfp_cor = xfp_mtof_corr_xfp.Value();
   static int line_displayed = 0;
   if(std::isnan(afp_cor) || std::isnan(xfp_cor)) {
     if(line_displayed < 10) {
@@ -897,22 +908,22 @@ void TS800Track::Clear() {
 /*******************************************************************************/
 void TS800Track::CalculateTracking(const TS800 *s800, int i) {
 
-  int maxp0 = s800->GetCrdc(0).GetMaxPad();
-  int maxp1 = s800->GetCrdc(1).GetMaxPad();
-
-  xfp[0] = s800->GetCrdc(0).GetDispersiveX(maxp0);
-  xfp[1] = s800->GetCrdc(1).GetDispersiveX(maxp1);
-  yfp[0] = s800->GetCrdc(0).GetNonDispersiveY(maxp0);
-  yfp[1] = s800->GetCrdc(1).GetNonDispersiveY(maxp1);
+  // Each CRDC is reconstructed once, these read the cached values.
+  xfp[0] = s800->GetCrdc(0).GetDispersiveX();
+  xfp[1] = s800->GetCrdc(1).GetDispersiveX();
+  yfp[0] = s800->GetCrdc(0).GetNonDispersiveY();
+  yfp[1] = s800->GetCrdc(1).GetNonDispersiveY();
 
   afp = s800->GetAFP(xfp[0], xfp[1]);
   bfp = s800->GetBFP(yfp[0], yfp[1]);
 
   if(TInverseMap::Get()) {
-    ata = s800->GetAta(xfp[0], afp, yfp[0], bfp, i);
-    bta = s800->GetBta(xfp[0], afp, yfp[0], bfp, i);
-    yta = s800->GetYta(xfp[0], afp, yfp[0], bfp, i);
-    dta = s800->GetDta(xfp[0], afp, yfp[0], bfp, i);
+    // One pass over the map for all four, shifts as in GetAta() etc.
+    TInverseMap::Get()->Calculate(i, xfp[0], afp, yfp[0], bfp, ata, bta, yta, dta);
+    if(!std::isnan(ata_shift.Value())) ata += ata_shift.Value();
+    if(!std::isnan(bta_shift.Value())) bta += bta_shift.Value();
+    if(!std::isnan(yta_shift.Value())) yta += yta_shift.Value();
+    if(!std::isnan(dta_shift.Value())) dta += dta_shift.Value();
 
     scatter = s800->GetScatteringAngle(ata, bta);
     azita = s800->GetAzita(ata, bta);
@@ -2,8 +2,172 @@
 #include "TS800Hit.h"
 
 #include "chrono"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "TChannel.h"
 using namespace std::chrono;
 
+static GValueHandle ic_de_xtilt("IC_DE_XTILT");
+static GValueHandle ic_de_ytilt("IC_DE_YTILT");
+static GValueHandle ic_de_x0tilt("IC_DE_X0TILT");
+static GValueHandle crdc1_x_slope("CRDC1_X_SLOPE");
+static GValueHandle crdc1_x_offset("CRDC1_X_OFFSET");
+static GValueHandle crdc2_x_slope("CRDC2_X_SLOPE");
+static GValueHandle crdc2_x_offset("CRDC2_X_OFFSET");
+static GValueHandle crdc1_y_slope("CRDC1_Y_SLOPE");
+static GValueHandle crdc1_y_offset("CRDC1_Y_OFFSET");
+static GValueHandle crdc2_y_slope("CRDC2_Y_SLOPE");
+static GValueHandle crdc2_y_offset("CRDC2_Y_OFFSET");
+static GValueHandle target_mtof_obje1("TARGET_MTOF_OBJE1");
+static GValueHandle shift_mtof_obje1("SHIFT_MTOF_OBJE1");
+static GValueHandle target_mtof_xfpe1("TARGET_MTOF_XFPE1");
+
+namespace {
+  /// Energy calibration of every pad of one CRDC, copied from the TChannels.
+  /**
+    Rebuilt when TChannel::Generation() changes.  Pads without a TChannel
+      keep the raw value, as TChannel::GetChannel returning null did.
+   */
+  struct CrdcPadTable {
+    enum { kNumPads = 224 };
+
+    unsigned int address;
+    unsigned int generation;
+    bool has_channel[kNumPads];
+    int  pedestal[kNumPads];
+    int  first_coeff[kNumPads+1];
+    std::vector<double> coeff;
+
+    /// Same as TChannel::CalEnergy(int) for the pad.
+    double Calibrate(int pad, int value) const {
+      if(!has_channel[pad]) {
+        return value;
+      }
+      value -= pedestal[pad];
+      if(value == 0) {
+        return 0;
+      }
+      double dvalue = value + gRandom->Uniform();
+      int first = first_coeff[pad];
+      int last  = first_coeff[pad+1];
+      if(first == last) {
+        return dvalue;
+      }
+      double cal_value = 0;
+      for(int i=last-1; i>=first; i--) {
+        cal_value *= dvalue;
+        cal_value += coeff[i];
+      }
+      return cal_value;
+    }
+
+    static std::shared_ptr<const CrdcPadTable> Get(unsigned int address);
+    static std::shared_ptr<const CrdcPadTable> Build(unsigned int address, unsigned int generation);
+  };
+
+  std::shared_ptr<const CrdcPadTable> CrdcPadTable::Get(unsigned int address) {
+    // Each thread holds on to the tables it last used, two since the CRDCs
+    //   alternate, so that older tables are freed once no thread uses them.
+    thread_local std::shared_ptr<const CrdcPadTable> recent[2];
+
+    unsigned int generation = TChannel::Generation();
+    for(auto& table : recent) {
+      if(table && table->address == address && table->generation == generation) {
+        return table;
+      }
+    }
+
+    static std::mutex table_mutex;
+    static std::map<unsigned int, std::shared_ptr<const CrdcPadTable> > current;
+    std::lock_guard<std::mutex> lock(table_mutex);
+    std::shared_ptr<const CrdcPadTable>& table = current[address];
+    if(!table || table->generation != generation) {
+      table = Build(address, generation);
+    }
+    recent[1] = std::move(recent[0]);
+    recent[0] = table;
+    return table;
+  }
+
+  std::shared_ptr<const CrdcPadTable> CrdcPadTable::Build(unsigned int address, unsigned int generation) {
+    auto table = std::make_shared<CrdcPadTable>();
+    table->address = address;
+    table->generation = generation;
+    for(int pad=0; pad<kNumPads; pad++) {
+      TChannel* c = TChannel::GetChannel(address + pad);
+      table->has_channel[pad] = c;
+      table->pedestal[pad]    = c ? c->GetPedestal() : 0;
+      table->first_coeff[pad] = table->coeff.size();
+      if(c) {
+        const std::vector<double>& coeff = c->GetEnergyCoeff();
+        table->coeff.insert(table->coeff.end(), coeff.begin(), coeff.end());
+      }
+    }
+    table->first_coeff[kNumPads] = table->coeff.size();
+    return table;
+  }
+
+  /// Centre of gravity of maxpad +/- 7 pads, in pads, with the charge and RMS width.
+  double CrdcCluster(const double* pad_charge, int maxpad, double& charge, double& width) {
+    const int GRAVITY_WIDTH = 14;//determines how many pads one uses in averaging
+    const int NUM_PADS = CrdcPadTable::kNumPads;
+    int lowpad = maxpad - GRAVITY_WIDTH/2;
+    int highpad = lowpad + GRAVITY_WIDTH;
+    if (lowpad < 0){
+      lowpad = 0;
+    }
+    if (highpad >= NUM_PADS){
+      highpad = NUM_PADS-1;
+    }
+
+    double datasum = 0;
+    double weighted_sum = 0;
+    double squared_sum = 0;
+    for(int pad = lowpad; pad <= highpad; pad++) {
+      datasum      += pad_charge[pad];
+      weighted_sum += pad*pad_charge[pad];
+      squared_sum  += pad*pad*pad_charge[pad];
+    }
+
+    double mean = weighted_sum/datasum;
+    charge = datasum;
+    width  = std::sqrt(std::max(squared_sum/datasum - mean*mean, 0.0));
+    // + 0.5 so that we take the middle of the pad, not the left edge.
+    return mean + 0.5;
+  }
+
+  void CrdcXCalibration(int id, float& x_slope, float& x_offset) {
+    if(id == 0) {
+      x_slope = crdc1_x_slope.Value();
+      x_offset = crdc1_x_offset.Value();
+    } else {
+      x_slope = crdc2_x_slope.Value();
+      x_offset = crdc2_x_offset.Value();
+    }
+    if(std::isnan(x_slope))
+      x_slope = 1.0;
+    if(std::isnan(x_offset))
+      x_offset = 0.0;
+  }
+
+  void CrdcYCalibration(int id, float& y_slope, float& y_offset) {
+    y_slope = sqrt(-1);
+    y_offset = sqrt(-1);
+    if(id==0) {
+      y_slope = crdc1_y_slope.Value();
+      y_offset = crdc1_y_offset.Value();
+    } else if(id==1) {
+      y_slope = crdc2_y_slope.Value();
+      y_offset = crdc2_y_offset.Value();
+    }
+    if(std::isnan(y_slope)) y_slope = 1.0;
+    if(std::isnan(y_offset)) y_offset = 0.0;
+  }
+}
+
 /*******************************************************************************/
 /* TTrigger ********************************************************************/
 /* Stores data from ULM trigger module *****************************************/
@@ -190,9 +354,9 @@ float TIonChamber::GetSum() const {
 float TIonChamber::GetdE(double crdc_1_x, double crdc_1_y){
   float sum = GetAve();
 
-  float xtilt  = GValue::Value("IC_DE_XTILT");
-  float ytilt  = GValue::Value("IC_DE_YTILT");
-  float x0tilt = GValue::Value("IC_DE_X0TILT");
+  float xtilt  = ic_de_xtilt.Value();
+  float ytilt  = ic_de_ytilt.Value();
+  float x0tilt = ic_de_x0tilt.Value();
 
   if (isnan(xtilt) || isnan(ytilt) || isnan(x0tilt)){
     std::cout << "Define  IC_DE_XTILT, IC_DE_YTILT, and IC_DE_X0TILT before using TIonChamber::GetdE()!\n";
@@ -246,48 +410,8 @@ TCrdc::~TCrdc() {
 /* Calibrates data if .cal file is provided ************************************/
 /*******************************************************************************/
 int TCrdc::GetMaxPad() const {
-//  auto start = high_resolution_clock::now();
-  if(!data.size()) return -1.0;
-  int maxp = 0;
-  float maxd = 0;
-  for(unsigned int i = 0; i < data.size(); i++){
-    if(!IsGoodSample(i)) {
-      continue;
-    }
-    TChannel *c = TChannel::GetChannel(Address(i));
-    double cal_data;
-    if(c){
-      cal_data = c->CalEnergy(data.at(i));
-    } else{
-      cal_data = (double)data.at(i);
-    }
-    if(cal_data > maxd) {
-      maxp = channel.at(i);
-      maxd = cal_data;
-    }
-  }
-//  auto stop = high_resolution_clock::now();
-//  auto duration = duration_cast<microseconds>(stop - start);
-//  std::cout << "Time taken by MaxPad: " << duration.count() << " microseconds" << std::endl;
-  return maxp;
-}
-
-/*******************************************************************************/
-/* Fast Function Find the pad number with the largest measured charge **********/
-/* WIP - Do not use ************************************************************/
-/*******************************************************************************/
-int TCrdc::GetMaxPadFast() const {
-//  auto start = high_resolution_clock::now();
-  //WIP
-  //Attempting to speed up function
-  if(!data.size()) return -1.0;
-  int dis = std::distance(data.begin(), std::max_element(data.begin(), data.end()));
-  int maxp = channel.at(dis);
-
-//  auto stop = high_resolution_clock::now();
-//  auto duration = duration_cast<microseconds>(stop - start);
-//  std::cout << "Time taken by Fast function: " << duration.count() << " microseconds" << std::endl;
-  return maxp;
+  Reconstruct();
+  return fMaxPad;
 }
 
 /*******************************************************************************/
@@ -295,25 +419,25 @@ int TCrdc::GetMaxPadFast() const {
 /* Calibrates data if .cal file is provided ************************************/
 /*******************************************************************************/
 int TCrdc::GetMaxPadSum() const{
-  if(!data.size()) return -1.0;
-  float maxd = 0;
-  for(unsigned int i = 0; i < data.size(); i++){
-    if(!IsGoodSample(i)) {
-      continue;
-    }
-    TChannel *c = TChannel::GetChannel(Address(i));
-    double cal_data;
-    if(c){
-      cal_data = c->CalEnergy(data.at(i));
-    } else{
-      cal_data = (double)data.at(i);
-    }
-    if(cal_data > maxd) {
-      maxd = cal_data;
-    }
-  }
-  return maxd;
+  Reconstruct();
+  return fMaxPadCharge;
 }
+
+float TCrdc::GetPadCentroid() const {
+  Reconstruct();
+  return fPadCentroid;
+}
+
+float TCrdc::GetClusterWidth() const {
+  Reconstruct();
+  return fClusterWidth;
+}
+
+float TCrdc::GetClusterCharge() const {
+  Reconstruct();
+  return fClusterCharge;
+}
+
 /*******************************************************************************/
 /* Not Really sure the purpose of this function ********************************/
 /*******************************************************************************/
@@ -335,6 +459,7 @@ void TCrdc::Copy(TObject &obj) const {
   c.data     = data;
   c.anode    = anode;
   c.time     = time;
+  c.fReconstructed = false;
 }
 
 /*******************************************************************************/
@@ -348,8 +473,7 @@ void TCrdc::Clear(Option_t *opt) {
   channel.clear();
   sample.clear();
   data.clear();
-  has_cached_dispersive_x = false;
-  cached_dispersive_x = std::sqrt(-1);
+  fReconstructed = false;
 }
 
 
@@ -358,164 +482,125 @@ void TCrdc::Clear(Option_t *opt) {
 /*******************************************************************************/
 bool TCrdc::IsGoodSample(int i) const {
   if (i == 0 && data.size()>1) {
-    return channel.at(i) == channel.at(i+1);
+    return channel[i] == channel[i+1];
   } else if(i == (int)data.size()-1 && data.size()>2) {
-    return channel.at(i) == channel.at(i-1);
+    return channel[i] == channel[i-1];
   } else if(data.size()>2) {
-    return (channel.at(i) == channel.at(i-1) ||
-	    (channel.at(i) == channel.at(i+1)));
+    return (channel[i] == channel[i-1] ||
+	    (channel[i] == channel[i+1]));
   }
   return false;
 }
 
 /*******************************************************************************/
-/* Calculate X position of CRDC - Uses the Mean of GetMaxPad +/- 7 strips ******/
+/* Calibrates every good sample once, summing the charge on each pad ***********/
+/* Returns the pad of the largest single sample, as GetMaxPad always did *******/
 /*******************************************************************************/
-float TCrdc::GetDispersiveX() const{
-  int maxpad = GetMaxPad();
-
-  if (maxpad ==-1){
-    has_cached_dispersive_x = true;
-    return sqrt(-1);
-  }
-  float x_slope = sqrt(-1);
-  float x_offset = sqrt(-1);
-  if(fId == 0) {
-    x_slope = GValue::Value("CRDC1_X_SLOPE");
-    x_offset = GValue::Value("CRDC1_X_OFFSET");
-  } else {
-    x_slope = GValue::Value("CRDC2_X_SLOPE");
-    x_offset = GValue::Value("CRDC2_X_OFFSET");
-  }
-  if(std::isnan(x_slope))
-    x_slope = 1.0;
-  if(std::isnan(x_offset))
-    x_offset = 0.0;
-
-  const int GRAVITY_WIDTH = 14;//determines how many pads one uses in averaging
-  const int NUM_PADS = 224;
-  int lowpad = maxpad - GRAVITY_WIDTH/2;
-  int highpad = lowpad + GRAVITY_WIDTH;
-  if (lowpad < 0){
-    lowpad = 0;
-  }
-  if (highpad >= NUM_PADS){
-    highpad = NUM_PADS-1;
-  }
+int TCrdc::CalibratePads(double* pad_charge, double& max_charge) const {
+  std::shared_ptr<const CrdcPadTable> table = CrdcPadTable::Get(TDetectorHit::Address());
+  std::fill(pad_charge, pad_charge + CrdcPadTable::kNumPads, 0.0);
 
-  double datasum = 0;
-  double weighted_sum = 0;
-  for(int i=0;i<Size();i++) {
-    if((channel.at(i) < lowpad) || (channel.at(i)>highpad) || !IsGoodSample(i)) {
+  int maxp = 0;
+  max_charge = 0;
+  for(unsigned int i = 0; i < data.size(); i++){
+    int pad = channel[i];
+    if(pad < 0 || pad >= CrdcPadTable::kNumPads || !IsGoodSample(i)) {
       continue;
     }
-
-    TChannel *c = TChannel::GetChannel(Address(i));
-    double cal_data;
-    if (c){
-      cal_data = c->CalEnergy(GetData(i));
-    } else{
-      cal_data = (double)GetData(i);
+    double cal_data = table->Calibrate(pad, data[i]);
+    pad_charge[pad] += cal_data;
+    if(cal_data > max_charge) {
+      maxp = pad;
+      max_charge = cal_data;
     }
-    datasum += cal_data;
-    weighted_sum += channel.at(i)*cal_data;
   }
-
-  // + 0.5 so that we take the middle of the pad, not the left edge.
-  double mean_chan = weighted_sum/datasum + 0.5;
-  double output = (mean_chan*x_slope+x_offset);
-
-  has_cached_dispersive_x = true;
-  cached_dispersive_x = output;
-  return output;
+  return maxp;
 }
 
 /*******************************************************************************/
-/* Calculate Y position of CRDC ************************************************/
+/* Runs once per event, everything below reads the cached values ***************/
 /*******************************************************************************/
-float TCrdc::GetNonDispersiveY() {
-  if (GetMaxPad() == -1){
-    return sqrt(-1);
+void TCrdc::Reconstruct() const {
+  if(fReconstructed &&
+     fChannelGeneration == TChannel::Generation() &&
+     fValueGeneration == GValue::Generation()) {
+    return;
   }
+  fReconstructed     = true;
+  fChannelGeneration = TChannel::Generation();
+  fValueGeneration   = GValue::Generation();
 
-  float y_slope = sqrt(-1);
-  float y_offset = sqrt(-1);
-  if(fId==0) {
-    y_slope = GValue::Value("CRDC1_Y_SLOPE");
-    y_offset = GValue::Value("CRDC1_Y_OFFSET");
-  } else if(fId==1) {
-    y_slope = GValue::Value("CRDC2_Y_SLOPE");
-    y_offset = GValue::Value("CRDC2_Y_OFFSET");
+  fMaxPad         = -1;
+  fMaxPadCharge   = -1;
+  fPadCentroid    = std::sqrt(-1);
+  fClusterWidth   = std::sqrt(-1);
+  fClusterCharge  = std::sqrt(-1);
+  fDispersiveX    = std::sqrt(-1);
+  fNonDispersiveY = std::sqrt(-1);
+  if(!data.size()) {
+    return;
   }
 
-  if(std::isnan(y_slope)) y_slope = 1.0;
-  if(std::isnan(y_offset)) y_offset = 0.0;
-  float tmp = ((float)time) * y_slope + y_offset;
-  return tmp;
+  double pad_charge[CrdcPadTable::kNumPads];
+  double max_charge;
+  fMaxPad = CalibratePads(pad_charge, max_charge);
+  fMaxPadCharge = max_charge;
+
+  double charge, width;
+  double centroid = CrdcCluster(pad_charge, fMaxPad, charge, width);
+  fPadCentroid   = centroid;
+  fClusterWidth  = width;
+  fClusterCharge = charge;
+
+  float x_slope, x_offset;
+  CrdcXCalibration(fId, x_slope, x_offset);
+  fDispersiveX = centroid*x_slope + x_offset;
+
+  float y_slope, y_offset;
+  CrdcYCalibration(fId, y_slope, y_offset);
+  fNonDispersiveY = ((float)time)*y_slope + y_offset;
 }
 
 /*******************************************************************************/
 /* Calculate X position of CRDC - Uses the Mean of GetMaxPad +/- 7 strips ******/
-/* Provides maxpad as argument to reduce function calls ************************/
+/*******************************************************************************/
+float TCrdc::GetDispersiveX() const{
+  Reconstruct();
+  return fDispersiveX;
+}
+
+/*******************************************************************************/
+/* Calculate Y position of CRDC ************************************************/
+/*******************************************************************************/
+float TCrdc::GetNonDispersiveY() {
+  Reconstruct();
+  return fNonDispersiveY;
+}
+
+/*******************************************************************************/
+/* Calculate X position of CRDC - Uses the Mean of maxpad +/- 7 strips *********/
+/* Only recalculates if maxpad is not the one found by Reconstruct() ***********/
 /*******************************************************************************/
 float TCrdc::GetDispersiveX(int maxpad) const{
   if (maxpad ==-1){
-    has_cached_dispersive_x = true;
     return sqrt(-1);
   }
-  float x_slope = sqrt(-1);
-  float x_offset = sqrt(-1);
-  if(fId == 0) {
-    x_slope = GValue::Value("CRDC1_X_SLOPE");
-    x_offset = GValue::Value("CRDC1_X_OFFSET");
-  } else {
-    x_slope = GValue::Value("CRDC2_X_SLOPE");
-    x_offset = GValue::Value("CRDC2_X_OFFSET");
-  }
-  if(std::isnan(x_slope))
-    x_slope = 1.0;
-  if(std::isnan(x_offset))
-    x_offset = 0.0;
-
-  const int GRAVITY_WIDTH = 14;//determines how many pads one uses in averaging
-  const int NUM_PADS = 224;
-  int lowpad = maxpad - GRAVITY_WIDTH/2;
-  int highpad = lowpad + GRAVITY_WIDTH;
-  if (lowpad < 0){
-    lowpad = 0;
-  }
-  if (highpad >= NUM_PADS){
-    highpad = NUM_PADS-1;
+  Reconstruct();
+  if(maxpad == fMaxPad) {
+    return fDispersiveX;
   }
 
-  double datasum = 0;
-  double weighted_sum = 0;
-  for(int i = 0; i < Size(); i++) {
-    if((channel.at(i) < lowpad) || (channel.at(i)>highpad) || !IsGoodSample(i)) {
-      continue;
-    }
+  double pad_charge[CrdcPadTable::kNumPads];
+  double max_charge;
+  CalibratePads(pad_charge, max_charge);
+  double charge, width;
+  double centroid = CrdcCluster(pad_charge, maxpad, charge, width);
 
-    TChannel *c = TChannel::GetChannel(Address(i));
-    double cal_data;
-    if (c){
-      cal_data = c->CalEnergy(GetData(i));
-    } else{
-      cal_data = (double)GetData(i);
-    }
-    datasum += cal_data;
-    weighted_sum += channel.at(i)*cal_data;
-  }
-
-  // + 0.5 so that we take the middle of the pad, not the left edge.
-  double mean_chan = weighted_sum/datasum + 0.5;
-  double output = (mean_chan*x_slope+x_offset);
-
-  has_cached_dispersive_x = true;
-  cached_dispersive_x = output;
-  return output;
+  float x_slope, x_offset;
+  CrdcXCalibration(fId, x_slope, x_offset);
+  return centroid*x_slope + x_offset;
 }
 
-
 /*******************************************************************************/
 /* Calculate Y position of CRDC ************************************************/
 /* Provides maxpad as argument to reduce function calls ************************/
@@ -524,21 +609,9 @@ float TCrdc::GetNonDispersiveY(int maxpad) {
   if (maxpad ==-1){
     return sqrt(-1);
   }
-
-  float y_slope = sqrt(-1);
-  float y_offset = sqrt(-1);
-  if(fId==0) {
-    y_slope = GValue::Value("CRDC1_Y_SLOPE");
-    y_offset = GValue::Value("CRDC1_Y_OFFSET");
-  } else if(fId==1) {
-    y_slope = GValue::Value("CRDC2_Y_SLOPE");
-    y_offset = GValue::Value("CRDC2_Y_OFFSET");
-  }
-
-  if(std::isnan(y_slope)) y_slope = 1.0;
-  if(std::isnan(y_offset)) y_offset = 0.0;
-  float tmp = ((float)time)*y_slope+y_offset;
-  return tmp;
+  float y_slope, y_offset;
+  CrdcYCalibration(fId, y_slope, y_offset);
+  return ((float)time)*y_slope + y_offset;
 }
 
 /*******************************************************************************/
@@ -884,7 +957,7 @@ std::vector<unsigned short> TMTof::GetMTofVectorFromString(std::string vecname)
 /* Corrected ToF between Obj scintillator **************************************/
 /*******************************************************************************/
 double TMTof::GetCorrelatedObjE1() const {
-  double target = GValue::Value("TARGET_MTOF_OBJE1");
+  double target = target_mtof_obje1.Value();
   if (std::isnan(target)){
     std::cout << "TARGET_MTOF_OBJE1 not defined! Use fObj.at(0) if you want first.\n";
     fCorrelatedOBJE1 = sqrt(-1);
@@ -893,7 +966,7 @@ double TMTof::GetCorrelatedObjE1() const {
 
   //shift allows "shifting" of TOF to line up different runs. Necessary when,
   //e.g., the voltage on a scintillator changes during an experiment
-  double shift = GValue::Value("SHIFT_MTOF_OBJE1");
+  double shift = shift_mtof_obje1.Value();
 
   if(fObj.size() && fE1Up.size()){
     fCorrelatedOBJE1 = std::numeric_limits<double>::max();
@@ -917,7 +990,7 @@ double TMTof::GetCorrelatedObjE1() const {
 /* Corrected ToF between Obj scintillator **************************************/
 /*******************************************************************************/
 double TMTof::GetCorrelatedXfpE1() const{
-  double target = GValue::Value("TARGET_MTOF_XFPE1");
+  double target = target_mtof_xfpe1.Value();
   if (std::isnan(target)){
     std::cout << "TARGET_MTOF_XFPE1 not defined! Use fXfp.at(0) if you want first.\n";
     fCorrelatedXFPE1 = sqrt(-1);
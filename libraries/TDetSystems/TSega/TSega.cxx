@@ -1,23 +1,117 @@
 #include "TSega.h"
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <mutex>
 
 #include "DDASDataFormat.h"
 #include "TNSCLEvent.h"
 #include "TChannel.h"
 #include "TRawEvent.h" // added Mark
+#include "TGRUTOptions.h"
 
 std::map<int,TSega::Transformation> TSega::detector_positions;
 
+namespace {
+  /// Detector and segment number of a DDAS channel, as given in the cal file.
+  struct ChannelInfo {
+    int detnum;
+    int segnum;
+    int slot; // Dense index over detnum, -1 if the channel is not in the cal file.
+  };
+
+  /// The ChannelInfo of every DDAS channel, built from the TChannels of one generation.
+  struct ChannelMap {
+    unsigned int generation;
+    int slots;
+    /// Indexed by (crate<<8) + (slot<<4) + channel.
+    std::vector<ChannelInfo> channels;
+  };
+
+  /// Never changed once published, so events being built keep the one they started with.
+  std::shared_ptr<const ChannelMap> channel_map;
+  std::mutex channel_map_mutex;
+
+  /// The ChannelMap of the current TChannels, built again only once they have changed.
+  std::shared_ptr<const ChannelMap> LoadChannelMap() {
+    unsigned int generation = TChannel::Generation();
+    std::shared_ptr<const ChannelMap> current = std::atomic_load(&channel_map);
+    if(current && current->generation == generation) {
+      return current;
+    }
+
+    std::lock_guard<std::mutex> lock(channel_map_mutex);
+    current = std::atomic_load(&channel_map);
+    if(current && current->generation == generation) {
+      return current;
+    }
+
+    std::shared_ptr<ChannelMap> next = std::make_shared<ChannelMap>();
+    next->generation = generation;
+    next->channels.assign(4096, ChannelInfo{-1, -1, -1});
+    std::map<int,int> slots;
+    for(auto& item : TChannel::fChannelMap) {
+      unsigned int address = item.first;
+      TChannel* chan = item.second;
+      if(!chan || (address>>24) != 1 || (address&0x00f0f0f0)) {
+        continue;
+      }
+      int detnum = chan->GetArrayPosition();
+      if(!slots.count(detnum)) {
+        int next_slot = slots.size();
+        slots[detnum] = next_slot;
+      }
+      ChannelInfo& info = next->channels[((address&0x000f0000)>>8) + ((address&0x00000f00)>>4) + (address&0x0000000f)];
+      info.detnum = detnum;
+      info.segnum = chan->GetSegment();
+      info.slot = slots[detnum];
+    }
+    next->slots = slots.size();
+    std::atomic_store(&channel_map, std::shared_ptr<const ChannelMap>(next));
+    return next;
+  }
+
+  const size_t max_pooled_traces = 4096;
+  std::mutex trace_pool_mutex;
+  std::vector<std::vector<unsigned short> > trace_pool;
+
+  std::vector<unsigned short> AcquireTraceBuffer() {
+    std::lock_guard<std::mutex> lock(trace_pool_mutex);
+    if(trace_pool.empty()) {
+      return std::vector<unsigned short>();
+    }
+    std::vector<unsigned short> output = std::move(trace_pool.back());
+    trace_pool.pop_back();
+    return output;
+  }
+
+  template<typename HitType>
+  void ReleaseTraceBuffer(HitType& hit) {
+    std::vector<unsigned short> trace;
+    hit.ReleaseTrace(trace);
+    if(!trace.capacity()) {
+      return;
+    }
+    trace.clear();
+    std::lock_guard<std::mutex> lock(trace_pool_mutex);
+    if(trace_pool.size() < max_pooled_traces) {
+      trace_pool.push_back(std::move(trace));
+    }
+  }
+}
+
 /*******************************************************************************/
 /* TSega ***********************************************************************/
 /* Main class for unpacking SeGA in DDAS electronics ***************************/
 /*******************************************************************************/
 TSega::TSega(){ }
 
-TSega::~TSega(){ }
+TSega::~TSega(){
+  RecycleTraces();
+}
 
 /*******************************************************************************/
 /* Copies hit ******************************************************************/
@@ -33,6 +127,7 @@ void TSega::Copy(TObject& obj) const {
 /*******************************************************************************/
 void TSega::Clear(Option_t* opt){
   TDetector::Clear(opt);
+  RecycleTraces();
   sega_hits.clear();
 }
 
@@ -51,6 +146,17 @@ TDetectorHit& TSega::GetHit(int i){
 /* Unpacks raw DDAS data and builds TSega events *******************************/
 /*******************************************************************************/
 int TSega::BuildHits(std::vector<TRawEvent>& raw_data) {
+  std::shared_ptr<const ChannelMap> chan_map = LoadChannelMap();
+  bool store_traces = TGRUTOptions::Get()->ExtractWaves();
+
+  // Per-event slot table, hits belonging to each detector are chained in the order they were made.
+  static thread_local std::vector<int> first_hit;
+  static thread_local std::vector<int> last_hit;
+  static thread_local std::vector<int> next_hit;
+  first_hit.assign(chan_map->slots, -1);
+  last_hit.assign(chan_map->slots, -1);
+  next_hit.assign(sega_hits.size(), -1);
+
   long int smallest_timestamp = 0x7fffffffffffffff;
   for(auto& event : raw_data){
     //Get raw data and unpacks it as a DDAS Event (DDASDataFormat.h)
@@ -58,9 +164,9 @@ int TSega::BuildHits(std::vector<TRawEvent>& raw_data) {
     TDDASEvent<DDASHeader> ddas(buf);
     unsigned int address = ( (1<<24) + (ddas.GetCrateID()<<16) + (ddas.GetSlotID()<<8) + ddas.GetChannelID() );
     //If channel not found in calibration file (*.cal) file skip and do nothing
-    TChannel* chan = TChannel::GetChannel(address);
+    const ChannelInfo& chan = chan_map->channels[(ddas.GetCrateID()<<8) + (ddas.GetSlotID()<<4) + ddas.GetChannelID()];
     static int lines_displayed = 0;
-    if(!chan){
+    if(chan.slot < 0){
       if(lines_displayed < 10 && ddas.GetCrateID() !=3) {
         std::cout << "Unknown SeGA (crate, slot, channel): (" << ddas.GetCrateID() << ", " << ddas.GetSlotID() << ", " << ddas.GetChannelID() << ")" << std::endl;
       }
@@ -68,29 +174,35 @@ int TSega::BuildHits(std::vector<TRawEvent>& raw_data) {
       continue;
     }
     //Get detector information from channels.cal file
-    int detnum = chan->GetArrayPosition();
-    int segnum = chan->GetSegment();
+    int segnum = chan.segnum;
     // Get a hit, make it if it does not exist
     TSegaHit* hit = NULL;
-    for(auto& ihit : sega_hits){
-      if(ihit.GetDetnum() == detnum) {
-	if(segnum == 0) {
-	  if(!ihit.HasCore()){ //If there is no core event assign to the ihit
-              hit = &ihit;
-	      break;
-          }
-        } else {
-	  int tdiff = static_cast<int>(ihit.Timestamp()-ddas.GetTimestamp());
-	  if(tdiff < 2000 && tdiff > -2000) { //Segments should be within 2us of a core
-            hit = &ihit;
-      	    break;
-	  } //else std::cout << "BadSegmentMatch " << detnum << "\t" << tdiff << std::endl;
+    for(int index = first_hit[chan.slot]; index != -1; index = next_hit[index]){
+      TSegaHit& ihit = sega_hits[index];
+      if(segnum == 0) {
+        if(!ihit.HasCore()){ //If there is no core event assign to the ihit
+          hit = &ihit;
+          break;
         }
+      } else {
+        int tdiff = static_cast<int>(ihit.Timestamp()-ddas.GetTimestamp());
+        if(tdiff < 2000 && tdiff > -2000) { //Segments should be within 2us of a core
+          hit = &ihit;
+          break;
+        } //else std::cout << "BadSegmentMatch " << chan.detnum << "\t" << tdiff << std::endl;
       }
     }
     //Make a new hit
     if(hit == NULL){
+      int index = sega_hits.size();
       sega_hits.emplace_back();
+      next_hit.push_back(-1);
+      if(first_hit[chan.slot] == -1) {
+        first_hit[chan.slot] = index;
+      } else {
+        next_hit[last_hit[chan.slot]] = index;
+      }
+      last_hit[chan.slot] = index;
       hit = &sega_hits.back();
       fSize++;
     }
@@ -104,7 +216,9 @@ int TSega::BuildHits(std::vector<TRawEvent>& raw_data) {
       hit->SetCFDFail(ddas.GetCFDFailBit());
       if(hit->Timestamp()<smallest_timestamp) { smallest_timestamp = hit->Timestamp(); }
       hit->SetCharge(ddas.GetEnergy());
-      hit->SetTrace(ddas.GetTraceLength(), ddas.trace);
+      if(store_traces) {
+        hit->SetTrace(ddas.GetTraceView());
+      }
       //For checking Trapezoidal filter output in DDAS, unlikely to be useful for mosr people
       if(ddas.HasEnergySum()) {
         for(int i = 0; i < 4; i++){
@@ -123,7 +237,9 @@ int TSega::BuildHits(std::vector<TRawEvent>& raw_data) {
       seg.SetTimestamp(ddas.GetTimestamp());  // Timestamp in ns
       seg.SetTime(ddas.GetTime()); // Timestamp + CFD
       seg.SetCFDTime(ddas.GetCFDTime()); // CFD ONLY
-      seg.SetTrace(ddas.GetTraceLength(), ddas.trace);
+      if(store_traces) {
+        seg.SetTrace(ddas.GetTraceView());
+      }
     }
   }
   //set the TSeGA  time....
@@ -132,6 +248,33 @@ int TSega::BuildHits(std::vector<TRawEvent>& raw_data) {
   return Size();
 }
 
+/*******************************************************************************/
+/* Traces are kept as views of the raw buffer until written out ****************/
+/* Copies reuse buffers handed back when earlier events were deleted ***********/
+/*******************************************************************************/
+void TSega::MaterializeTraces() {
+  for(auto& hit : sega_hits) {
+    if(!hit.GetTraceView().empty()) {
+      hit.MaterializeTrace(AcquireTraceBuffer());
+    }
+    for(unsigned int i=0; i<hit.GetNumSegments(); i++) {
+      TSegaSegmentHit& seg = hit.GetSegment(i);
+      if(!seg.GetTraceView().empty()) {
+        seg.MaterializeTrace(AcquireTraceBuffer());
+      }
+    }
+  }
+}
+
+void TSega::RecycleTraces() {
+  for(auto& hit : sega_hits) {
+    ReleaseTraceBuffer(hit);
+    for(unsigned int i=0; i<hit.GetNumSegments(); i++) {
+      ReleaseTraceBuffer(hit.GetSegment(i));
+    }
+  }
+}
+
 /*******************************************************************************/
 /* Gets interaction position based on detector and segment number **************/
 /*******************************************************************************/
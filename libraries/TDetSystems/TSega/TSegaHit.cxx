@@ -9,6 +9,10 @@
 #include "GValue.h"
 #include "TSega.h"
 
+static GValueHandle sega_x_offset("Sega_X_offset");
+static GValueHandle sega_y_offset("Sega_Y_offset");
+static GValueHandle sega_z_offset("Sega_Z_offset");
+
 
 TSegaHit::TSegaHit() {
   Clear();
@@ -21,6 +25,7 @@ void TSegaHit::Copy(TObject& obj) const{
   TDetectorHit::Copy(obj);
   TSegaHit& sega = (TSegaHit&)obj;
   sega.fTrace = fTrace;
+  sega.fTraceView = fTraceView;
 }
 
 /*******************************************************************************/
@@ -29,6 +34,7 @@ void TSegaHit::Copy(TObject& obj) const{
 void TSegaHit::Clear(Option_t *opt) {
   TDetectorHit::Clear(opt);
   fTrace.clear();
+  fTraceView.Clear();
 }
 
 /*******************************************************************************/
@@ -42,17 +48,26 @@ void TSegaHit::Print(Option_t *opt) const {
 /* Sets trace information if present in data ***********************************/
 /*******************************************************************************/
 void TSegaHit::SetTrace(unsigned int trace_length, const unsigned short* trace) {
+  fTraceView.Clear();
   if(!trace){
     fTrace.clear();
     return;
   }
 
-  fTrace.clear();
-  return;
-  fTrace.reserve(trace_length);
-  for(unsigned int i=0; i<trace_length; i++){
-    fTrace.push_back(trace[i]);
+  // Reuses the existing capacity, TSega hands in recycled buffers.
+  fTrace.assign(trace, trace + trace_length);
+}
+
+/*******************************************************************************/
+/* Copies a trace view into the hit, buffer is storage to reuse ****************/
+/*******************************************************************************/
+void TSegaHit::MaterializeTrace(std::vector<unsigned short> buffer) {
+  if(fTraceView.empty()){
+    return;
   }
+  fTraceView.CopyTo(buffer);
+  fTrace.swap(buffer);
+  fTraceView.Clear();
 }
 
 /*******************************************************************************/
@@ -110,6 +125,7 @@ TSegaSegmentHit& TSegaHit::MakeSegmentByAddress(unsigned int address){
 /*******************************************************************************/
 std::vector<unsigned short>* TSegaHit::GetTrace(int segnum) {
   if(segnum == 0){
+    MaterializeTrace();
     return &fTrace;
   }
   for(auto& seg : fSegments) {
@@ -142,8 +158,8 @@ TVector3 TSegaHit::GetPosition(bool apply_array_offset, TVector3 array_offset) c
   TVector3 array_pos = TSega::GetSegmentPosition(GetDetnum(), GetMainSegnum());
   if(apply_array_offset){
     if(std::isnan(array_offset.X()) && std::isnan(array_offset.Y()) && std::isnan(array_offset.Z())) {
-      if(!std::isnan(GValue::Value("Sega_X_offset")) && !std::isnan(GValue::Value("Sega_Y_offset")) && !std::isnan(GValue::Value("Sega_Z_offset"))) {
-        array_offset = TVector3(GValue::Value("Sega_X_offset"), GValue::Value("Sega_Y_offset"), GValue::Value("Sega_Z_offset"));
+      if(!std::isnan(sega_x_offset.Value()) && !std::isnan(sega_y_offset.Value()) && !std::isnan(sega_z_offset.Value())) {
+        array_offset = TVector3(sega_x_offset.Value(), sega_y_offset.Value(), sega_z_offset.Value());
       } else array_offset = TVector3(0,0,0);
     }
     array_pos += array_offset;
@@ -181,14 +197,16 @@ double TSegaHit::GetDoppler(double beta,const TVector3& particle_vec, const TVec
 /* Simple energy evaluation from traces ****************************************/
 /*******************************************************************************/
 double TSegaHit::GetTraceHeight() const {
-  if(fTrace.size() < 20){
+  unsigned int length = GetTraceLength();
+  if(length < 20){
     return std::sqrt(-1);
   }
+  const unsigned short* trace = fTraceView.empty() ? fTrace.data() : fTraceView.data();
   double low = 0;
   double high = 0;
   for(unsigned int i=0; i<10; i++){
-    low += fTrace[i];
-    high += fTrace[fTrace.size()-i-1];
+    low += trace[i];
+    high += trace[length-i-1];
   }
   return (high-low)/10;
 }
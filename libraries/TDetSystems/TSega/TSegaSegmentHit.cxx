@@ -12,6 +12,7 @@ void TSegaSegmentHit::Copy(TObject& obj) const{
 
   TSegaSegmentHit& sega = (TSegaSegmentHit&)obj;
   sega.fTrace = fTrace;
+  sega.fTraceView = fTraceView;
 }
 
 /*******************************************************************************/
@@ -20,6 +21,7 @@ void TSegaSegmentHit::Copy(TObject& obj) const{
 void TSegaSegmentHit::Clear(Option_t *opt) {
   TDetectorHit::Clear(opt);
   fTrace.clear();
+  fTraceView.Clear();
 }
 
 /*******************************************************************************/
@@ -35,17 +37,26 @@ void TSegaSegmentHit::Print(Option_t *opt) const {
 /* Sets trace information if present in data ***********************************/
 /*******************************************************************************/
 void TSegaSegmentHit::SetTrace(unsigned int trace_length, const unsigned short* trace) {
+  fTraceView.Clear();
   if(!trace){
     fTrace.clear();
     return;
   }
 
-  fTrace.clear();
-  return;
-  fTrace.reserve(trace_length);
-  for(unsigned int i=0; i<trace_length; i++){
-    fTrace.push_back(trace[i]);
+  // Reuses the existing capacity, TSega hands in recycled buffers.
+  fTrace.assign(trace, trace + trace_length);
+}
+
+/*******************************************************************************/
+/* Copies a trace view into the hit, buffer is storage to reuse ****************/
+/*******************************************************************************/
+void TSegaSegmentHit::MaterializeTrace(std::vector<unsigned short> buffer) {
+  if(fTraceView.empty()){
+    return;
   }
+  fTraceView.CopyTo(buffer);
+  fTrace.swap(buffer);
+  fTraceView.Clear();
 }
 
 /*******************************************************************************/
@@ -6,14 +6,18 @@
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
+#include <TROOT.h>
 #include <TH1.h>
 #include <TSpectrum.h>
 #include <TLinearFitter.h>
 #include <TGraphErrors.h>
 #include <TRandom.h>
+#include <TMath.h>
 
 #include <TChannel.h>
 #include <TNucleus.h>
@@ -24,12 +28,43 @@
 #include <GCanvas.h>
 #include <GPeak.h>
 #include <GGaus.h>
+#include <GFitPool.h>
 #include <Globals.h>
 
 #include "combinations.h"
 
 ClassImp(TCalibrator)
 
+namespace {
+  // Channels with fewer counts than this are not calibrated by CalibrateChannels.
+  const double kMinChannelCounts = 100;
+
+  // Positions of the peaks TSpectrum finds in data, raising the threshold
+  //   until there are no more than 10.
+  std::vector<double> SearchPeaks(TSpectrum& spectrum,TH1 *data,double sigma,double threshold,Option_t *opt) {
+    spectrum.Search(data,sigma,opt,threshold);
+    while(spectrum.GetNPeaks()>10) {
+      spectrum.Clear();
+      threshold+=.01;
+      spectrum.Search(data,sigma,opt,threshold);
+    }
+    std::vector<double> positions;
+    for(int x=0;x<spectrum.GetNPeaks();x++) {
+      positions.push_back(spectrum.GetPositionX()[x]);
+    }
+    return positions;
+  }
+
+  // Window fit about a peak found by TSpectrum, wider on the low side for the tail.
+  void PeakWindow(double peak,double& low,double& high) {
+    double range = 0.02 * peak;
+    if(range < 8.)
+      range = 8.0;
+    low  = peak-range;
+    high = peak+range/2.;
+  }
+}
+
 TCalibrator::TCalibrator() {
   linfit=0;
   efffit=0;
@@ -209,13 +244,19 @@ void TCalibrator::Draw(Option_t *opt) {
   fit_graph.Draw("AP");
 }
 
-void TCalibrator::Fit(int order,bool zerozero) {
+void TCalibrator::Fit(int order,bool zerozero,Option_t *opt) {
+  TString option(opt);
+  bool quiet = option.Contains("Q");
 
   //if((graph_of_everything.GetN()<1) &&
   //    (all_fits.size()>0))
   MakeCalibrationGraph(zerozero);
   if(fit_graph.GetN()<1)
     return;
+  if(linfit) {
+    delete linfit;
+    linfit = 0;
+  }
   if(order==1) {
     linfit = new TF1("linfit",GRootFunctions::LinFit,0,1,2);
     linfit->SetParameter(0,0.0);
@@ -231,9 +272,13 @@ void TCalibrator::Fit(int order,bool zerozero) {
     linfit->SetParName(1,"B");
     linfit->SetParName(2,"C");
   }
-  fit_graph.Fit(linfit);
-  fit_graph.Print();
-  Print();
+  if(!linfit)
+    return;
+  fit_graph.Fit(linfit,quiet ? "Q" : "");
+  if(!quiet) {
+    fit_graph.Print();
+    Print();
+  }
 
 }
 
@@ -323,57 +368,30 @@ int TCalibrator::AddData(TH1 *data,TNucleus *source, double sigma,double thresho
      TH1 *bg = spectrum.Background(data,20,"Compton");
      data->Add(bg,-1);
   }
-  spectrum.Search(data,sigma,"",threshold);
-  while(spectrum.GetNPeaks()>10) {
-    spectrum.Clear();
-    threshold+=.01;
-    spectrum.Search(data,sigma,"",threshold);
-  }
-  //std::vector<double> data_channels;
-  std::vector<double> peak_positions;
-  //std::map<double,double> peak_area;;
-  //std::vector<double> data;
-  for(int x=0;x<spectrum.GetNPeaks();x++) {
-    //double range = 8*data->GetXaxis()->GetBinWidth(1);
-    //printf(DGREEN "\tlow %.02f \t high %.02f" RESET_COLOR "\n",spectrum.GetPositionX()[x]-range,spectrum.GetPositionX()[x]+range);
-
-    //GPeak *fit = PhotoPeakFit(data,spectrum.GetPositionX()[x]-range,spectrum.GetPositionX()[x]+range,"no-print");
-    //data_channels.push_back(fit->GetCentroid());
-    //data->GetListOfFunctions()->Remove(fit);
-    //peak_area[fit->GetCentroid()] = fit->GetSum();
-
-    peak_positions.push_back(spectrum.GetPositionX()[x]);
-
-
-  }
+  std::vector<double> peak_positions = SearchPeaks(spectrum,data,sigma,threshold,"");
 
 
   //std::map<double,double> datatosource = Match(data_channels,source_energy);;
   std::map<double,double> datatosource = Match(peak_positions,source_energy);;
 
   //PrintMap(datatosource);
-  double range = 8;//8*data->GetXaxis()->GetBinWidth(1);
+  // The matched peaks are fit at once, each on its own thread.
+  GFitPool pool(GFitPool::kGaus);
+  std::vector<double> energies;
   for(auto it : datatosource) {
 
-    double peak = it.first;
-    double eng  = it.second;
-
-    range = 0.02 * peak;
-    if(range < 8.)
-      range = 8.0;
-
-
-    //GPeak *fit = PhotoPeakFit(data,peak-range,peak+range/2.,"no-print");
-      GGaus *fit = GausFit(data,peak-range,peak+range/2.,"no-print");
-
-    peak = fit->GetCentroid();
-    fit->Print();
-    //data_channels.push_back(fit->GetCentroid());
-    //data->GetListOfFunctions()->Remove(fit);
-    //peak_area[fit->GetCentroid()] = fit->GetSum();
-
-    //AddPeak(it.first,it.second,source->GetName(),peak_area.at(it.first),src_eng_int[it.second]);
-    AddPeak(fit->GetCentroid(),eng,source->GetName(),fit->GetSum(),src_eng_int[eng]);
+    double low,high;
+    PeakWindow(it.first,low,high);
+    pool.Add(energies.size(),data,low,high);
+    energies.push_back(it.second);
+  }
+  std::vector<GFitPool::Result> fits = pool.Fit();
+  GFitPool::Print(fits);
+  for(auto& fit : fits) {
+    if(!fit.valid)
+      continue;
+    double eng = energies.at(fit.index);
+    AddPeak(fit.centroid,eng,source->GetName(),fit.sum,src_eng_int[eng]);
   }
 
   //Print();
@@ -410,7 +428,7 @@ std::map<double,double> TCalibrator::Match(std::vector<double> peaks,std::vector
   // source are the known values
 
   std::vector<bool> filled(source.size());
-  std::fill(filled.begin(), filled.begin() + peaks.size(), true);
+  std::fill(filled.begin(), filled.begin() + std::min(peaks.size(), source.size()), true);
 
   //std::cout << "Num peaks: " << peaks.size() << std::endl;
   //std::cout << "Num source: " << source.size() << std::endl;
@@ -498,7 +516,236 @@ bool TCalibrator::CheckMap(std::map<double,double> inmap) {
 
 
 
-void TCalibrator::UpdateTChannel(TChannel *channel) { }
+void TCalibrator::UpdateTChannel(TChannel *channel) {
+  if(!channel || !linfit)
+    return;
+  // The fit is of the charge, and TChannel calibrates the charge less its pedestal p:
+  //   sum_i c_i (x+p)^i = sum_j x^j sum_{i>=j} c_i Binomial(i,j) p^(i-j)
+  double pedestal = channel->GetPedestal();
+  std::vector<double> coeff(linfit->GetNpar(),0.0);
+  for(int i=0;i<linfit->GetNpar();i++) {
+    for(int j=0;j<=i;j++) {
+      coeff[j] += linfit->GetParameter(i)*TMath::Binomial(i,j)*std::pow(pedestal,i-j);
+    }
+  }
+  channel->SetEnergyCoeff(coeff);
+}
+
+std::vector<TCalibrator::ChannelFit> TCalibrator::CalibrateChannels(const std::map<unsigned int,TH1*>& data,
+                                                                    const std::vector<std::string>& sources,
+                                                                    int order,double sigma,double threshold,
+                                                                    int nthreads) {
+  std::vector<TH1*> hists;
+  std::vector<ChannelFit> fits;
+  for(auto& it : data) {
+    if(!it.second)
+      continue;
+    ChannelFit fit;
+    fit.address = it.first;
+    fit.valid = false;
+    fit.rms_residual = 0;
+    fit.max_residual = 0;
+    fits.push_back(fit);
+    hists.push_back(it.second);
+  }
+  if(order<1 || order>2) {
+    printf(DRED "calibrations of order %i are not supported" RESET_COLOR "\n",order);
+    return fits;
+  }
+
+  // Lines of each source, read here once and only read by the threads.
+  struct Lines {
+    std::string nucleus;
+    std::vector<double> energy;
+    std::map<double,double> intensity;
+  };
+  std::vector<Lines> lines;
+  for(auto& source : sources) {
+    TNucleus nucleus(source.c_str());
+    Lines src;
+    src.nucleus = nucleus.GetName();
+    TIter iter(nucleus.GetTransitionList());
+    while(TTransition *transition = (TTransition*)iter.Next()) {
+      src.energy.push_back(transition->GetEnergy());
+      src.intensity[transition->GetEnergy()] = transition->GetIntensity();
+    }
+    if(src.energy.empty()) {
+      printf(DRED "no lines for source %s" RESET_COLOR "\n",source.c_str());
+      continue;
+    }
+    std::sort(src.energy.begin(),src.energy.end());
+    lines.push_back(src);
+  }
+  if(hists.empty() || lines.empty())
+    return fits;
+
+  if(nthreads<=0)
+    nthreads = std::max(1u,std::thread::hardware_concurrency());
+  nthreads = std::min(size_t(nthreads),hists.size());
+  if(nthreads>1)
+    ROOT::EnableThreadSafety();
+
+  // The peaks of each channel, matched to the lines of each source.
+  // Each thread has its own TSpectrum and TCalibrator, and each channel is
+  //   searched by one thread only.  Searching with "goff" leaves the histogram
+  //   untouched, and the TFormulae of the TLinearFitter in Match are added to
+  //   gROOT under the lock taken once ROOT::EnableThreadSafety has been called.
+  std::vector<std::vector<std::map<double,double> > > matched(hists.size(),
+                                                              std::vector<std::map<double,double> >(lines.size()));
+  std::atomic<size_t> next(0);
+  auto match = [&]() {
+    TCalibrator cal;
+    TSpectrum spectrum;
+    size_t i;
+    while((i = next++) < hists.size()) {
+      if(hists[i]->Integral() < kMinChannelCounts)
+        continue;
+      std::vector<double> peaks = SearchPeaks(spectrum,hists[i],sigma,threshold,"goff");
+      for(size_t s=0;s<lines.size();s++) {
+        matched[i][s] = cal.Match(peaks,lines[s].energy);
+      }
+    }
+  };
+  if(nthreads==1) {
+    match();
+  } else {
+    std::vector<std::thread> threads;
+    for(int i=0;i<nthreads;i++)
+      threads.emplace_back(match);
+    for(auto& thread : threads)
+      thread.join();
+  }
+
+  // Every matched peak of every channel is fit at once.
+  struct Window {
+    size_t channel;
+    size_t source;
+    double energy;
+  };
+  std::vector<Window> windows;
+  GFitPool pool(GFitPool::kGaus,nthreads);
+  for(size_t i=0;i<hists.size();i++) {
+    for(size_t s=0;s<lines.size();s++) {
+      for(auto& it : matched[i][s]) {
+        if(std::isnan(it.second))
+          continue;
+        double low,high;
+        PeakWindow(it.first,low,high);
+        pool.Add(windows.size(),hists[i],low,high);
+        windows.push_back({i,s,it.second});
+      }
+    }
+  }
+  std::vector<GFitPool::Result> results = pool.Fit();
+
+  std::vector<std::vector<Peak> > peaks(hists.size());
+  for(auto& result : results) {
+    if(!result.valid)
+      continue;
+    const Window& window = windows.at(result.index);
+    Peak peak;
+    peak.centroid  = result.centroid;
+    peak.energy    = window.energy;
+    peak.area      = result.sum;
+    peak.intensity = lines[window.source].intensity[window.energy];
+    peak.nucleus   = lines[window.source].nucleus;
+    peaks[window.channel].push_back(peak);
+  }
+
+  TCalibrator cal;
+  for(size_t i=0;i<fits.size();i++) {
+    ChannelFit& fit = fits[i];
+    fit.peaks = peaks[i];
+    if(fit.peaks.size()<2 || int(fit.peaks.size())<order+1)
+      continue;
+    cal.Clear();
+    for(auto& peak : fit.peaks)
+      cal.AddPeak(peak.centroid,peak.energy,peak.nucleus,peak.area,peak.intensity);
+    cal.Fit(order,false,"Q");
+    if(!cal.linfit)
+      continue;
+
+    for(int j=0;j<cal.linfit->GetNpar();j++)
+      fit.coeff.push_back(cal.GetParameter(j));
+    double sum2 = 0;
+    for(auto& peak : fit.peaks) {
+      double residual = cal.linfit->Eval(peak.centroid) - peak.energy;
+      sum2 += residual*residual;
+      fit.max_residual = std::max(fit.max_residual,std::abs(residual));
+    }
+    fit.rms_residual = std::sqrt(sum2/fit.peaks.size());
+    fit.valid = true;
+
+    cal.UpdateTChannel(TChannel::GetChannel(fit.address));
+  }
+  return fits;
+}
+
+std::string TCalibrator::ResidualReport(const std::vector<ChannelFit>& fits,const char *filename) {
+  std::string toprint;
+  std::string file = filename;
+
+  toprint.append("address\tname\t\tpeaks\trms[keV]\tmax[keV]\tcoefficients\n");
+  toprint.append("--------------------------------------------------------------------\n");
+  // Residuals of each line, over every channel.
+  std::map<std::pair<std::string,double>,std::vector<double> > line_residuals;
+  std::vector<double> rms;
+  const ChannelFit *worst = 0;
+  for(auto& fit : fits) {
+    TChannel *chan = TChannel::GetChannel(fit.address);
+    std::string name = chan ? chan->GetName() : "-";
+    if(!fit.valid) {
+      toprint.append(Form("0x%08x\t%-12s\t%i\tnot calibrated\n",fit.address,name.c_str(),(int)fit.peaks.size()));
+      continue;
+    }
+    toprint.append(Form("0x%08x\t%-12s\t%i\t%.3f\t\t%.3f\t",
+                        fit.address,name.c_str(),(int)fit.peaks.size(),fit.rms_residual,fit.max_residual));
+    for(auto coeff : fit.coeff)
+      toprint.append(Form("  %.6g",coeff));
+    toprint.append("\n");
+
+    for(auto& peak : fit.peaks) {
+      double energy = 0;
+      for(size_t j=0;j<fit.coeff.size();j++)
+        energy += fit.coeff[j]*std::pow(peak.centroid,j);
+      line_residuals[std::make_pair(peak.nucleus,peak.energy)].push_back(energy-peak.energy);
+    }
+    rms.push_back(fit.rms_residual);
+    if(!worst || fit.rms_residual>worst->rms_residual)
+      worst = &fit;
+  }
+  toprint.append("--------------------------------------------------------------------\n");
+
+  toprint.append("nuc\teng\t\tchannels\tmean[keV]\trms[keV]\n");
+  for(auto& it : line_residuals) {
+    double sum = 0;
+    double sum2 = 0;
+    for(auto residual : it.second) {
+      sum  += residual;
+      sum2 += residual*residual;
+    }
+    toprint.append(Form("%s\t%.2f\t\t%i\t\t%.3f\t\t%.3f\n",it.first.first.c_str(),it.first.second,
+                        (int)it.second.size(),sum/it.second.size(),std::sqrt(sum2/it.second.size())));
+  }
+  toprint.append("--------------------------------------------------------------------\n");
+
+  toprint.append(Form("%i of %i channels calibrated",(int)rms.size(),(int)fits.size()));
+  if(worst) {
+    std::sort(rms.begin(),rms.end());
+    toprint.append(Form(", rms residual median %.3f keV, worst %.3f keV (0x%08x)",
+                        rms[rms.size()/2],worst->rms_residual,worst->address));
+  }
+  toprint.append("\n");
+
+  if(file.length()) {
+    std::ofstream ofile;
+    ofile.open(file.c_str());
+    ofile << toprint ;
+    ofile.close();
+  }
+  printf("%s\n",toprint.c_str());
+  return toprint;
+}
 
 
 void TCalibrator::AddPeak(double cent,double eng,std::string nuc,double a,double inten) {
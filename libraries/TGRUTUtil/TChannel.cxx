@@ -18,6 +18,7 @@ std::unordered_map<unsigned int,TChannel*> TChannel::fChannelMap;
 TChannel *TChannel::fDefaultChannel = new TChannel("TChannel",0xffffffff);
 std::string TChannel::fChannelData;
 std::vector<double> TChannel::empty_vec;
+std::atomic<unsigned int> TChannel::fGeneration(0);
 
 ClassImp(TChannel)
 
@@ -121,6 +122,7 @@ void TChannel::Copy(TObject &rhs) const {
   ((TChannel&)rhs).time_coeff = time_coeff;
   ((TChannel&)rhs).efficiency_coeff = efficiency_coeff;
   ((TChannel&)rhs).pedestal = pedestal;
+  fGeneration++;
 }
 
 void TChannel::Clear(Option_t *opt) {
@@ -179,6 +181,7 @@ bool TChannel::AddChannel(TChannel* chan,Option_t *opt) {
   if(!chan)
      return false;
   TString option(opt);
+  fGeneration++;
   if(fChannelMap.count(chan->GetAddress())==1) {
      if(option.Contains("overwrite",TString::kIgnoreCase)) {
        TChannel *oldchan = GetChannel(chan->GetAddress());
@@ -222,6 +225,7 @@ bool TChannel::ReplaceChannel(TChannel *oldchan)  {
 bool TChannel::RemoveChannel(TChannel &chan) {
   if(fChannelMap.count(chan.GetAddress()==1)) {
     fChannelMap.erase(chan.GetAddress());
+    fGeneration++;
     return true;
   }
   return false;
@@ -236,6 +240,7 @@ int TChannel::DeleteAllChannels()  {
     count++;
   }
   fChannelMap.clear();
+  fGeneration++;
   return count;
 }
 
@@ -258,6 +263,7 @@ const std::vector<double>& TChannel::GetEnergyCoeff(double timestamp) const {
 void TChannel::ClearEnergyCoeff() {
   energy_coeff.clear();
   energy_coeff.push_back({std::vector<double>(), -DBL_MAX});
+  fGeneration++;
 }
 
 void TChannel::SetEnergyCoeff(std::vector<double> coeff, double timestamp) {
@@ -274,6 +280,7 @@ void TChannel::SetEnergyCoeff(std::vector<double> coeff, double timestamp) {
     energy_coeff.push_back({std::move(coeff), timestamp});
     std::sort(energy_coeff.begin(), energy_coeff.end());
   }
+  fGeneration++;
 }
 
 double TChannel::CalEnergy(int charge, double timestamp) const {
@@ -301,6 +308,7 @@ const std::vector<double>& TChannel::GetTimeCoeff(double timestamp) const {
 void TChannel::ClearTimeCoeff() {
   time_coeff.clear();
   time_coeff.push_back({std::vector<double>(), -DBL_MAX});
+  fGeneration++;
 }
 
 void TChannel::SetTimeCoeff(std::vector<double> coeff, double timestamp) {
@@ -316,6 +324,7 @@ void TChannel::SetTimeCoeff(std::vector<double> coeff, double timestamp) {
     time_coeff.push_back({std::move(coeff), timestamp});
     std::sort(time_coeff.begin(), time_coeff.end());
   }
+  fGeneration++;
 }
 
 double TChannel::CalTime(int time, double timestamp) const {
@@ -328,6 +337,7 @@ double TChannel::CalTime(double time, double timestamp) const {
 
 void TChannel::ClearEfficiencyCoeff() {
   efficiency_coeff.clear();
+  fGeneration++;
 }
 
 double TChannel::Calibrate(int value, const std::vector<double>& coeff) {
@@ -564,6 +574,9 @@ int TChannel::ParseInputData(std::string &input,Option_t *opt) {
   if(!strcmp(opt,"debug"))
      printf("parsed %i lines,\n",linenumber);
 
+  // Existing channels may have been updated in place by AppendChannel.
+  fGeneration++;
+
   return newchannels;
 }
 
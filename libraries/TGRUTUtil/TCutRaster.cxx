@@ -0,0 +1,149 @@
+#include "TCutRaster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "TCutG.h"
+#include "TEnv.h"
+
+TCutRaster::TCutRaster(const TCutG* cut, int nx, int ny)
+  : fCuts(1, cut) {
+  Build(nx, ny);
+}
+
+TCutRaster::TCutRaster(const std::vector<const TCutG*>& cuts, int nx, int ny)
+  : fCuts(cuts) {
+  Build(nx, ny);
+}
+
+void TCutRaster::Build(int nx, int ny) {
+  int size = gEnv->GetValue("GRUT.CutRasterSize", 256);
+  fNx = (nx > 0) ? nx : size;
+  fNy = (ny > 0) ? ny : size;
+
+  const double inf = std::numeric_limits<double>::infinity();
+  fXmin = fYmin =  inf;
+  fXmax = fYmax = -inf;
+  for(auto cut : fCuts) {
+    Box box = { inf, -inf, inf, -inf };
+    for(int i=0; i<cut->GetN(); i++) {
+      box.xmin = std::min(box.xmin, cut->GetX()[i]);
+      box.xmax = std::max(box.xmax, cut->GetX()[i]);
+      box.ymin = std::min(box.ymin, cut->GetY()[i]);
+      box.ymax = std::max(box.ymax, cut->GetY()[i]);
+    }
+    fBoxes.push_back(box);
+    fXmin = std::min(fXmin, box.xmin);
+    fXmax = std::max(fXmax, box.xmax);
+    fYmin = std::min(fYmin, box.ymin);
+    fYmax = std::max(fYmax, box.ymax);
+  }
+  fXScale = (fXmax > fXmin) ? fNx/(fXmax - fXmin) : 0;
+  fYScale = (fYmax > fYmin) ? fNy/(fYmax - fYmin) : 0;
+
+  // Each cell takes the first cut that decides it: one it is inside, or
+  // one with an edge through it, which leaves the cell to be tested exactly.
+  fLabels.assign(fNx*fNy, -1);
+  std::vector<char> resolved(fNx*fNy, false);
+  std::vector<char> state(fNx*fNy);
+  for(size_t icut=0; icut<fCuts.size(); icut++) {
+    const TCutG* cut = fCuts[icut];
+    std::fill(state.begin(), state.end(), kOutside);
+    MarkEdges(cut, state);
+
+    for(int iy=0; iy<fNy; iy++) {
+      double y = fYmin + (iy + 0.5)/fYScale;
+      for(int ix=0; ix<fNx; ix++) {
+        int cell = iy*fNx + ix;
+        if(resolved[cell]) {
+          continue;
+        }
+        if(state[cell] == kOnEdge) {
+          fLabels[cell] = kFirstEdge - icut;
+          resolved[cell] = true;
+        } else if(cut->IsInside(fXmin + (ix + 0.5)/fXScale, y)) {
+          fLabels[cell] = icut;
+          resolved[cell] = true;
+        }
+      }
+    }
+  }
+}
+
+void TCutRaster::MarkEdges(const TCutG* cut, std::vector<char>& state) const {
+  int npoints = cut->GetN();
+  const double* px = cut->GetX();
+  const double* py = cut->GetY();
+
+  // A degenerate box leaves nothing to rasterise.
+  if(fXScale == 0 || fYScale == 0) {
+    std::fill(state.begin(), state.end(), kOnEdge);
+    return;
+  }
+
+  auto column = [this](double x) { return std::max(0, std::min(fNx-1, int(std::floor((x - fXmin)*fXScale)))); };
+  auto row    = [this](double y) { return std::max(0, std::min(fNy-1, int(std::floor((y - fYmin)*fYScale)))); };
+
+  // TCutG::IsInside closes the polygon from the last point to the first.
+  for(int i=0, j=npoints-1; i<npoints; j=i++) {
+    double x1 = px[j], y1 = py[j];
+    double x2 = px[i], y2 = py[i];
+    int ixlow  = column(std::min(x1, x2));
+    int ixhigh = column(std::max(x1, x2));
+
+    for(int ix=ixlow; ix<=ixhigh; ix++) {
+      // Part of the edge within this column of cells.
+      double ylow = std::min(y1, y2);
+      double yhigh = std::max(y1, y2);
+      if(x1 != x2) {
+        double t0 = ((fXmin +  ix   /fXScale) - x1)/(x2 - x1);
+        double t1 = ((fXmin + (ix+1)/fXScale) - x1)/(x2 - x1);
+        if(t0 > t1) {
+          std::swap(t0, t1);
+        }
+        t0 = std::max(0., t0);
+        t1 = std::min(1., t1);
+        double ya = y1 + t0*(y2 - y1);
+        double yb = y1 + t1*(y2 - y1);
+        ylow  = std::min(ya, yb);
+        yhigh = std::max(ya, yb);
+      }
+
+      // One cell of margin all round, for rounding in the cell lookup.
+      int iylow  = std::max(0, row(ylow) - 1);
+      int iyhigh = std::min(fNy-1, row(yhigh) + 1);
+      for(int jx=std::max(0, ix-1); jx<=std::min(fNx-1, ix+1); jx++) {
+        for(int iy=iylow; iy<=iyhigh; iy++) {
+          state[iy*fNx + jx] = kOnEdge;
+        }
+      }
+    }
+  }
+}
+
+int TCutRaster::ClassifyExact(double x, double y, size_t first) const {
+  // The cuts before the first one with an edge here are known to miss.
+  for(size_t i=first; i<fCuts.size(); i++) {
+    const Box& box = fBoxes[i];
+    if(x >= box.xmin && x <= box.xmax && y >= box.ymin && y <= box.ymax &&
+       fCuts[i]->IsInside(x, y)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void TCutRaster::Classify(size_t n, const double* x, const double* y, int* index) const {
+  for(size_t i=0; i<n; i++) {
+    index[i] = Classify(x[i], y[i]);
+  }
+}
+
+double TCutRaster::GetEdgeFraction() const {
+  if(fLabels.empty()) {
+    return 0;
+  }
+  size_t edges = std::count_if(fLabels.begin(), fLabels.end(), [](short label) { return label < -1; });
+  return double(edges)/fLabels.size();
+}
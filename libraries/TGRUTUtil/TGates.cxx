@@ -6,7 +6,7 @@ ClassImp(TGates)
 /* Used to make a vector of <TNucleus, TCutG> which contain atomic data and ****/
 /* gates used for making/filling histograms ************************************/
 /*******************************************************************************/
-TGates::TGates() {
+TGates::TGates() : gate2D(0) {
 }
 
 TGates::~TGates() { }
@@ -33,6 +33,7 @@ bool TGates::LoadPIDFile(const char * infile) {
     tmpG->SetName(Form("%s",tmpN->GetSymbol()));
     GateList.push_back(std::make_pair(tmpN, tmpG));
   }
+  Compile();
   return true;
 }
 
@@ -136,17 +137,57 @@ std::string TGates::GetSymbol(int ID) {
 /* For a 1D gate variable y must be defined, but is not used *******************/
 /*******************************************************************************/
 int TGates::GateID(float x, float y) {
+  if(fPIDRaster) return fPIDRaster->Classify(x,y);
+
   int i = 0;
   for(auto &iter: GateList) {
     //Check if 1D Gate
     if(iter.second->GetN() == 1) {
       if((x > iter.second->GetPointX(0)) && (x < iter.second->GetPointY(0))) return i;
+    } else if(i < (int)fGateRasters.size() && fGateRasters[i]) {
+      if(fGateRasters[i]->IsInside(x,y)) return i;
     } else if(iter.second->IsInside(x,y)) return i;
     i++;
   }
   return -1;
 }
 
+void TGates::GateID(size_t n, const float* x, const float* y, int* id) {
+  if(fPIDRaster) {
+    for(size_t i = 0; i < n; i++) id[i] = fPIDRaster->Classify(x[i],y[i]);
+  } else {
+    for(size_t i = 0; i < n; i++) id[i] = GateID(x[i],y[i]);
+  }
+}
+
+/*******************************************************************************/
+/* Rasterises the gates, so that GateID and InGate look up a bitmap ************/
+/* With no 1D gates, one raster gives the first gate of a point directly *******/
+/*******************************************************************************/
+void TGates::Compile() {
+  fPIDRaster.reset();
+  fGateRasters.clear();
+  fGate2DRaster.reset();
+
+  bool has1D = false;
+  std::vector<const TCutG*> cuts;
+  for(auto &iter: GateList) {
+    if(iter.second->GetN() == 1) has1D = true;
+    cuts.push_back(iter.second);
+  }
+
+  if(!has1D) {
+    if(cuts.size()) fPIDRaster.reset(new TCutRaster(cuts));
+  } else {
+    for(auto cut: cuts) {
+      if(cut->GetN() == 1) fGateRasters.emplace_back(nullptr);
+      else fGateRasters.emplace_back(new TCutRaster(cut));
+    }
+  }
+
+  if(gate2D) fGate2DRaster.reset(new TCutRaster(gate2D));
+}
+
 /*******************************************************************************/
 /* Gets the mass number a TGate ************************************************/
 /*******************************************************************************/
@@ -199,6 +240,7 @@ bool TGates::LoadGateFile(const char * infile) {
     gate2D->SetPoint(j, fX, fY);
   }
   gate2D->SetName("gate2d");
+  fGate2DRaster.reset(new TCutRaster(gate2D));
 
   return true;
 }
@@ -246,6 +288,7 @@ void TGates::MakeGateFile(const char * filename) {
 /* Checks if gate codition is met **********************************************/
 /*******************************************************************************/
 bool TGates::InGate(float X, float Y) {
+  if(fGate2DRaster) return fGate2DRaster->IsInside(X, Y);
   if(gate2D->IsInside(X, Y)) return true;
   else return false;
 }
@@ -62,6 +62,8 @@ void TGRUTOptions::Load(int argc, char** argv) {
     compiled_histogram_file = std::string(getenv("GRUTSYS")) + "/libraries/libMakeHistos.so";
   }
 
+  metrics_socket = gEnv->GetValue("GRUT.MetricsSocket","");
+
   s800_inverse_map_file = "";//"invmap.inv";
 
   // Load default TChannels, if specified.
@@ -84,6 +86,7 @@ void TGRUTOptions::Load(int argc, char** argv) {
 
   std::vector<std::string> input_files;
   std::string default_file_format;
+  std::string tree_format;
 
   //parser.option() will initialize boolean values to false.
 
@@ -120,6 +123,31 @@ void TGRUTOptions::Load(int argc, char** argv) {
   parser.option("build-window", &fBuildWindow)
     .description("Build window, timestamp units")
     .default_value(1000);
+  parser.option("write-threads", &fWriteThreads)
+    .description("Threads filling the output tree, merged with TBufferMerger")
+    .default_value(1);
+  parser.option("replay-threads", &fReplayThreads)
+    .description("Threads histogramming a root tree, each filling its own copy of the histograms")
+    .default_value(1);
+  parser.option("all-branches", &fReadAllBranches)
+    .description("Read every branch of a root tree, not only those the histograms use")
+    .default_value(false);
+  parser.option("profile", &fProfile)
+    .description("Print the busy, waiting and latency of each pipeline stage on exit")
+    .default_value(false);
+  parser.option("metrics-socket", &metrics_socket)
+    .description("Unix socket serving the stage metrics as JSON");
+  parser.option("basket-size", &fBasketSize)
+    .description("Basket size of the output tree branches in bytes, 0 for the ROOT default")
+    .default_value(0);
+  parser.option("compression", &fCompression)
+    .description("ROOT compression setting of the output tree (ex. 404 for LZ4 level 4), -1 for the default")
+    .default_value(-1);
+  parser.option("autoflush", &fAutoFlush)
+    .description("Auto-flush of the output tree, entries if positive, bytes if negative, 0 for the default")
+    .default_value(0);
+  parser.option("tree-format", &tree_format)
+    .description("Output tree format: \"objects\" for EventTree (default), \"flat\" for flat hit tables, or \"both\"");
   parser.option("long-file-description", &fLongFileDescription)
     .description("Show full path to file in status messages")
     .default_value(false);
@@ -194,6 +222,24 @@ void TGRUTOptions::Load(int argc, char** argv) {
     }
   }
 
+  // Handle the output tree format
+  fWriteObjectTree = true;
+  fWriteFlatTables = false;
+  if(tree_format.length()){
+    std::transform(tree_format.begin(), tree_format.end(), tree_format.begin(),
+                   (int (*)(int))std::tolower);
+    if(tree_format == "flat"){
+      fWriteObjectTree = false;
+      fWriteFlatTables = true;
+    } else if (tree_format == "both") {
+      fWriteFlatTables = true;
+    } else if (tree_format != "objects") {
+      std::cerr << "ERROR: Unknown tree format: \"" << tree_format << "\"\n"
+                << parser << std::endl;
+      fShouldExit = true;
+    }
+  }
+
   if(input_ring.length() && fDefaultFileType == kFileType::UNKNOWN_FILETYPE){
     std::cerr << "ERROR: Must specify --format when reading from a ring\n"
               << parser << std::endl;
@@ -214,7 +260,7 @@ kFileType TGRUTOptions::DetermineFileType(const std::string& filename) const{
   size_t dot_pos = filename.find_last_of('.');
   std::string ext = filename.substr(dot_pos+1);
 
-  bool isZipped = (ext=="gz") || (ext=="bz2") || (ext=="zip");
+  bool isZipped = (ext=="gz") || (ext=="bz2") || (ext=="zst") || (ext=="zip");
   if(isZipped){
     std::string remaining = filename.substr(0,dot_pos);
     ext = remaining.substr(remaining.find_last_of('.')+1);
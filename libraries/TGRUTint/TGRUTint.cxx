@@ -35,6 +35,7 @@
 #include "TGRUTUtilities.h"
 #include "THistogramLoop.h"
 #include "TInverseMap.h"
+#include "TMetricsServer.h"
 #include "TMultiRawFile.h"
 #include "TOrderedRawFile.h"
 #include "TRawSource.h"
@@ -190,6 +191,10 @@ void TGRUTint::ApplyOptions() {
   // Note: Assumes that gChain has already been loaded.
   SetupPipeline();
 
+  StoppableThread::SetProfile(opt->Profile());
+  if(opt->MetricsSocket().length()) {
+    TMetricsServer::Start(opt->MetricsSocket());
+  }
 
 
 
@@ -448,6 +453,7 @@ void TGRUTint::SetupPipeline() {
   }
 
   std::shared_ptr<ThreadsafeQueue<TUnpackedEvent*> > current_queue = nullptr;
+  TUnpackingLoop* unpack_loop = NULL;
 
   //next most important thing, if given a raw file && NOT told to not sort!
   if(sort_raw) {
@@ -459,13 +465,18 @@ void TGRUTint::SetupPipeline() {
     build_loop->SetBuildWindow(opt->BuildWindow());
     build_loop->InputQueue() = fDataLoop->OutputQueue();
 
-    TUnpackingLoop* unpack_loop = TUnpackingLoop::Get("3_unpack");
+    unpack_loop = TUnpackingLoop::Get("3_unpack");
     unpack_loop->InputQueue() = build_loop->OutputQueue();
     current_queue = unpack_loop->OutputQueue();
 
   } else if(sort_tree) {
     fChainLoop = TChainLoop::Get("1_chain_loop",gChain);
     fChainLoop->SetSelfStopping(self_stopping);
+    if(!filter_data && !write_root_tree) {
+      // Only the histograms need the events, so they need not be in order.
+      fChainLoop->SetReplayThreads(opt->ReplayThreads());
+      fChainLoop->SetSelectBranches(!opt->ReadAllBranches());
+    }
     current_queue = fChainLoop->OutputQueue();
   }
 
@@ -477,12 +488,20 @@ void TGRUTint::SetupPipeline() {
     for(auto cut_file : cuts_files) {
       filter_loop->AddCutFile(cut_file);
     }
+    if(unpack_loop && filter_loop->HasPreFilter()) {
+      unpack_loop->SetDeferBuild(true);
+    }
     filter_loop->InputQueue() = current_queue;
     current_queue = filter_loop->OutputQueue();
   }
 
   if(write_root_tree) {
     TWriteLoop* write_loop = TWriteLoop::Get("5_write_loop", output_root_file);
+    write_loop->SetTreeFormat(opt->WriteObjectTree(), opt->WriteFlatTables());
+    write_loop->SetWriteThreads(opt->WriteThreads());
+    write_loop->SetBasketSize(opt->BasketSize());
+    write_loop->SetCompression(opt->Compression());
+    write_loop->SetAutoFlush(opt->AutoFlush());
     write_loop->InputQueue() = current_queue;
     current_queue = write_loop->OutputQueue();
   }
@@ -495,6 +514,9 @@ void TGRUTint::SetupPipeline() {
     }
     fHistogramLoop->InputQueue() = current_queue;
     current_queue = fHistogramLoop->OutputQueue();
+    if(fChainLoop) {
+      fChainLoop->SetHistogramLoop(fHistogramLoop);
+    }
   }
 
   TTerminalLoop* terminal_loop = TTerminalLoop::Get("7_terminal_loop");
@@ -618,6 +640,7 @@ void TGRUTint::Terminate(Int_t status){
     //std::cout << "SQUASHED!" << std::endl;
     return;
   }
+  TMetricsServer::Stop();
   StoppableThread::StopAll();
 
   //if(GUIIsRunning()){
@@ -20,7 +20,7 @@
 typedef void* __attribute__((__may_alias__)) void_alias;
 
 TCompiledFilter::TCompiledFilter()
-  : libname(""), library(nullptr), func(nullptr),
+  : libname(""), library(nullptr), func(nullptr), pre_func(nullptr),
     last_modified(0), last_checked(0), check_every(5),
     obj(&objects, &gates, cut_files) { }
 
@@ -37,6 +37,7 @@ TCompiledFilter::TCompiledFilter(std::string input_lib)
     std::cout << "Could not find FilterCondition() inside "
               <<"\"" << input_lib << "\"" << std::endl;
   }
+  *(void_alias*)(&pre_func) = library->GetSymbol("PreFilterCondition");
   last_modified = get_timestamp();
   last_checked = time(NULL);
 }
@@ -70,6 +71,7 @@ void TCompiledFilter::swap_lib(TCompiledFilter& other) {
   std::swap(libname, other.libname);
   std::swap(library, other.library);
   std::swap(func, other.func);
+  std::swap(pre_func, other.pre_func);
   std::swap(last_modified, other.last_modified);
   std::swap(last_checked, other.last_checked);
   std::swap(check_every, other.check_every);
@@ -88,6 +90,15 @@ bool TCompiledFilter::MatchesCondition(TUnpackedEvent& detectors) {
   return func(obj);
 }
 
+bool TCompiledFilter::MatchesPreCondition(TUnpackedEvent& detectors) {
+  if(!library || !pre_func){
+    return true;
+  }
+
+  obj.SetDetectors(&detectors);
+  return pre_func(obj);
+}
+
 void TCompiledFilter::AddCutFile(TFile* cut_file) {
   if(cut_file) {
     cut_files.push_back(cut_file);
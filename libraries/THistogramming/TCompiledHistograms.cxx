@@ -9,6 +9,7 @@
 #include "TH1.h"
 #include "TFile.h"
 #include "TDirectory.h"
+#include "TEnv.h"
 #include "TObject.h"
 #include "TROOT.h"
 #include "TKey.h"
@@ -20,8 +21,10 @@
 typedef void* __attribute__((__may_alias__)) void_alias;
 
 TCompiledHistograms::TCompiledHistograms()
-  : libname(""), library(nullptr), func(nullptr),
+  : libname(""), library(nullptr), func(nullptr), used_branches(nullptr),
     last_modified(0), last_checked(0), check_every(5),
+    warm_up_events(gEnv->GetValue("GRUT.BranchWarmUp", 0)),
+    events_filled(0), requested_detectors(0), used_branches_version(0),
     default_directory(0),obj(&objects, &gates, cut_files) { }
 
 TCompiledHistograms::TCompiledHistograms(std::string input_lib)
@@ -36,6 +39,10 @@ TCompiledHistograms::TCompiledHistograms(std::string input_lib)
     std::cout << "Could not find MakeHistograms() inside "
               <<"\"" << input_lib << "\"" << std::endl;
   }
+  *(void_alias*)(&used_branches) = library->GetSymbol("UsedBranches");
+  if(used_branches){
+    used_branches_version = 1;
+  }
   last_modified = get_timestamp();
   last_checked = time(NULL);
 }
@@ -126,6 +133,14 @@ void TCompiledHistograms::swap_lib(TCompiledHistograms& other) {
   std::swap(last_modified, other.last_modified);
   std::swap(last_checked, other.last_checked);
   std::swap(check_every, other.check_every);
+  std::swap(used_branches, other.used_branches);
+
+  // The new library may read other branches; without a list of its own,
+  // it gets a new warm-up.
+  if(!used_branches){
+    events_filled = 0;
+  }
+  used_branches_version++;
 }
 
 void TCompiledHistograms::Fill(TUnpackedEvent& detectors) {
@@ -143,6 +158,31 @@ void TCompiledHistograms::Fill(TUnpackedEvent& detectors) {
 
   obj.SetDetectors(&detectors);
   func(obj);
+
+  if(!used_branches && warm_up_events > 0){
+    events_filled++;
+    size_t requested = obj.GetRequestedDetectors().size();
+    if(events_filled == warm_up_events ||
+       (events_filled > warm_up_events && requested != requested_detectors)){
+      requested_detectors = requested;
+      used_branches_version++;
+    }
+  }
+}
+
+size_t TCompiledHistograms::GetUsedBranches(std::vector<std::string>& branches) {
+  std::lock_guard<std::mutex> lock(mutex);
+  branches.clear();
+  if(used_branches){
+    used_branches(branches);
+  } else if(warm_up_events > 0 && events_filled >= warm_up_events){
+    for(auto& name : obj.GetRequestedDetectors()){
+      branches.push_back(name);
+    }
+  } else {
+    return 0;
+  }
+  return used_branches_version;
 }
 
 void TCompiledHistograms::AddCutFile(TFile* cut_file) {
@@ -158,6 +198,66 @@ void TCompiledHistograms::AddCutFile(TFile* cut_file) {
   }
 }
 
+TCompiledHistograms* TCompiledHistograms::MakeShard(TDirectory* dir) {
+  TCompiledHistograms* shard = library ? new TCompiledHistograms(libname) : new TCompiledHistograms;
+  for(auto cut_file : cut_files) {
+    shard->AddCutFile(cut_file);
+  }
+  shard->SetDefaultDirectory(dir);
+  return shard;
+}
+
+namespace {
+  // Adds hist to the histogram of the same name in list, or copies it into dir.
+  void MergeHistogram(TH1* hist, TList* list, TDirectory* dir) {
+    TH1* existing = dynamic_cast<TH1*>(list->FindObject(hist->GetName()));
+    if(existing) {
+      existing->Add(hist);
+    } else {
+      TH1* copy = (TH1*)hist->Clone();
+      copy->SetDirectory(dir);
+      if(list != dir->GetList()) {
+        list->Add(copy);
+      }
+    }
+  }
+}
+
+void TCompiledHistograms::Merge(TCompiledHistograms& other) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  TPreserveGDirectory preserve;
+  if(default_directory) {
+    default_directory->cd();
+  }
+
+  TIter next(&other.objects);
+  TObject* obj;
+  while((obj = next())){
+    if(obj->InheritsFrom(TH1::Class())){
+      MergeHistogram((TH1*)obj, &objects, gDirectory);
+    }
+    else if(obj->InheritsFrom(TDirectory::Class())){
+      TDirectory* other_dir = (TDirectory*)obj;
+      TDirectory* dir = (TDirectory*)objects.FindObject(other_dir->GetName());
+      if(!dir){
+        dir = new TDirectory(other_dir->GetName(), other_dir->GetName());
+        objects.Add(dir);
+      }
+      TIter dirnext(other_dir->GetList());
+      TObject* dirobj;
+      while((dirobj=dirnext())){
+        if(dirobj->InheritsFrom(TH1::Class())){
+          MergeHistogram((TH1*)dirobj, dir->GetList(), dir);
+        }
+      }
+    }
+    else if(!objects.FindObject(obj->GetName())){
+      objects.Add(obj->Clone());
+    }
+  }
+}
+
 void TCompiledHistograms::SetDefaultDirectory(TDirectory* dir) {
   default_directory = dir;
 
@@ -2,6 +2,7 @@
 
 #include "TFile.h"
 
+#include "TBuildProfile.h"
 #include "TGRUTint.h"
 #include "TGRUTOptions.h"
 #include "TPreserveGDirectory.h"
@@ -108,6 +109,10 @@ void THistogramLoop::Write() {
       TChannel::Get()->Write();
       printf(BLUE "\t%i TChannels written to file %s" RESET_COLOR "\n",TChannel::Size(),gDirectory->GetName());
     }
+    TBuildProfile profile = TBuildProfile::Snapshot();
+    if(profile.GetNSystems()) {
+      profile.Write("", TObject::kOverwrite);
+    }
   }
 }
 
@@ -138,3 +143,14 @@ std::string THistogramLoop::GetOutputFilename() const {
 void THistogramLoop::AddCutFile(TFile* cut_file) {
   compiled_histograms.AddCutFile(cut_file);
 }
+
+TCompiledHistograms* THistogramLoop::MakeShard(TDirectory* dir) {
+  return compiled_histograms.MakeShard(dir);
+}
+
+void THistogramLoop::MergeShard(TCompiledHistograms& shard) {
+  if(!output_file){
+    OpenFile();
+  }
+  compiled_histograms.Merge(shard);
+}
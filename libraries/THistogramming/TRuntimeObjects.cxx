@@ -23,7 +23,7 @@ TRuntimeObjects::TRuntimeObjects(TUnpackedEvent *detectors, TList* objects, TLis
                                  TDirectory* directory,const char *name)
   : detectors(detectors), objects(objects), gates(gates),
     cut_files(cut_files),
-    directory(directory) {
+    directory(directory), cut_files_searched(0) {
   SetName(name);
   fRuntimeMap.insert(std::make_pair(name,this));
 }
@@ -33,7 +33,7 @@ TRuntimeObjects::TRuntimeObjects(TList* objects, TList *gates,
                                  TDirectory* directory,const char *name)
   : detectors(0),objects(objects), gates(gates),
     cut_files(cut_files),
-    directory(directory) {
+    directory(directory), cut_files_searched(0) {
   SetName(name);
   fRuntimeMap.insert(std::make_pair(name,this));
 }
@@ -304,16 +304,46 @@ TList& TRuntimeObjects::GetGates() {
 }
 
 TCutG* TRuntimeObjects::GetCut(const std::string& name) {
+  // A cut file added since the last lookup may have the cuts that were missing.
+  if(cut_files.size() != cut_files_searched) {
+    for(auto it = cut_registry.begin(); it != cut_registry.end(); ) {
+      it = it->second ? std::next(it) : cut_registry.erase(it);
+    }
+    cut_files_searched = cut_files.size();
+  }
+
+  auto it = cut_registry.find(name);
+  if(it != cut_registry.end()) {
+    return it->second;
+  }
+
+  TCutG* cut = NULL;
   for(auto& tfile : cut_files) {
     TObject* obj = tfile->Get(name.c_str());
     if(obj) {
-      TCutG* cut = dynamic_cast<TCutG*>(obj);
+      cut = dynamic_cast<TCutG*>(obj);
       if(cut) {
-        return cut;
+        break;
       }
     }
   }
-  return NULL;
+  cut_registry[name] = cut;
+  return cut;
+}
+
+const TCutRaster* TRuntimeObjects::GetCutRaster(const std::string& name) {
+  auto it = cut_rasters.find(name);
+  if(it != cut_rasters.end()) {
+    return it->second.get();
+  }
+
+  TCutG* cut = GetCut(name);
+  if(!cut) {
+    return NULL;
+  }
+  TCutRaster* raster = new TCutRaster(cut);
+  cut_rasters[name].reset(raster);
+  return raster;
 }
 
 double TRuntimeObjects::GetVariable(const char* name) {
@@ -1,4 +1,4 @@
-// TDataLoop.h TBuildingLoop.h TUnpackingLoop.h StoppableThread.h TWriteLoop.h TChainLoop.h TTerminalLoop.h TFilterLoop.h
+// TDataLoop.h TBuildingLoop.h TUnpackingLoop.h StoppableThread.h TWriteLoop.h TChainLoop.h TTerminalLoop.h TFilterLoop.h TBuildProfile.h
 
 #ifdef __CINT__
 
@@ -18,4 +18,6 @@
 #pragma link C++ class TTerminalLoop+;
 #pragma link C++ class TFilterLoop+;
 
+#pragma link C++ class TBuildProfile+;
+
 #endif
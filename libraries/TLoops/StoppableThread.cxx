@@ -1,16 +1,20 @@
 #include "StoppableThread.h"
 
+#include <cstdio>
+#include <ctime>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
 #include <TString.h>
 
+#include "TBuildProfile.h"
 #include "TDataLoop.h"
 #include "TChainLoop.h"
 
 std::map<std::string,StoppableThread*> StoppableThread::fthreadmap;
 bool StoppableThread::status_thread_on = false;
+bool StoppableThread::profile_at_exit = false;
 std::thread StoppableThread::status_thread;
 
 
@@ -80,6 +84,10 @@ void StoppableThread::StopAll() {
     thread->Join();
   }
 
+  if(profile_at_exit) {
+    PrintProfile();
+  }
+
   while(fthreadmap.size()){
     StoppableThread* thread = fthreadmap.begin()->second;
     std::cout << "Deleting thread " << fthreadmap.begin()->first << std::endl;
@@ -142,6 +150,7 @@ void StoppableThread::Join() {
 }
 
 void StoppableThread::Loop() {
+  TStageMetrics::Current() = &metrics;
   while(running){
     {
       std::unique_lock<std::mutex> lock(pause_mutex);
@@ -149,7 +158,9 @@ void StoppableThread::Loop() {
         paused_wait.wait_for(lock, std::chrono::milliseconds(100));
       }
     }
+    metrics.BeginIteration();
     bool success = Iteration();
+    metrics.EndIteration();
     if(!success){
       running = false;
       break;
@@ -212,7 +223,74 @@ void StoppableThread::status_out() {
   }
   outfile << "---------------------------------------------------------------\n"; // 64 -.
 
+  TBuildProfile profile = TBuildProfile::Snapshot();
+  for(size_t i=0; i<profile.GetNSystems(); i++) {
+    outfile << "- BuildHits " << profile.GetSystem(i) << "\n";
+    outfile << "- " << std::string(40,' ') << "calls:     " << profile.GetCalls(i)     << "\n";
+    outfile << "- " << std::string(40,' ') << "fragments: " << profile.GetFragments(i) << "\n";
+    outfile << "- " << std::string(40,' ') << "bytes:     " << profile.GetBytes(i)     << "\n";
+    outfile << "- " << std::string(40,' ') << "hits:      " << profile.GetHits(i)      << "\n";
+    outfile << "- " << std::string(40,' ') << "seconds:   " << profile.GetSeconds(i)   << "\n";
+  }
+  if(profile.GetNSystems()) {
+    outfile << "---------------------------------------------------------------\n"; // 64 -.
+  }
+
+  // Written aside and renamed, so that a reader never sees half of it.
+  std::string json_name = Form("%s/.grut_metrics.json",getenv("GRUTSYS"));
+  {
+    std::ofstream json((json_name + ".tmp").c_str());
+    json << MetricsJson() << "\n";
+  }
+  std::rename((json_name + ".tmp").c_str(), json_name.c_str());
+}
+
+std::string StoppableThread::MetricsJson() {
+  std::stringstream ss;
+  ss << "{\"time\": " << std::time(nullptr) << ", \"stages\": [";
+  bool first = true;
+  for(auto& elem : fthreadmap) {
+    StoppableThread* thread = elem.second;
+    ss << (first ? "\n  " : ",\n  ")
+       << "{\"name\": \"" << thread->Name() << "\""
+       << ", \"running\": " << (thread->IsRunning() ? "true" : "false")
+       << ", \"queue_current\": " << thread->GetItemsCurrent()
+       << ", " << TStageMetrics::Json(thread->Metrics().Get())
+       << "}";
+    first = false;
+  }
+  ss << "\n], \"build_hits\": " << TBuildProfile::Json() << "}";
+  return ss.str();
+}
+
+void StoppableThread::PrintProfile() {
+  printf("\n%-16s %10s %10s %6s %8s %9s %9s %9s\n",
+         "stage", "events", "events/s", "busy", "starved", "backed-up", "p50 (us)", "p99 (us)");
+  std::string busiest;
+  double busiest_fraction = -1;
+  for(auto& elem : fthreadmap) {
+    StoppableThread* thread = elem.second;
+    TStageMetrics::Snapshot snap = thread->Metrics().Get();
+    double elapsed = snap.elapsed_seconds > 0 ? snap.elapsed_seconds : 1;
+    printf("%-16s %10lu %10.0f %5.1f%% %7.1f%% %8.1f%% %9.1f %9.1f\n",
+           thread->Name().c_str(), (unsigned long)snap.events, snap.EventsPerSecond(),
+           100*snap.BusyFraction(),
+           100*snap.pop_wait_seconds/elapsed, 100*snap.push_wait_seconds/elapsed,
+           1e6*snap.LatencyQuantile(0.5), 1e6*snap.LatencyQuantile(0.99));
+    if(snap.events && snap.BusyFraction() > busiest_fraction) {
+      busiest = thread->Name();
+      busiest_fraction = snap.BusyFraction();
+    }
+  }
+  if(busiest.length()) {
+    printf("Busiest stage: %s, %.1f%% of its time working\n", busiest.c_str(), 100*busiest_fraction);
+  }
 
+  TBuildProfile profile = TBuildProfile::Snapshot();
+  if(profile.GetNSystems()) {
+    printf("\n");
+    profile.Print();
+  }
 }
 
 std::vector<StoppableThread*> StoppableThread::GetAll() {
@@ -0,0 +1,166 @@
+#include "TBuildProfile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "TClass.h"
+#include "TEnv.h"
+
+#include "TDetectorFactory.h"
+
+ClassImp(TBuildProfile)
+
+namespace {
+  // Enough for every value of kDetectorSystems.
+  const int kMaxSystems = 128;
+
+  struct Counters {
+    std::atomic<unsigned long long> calls;
+    std::atomic<unsigned long long> fragments;
+    std::atomic<unsigned long long> bytes;
+    std::atomic<unsigned long long> hits;
+    std::atomic<unsigned long long> timed_calls;
+    std::atomic<unsigned long long> timed_ticks;
+  };
+  Counters counters[kMaxSystems];
+
+  unsigned long long Ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  // The tick rate is measured against the steady clock since the library was loaded.
+  const unsigned long long start_ticks = Ticks();
+  const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+  double SecondsPerTick() {
+#if defined(__x86_64__) || defined(__i386__)
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    unsigned long long ticks = Ticks() - start_ticks;
+    return (ticks > 0) ? seconds/ticks : 0;
+#else
+    return 1e-9;
+#endif
+  }
+
+  int SampleInterval() {
+    static int interval = std::max(1, gEnv->GetValue("GRUT.BuildProfileSample", 16));
+    return interval;
+  }
+
+  std::string SystemName(int system) {
+    auto factory = detector_factory_map.find(kDetectorSystems(system));
+    if(factory != detector_factory_map.end() && factory->second) {
+      return factory->second->get_class()->GetName();
+    }
+    std::stringstream ss;
+    ss << "system" << system;
+    return ss.str();
+  }
+}
+
+TBuildProfile::TBuildProfile()
+  : TNamed("BuildProfile", "Time spent building the hits of each detector system"),
+    fSampleInterval(0) { }
+
+unsigned long long TBuildProfile::Start(kDetectorSystems system) {
+  if(system < 0 || system >= kMaxSystems) {
+    return 0;
+  }
+  unsigned long long call = counters[system].calls++;
+  // The call number is scrambled, so that a pattern repeating in the data
+  //   cannot line up with the calls timed.
+  if(((call*0x9E3779B97F4A7C15ULL) >> 32) % SampleInterval()) {
+    return 0;
+  }
+  return Ticks();
+}
+
+void TBuildProfile::Stop(kDetectorSystems system, unsigned long long start,
+                         size_t fragments, size_t bytes, size_t hits) {
+  if(system < 0 || system >= kMaxSystems) {
+    return;
+  }
+  Counters& counter = counters[system];
+  counter.fragments += fragments;
+  counter.bytes += bytes;
+  counter.hits += hits;
+  if(start) {
+    counter.timed_ticks += Ticks() - start;
+    counter.timed_calls++;
+  }
+}
+
+TBuildProfile TBuildProfile::Snapshot() {
+  TBuildProfile output;
+  output.fSampleInterval = SampleInterval();
+  double seconds_per_tick = SecondsPerTick();
+  for(int system=0; system<kMaxSystems; system++) {
+    Counters& counter = counters[system];
+    unsigned long long calls = counter.calls;
+    if(!calls) {
+      continue;
+    }
+    unsigned long long timed_calls = counter.timed_calls;
+    double timed_seconds = counter.timed_ticks*seconds_per_tick;
+
+    output.fSystems.push_back(SystemName(system));
+    output.fCalls.push_back(calls);
+    output.fFragments.push_back(counter.fragments);
+    output.fBytes.push_back(counter.bytes);
+    output.fHits.push_back(counter.hits);
+    output.fSeconds.push_back(timed_calls ? timed_seconds*calls/timed_calls : 0);
+  }
+  return output;
+}
+
+std::string TBuildProfile::Json() {
+  TBuildProfile profile = Snapshot();
+  std::stringstream ss;
+  ss << "[";
+  for(size_t i=0; i<profile.GetNSystems(); i++) {
+    ss << (i ? ", " : "")
+       << "{\"system\": \""   << profile.fSystems[i] << "\""
+       << ", \"calls\": "     << profile.fCalls[i]
+       << ", \"fragments\": " << profile.fFragments[i]
+       << ", \"bytes\": "     << profile.fBytes[i]
+       << ", \"hits\": "      << profile.fHits[i]
+       << ", \"seconds\": "   << profile.fSeconds[i]
+       << "}";
+  }
+  ss << "]";
+  return ss.str();
+}
+
+void TBuildProfile::Print(Option_t* opt) const {
+  printf("%-16s %12s %12s %10s %12s %10s %9s\n",
+         "BuildHits", "calls", "fragments", "MB", "hits", "seconds", "us/call");
+  for(size_t i=0; i<fSystems.size(); i++) {
+    printf("%-16s %12lld %12lld %10.1f %12lld %10.3f %9.2f\n",
+           fSystems[i].c_str(), fCalls[i], fFragments[i], fBytes[i]/1e6, fHits[i],
+           fSeconds[i], fCalls[i] ? 1e6*fSeconds[i]/fCalls[i] : 0.);
+  }
+  if(fSampleInterval > 1) {
+    printf("(1 call in %d timed)\n", fSampleInterval);
+  }
+}
+
+void TBuildProfile::Clear(Option_t* opt) {
+  fSystems.clear();
+  fCalls.clear();
+  fFragments.clear();
+  fBytes.clear();
+  fHits.clear();
+  fSeconds.clear();
+}
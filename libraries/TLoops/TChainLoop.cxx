@@ -1,16 +1,44 @@
 #include "TChainLoop.h"
 
+#include <algorithm>
 #include <chrono>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "TClass.h"
+#include "TDirectory.h"
 #include "TFile.h"
+#include "TROOT.h"
 #include "TThread.h"
+#include "TTree.h"
 
+#include "TCompiledHistograms.h"
 #include "TDetector.h"
 #include "TGRUTint.h"
+#include "THistogramLoop.h"
+#include "TPreserveGDirectory.h"
 #include "TUnpackedEvent.h"
 
+struct TChainLoop::Replay {
+  /// Entries [first, last) of one cluster of one tree.
+  struct Range {
+    std::string filename;
+    std::string treename;
+    Long64_t first;
+    Long64_t last;
+  };
+
+  std::vector<Range> ranges;
+  std::vector<TCompiledHistograms*> shards;
+  std::vector<TDirectory*> directories;
+  std::vector<std::thread> threads;
+
+  std::atomic_size_t next_range{0};
+  std::atomic_int running{0};
+  std::atomic_bool stop{false};
+};
+
 TChainLoop* TChainLoop::Get(std::string name,TChain *chain){
   if(name.length()==0){
     name = "chain_loop";
@@ -33,11 +61,16 @@ TChainLoop::TChainLoop(std::string name, TChain *chain)
     fEntriesRead(0), fEntriesTotal(chain->GetEntries()),
     input_chain(chain),
     output_queue(std::make_shared<ThreadsafeQueue<TUnpackedEvent*> >()),
-    fSelfStopping(true) {
+    fSelfStopping(true), fReplayThreads(1), histogram_loop(0),
+    fSelectBranches(false), fBranchesVersion(0), fSelectedAt(-1) {
   SetupChain();
 }
 
-TChainLoop::~TChainLoop() { }
+TChainLoop::~TChainLoop() {
+  if(replay) {
+    FinishReplay();
+  }
+}
 
 void TChainLoop::ClearQueue() {
   while(output_queue->Size()){
@@ -67,23 +100,37 @@ int TChainLoop::SetupChain() {
       }
     }
   }
+  read_map = det_map;
   return 0;
 }
 
 std::string TChainLoop::Status() {
+  if(fReplayThreads > 1 && histogram_loop) {
+    return Form("Event: %ld / %ld, %d replay threads", long(fEntriesRead), fEntriesTotal, fReplayThreads);
+  }
   return Form("Event: %ld / %ld", long(fEntriesRead), fEntriesTotal);
 }
 
 
 void TChainLoop::Restart() {
   fEntriesRead = 0;
+  if(fSelectedAt > 0) {
+    fSelectedAt = 0;
+  }
 }
 
 void TChainLoop::OnEnd() {
+  if(replay) {
+    FinishReplay();
+  }
   output_queue->SetFinished();
 }
 
 bool TChainLoop::Iteration() {
+  if(fReplayThreads > 1 && histogram_loop) {
+    return ReplayIteration();
+  }
+
   if(fEntriesRead >= fEntriesTotal){
     if(fSelfStopping) {
       return false;
@@ -93,13 +140,80 @@ bool TChainLoop::Iteration() {
     }
   }
 
-  for(auto& elem : det_map){
+  if(fSelectBranches && histogram_loop) {
+    TCompiledHistograms* histograms = histogram_loop->GetCompiledHistograms();
+    if(histograms->UsedBranchesVersion() != fBranchesVersion) {
+      fBranchesVersion = histograms->UsedBranchesVersion();
+      std::map<TClass*, TDetector**> selected = SelectBranches(input_chain, *histograms, det_map, true);
+      if(fSelectedAt < 0 && selected.size() < det_map.size()) {
+        fSelectedAt = fEntriesRead;
+      } else if(fSelectedAt >= 0) {
+        WarnLateBranches(read_map, selected, fEntriesRead - fSelectedAt);
+      }
+      read_map = selected;
+    }
+  }
+
+  for(auto& elem : read_map){
     *elem.second = (TDetector*)elem.first->New();
   }
   input_chain->GetEntry(fEntriesRead++);
 
+  output_queue->Push(CollectDetectors(read_map));
+  return true;
+}
+
+std::map<TClass*, TDetector**> TChainLoop::SelectBranches(TTree* tree, TCompiledHistograms& histograms,
+                                                          const std::map<TClass*, TDetector**>& detectors,
+                                                          bool verbose) {
+  std::vector<std::string> branches;
+  if(!histograms.GetUsedBranches(branches)) {
+    tree->SetBranchStatus("*", true);
+    return detectors;
+  }
+
+  // A detector is read if its branch, or any member of it, is used.
+  tree->SetBranchStatus("*", false);
+  std::map<TClass*, TDetector**> selected;
+  std::string names;
+  for(auto& elem : detectors) {
+    std::string name = elem.first->GetName();
+    for(auto& branch : branches) {
+      if(branch == name || branch.compare(0, name.length()+1, name + ".") == 0) {
+        tree->SetBranchStatus(branch.c_str(), true);
+        selected.insert(elem);
+        names += " " + branch;
+      }
+    }
+  }
+
+  if(verbose) {
+    std::cout << "Reading " << selected.size() << " of " << detectors.size()
+              << " detector branches:" << names << std::endl;
+  }
+  return selected;
+}
+
+void TChainLoop::WarnLateBranches(const std::map<TClass*, TDetector**>& before,
+                                  const std::map<TClass*, TDetector**>& after,
+                                  long missed) {
+  std::string names;
+  for(auto& elem : after) {
+    if(!before.count(elem.first)) {
+      names += std::string(" ") + elem.first->GetName();
+    }
+  }
+  if(names.length() && missed > 0) {
+    std::cerr << "Branches first used after " << missed << " entries were read without them:"
+              << names << "\n"
+              << "Those entries are missing from their histograms; set GRUT.BranchWarmUp to 0,"
+              << " or use --all-branches, to read every branch." << std::endl;
+  }
+}
+
+TUnpackedEvent* TChainLoop::CollectDetectors(const std::map<TClass*, TDetector**>& detectors) {
   TUnpackedEvent* event = new TUnpackedEvent;
-  for(auto& elem : det_map){
+  for(auto& elem : detectors){
     TDetector* det = *elem.second;
     if(!det->TestBit(TDetector::kUnbuilt)){
       event->AddDetector(det);
@@ -112,7 +226,165 @@ bool TChainLoop::Iteration() {
       delete det;
     }
   }
+  return event;
+}
 
-  output_queue->Push(event);
-  return true;
+/*******************************************************************************/
+/* Replay mode *****************************************************************/
+/*******************************************************************************/
+
+bool TChainLoop::ReplayIteration() {
+  if(!replay && fEntriesRead < fEntriesTotal) {
+    StartReplay();
+  }
+
+  if(replay && replay->running > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return true;
+  }
+
+  if(replay) {
+    FinishReplay();
+    fEntriesRead = fEntriesTotal;
+  }
+
+  if(fSelfStopping) {
+    return false;
+  } else {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    return true;
+  }
+}
+
+void TChainLoop::StartReplay() {
+  ROOT::EnableThreadSafety();
+  replay.reset(new Replay);
+
+  // The clusters are the smallest ranges that can be read without
+  // decompressing any basket twice.
+  TObjArray* files = input_chain->GetListOfFiles();
+  for(int i=0; i<files->GetEntriesFast(); i++) {
+    TObject* element = files->At(i);
+    TPreserveGDirectory preserve;
+    std::unique_ptr<TFile> file(TFile::Open(element->GetTitle()));
+    TTree* tree = file ? (TTree*)file->Get(element->GetName()) : 0;
+    if(!tree) {
+      std::cerr << "Could not read " << element->GetName() << " from "
+                << element->GetTitle() << std::endl;
+      continue;
+    }
+
+    Long64_t nentries = tree->GetEntries();
+    TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+    Long64_t first;
+    while((first = clusters()) < nentries) {
+      Long64_t last = std::min(clusters.GetNextEntry(), nentries);
+      replay->ranges.push_back({element->GetTitle(), element->GetName(), first, last});
+    }
+  }
+
+  size_t nthreads = std::min(size_t(fReplayThreads), replay->ranges.size());
+  for(size_t i=0; i<nthreads; i++) {
+    TDirectory* dir = new TDirectory(Form("%s_shard%d", Name().c_str(), int(i)), "replay shard", "", gROOT);
+    replay->directories.push_back(dir);
+    replay->shards.push_back(histogram_loop->MakeShard(dir));
+  }
+
+  replay->running = nthreads;
+  for(size_t i=0; i<nthreads; i++) {
+    replay->threads.emplace_back(&TChainLoop::ReplayRanges, this, i);
+  }
+}
+
+void TChainLoop::ReplayRanges(size_t ishard) {
+  TCompiledHistograms& shard = *replay->shards[ishard];
+
+  // Same classes as the chain, but branch addresses of this thread.
+  std::map<TClass*, std::unique_ptr<TDetector*> > addresses;
+  for(auto& elem : det_map) {
+    addresses[elem.first].reset(new TDetector*(0));
+  }
+
+  std::unique_ptr<TFile> file;
+  TTree* tree = 0;
+  std::string filename;
+  std::map<TClass*, TDetector**> present;
+  std::map<TClass*, TDetector**> detectors;
+  size_t version = 0;
+  size_t printed = 0;
+  long read = 0;
+  long selected_at = -1;
+
+  while(!replay->stop) {
+    size_t irange = replay->next_range++;
+    if(irange >= replay->ranges.size()) {
+      break;
+    }
+    const Replay::Range& range = replay->ranges[irange];
+
+    if(range.filename != filename) {
+      TPreserveGDirectory preserve;
+      present.clear();
+      file.reset(TFile::Open(range.filename.c_str()));
+      tree = file ? (TTree*)file->Get(range.treename.c_str()) : 0;
+      filename = range.filename;
+      if(tree) {
+        for(auto& elem : addresses) {
+          const char* name = elem.first->GetName();
+          if(tree->GetBranch(name)) {
+            tree->SetBranchAddress(name, elem.second.get());
+            present[elem.first] = elem.second.get();
+          }
+        }
+      }
+      detectors = present;
+      version = 0;
+    }
+    if(!tree) {
+      continue;
+    }
+
+    if(fSelectBranches && shard.UsedBranchesVersion() != version) {
+      version = shard.UsedBranchesVersion();
+      std::map<TClass*, TDetector**> selected =
+        SelectBranches(tree, shard, present, ishard==0 && version!=printed);
+      if(selected_at < 0 && selected.size() < present.size()) {
+        selected_at = read;
+      } else if(selected_at >= 0) {
+        WarnLateBranches(detectors, selected, read - selected_at);
+      }
+      detectors = selected;
+      printed = version;
+    }
+
+    for(Long64_t entry = range.first; entry < range.last && !replay->stop; entry++) {
+      for(auto& elem : detectors) {
+        *elem.second = (TDetector*)elem.first->New();
+      }
+      tree->GetEntry(entry);
+
+      TUnpackedEvent* event = CollectDetectors(detectors);
+      shard.Fill(*event);
+      delete event;
+      fEntriesRead++;
+      read++;
+    }
+  }
+
+  file.reset();
+  replay->running--;
+}
+
+void TChainLoop::FinishReplay() {
+  replay->stop = true;
+  for(auto& thread : replay->threads) {
+    thread.join();
+  }
+
+  for(size_t i=0; i<replay->shards.size(); i++) {
+    histogram_loop->MergeShard(*replay->shards[i]);
+    delete replay->shards[i];
+    delete replay->directories[i];
+  }
+  replay.reset();
 }
@@ -50,6 +50,10 @@ bool TFilterLoop::Iteration() {
     HandleEvent(event);
     return true;
   } else if(input_queue->IsFinished()) {
+    if(filtered_output) {
+      // Waits for the writer thread, so the file is complete once the loop ends.
+      filtered_output->Close();
+    }
     output_queue->SetFinished();
     return false;
   } else {
@@ -59,6 +63,18 @@ bool TFilterLoop::Iteration() {
 }
 
 void TFilterLoop::HandleEvent(TUnpackedEvent* event) {
+  // Events may come in not yet unpacked; those the pre-filter rejects never are.
+  if(!compiled_filter.MatchesPreCondition(*event)) {
+    delete event;
+    return;
+  }
+
+  event->Build();
+  if(event->GetDetectors().size() == 0) {
+    delete event;
+    return;
+  }
+
   if(compiled_filter.MatchesCondition(*event)) {
     if(filtered_output) {
       filtered_output->Write(*event);
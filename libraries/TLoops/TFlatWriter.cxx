@@ -0,0 +1,117 @@
+#include "TFlatWriter.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "TBranch.h"
+#include "TEnv.h"
+#include "TTree.h"
+#include "TVector3.h"
+
+#include "TGretina.h"
+#include "TS800.h"
+#include "TUnpackedEvent.h"
+
+TFlatWriter::TFlatWriter(int basket_size, int compression)
+  : fBasketSize(basket_size), fCompression(compression) {
+  fEvents      = new TTree("FlatEvents","FlatEvents");
+  fGretinaHits = new TTree("FlatGretinaHits","FlatGretinaHits");
+
+  Column(fEvents, "event",          &fEventRow.event,          'L');
+  Column(fEvents, "timestamp",      &fEventRow.timestamp,      'L');
+  Column(fEvents, "gretina_n",      &fEventRow.gretina_n,      'I');
+  Column(fEvents, "s800",           &fEventRow.s800,           'I');
+  Column(fEvents, "s800_timestamp", &fEventRow.s800_timestamp, 'L');
+  Column(fEvents, "ata",            &fEventRow.ata,            'F');
+  Column(fEvents, "bta",            &fEventRow.bta,            'F');
+  Column(fEvents, "dta",            &fEventRow.dta,            'F');
+  Column(fEvents, "yta",            &fEventRow.yta,            'F');
+  Column(fEvents, "xfp0",           &fEventRow.xfp0,           'F');
+  Column(fEvents, "xfp1",           &fEventRow.xfp1,           'F');
+  Column(fEvents, "yfp0",           &fEventRow.yfp0,           'F');
+  Column(fEvents, "yfp1",           &fEventRow.yfp1,           'F');
+  Column(fEvents, "afp",            &fEventRow.afp,            'F');
+  Column(fEvents, "bfp",            &fEventRow.bfp,            'F');
+
+  Column(fGretinaHits, "event",       &fGretinaRow.event,       'L');
+  Column(fGretinaHits, "timestamp",   &fGretinaRow.timestamp,   'L');
+  Column(fGretinaHits, "crystal_id",  &fGretinaRow.crystal_id,  'I');
+  Column(fGretinaHits, "core_energy", &fGretinaRow.core_energy, 'F');
+  Column(fGretinaHits, "x",           &fGretinaRow.x,           'F');
+  Column(fGretinaHits, "y",           &fGretinaRow.y,           'F');
+  Column(fGretinaHits, "z",           &fGretinaRow.z,           'F');
+  Column(fGretinaHits, "time",        &fGretinaRow.time,        'D');
+}
+
+void TFlatWriter::Column(TTree* tree, const char* name, void* address, char type) {
+  // Same .rootrc keys as the EventTree branches, by table name.
+  int basket_size = gEnv->GetValue(Form("GRUT.BasketSize.%s", tree->GetName()), fBasketSize);
+  int compression = gEnv->GetValue(Form("GRUT.Compression.%s", tree->GetName()), fCompression);
+
+  std::string leaflist = std::string(name) + "/" + type;
+  TBranch* branch = (basket_size > 0)
+    ? tree->Branch(name, address, leaflist.c_str(), basket_size)
+    : tree->Branch(name, address, leaflist.c_str());
+  if(compression >= 0) {
+    branch->SetCompressionSettings(compression);
+  }
+}
+
+Long64_t TFlatWriter::Fill(TUnpackedEvent& event, Long64_t index) {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  Long64_t bytes = 0;
+
+  fEventRow.event     = index;
+  fEventRow.timestamp = -1;
+  for(auto det : event.GetDetectors()) {
+    if(det->Timestamp() > 0 && (fEventRow.timestamp < 0 || det->Timestamp() < fEventRow.timestamp)) {
+      fEventRow.timestamp = det->Timestamp();
+    }
+  }
+
+  TGretina* gretina = event.GetDetector<TGretina>();
+  fEventRow.gretina_n = gretina ? gretina->Size() : 0;
+  for(int i=0; i<fEventRow.gretina_n; i++) {
+    const TGretinaHit& hit = gretina->GetGretinaHit(i);
+    TVector3 pos = hit.GetPosition();
+    fGretinaRow.event       = index;
+    fGretinaRow.timestamp   = hit.Timestamp();
+    fGretinaRow.crystal_id  = hit.GetCrystalId();
+    fGretinaRow.core_energy = hit.GetCoreEnergy();
+    fGretinaRow.x           = pos.X();
+    fGretinaRow.y           = pos.Y();
+    fGretinaRow.z           = pos.Z();
+    fGretinaRow.time        = hit.GetTime();
+    bytes += fGretinaHits->Fill();
+  }
+
+  TS800* s800 = event.GetDetector<TS800>();
+  fEventRow.s800 = s800 ? 1 : 0;
+  if(s800) {
+    fEventRow.s800_timestamp = s800->Timestamp();
+    fEventRow.ata  = s800->GetAta();
+    fEventRow.bta  = s800->GetBta();
+    fEventRow.dta  = s800->GetDta();
+    fEventRow.yta  = s800->GetYta();
+    fEventRow.xfp0 = s800->GetXFP(0);
+    fEventRow.xfp1 = s800->GetXFP(1);
+    fEventRow.yfp0 = s800->GetYFP(0);
+    fEventRow.yfp1 = s800->GetYFP(1);
+    fEventRow.afp  = s800->GetAFP();
+    fEventRow.bfp  = s800->GetBFP();
+  } else {
+    fEventRow.s800_timestamp = -1;
+    fEventRow.ata  = fEventRow.bta  = fEventRow.dta  = fEventRow.yta  = nan;
+    fEventRow.xfp0 = fEventRow.xfp1 = fEventRow.yfp0 = fEventRow.yfp1 = nan;
+    fEventRow.afp  = fEventRow.bfp  = nan;
+  }
+  bytes += fEvents->Fill();
+
+  return bytes;
+}
+
+void TFlatWriter::Write() {
+  fEvents->Write(fEvents->GetName(), TObject::kOverwrite);
+  fGretinaHits->Write(fGretinaHits->GetName(), TObject::kOverwrite);
+}
@@ -0,0 +1,90 @@
+#include "TMetricsServer.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "StoppableThread.h"
+
+namespace {
+  std::thread server_thread;
+  std::atomic_bool serving(false);
+  std::string socket_path;
+}
+
+bool TMetricsServer::Start(const std::string& path) {
+  Stop();
+
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(path.length() >= sizeof(address.sun_path)) {
+    std::cerr << "Metrics socket path is too long: " << path << std::endl;
+    return false;
+  }
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if(listen_fd < 0) {
+    std::cerr << "Could not create metrics socket: " << strerror(errno) << std::endl;
+    return false;
+  }
+  unlink(path.c_str());
+  if(bind(listen_fd, (sockaddr*)&address, sizeof(address)) < 0 ||
+     listen(listen_fd, 8) < 0) {
+    std::cerr << "Could not listen on " << path << ": " << strerror(errno) << std::endl;
+    close(listen_fd);
+    return false;
+  }
+
+  socket_path = path;
+  serving = true;
+  server_thread = std::thread(&TMetricsServer::Serve, listen_fd);
+  return true;
+}
+
+void TMetricsServer::Stop() {
+  if(server_thread.joinable()) {
+    serving = false;
+    server_thread.join();
+    unlink(socket_path.c_str());
+  }
+}
+
+bool TMetricsServer::IsRunning() {
+  return serving;
+}
+
+void TMetricsServer::Serve(int listen_fd) {
+  while(serving) {
+    // Wakes up now and then to see whether it has been stopped.
+    pollfd pfd = { listen_fd, POLLIN, 0 };
+    if(poll(&pfd, 1, 250) <= 0) {
+      continue;
+    }
+
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if(fd < 0) {
+      continue;
+    }
+    std::string json = StoppableThread::MetricsJson() + "\n";
+    const char* data = json.c_str();
+    size_t remaining = json.length();
+    while(remaining) {
+      ssize_t written = send(fd, data, remaining, MSG_NOSIGNAL);
+      if(written <= 0) {
+        break;
+      }
+      data += written;
+      remaining -= written;
+    }
+    close(fd);
+  }
+  close(listen_fd);
+}
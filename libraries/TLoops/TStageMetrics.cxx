@@ -0,0 +1,115 @@
+#include "TStageMetrics.h"
+
+#include <sstream>
+
+namespace {
+  int64_t SteadyNanoseconds(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+  }
+}
+
+TStageMetrics::TStageMetrics()
+  : waited_ns(0), moved_item(false),
+    first_ns(-1), last_ns(-1),
+    events(0), items_in(0), items_out(0),
+    busy_ns(0), idle_ns(0), pop_wait_ns(0), push_wait_ns(0) {
+  for(auto& bin : latency) {
+    bin = 0;
+  }
+}
+
+void TStageMetrics::BeginIteration() {
+  iteration_start = std::chrono::steady_clock::now();
+  if(first_ns < 0) {
+    first_ns = SteadyNanoseconds(iteration_start);
+  }
+  waited_ns = 0;
+  moved_item = false;
+}
+
+void TStageMetrics::EndIteration() {
+  auto now = std::chrono::steady_clock::now();
+  int64_t length = std::chrono::duration_cast<std::chrono::nanoseconds>(now - iteration_start).count();
+  uint64_t working = (uint64_t(length) > waited_ns) ? length - waited_ns : 0;
+
+  if(moved_item) {
+    int bin = 0;
+    while(bin < kLatencyBins-1 && (uint64_t(1) << bin) < working) {
+      bin++;
+    }
+    latency[bin]++;
+    busy_ns += working;
+    events++;
+  } else {
+    idle_ns += working;
+  }
+  last_ns = SteadyNanoseconds(now);
+}
+
+TStageMetrics::Snapshot TStageMetrics::Get() const {
+  Snapshot snap;
+  snap.events            = events;
+  snap.items_in          = items_in;
+  snap.items_out         = items_out;
+  snap.busy_seconds      = 1e-9*busy_ns;
+  snap.idle_seconds      = 1e-9*idle_ns;
+  snap.pop_wait_seconds  = 1e-9*pop_wait_ns;
+  snap.push_wait_seconds = 1e-9*push_wait_ns;
+  int64_t first = first_ns;
+  int64_t last = last_ns;
+  snap.elapsed_seconds = (first >= 0 && last > first) ? 1e-9*(last - first) : 0;
+  for(int i=0; i<kLatencyBins; i++) {
+    snap.latency[i] = latency[i];
+  }
+  return snap;
+}
+
+double TStageMetrics::Snapshot::LatencyQuantile(double q) const {
+  uint64_t total = 0;
+  for(auto count : latency) {
+    total += count;
+  }
+  if(total == 0) {
+    return 0;
+  }
+
+  uint64_t sum = 0;
+  for(int i=0; i<kLatencyBins; i++) {
+    sum += latency[i];
+    if(sum >= q*total) {
+      return 1e-9*LatencyBinEdge(i);
+    }
+  }
+  return 1e-9*LatencyBinEdge(kLatencyBins-1);
+}
+
+std::string TStageMetrics::Json(const Snapshot& snap) {
+  std::stringstream ss;
+  ss << "\"events\": "              << snap.events
+     << ", \"items_in\": "          << snap.items_in
+     << ", \"items_out\": "         << snap.items_out
+     << ", \"events_per_second\": " << snap.EventsPerSecond()
+     << ", \"elapsed_seconds\": "   << snap.elapsed_seconds
+     << ", \"busy_seconds\": "      << snap.busy_seconds
+     << ", \"idle_seconds\": "      << snap.idle_seconds
+     << ", \"pop_wait_seconds\": "  << snap.pop_wait_seconds
+     << ", \"push_wait_seconds\": " << snap.push_wait_seconds
+     << ", \"busy_fraction\": "     << snap.BusyFraction()
+     << ", \"latency_seconds\": {"
+     << "\"p50\": "   << snap.LatencyQuantile(0.5)
+     << ", \"p90\": " << snap.LatencyQuantile(0.9)
+     << ", \"p99\": " << snap.LatencyQuantile(0.99)
+     << "}";
+
+  // Only the filled bins, as [upper edge in ns, count].
+  ss << ", \"latency_histogram_ns\": [";
+  bool first = true;
+  for(int i=0; i<kLatencyBins; i++) {
+    if(snap.latency[i]) {
+      ss << (first ? "" : ", ") << "[" << uint64_t(LatencyBinEdge(i)) << ", " << snap.latency[i] << "]";
+      first = false;
+    }
+  }
+  ss << "]";
+  return ss.str();
+}
@@ -1,6 +1,7 @@
 #include "TUnpackedEvent.h"
 
 #include "TClass.h"
+#include "TBuildProfile.h"
 #include "TBank88.h"
 #include "TCaesar.h"
 #include "TGretina.h"
@@ -15,7 +16,8 @@
 #include "TFastScint.h"
 #include "TLenda.h"
 
-TUnpackedEvent::TUnpackedEvent() { }
+TUnpackedEvent::TUnpackedEvent()
+  : run_start(0), has_run_start(false) { }
 
 TUnpackedEvent::~TUnpackedEvent() {
   for(auto det : detectors) {
@@ -25,13 +27,57 @@ TUnpackedEvent::~TUnpackedEvent() {
 
 void TUnpackedEvent::Build() {
   for(auto& item : raw_data_map) {
-    kDetectorSystems detector = item.first;
-    std::vector<TRawEvent>& raw_data = item.second;
-//    printf("det %s\n",GetDetector(detector, true)->Class()->GetName());
-    GetDetector(detector, true)->Build(raw_data);
+    if(!built_systems.count(item.first)) {
+      BuildSystem(item.first);
+    }
   }
 }
 
+TDetector* TUnpackedEvent::BuildSystem(kDetectorSystems detector) {
+  built_systems.insert(detector);
+  TDetector* det = GetDetector(detector, true);
+  if(det) {
+    std::vector<TRawEvent>& raw_data = raw_data_map[detector];
+    size_t bytes = 0;
+    for(auto& raw_event : raw_data) {
+      bytes += raw_event.GetTotalSize();
+    }
+    size_t hits_before = det->Size();
+
+    unsigned long long start = TBuildProfile::Start(detector);
+    det->Build(raw_data);
+    TBuildProfile::Stop(detector, start, raw_data.size(), bytes, det->Size() - hits_before);
+
+    if(has_run_start) {
+      det->SetRunStart(run_start);
+    }
+  }
+  return det;
+}
+
+TDetector* TUnpackedEvent::BuildDetector(TClass* cls) {
+  TDetector* output = NULL;
+  for(auto& item : raw_data_map) {
+    if(built_systems.count(item.first)) {
+      continue;
+    }
+    auto factory = detector_factory_map.find(item.first);
+    if(factory != detector_factory_map.end() && factory->second &&
+       factory->second->get_class()->InheritsFrom(cls)) {
+      TDetector* det = BuildSystem(item.first);
+      if(!output) {
+        output = det;
+      }
+    }
+  }
+  return output;
+}
+
+size_t TUnpackedEvent::GetFragmentCount(kDetectorSystems system) const {
+  auto it = raw_data_map.find(system);
+  return (it == raw_data_map.end()) ? 0 : it->second.size();
+}
+
 void TUnpackedEvent::AddRawData(const TRawEvent& event, kDetectorSystems detector) {
   raw_data_map[detector].push_back(event);
 }
@@ -41,6 +87,8 @@ void TUnpackedEvent::ClearRawData() {
 }
 
 void TUnpackedEvent::SetRunStart(unsigned int unix_time){
+  run_start = unix_time;
+  has_run_start = true;
   for(auto det : detectors){
     det->SetRunStart(unix_time);
   }
@@ -13,9 +13,6 @@
 #include "TDetectorEnv.h"
 #include "TUnpackedEvent.h"
 
-#include "chrono"
-using namespace std::chrono;
-
 //#include "TMode3.h"
 
 ClassImp(TUnpackingLoop)
@@ -33,15 +30,13 @@ TUnpackingLoop *TUnpackingLoop::Get(std::string name) {
 
 TUnpackingLoop::TUnpackingLoop(std::string name)
   : StoppableThread(name),
-    fOutputEvent(NULL), fRunStart(0),
+    fOutputEvent(NULL), fRunStart(0), fDeferBuild(false),
     input_queue(std::make_shared<ThreadsafeQueue<std::vector<TRawEvent> > >()),
     output_queue(std::make_shared<ThreadsafeQueue<TUnpackedEvent*> >()) { }
 
 TUnpackingLoop::~TUnpackingLoop() { }
 
 bool TUnpackingLoop::Iteration(){
-//  auto start = high_resolution_clock::now();
-
   std::vector<TRawEvent> event;
   int error = input_queue->Pop(event);
   if(error < 0){
@@ -81,10 +76,14 @@ bool TUnpackingLoop::Iteration(){
     }
   }
 
-//  auto stop = high_resolution_clock::now();
-//  auto duration = duration_cast<nanoseconds>(stop - start);
-//  std::cout << event.size() << " Time taken in Build " << duration.count() << " microseconds" << std::endl;
-//  auto start = high_resolution_clock::now();
+  if(fDeferBuild) {
+    fOutputEvent->SetRunStart(fRunStart);
+    if(fOutputEvent->GetRawData().size() != 0){
+      output_queue->Push(fOutputEvent);
+      fOutputEvent = NULL;
+    }
+    return true;
+  }
 
   fOutputEvent->Build();
   fOutputEvent->SetRunStart(fRunStart);
@@ -93,9 +92,6 @@ bool TUnpackingLoop::Iteration(){
     output_queue->Push(fOutputEvent);
     fOutputEvent = NULL;
   }
-//  auto stop2 = high_resolution_clock::now();
-//  auto duration2 = duration_cast<nanoseconds>(stop2 - start);
-//  std::cout << "Time taken in Detector " << duration2.count() << " microseconds" << std::endl;
 
   return true;
 }
@@ -117,8 +113,6 @@ void TUnpackingLoop::ClearQueue() {
 }
 
 void TUnpackingLoop::HandleNSCLData(TNSCLEvent& event) {
-//  auto start = high_resolution_clock::now();
-
   //printf("in handle nscl\t%i\n",event.GetEventType()); fflush(stdout);
   switch(event.GetEventType()) {
     case kNSCLEventType::BEGIN_RUN:            // 0x0001
@@ -153,14 +147,10 @@ void TUnpackingLoop::HandleNSCLData(TNSCLEvent& event) {
 */
       break;
   }
-//  auto stop = high_resolution_clock::now();
-//  auto duration = duration_cast<nanoseconds>(stop - start);
-//  std::cout << "Time taken in NSCL " << duration.count() << " microseconds" << std::endl;
 }
 
 
 void TUnpackingLoop::HandleBuiltNSCLData(TNSCLEvent& event){
-//  auto start = high_resolution_clock::now();
   TNSCLBuiltRingItem built(event);
 
   //printf("i am being called!!!\n"); fflush(stdout);
@@ -170,11 +160,7 @@ void TUnpackingLoop::HandleBuiltNSCLData(TNSCLEvent& event){
     TNSCLFragment& fragment = built.GetFragment(i);
 
     int source_id = fragment.GetFragmentSourceID();
-//  auto start = high_resolution_clock::now();
     kDetectorSystems detector = TDetectorEnv::Get().DetermineSystem(source_id);
-//  auto stop = high_resolution_clock::now();
-//  auto duration = duration_cast<nanoseconds>(stop - start);
-//  std::cout << built.NumFragments() << " Time in Built " << duration.count() << " nanoseconds" << std::endl;
 
 
     TRawEvent frag_event = fragment.GetNSCLEvent();
@@ -187,9 +173,6 @@ void TUnpackingLoop::HandleBuiltNSCLData(TNSCLEvent& event){
 //    fOutputEvent->AddRawData(frag_event, kDetectorSystems::SEGA);
     fOutputEvent->AddRawData(frag_event, detector);
   }
-//  auto stop = high_resolution_clock::now();
-//  auto duration = duration_cast<nanoseconds>(stop - start);
-//  std::cout << built.NumFragments() << " Time in Built " << duration.count() << " nanoseconds" << std::endl;
 
 }
 
@@ -1,14 +1,208 @@
 #include "TWriteLoop.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
 #include <thread>
 
+#include "RVersion.h"
+#include "TEnv.h"
 #include "TFile.h"
+#include "TROOT.h"
 #include "TThread.h"
+#include "ROOT/TBufferMerger.hxx"
 
 #include "GValue.h"
 #include "TChannel.h"
+#include "TDetectorEnv.h"
+#include "TFlatWriter.h"
+#include "TGRUTTypes.h"
 #include "THistogramLoop.h"
+#include "TPreserveGDirectory.h"
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,26,0)
+typedef ROOT::TBufferMerger               GBufferMerger;
+typedef ROOT::TBufferMergerFile           GBufferMergerFile;
+#else
+typedef ROOT::Experimental::TBufferMerger     GBufferMerger;
+typedef ROOT::Experimental::TBufferMergerFile GBufferMergerFile;
+#endif
+
+/*******************************************************************************/
+/* One tree, with one branch per detector class ********************************/
+/*******************************************************************************/
+struct TWriteLoop::TreeFiller {
+  // Either may be null, depending on the tree format.
+  TreeFiller(TTree* tree, TFlatWriter* flat) : tree(tree), flat(flat), bytes_filled(0) { }
+
+  ~TreeFiller() {
+    for(auto& elem : det_map) {
+      delete elem.second;
+    }
+    for(auto& elem : default_dets) {
+      delete elem.second;
+    }
+  }
+
+  void AddBranch(TClass* cls, const TWriteLoop& loop) {
+    if(!tree) {
+      return;
+    }
+
+    // This uses the ROOT dictionaries, so we need to lock the threads.
+    TThread::Lock();
+
+    // Make a default detector of that type.
+    TDetector* det_p = (TDetector*)cls->New();
+    default_dets[cls] = det_p;
+
+    // Make the TDetector**
+    TDetector** det_pp = new TDetector*;
+    *det_pp = det_p;
+    det_map[cls] = det_pp;
+
+    // Make a new branch.
+    int basket_size = gEnv->GetValue(Form("GRUT.BasketSize.%s", cls->GetName()), loop.fBasketSize);
+    int compression = gEnv->GetValue(Form("GRUT.Compression.%s", cls->GetName()), loop.fCompression);
+    TBranch* new_branch = (basket_size > 0)
+      ? tree->Branch(cls->GetName(), cls->GetName(), det_pp, basket_size)
+      : tree->Branch(cls->GetName(), cls->GetName(), det_pp);
+    if(compression >= 0) {
+      new_branch->SetCompressionSettings(compression);
+    }
+
+    // Fill the new branch up to the point where the tree is filled.
+    // Explanation:
+    //   When TTree::Fill is called, it calls TBranch::Fill for each
+    // branch, then increments the number of entries.  We may be
+    // adding branches after other branches have already been filled.
+    // If the S800 branch has been filled 100 times before the Gretina
+    // branch is created, then the next call to TTree::Fill will fill
+    // entry 101 of S800, but entry 1 of Gretina, rather than entry
+    // 101 of both.
+    //   Therefore, we need to fill the new branch as many times as
+    // TTree::Fill has been called before.
+    for(int i=0; i<tree->GetEntries(); i++){
+      new_branch->Fill();
+    }
+
+    // Unlock after we are done.
+    TThread::UnLock();
+  }
+
+  void Fill(TUnpackedEvent& event, Long64_t index) {
+    if(flat) {
+      bytes_filled += flat->Fill(event, index);
+    }
+    if(!tree) {
+      return;
+    }
+
+    // Clear pointers from previous writes.
+    // Note that we cannot just set this equal to NULL,
+    //   because ROOT would then construct a new object.
+    // This contradicts the ROOT documentation for TBranchElement::SetAddress,
+    //   which suggests that a new object would be constructed only when setting the address,
+    //   not when filling the TTree.
+    for(auto& elem : det_map){
+      *elem.second = default_dets[elem.first];
+    }
+
+    // Load current events.  A class without a branch is left out, which
+    //   only happens with write threads, once a tree has been merged.
+    for(auto det : event.GetDetectors()) {
+      auto branch = det_map.find(det->IsA());
+      if(branch == det_map.end()) {
+        continue;
+      }
+      det->MaterializeTraces();
+      *branch->second = det;
+    }
+
+    // Fill
+    int bytes = tree->Fill();
+    if(bytes > 0) {
+      bytes_filled += bytes;
+    }
+  }
+
+  void Write() {
+    if(tree) {
+      tree->Write(tree->GetName(), TObject::kOverwrite);
+    }
+    if(flat) {
+      flat->Write();
+    }
+  }
+
+  Long64_t ZipBytes() const {
+    Long64_t bytes = 0;
+    if(tree) {
+      bytes += tree->GetZipBytes();
+    }
+    if(flat) {
+      bytes += flat->GetEventTable()->GetZipBytes() + flat->GetGretinaTable()->GetZipBytes();
+    }
+    return bytes;
+  }
+
+  TTree* tree;
+  std::unique_ptr<TFlatWriter> flat;
+  std::map<TClass*, TDetector**> det_map;
+  std::map<TClass*, TDetector*> default_dets;
+  std::atomic<long long> bytes_filled;
+};
+
+/*******************************************************************************/
+/* Write threads, each filling a tree in its own TBufferMerger file ************/
+/*******************************************************************************/
+struct TWriteLoop::Parallel {
+  struct Task {
+    TUnpackedEvent* event;
+    Long64_t index;
+    bool written;
+  };
+
+  Parallel() : stopping(false), flushed(false), dropped(0) { }
+
+  std::unique_ptr<GBufferMerger> merger;
+  std::vector<std::shared_ptr<GBufferMergerFile> > files;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable can_work;
+  std::condition_variable task_written;
+  std::deque<Task*> todo;      // Guarded by mutex.
+  bool stopping;               // Guarded by mutex.
+
+  // Set once any tree has been sent to be merged.  From then on a branch
+  //   cannot be added, since the merged tree would not have it for the
+  //   entries already merged.
+  std::atomic<bool> flushed;
+  // Classes that showed up after the first merge, and are left out of
+  //   EventTree, and the number of events they were in.
+  std::vector<TClass*> left_out;
+  size_t dropped;
+
+  // Every task handed out and not yet passed on, in the order the events came in.
+  // Only used by the loop thread.
+  std::deque<Task*> pending;
+};
+
+namespace {
+  // Tasks waiting to be passed on, per write thread, before the loop thread waits.
+  const size_t max_pending_per_thread = 1000;
+  // Bytes compressed into a TBufferMerger file before it is sent to be merged,
+  //   when the auto-flush is not given in bytes.
+  const long long default_bytes_per_merge = 30000000;
+}
 
 TWriteLoop* TWriteLoop::Get(std::string name, std::string output_filename){
   if(name.length()==0){
@@ -28,31 +222,51 @@ TWriteLoop* TWriteLoop::Get(std::string name, std::string output_filename){
 
 TWriteLoop::TWriteLoop(std::string name, std::string output_filename)
   : StoppableThread(name),
+    output_filename(output_filename),
     output_file(NULL), event_tree(NULL),
+    fObjectTree(true), fFlatTables(false),
+    fWriteThreads(1), fBasketSize(0), fCompression(-1), fAutoFlush(0),
+    fIsSetup(false),
     items_handled(0),
     input_queue(std::make_shared<ThreadsafeQueue<TUnpackedEvent*> >()),
-    output_queue(std::make_shared<ThreadsafeQueue<TUnpackedEvent*> >()) {
-
-  if(output_filename != "/dev/null"){
-    //TPreserveGDirectory preserve;
-    output_file = new TFile(output_filename.c_str(),"RECREATE");
-    event_tree = new TTree("EventTree","EventTree");
-    //scaler_tree = new TTree("ScalerTree","ScalerTree");
-  }
-}
+    output_queue(std::make_shared<ThreadsafeQueue<TUnpackedEvent*> >()) { }
 
 TWriteLoop::~TWriteLoop() {
-  for(auto& elem : det_map) {
-    delete elem.second;
-  }
+  // Make the file even if no event came through.
+  Setup();
+  double bytes_filled = GetBytesFilled();
+
+  if(parallel){
+    StopWriteThreads();
+    PassOnWritten(true);
+    fillers.clear();
 
-  for(auto& elem : default_dets) {
-    delete elem.second;
+    if(GValue::Size() || TChannel::Size()) {
+      std::shared_ptr<GBufferMergerFile> file = parallel->merger->GetFile();
+      TPreserveGDirectory preserve;
+      file->cd();
+      if(GValue::Size())
+        GValue::Get()->Write();
+      if(TChannel::Size())
+        TChannel::Get()->Write();
+      file->Write();
+    }
+    if(parallel->dropped) {
+      std::cerr << Name() << ": " << parallel->dropped << " events had detectors left out of EventTree"
+                << std::endl;
+    }
+    // The last merge happens when the merger goes.
+    parallel.reset();
+    PrintSummary(bytes_filled);
+    return;
   }
 
   if(output_file){
     output_file->cd();
-    event_tree->Write(event_tree->GetName(), TObject::kOverwrite);
+    for(auto& filler : fillers) {
+      filler->Write();
+    }
+    fillers.clear();
     if(GValue::Size())
       GValue::Get()->Write();
     if(TChannel::Size())
@@ -60,7 +274,180 @@ TWriteLoop::~TWriteLoop() {
 
     output_file->Close();
     output_file->Delete();
+    PrintSummary(bytes_filled);
+  }
+  fillers.clear();
+}
+
+void TWriteLoop::SetTreeFormat(bool object_tree, bool flat_tables) {
+  if(fIsSetup) {
+    std::cerr << Name() << ": the tree format must be set before the first event" << std::endl;
+    return;
+  }
+  fObjectTree = object_tree;
+  fFlatTables = flat_tables;
+}
+
+void TWriteLoop::SetWriteThreads(int nthreads) {
+  if(fIsSetup) {
+    std::cerr << Name() << ": write threads must be set before the first event" << std::endl;
+    return;
+  }
+  fWriteThreads = std::max(1, nthreads);
+}
+
+/*******************************************************************************/
+/* Opens the output and declares the branches, before the first event *********/
+/*******************************************************************************/
+void TWriteLoop::Setup() {
+  if(fIsSetup) {
+    return;
+  }
+  fIsSetup = true;
+  start_time = std::chrono::steady_clock::now();
+
+  if(output_filename == "/dev/null"){
+    return;
+  }
+
+  if(fWriteThreads > 1) {
+    ROOT::EnableThreadSafety();
+    parallel.reset(new Parallel);
+    if(fCompression >= 0) {
+      parallel->merger.reset(new GBufferMerger(output_filename.c_str(), "RECREATE", fCompression));
+    } else {
+      parallel->merger.reset(new GBufferMerger(output_filename.c_str(), "RECREATE"));
+    }
+    for(int i=0; i<fWriteThreads; i++) {
+      std::shared_ptr<GBufferMergerFile> file = parallel->merger->GetFile();
+      TPreserveGDirectory preserve;
+      file->cd();
+      parallel->files.push_back(file);
+      fillers.emplace_back(NewFiller());
+    }
+  } else {
+    TPreserveGDirectory preserve;
+    output_file = new TFile(output_filename.c_str(),"RECREATE");
+    if(fCompression >= 0) {
+      output_file->SetCompressionSettings(fCompression);
+    }
+    fillers.emplace_back(NewFiller());
+    event_tree = fillers.back()->tree;
+  }
+
+  DeclareBranches();
+
+  if(parallel) {
+    long long bytes_per_merge = fAutoFlush < 0 ? -fAutoFlush : default_bytes_per_merge;
+    for(int i=0; i<fWriteThreads; i++) {
+      parallel->threads.emplace_back([this, i, bytes_per_merge]() {
+          Parallel& par = *parallel;
+          TreeFiller& filler = *fillers[i];
+          GBufferMergerFile& file = *par.files[i];
+          Long64_t entries = 0;
+          while(true) {
+            Parallel::Task* task = NULL;
+            {
+              std::unique_lock<std::mutex> lock(par.mutex);
+              par.can_work.wait(lock, [&par]() { return par.stopping || !par.todo.empty(); });
+              if(par.todo.empty()) {
+                break;
+              }
+              task = par.todo.front();
+              par.todo.pop_front();
+            }
+
+            filler.Fill(*task->event, task->index);
+            entries++;
+            // Sending the file resets the trees.
+            if((fAutoFlush > 0 && entries >= fAutoFlush) ||
+               (fAutoFlush <= 0 && filler.ZipBytes() >= bytes_per_merge)) {
+              par.flushed = true;
+              file.Write();
+              entries = 0;
+            }
+
+            {
+              std::lock_guard<std::mutex> lock(par.mutex);
+              task->written = true;
+            }
+            par.task_written.notify_all();
+          }
+          par.flushed = true;
+          file.Write();
+        });
+    }
+  }
+}
+
+TWriteLoop::TreeFiller* TWriteLoop::NewFiller() {
+  TTree* tree = NULL;
+  if(fObjectTree) {
+    tree = new TTree("EventTree","EventTree");
+  }
+  TFlatWriter* flat = NULL;
+  if(fFlatTables) {
+    flat = new TFlatWriter(fBasketSize, fCompression);
+  }
+  if(fAutoFlush) {
+    if(tree) {
+      tree->SetAutoFlush(fAutoFlush);
+    }
+    if(flat) {
+      flat->GetEventTable()->SetAutoFlush(fAutoFlush);
+      flat->GetGretinaTable()->SetAutoFlush(fAutoFlush);
+    }
   }
+  return new TreeFiller(tree, flat);
+}
+
+void TWriteLoop::DeclareBranches() {
+  if(!fObjectTree) {
+    return;
+  }
+  // Trees sent to the TBufferMerger cannot be given a branch later, so
+  //   with write threads every detector class that can be unpacked gets
+  //   one up front.
+  if(fWriteThreads > 1) {
+    for(auto& elem : detector_factory_map) {
+      if(elem.second) {
+        AddBranch(elem.second->get_class());
+      }
+    }
+    return;
+  }
+  for(auto& elem : TDetectorEnv::Get().source_ids) {
+    if(elem.second.empty()) {
+      continue;
+    }
+    auto factory = detector_factory_map.find(elem.first);
+    if(factory == detector_factory_map.end() || !factory->second) {
+      continue;
+    }
+    TDetector* det = factory->second->construct();
+    TClass* cls = det->IsA();
+    delete det;
+    AddBranch(cls);
+  }
+}
+
+void TWriteLoop::AddBranch(TClass* cls){
+  if(!fObjectTree) {
+    return;
+  }
+  if(std::find(branch_classes.begin(), branch_classes.end(), cls) != branch_classes.end()) {
+    return;
+  }
+  branch_classes.push_back(cls);
+
+  // Only back-fills if an event has been written already, never for
+  //   branches declared from the TDetectorEnv.
+  for(auto& filler : fillers) {
+    filler->AddBranch(cls, *this);
+  }
+
+  std::cout << "\r" << std::string(30,' ')
+            << "\rAdded \"" << cls->GetName() << "\" branch" << std::endl;
 }
 
 void TWriteLoop::ClearQueue() {
@@ -72,6 +459,17 @@ void TWriteLoop::ClearQueue() {
     }
   }
 
+  if(parallel) {
+    // Events being written cannot be deleted before their thread is done.
+    std::unique_lock<std::mutex> lock(parallel->mutex);
+    for(auto task : parallel->pending) {
+      parallel->task_written.wait(lock, [task]() { return task->written; });
+      delete task->event;
+      delete task;
+    }
+    parallel->pending.clear();
+  }
+
   while(output_queue->Size()){
     TUnpackedEvent* event = NULL;
     output_queue->Pop(event);
@@ -82,9 +480,15 @@ void TWriteLoop::ClearQueue() {
 }
 
 bool TWriteLoop::Iteration() {
+  Setup();
+
   TUnpackedEvent* event = NULL;
   input_queue->Pop(event);
 
+  if(parallel) {
+    return ParallelIteration(event);
+  }
+
   if(event) {
     WriteEvent(*event);
     output_queue->Push(event);
@@ -98,78 +502,171 @@ bool TWriteLoop::Iteration() {
   }
 }
 
-void TWriteLoop::Write() {
-  if(output_file){
-    //TPreserveGDirectory preserve;
-    output_file->cd();
-    event_tree->Write();
-  }
-}
+bool TWriteLoop::ParallelIteration(TUnpackedEvent* event) {
+  if(event) {
+    // A class not seen before needs a branch in every tree, so wait until
+    //   no thread is filling.  Once a tree has been merged, the branch can
+    //   no longer be back-filled there, and the class is left out.
+    bool dropped = false;
+    std::vector<TClass*>& left_out = parallel->left_out;
+    for(auto det : event->GetDetectors()) {
+      TClass* cls = det->IsA();
+      if(!fObjectTree ||
+         std::find(branch_classes.begin(), branch_classes.end(), cls) != branch_classes.end()) {
+        continue;
+      }
+      if(std::find(left_out.begin(), left_out.end(), cls) == left_out.end()) {
+        PassOnWritten(true);
+        if(!parallel->flushed) {
+          AddBranch(cls);
+          continue;
+        }
+        std::cerr << Name() << ": no \"" << cls->GetName() << "\" branch was declared before the"
+                  << " first merge; it is left out of EventTree.  Sort with one write thread to keep it."
+                  << std::endl;
+        left_out.push_back(cls);
+      }
+      dropped = true;
+    }
+    if(dropped) {
+      parallel->dropped++;
+    }
 
-void TWriteLoop::AddBranch(TClass* cls){
-  if(!det_map.count(cls)){
-    // This uses the ROOT dictionaries, so we need to lock the threads.
-    TThread::Lock();
+    Parallel::Task* task = new Parallel::Task;
+    task->event = event;
+    task->index = items_handled;
+    task->written = false;
+    parallel->pending.push_back(task);
+    {
+      std::lock_guard<std::mutex> lock(parallel->mutex);
+      parallel->todo.push_back(task);
+    }
+    parallel->can_work.notify_one();
+    items_handled++;
 
-    // Make a default detector of that type.
-    TDetector* det_p = (TDetector*)cls->New();
-    default_dets[cls] = det_p;
+    PassOnWritten(parallel->pending.size() > max_pending_per_thread*fWriteThreads);
+    return true;
+  }
 
-    // Make the TDetector**
-    TDetector** det_pp = new TDetector*;
-    *det_pp = det_p;
-    det_map[cls] = det_pp;
+  PassOnWritten(false);
+  if(input_queue->IsFinished()) {
+    PassOnWritten(true);
+    output_queue->SetFinished();
+    return false;
+  }
+  return true;
+}
 
-    // Make a new branch.
-    TBranch* new_branch = event_tree->Branch(cls->GetName(), cls->GetName(), det_pp);
+/*******************************************************************************/
+/* Passes written events on, in the order they came in *************************/
+/*******************************************************************************/
+void TWriteLoop::PassOnWritten(bool wait_for_all) {
+  if(!parallel) {
+    return;
+  }
 
-    // Fill the new branch up to the point where the tree is filled.
-    // Explanation:
-    //   When TTree::Fill is called, it calls TBranch::Fill for each
-    // branch, then increments the number of entries.  We may be
-    // adding branches after other branches have already been filled.
-    // If the S800 branch has been filled 100 times before the Gretina
-    // branch is created, then the next call to TTree::Fill will fill
-    // entry 101 of S800, but entry 1 of Gretina, rather than entry
-    // 101 of both.
-    //   Therefore, we need to fill the new branch as many times as
-    // TTree::Fill has been called before.
-    for(int i=0; i<event_tree->GetEntries(); i++){
-      new_branch->Fill();
+  std::deque<Parallel::Task*>& pending = parallel->pending;
+  while(!pending.empty()) {
+    Parallel::Task* task = pending.front();
+    {
+      std::unique_lock<std::mutex> lock(parallel->mutex);
+      if(wait_for_all) {
+        parallel->task_written.wait_for(lock, std::chrono::milliseconds(100),
+                                        [task]() { return task->written; });
+      }
+      if(!task->written) {
+        if(wait_for_all) {
+          continue;
+        }
+        break;
+      }
     }
+    pending.pop_front();
+    output_queue->Push(task->event);
+    delete task;
+  }
+}
 
-    std::cout << "\r" << std::string(30,' ')
-              << "\rAdded \"" << cls->GetName() << "\" branch" << std::endl;
-
-    // Unlock after we are done.
-    TThread::UnLock();
+void TWriteLoop::StopWriteThreads() {
+  if(!parallel) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(parallel->mutex);
+    parallel->stopping = true;
   }
+  parallel->can_work.notify_all();
+  for(auto& thread : parallel->threads) {
+    if(thread.joinable()) {
+      thread.join();
+    }
+  }
+  parallel->threads.clear();
 }
 
-void TWriteLoop::WriteEvent(TUnpackedEvent& event) {
-  if(event_tree){
-    // Clear pointers from previous writes.
-    // Note that we cannot just set this equal to NULL,
-    //   because ROOT would then construct a new object.
-    // This contradicts the ROOT documentation for TBranchElement::SetAddress,
-    //   which suggests that a new object would be constructed only when setting the address,
-    //   not when filling the TTree.
-    for(auto& elem : det_map){
-      *elem.second = default_dets[elem.first];
+void TWriteLoop::Write() {
+  if(output_file){
+    //TPreserveGDirectory preserve;
+    output_file->cd();
+    for(auto& filler : fillers) {
+      filler->Write();
     }
+  } else if(parallel) {
+    std::cout << Name() << ": the tree is written when sorting ends when using write threads" << std::endl;
+  }
+}
 
-    // Load current events
+void TWriteLoop::WriteEvent(TUnpackedEvent& event) {
+  if(fillers.size()){
+    TreeFiller& filler = *fillers.front();
     for(auto det : event.GetDetectors()) {
-      TClass* cls = det->IsA();
-      try{
-        *det_map.at(cls) = det;
-      } catch (std::out_of_range& e) {
-        AddBranch(cls);
-        *det_map.at(cls) = det;
+      if(fObjectTree && !filler.det_map.count(det->IsA())) {
+        AddBranch(det->IsA());
       }
     }
+    filler.Fill(event, items_handled);
+  }
+  items_handled++;
+}
 
-    // Fill
-    event_tree->Fill();
+/*******************************************************************************/
+/* Throughput ******************************************************************/
+/*******************************************************************************/
+double TWriteLoop::GetBytesFilled() const {
+  double bytes = 0;
+  for(auto& filler : fillers) {
+    bytes += filler->bytes_filled;
+  }
+  return bytes;
+}
+
+double TWriteLoop::GetMBPerSecond() const {
+  if(!fIsSetup) {
+    return 0;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  return seconds > 0 ? GetBytesFilled()/1e6/seconds : 0;
+}
+
+std::string TWriteLoop::Status() {
+  std::stringstream ss;
+  ss << StoppableThread::Status()
+     << "\t" << std::fixed << std::setprecision(1) << GetMBPerSecond() << " MB/s";
+  return ss.str();
+}
+
+void TWriteLoop::PrintSummary(double bytes_filled) {
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  double megabytes = bytes_filled/1e6;
+
+  std::cout << Name() << ": " << items_handled << " events, "
+            << std::fixed << std::setprecision(1) << megabytes << " MB";
+  struct stat info;
+  if(stat(output_filename.c_str(), &info) == 0) {
+    std::cout << " (" << info.st_size/1e6 << " MB on disk)";
   }
+  std::cout << " in " << seconds << " s, "
+            << (seconds > 0 ? megabytes/seconds : 0) << " MB/s with "
+            << fWriteThreads << " write thread" << (fWriteThreads > 1 ? "s" : "")
+            << std::endl;
 }
@@ -5,7 +5,12 @@
 #include "TNucleus.h"
 #include <algorithm>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 #include <TClass.h>
 #include <TGraph.h>
@@ -35,6 +40,145 @@ std::string& TNucleus::massfile(){
 }
 //const char *TNucleus::massfile = mfile.c_str();
 
+namespace {
+  /*******************************************************************************/
+  /* Mass table, read once per mass file *****************************************/
+  /*******************************************************************************/
+  struct MassEntry {
+    int z;
+    int n;
+    std::string symbol;   // As in the file, ex. 26Na
+    double mass_excess;   // keV, as in the file
+  };
+
+  class MassTable {
+  public:
+    explicit MassTable(const std::string& filename) : fMaxZ(-1), fMaxN(-1) {
+      // Same parsing, and same 3008 line limit, as the old scan in TNucleus(Z,N).
+      std::ifstream infile(filename.c_str());
+      std::string line;
+      int lines = 0;
+      while(lines < 3008 && getline(infile,line)) {
+        lines++;
+        if(line.length() < 1)
+          continue;
+        std::stringstream ss(line);
+        MassEntry entry;
+        if(!(ss >> entry.n >> entry.z >> entry.symbol >> entry.mass_excess))
+          continue;
+        fMaxZ = std::max(fMaxZ, entry.z);
+        fMaxN = std::max(fMaxN, entry.n);
+        fEntries.push_back(entry);
+      }
+
+      // First entry wins, as in the scans.
+      fByZN.assign((fMaxZ+1)*(fMaxN+1), -1);
+      for(size_t i=0; i<fEntries.size(); i++) {
+        const MassEntry& entry = fEntries[i];
+        if(entry.z < 0 || entry.n < 0)
+          continue;
+        int& index = fByZN[entry.z*(fMaxN+1) + entry.n];
+        if(index < 0)
+          index = i;
+        fBySymbol.emplace(Lower(entry.symbol), i);
+      }
+    }
+
+    const MassEntry* Find(int z, int n) const {
+      if(z < 0 || z > fMaxZ || n < 0 || n > fMaxN)
+        return 0;
+      int index = fByZN[z*(fMaxN+1) + n];
+      return index < 0 ? 0 : &fEntries[index];
+    }
+
+    /// Case-insensitive, ex. 26na.
+    const MassEntry* Find(const std::string& symbol) const {
+      auto it = fBySymbol.find(Lower(symbol));
+      return it == fBySymbol.end() ? 0 : &fEntries[it->second];
+    }
+
+    static std::string Lower(std::string str) {
+      std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+      return str;
+    }
+
+  private:
+    std::vector<MassEntry> fEntries;
+    std::vector<int> fByZN;
+    std::unordered_map<std::string,int> fBySymbol;
+    int fMaxZ;
+    int fMaxN;
+  };
+
+  // Tables are never freed, entries handed out stay valid.
+  const MassTable& GetMassTable(const std::string& filename) {
+    static std::mutex tables_mutex;
+    static std::map<std::string,std::unique_ptr<MassTable> > tables;
+    thread_local std::string last_name;
+    thread_local const MassTable* last = 0;
+
+    if(last && filename == last_name)
+      return *last;
+
+    std::lock_guard<std::mutex> lock(tables_mutex);
+    std::unique_ptr<MassTable>& table = tables[filename];
+    if(!table)
+      table.reset(new MassTable(filename));
+    last_name = filename;
+    last = table.get();
+    return *last;
+  }
+
+  /*******************************************************************************/
+  /* Transitions from the .sou files, read once per file *************************/
+  /*******************************************************************************/
+  // Energy, energy uncertainty, intensity and intensity uncertainty, zero if not given.
+  struct SourceLine {
+    double value[4];
+  };
+
+  // An empty list also stands for a missing file.
+  const std::vector<SourceLine>& GetSourceData(const std::string& filename) {
+    static std::mutex sources_mutex;
+    static std::map<std::string,std::unique_ptr<std::vector<SourceLine> > > sources;
+
+    std::lock_guard<std::mutex> lock(sources_mutex);
+    std::unique_ptr<std::vector<SourceLine> >& source = sources[filename];
+    if(source)
+      return *source;
+    source.reset(new std::vector<SourceLine>);
+
+    std::ifstream transfile;
+    transfile.open(filename.c_str());
+    if(!transfile.is_open()) {
+      //printf("failed: %s\n",filename.c_str());
+      return *source;
+    }
+    //printf("found %s\n",filename.c_str());
+
+    std::string line;
+    while(getline(transfile,line)) {
+      trim(line);
+
+      if(!line.length())
+          continue;
+      if(!line.compare(0,2,"//"))
+          continue;
+      if(!line.compare(0,1,"#"))
+          continue;
+      double temp;
+      SourceLine tran = {{0, 0, 0, 0}};
+      std::stringstream ss(line);
+      int counter = 0;
+      while(counter < 4 && ss >> temp) {
+        tran.value[counter++] = temp;
+      }
+      source->push_back(tran);
+    }
+    return *source;
+  }
+}
+
 
 TNucleus::TNucleus(const char *name){
   //Creates a nucleus based on symbol (ex. 26Na OR Na26) and sets all parameters from mass.dat
@@ -80,32 +224,14 @@ TNucleus::TNucleus(const char *name){
   }
 
   element.append(std::to_string((long long)Number)); element.append(symbol);
-  std::string line;
-  std::ifstream infile;
-  std::string MassFile = massfile();//getenv("GRSISYS");
-  //MassFile.append(massfile);
-  infile.open(MassFile.c_str());
-  //printf("MassFile.c_str()
-  int z,n;
-  std::string sym_name;
-  double mass;
-  bool found = false;
-  while(getline(infile,line)) {
-    if(line.length() <1)
-      continue;
-//              printf("%s\n",line.c_str());
-    std::stringstream ss(line);
-    ss>>n; ss>>z; ss>>sym_name; ss>>mass;
-    if(strcasecmp(element.c_str(),sym_name.c_str()) == 0) {
-      found = true;
-      break;
-    }
-  }
-  if(!found) {
-    printf("Warning: Element %s not found in the mass table %s.\n Nucleus not Set!\n",element.c_str(),MassFile.c_str());
+  const MassEntry* entry = GetMassTable(massfile()).Find(element);
+  if(!entry) {
+    printf("Warning: Element %s not found in the mass table %s.\n Nucleus not Set!\n",element.c_str(),massfile().c_str());
     return;
   }
-  infile.close();
+  int z = entry->z;
+  int n = entry->n;
+  double mass = entry->mass_excess;
   SetZ(z);
   SetN(n);
   SetMassExcess(mass/1000.0);
@@ -139,32 +265,16 @@ TNucleus::TNucleus(int charge, int neutrons, const char* MassFile){
   }
   fZ = charge;
   fN = neutrons;
-  int i = 0,n,z;
-  double emass;
-  char tmp[256];
-  std::ifstream mass_file;
-  mass_file.open(MassFile,std::ios::in);
-  while(!mass_file.bad() && !mass_file.eof() && i < 3008){
-    mass_file>>n;
-    mass_file>>z;
-    mass_file>>tmp;
-    mass_file>>emass;
-    if(n==fN&&z==fZ){
-      fMassExcess = emass/1000.;
-      fSymbol = tmp;
+  const MassEntry* entry = GetMassTable(MassFile).Find(fZ,fN);
+  if(entry) {
+    fMassExcess = entry->mass_excess/1000.;
+    fSymbol = entry->symbol;
 #ifdef debug
-      cout << "Symbol " << fSymbol << " tmp " << tmp <<endl;
+    cout << "Symbol " << fSymbol << " tmp " << entry->symbol <<endl;
 #endif
-      SetMass();
-      SetSymbol(fSymbol.c_str());
-      break;
-    }
-    i++;
-    mass_file.ignore(256,'\n');
+    SetMass();
+    SetSymbol(fSymbol.c_str());
   }
-  //max_elements=i;
-
-  mass_file.close();
   std::string name = fSymbol;
   std::string number = name.substr(0,name.find_first_not_of("0123456789 "));
 
@@ -359,45 +469,12 @@ bool TNucleus::LoadTransitionFile(){
   filename.append(std::to_string(this->GetA()));
   filename.append(".sou");
 
-  std::ifstream transfile;
-  transfile.open(filename.c_str());
-  if(!transfile.is_open()) {
-    //printf("failed: %s\n",filename.c_str());
+  const std::vector<SourceLine>& source = GetSourceData(filename);
+  if(source.empty()) {
     return false;
   }
-  //printf("found %s\n",filename.c_str());
-
-  std::string line;
-
-  while(getline(transfile,line)) {
-    trim(line);
-
-    //printf("%i\t%s\n",counter++,line.c_str());
-    if(!line.length())
-        continue;
-    if(!line.compare(0,2,"//"))
-        continue;
-    if(!line.compare(0,1,"#"))
-        continue;
-    double temp;
-    TTransition *tran = new TTransition;
-    std::stringstream ss(line);
-    int counter = 0;
-    while(ss >> temp) {
-      counter++;
-      if(counter==1) {
-        tran->SetEnergy(temp);
-      } else if(counter==2) {
-        tran->SetEnergyUncertainty(temp);
-      } else if(counter==3) {
-        tran->SetIntensity(temp);
-      } else if(counter==4) {
-        tran->SetIntensityUncertainty(temp);
-      } else {
-        break;
-      }
-    }
-    AddTransition(tran);
+  for(auto& line : source) {
+    AddTransition(line.value[0], line.value[2], line.value[1], line.value[3]);
   }
 
   return true;
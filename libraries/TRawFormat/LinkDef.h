@@ -21,6 +21,7 @@
 #pragma link C++ class TGZipByteSource+;
 #pragma link C++ class TPipeByteSource+;
 #pragma link C++ class TBZipByteSource+;
+#pragma link C++ class TZstdByteSource+;
 #pragma link C++ class TRingByteSource+;
 
 #pragma link C++ class TRawFile+;
@@ -1,9 +1,18 @@
 #include "TRawFileOut.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
 #include <cstdint>
 #include <cstdlib>
-#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "TEnv.h"
 
 #include "TGEBEvent.h"
 #include "TNSCLEvent.h"
@@ -34,44 +43,143 @@ namespace {
     }
     return false;
   }
+
+  // The argument, in single quotes for /bin/sh.
+  std::string ShellQuote(const std::string& arg) {
+    std::string quoted = "'";
+    for(char c : arg) {
+      if(c == '\'') {
+        quoted += "'\\''";
+      } else {
+        quoted += c;
+      }
+    }
+    return quoted + "'";
+  }
 }
 
 TRawFileOut::TRawFileOut()
-  : raw_file_out(nullptr), gzip_file_out(nullptr) { }
+  : raw_file_out(nullptr), gzip_file_out(nullptr), is_pipe(false),
+    buffers{nullptr, nullptr}, buffer_capacity(0), fill_index(0), fill_size(0),
+    bytes_total(0), seconds_waiting(0),
+    pending_index(0), pending_size(0), stop_writer(false), write_failed(false) { }
 
 TRawFileOut::TRawFileOut(const std::string& filename)
   : TRawFileOut() {
+  Open(filename);
+}
+
+TRawFileOut::~TRawFileOut() {
+  Close();
+}
+
+void TRawFileOut::Open(const std::string& filename) {
+  Close();
 
   size_t dot_pos = filename.find_last_of('.');
   std::string ext = filename.substr(dot_pos + 1);
-  bool is_zipped = (ext == "gz");
 
-  if(is_zipped) {
+  if(ext == "gz") {
     gzip_file_out = new gzFile;
     *gzip_file_out = gzopen(filename.c_str(), "wb");
+    if(*gzip_file_out) {
+      gzbuffer(*gzip_file_out, 1<<20);
+    } else {
+      delete gzip_file_out;
+      gzip_file_out = nullptr;
+    }
+  } else if(ext == "zst") {
+    raw_file_out = popen(("zstd -q -f -T0 -o " + ShellQuote(filename)).c_str(), "w");
+    is_pipe = true;
   } else {
     raw_file_out = fopen(filename.c_str(), "wb");
   }
+
+  if(!IsOpen()) {
+    std::cerr << "Could not open " << filename << " for writing" << std::endl;
+    return;
+  }
+  if(raw_file_out) {
+    // Whole buffers are written at once, stdio has nothing to add.
+    setvbuf(raw_file_out, nullptr, _IONBF, 0);
+  }
+
+  if(!AllocateBuffers()) {
+    std::cerr << "Could not allocate the output buffers for " << filename << std::endl;
+    Close();
+    return;
+  }
+  fill_index = 0;
+  fill_size = 0;
+  pending_size = 0;
+  stop_writer = false;
+  write_failed = false;
+  writer = std::thread(&TRawFileOut::WriterLoop, this);
 }
 
-TRawFileOut::~TRawFileOut() {
+void TRawFileOut::Close() {
+  if(writer.joinable()) {
+    HandOff();
+    {
+      std::lock_guard<std::mutex> lock(writer_mutex);
+      stop_writer = true;
+    }
+    writer_cv.notify_all();
+    writer.join();
+  }
+
   if(raw_file_out) {
-    fclose(raw_file_out);
+    if(is_pipe) {
+      int status = pclose(raw_file_out);
+      if(status != 0) {
+        if(status == -1) {
+          std::cerr << "Could not close zstd: " << std::strerror(errno) << std::endl;
+        } else if(WIFEXITED(status)) {
+          std::cerr << "zstd exited with status " << WEXITSTATUS(status) << std::endl;
+        } else if(WIFSIGNALED(status)) {
+          std::cerr << "zstd was killed by signal " << WTERMSIG(status) << std::endl;
+        }
+        write_failed = true;
+      }
+    } else {
+      fclose(raw_file_out);
+    }
+    raw_file_out = nullptr;
   }
   if(gzip_file_out) {
     gzclose(*gzip_file_out);
     delete gzip_file_out;
+    gzip_file_out = nullptr;
+  }
+  is_pipe = false;
+
+  for(auto& buffer : buffers) {
+    std::free(buffer);
+    buffer = nullptr;
   }
+  buffer_capacity = 0;
 }
 
-void TRawFileOut::Open(const std::string& filename) {
-  TRawFileOut new_file(filename);
-  swap(new_file);
+bool TRawFileOut::IsGood() const {
+  return IsOpen() && !write_failed;
 }
 
-void TRawFileOut::swap(TRawFileOut& other) {
-  std::swap(raw_file_out, other.raw_file_out);
-  std::swap(gzip_file_out, other.gzip_file_out);
+bool TRawFileOut::AllocateBuffers() {
+  // aligned_alloc needs the size to be a multiple of the alignment;
+  // a whole number of MB always is.
+  const size_t alignment = 4096;
+  size_t megabytes = std::max(1, gEnv->GetValue("GRUT.RawOutBufferMB", 16));
+  size_t capacity = megabytes<<20;
+  static_assert((size_t(1)<<20) % alignment == 0, "buffers must be a whole number of pages");
+
+  for(auto& buffer : buffers) {
+    buffer = static_cast<char*>(std::aligned_alloc(alignment, capacity));
+    if(!buffer) {
+      return false;
+    }
+  }
+  buffer_capacity = capacity;
+  return true;
 }
 
 void TRawFileOut::Write(TRawEvent& event) {
@@ -189,14 +297,109 @@ void TRawFileOut::WriteBuiltNSCLEvent(TUnpackedEvent& event) {
 }
 
 void TRawFileOut::WriteBytes(const char* data, size_t size) {
+  if(!buffer_capacity) {
+    return;
+  }
+
+  // Events larger than a buffer are split across several.
+  while(size) {
+    size_t bytes = std::min(size, buffer_capacity - fill_size);
+    std::memcpy(buffers[fill_index] + fill_size, data, bytes);
+    fill_size += bytes;
+    bytes_total += bytes;
+    data += bytes;
+    size -= bytes;
+    if(fill_size == buffer_capacity) {
+      HandOff();
+    }
+  }
+}
+
+void TRawFileOut::HandOff() {
+  if(fill_size == 0) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(writer_mutex);
+  if(pending_size) {
+    // The writer is still on the other buffer.
+    auto start = std::chrono::steady_clock::now();
+    writer_cv.wait(lock, [this]() { return pending_size == 0; });
+    seconds_waiting += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  pending_index = fill_index;
+  pending_size = fill_size;
+  lock.unlock();
+  writer_cv.notify_all();
+
+  fill_index = 1 - fill_index;
+  fill_size = 0;
+}
+
+void TRawFileOut::Flush() {
+  if(!writer.joinable()) {
+    return;
+  }
+  HandOff();
+  std::unique_lock<std::mutex> lock(writer_mutex);
+  writer_cv.wait(lock, [this]() { return pending_size == 0; });
+  if(raw_file_out) {
+    fflush(raw_file_out);
+  }
+}
+
+void TRawFileOut::WriterLoop() {
+  // If zstd dies, writing to its pipe should fail with EPIPE, not kill the process.
+  sigset_t sigpipe;
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+
+  std::unique_lock<std::mutex> lock(writer_mutex);
+  while(true) {
+    writer_cv.wait(lock, [this]() { return pending_size || stop_writer; });
+    if(!pending_size) {
+      return;
+    }
+
+    const char* data = buffers[pending_index];
+    size_t size = pending_size;
+    lock.unlock();
+    WriteOut(data, size);
+    lock.lock();
+
+    pending_size = 0;
+    writer_cv.notify_all();
+  }
+}
+
+void TRawFileOut::WriteOut(const char* data, size_t size) {
   size_t bytes_written = 0;
   if(raw_file_out) {
     bytes_written = fwrite(data, sizeof(char), size, raw_file_out);
   } else if(gzip_file_out) {
     bytes_written = gzwrite(*gzip_file_out, data, size);
   }
-  if(bytes_written != size) {
-    std::cout << "Incorrect amount written: " << bytes_written << " instead of " << size << std::endl;
+  if(bytes_written == size) {
+    return;
+  }
+  int error = errno;
+
+  if(!write_failed) {
+    std::cout << "Incorrect amount written: " << bytes_written << " instead of " << size;
+    if(raw_file_out && ferror(raw_file_out)) {
+      std::cout << " (" << std::strerror(error) << ")";
+    }
+    std::cout << std::endl;
+    write_failed = true;
+  }
+
+  if(raw_file_out && error == EPIPE) {
+    // Take the SIGPIPE left pending on this thread, now that the error is known.
+    sigset_t sigpipe;
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    timespec no_wait = {0, 0};
+    while(sigtimedwait(&sigpipe, nullptr, &no_wait) == SIGPIPE) { }
   }
-  assert(bytes_written == size);
 }
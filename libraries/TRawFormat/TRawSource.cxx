@@ -86,6 +86,8 @@ TRawEventSource* TRawEventSource::EventSource(const char* filename,
   // If it is an archived file, open it as such
   } else if(hasSuffix(filename,".bz2")){
     byte_source = new TBZipByteSource(filename);
+  } else if(hasSuffix(filename,".zst")){
+    byte_source = new TZstdByteSource(filename);
   } else if (hasSuffix(filename,".gz")){
     byte_source = new TGZipByteSource(filename);
   // Otherwise, open it as a normal file.
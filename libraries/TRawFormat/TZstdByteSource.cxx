@@ -0,0 +1,15 @@
+#include "TRawSource.h"
+
+#include "TGRUTUtilities.h"
+
+TZstdByteSource::TZstdByteSource(const std::string& filename)
+  : TPipeByteSource("zstd -dcq " + filename),
+    fFilename(filename) { }
+
+std::string TZstdByteSource::SourceDescription(bool long_description) const {
+  if(long_description) {
+    return fFilename;
+  } else {
+    return get_short_filename(fFilename);
+  }
+}
@@ -0,0 +1,171 @@
+#include "TKinematicsTable.h"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "TMath.h"
+
+namespace {
+  std::mutex table_mutex;
+
+  // Tables are never freed, references handed out stay valid.
+  std::vector<std::unique_ptr<TKinematicsTable> >& all_tables() {
+    static std::vector<std::unique_ptr<TKinematicsTable> > tables;
+    return tables;
+  }
+
+  typedef std::tuple<std::string,std::string,std::string,std::string,double,double,bool> NameKey;
+  typedef std::tuple<double,double,double,double,double,double,bool> MassKey;
+
+  std::map<NameKey,const TKinematicsTable*> by_name;
+  std::map<MassKey,const TKinematicsTable*> by_mass;
+
+  MassKey KeyOf(TReaction& reac) {
+    return MassKey(reac.GetM(0), reac.GetM(1), reac.GetM(2), reac.GetM(3),
+                   reac.GetEBeam(), reac.GetExc(), reac.Inverse());
+  }
+}
+
+/*******************************************************************************/
+/* Finds or builds the table for a reaction ************************************/
+/*******************************************************************************/
+const TKinematicsTable& TKinematicsTable::Get(const char* beam, const char* targ, const char* ejec,
+                                              const char* reco, double ebeam, double ex3, bool inverse) {
+  // The last reaction asked for by this thread, almost always the same one.
+  thread_local NameKey last_key;
+  thread_local const TKinematicsTable* last = 0;
+
+  NameKey key(beam, targ, ejec, reco, ebeam, ex3, inverse);
+  if(last && key == last_key) {
+    return *last;
+  }
+
+  std::lock_guard<std::mutex> lock(table_mutex);
+  const TKinematicsTable*& table = by_name[key];
+  if(!table) {
+    TReaction* reac = new TReaction(beam, targ, ejec, reco, ebeam, ex3, inverse);
+    const TKinematicsTable*& same = by_mass[KeyOf(*reac)];
+    if(same) {
+      delete reac;
+    } else {
+      all_tables().emplace_back(new TKinematicsTable(reac));
+      same = all_tables().back().get();
+    }
+    table = same;
+  }
+  last_key = key;
+  last = table;
+  return *table;
+}
+
+const TKinematicsTable& TKinematicsTable::Get(TReaction& reac) {
+  thread_local MassKey last_key;
+  thread_local const TKinematicsTable* last = 0;
+
+  MassKey key = KeyOf(reac);
+  if(last && key == last_key) {
+    return *last;
+  }
+
+  std::lock_guard<std::mutex> lock(table_mutex);
+  const TKinematicsTable*& table = by_mass[key];
+  if(!table) {
+    // A copy, so that the table does not depend on reac staying alive.
+    TReaction* copy = new TReaction(reac.GetNucleusPtr(0), reac.GetNucleusPtr(1),
+                                    reac.GetNucleusPtr(2), reac.GetNucleusPtr(3),
+                                    reac.GetEBeam(), reac.GetExc(), reac.Inverse());
+    all_tables().emplace_back(new TKinematicsTable(copy));
+    table = all_tables().back().get();
+  }
+  last_key = key;
+  last = table;
+  return *table;
+}
+
+/*******************************************************************************/
+/* Fills the tables from the exact TReaction calculations **********************/
+/*******************************************************************************/
+TKinematicsTable::TKinematicsTable(TReaction* reac)
+  : fReaction(reac), fStep(2*TMath::Pi()/(kPoints-1)) {
+  for(int part=0; part<4; part++) {
+    fThetaMax[part] = fReaction->GetThetaMax(part);
+    for(int q=0; q<kNumQuantities; q++) {
+      std::vector<double>& table = fTable[q][part];
+      table.resize(kPoints);
+      for(int i=0; i<kPoints; i++) {
+        table[i] = Exact(Quantity(q), -TMath::Pi() + i*fStep, part);
+      }
+    }
+
+    // Cells that are not interpolated: those across theta_lab = 0, where the
+    //   solution changes, those next to the maximum lab angle, those with an
+    //   end outside the kinematically allowed range, and any other cell where
+    //   the midpoint is off by more than the tolerance.
+    std::vector<char>& exact = fExactCell[part];
+    exact.resize(kPoints-1);
+    for(int i=0; i<kPoints-1; i++) {
+      double lo = -TMath::Pi() + i*fStep;
+      double hi = lo + fStep;
+      bool edge = (lo < 0.5*fStep && hi > -0.5*fStep) ||
+                  std::abs(std::abs(lo) - fThetaMax[part]) < 2*fStep ||
+                  std::abs(std::abs(hi) - fThetaMax[part]) < 2*fStep;
+      for(int q=0; q<kNumQuantities && !edge; q++) {
+        const std::vector<double>& table = fTable[q][part];
+        double mid = Exact(Quantity(q), lo + 0.5*fStep, part);
+        double interp = 0.5*(table[i] + table[i+1]);
+        edge = !std::isfinite(table[i]) || !std::isfinite(table[i+1]) ||
+               !(std::abs(mid - interp) <= kTolerance*std::max(1.0, std::abs(mid)));
+      }
+      exact[i] = edge;
+    }
+  }
+}
+
+double TKinematicsTable::Exact(Quantity q, double theta_lab, int part) const {
+  switch(q) {
+  case kThetaCm:
+    return fReaction->ConvertThetaLabToCm(theta_lab, part);
+  case kTLab:
+    return fReaction->GetTLab(theta_lab, part);
+  case kBeta:
+    return fReaction->AnalysisBetaFromThetaLab(theta_lab, part);
+  default:
+    return std::sqrt(-1);
+  }
+}
+
+double TKinematicsTable::Lookup(Quantity q, double theta_lab, int part) const {
+  if(part < 0 || part > 3) {
+    return std::sqrt(-1);
+  }
+  double x = (theta_lab + TMath::Pi())/fStep;
+  // Also catches NaN.
+  if(!(x >= 0 && x <= kPoints-1)) {
+    return Exact(q, theta_lab, part);
+  }
+
+  int i = x;
+  if(i > kPoints-2) {
+    i = kPoints-2;
+  }
+  if(fExactCell[part][i]) {
+    return Exact(q, theta_lab, part);
+  }
+  double frac = x - i;
+  const double* table = fTable[q][part].data();
+  return table[i] + frac*(table[i+1] - table[i]);
+}
+
+double TKinematicsTable::ConvertThetaLab(double theta_lab_a, int parta, int partb) const {
+  double theta_cm_a = ThetaCm(theta_lab_a, parta);
+
+  if(parta==3) {
+    theta_cm_a = -theta_cm_a;
+  }
+
+  double theta_cm_b = TMath::Pi() - theta_cm_a;
+  return fReaction->ConvertThetaCmToLab(theta_cm_b, partb);
+}
@@ -1,5 +1,6 @@
 #include "TSRIM.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <sstream>
@@ -14,9 +15,23 @@
 
 const double TSRIM::dx = 1.0; // um [sets accuracy of energy loss E vs X functions]
 
+namespace {
+  const int range_table_points = 4096; // about 400 per decade of energy for a typical SRIM file
+
+  // Cubic through (x0,y0) and (x1,y1) with slopes d0 and d1.
+  double Hermite(double x0, double x1, double y0, double y1, double d0, double d1, double x) {
+    double h = x1 - x0;
+    double t = (x - x0)/h;
+    double t2 = t*t;
+    double t3 = t2*t;
+    return (2*t3 - 3*t2 + 1)*y0 + (t3 - 2*t2 + t)*h*d0 + (-2*t3 + 3*t2)*y1 + (t3 - t2)*h*d1;
+  }
+}
+
 TSRIM::TSRIM()
   : fEnergyLoss(NULL), fEgetX(NULL), fXgetE(NULL),
-    sEnergyLoss(NULL), sEgetX(NULL), sXgetE(NULL) { }
+    sEnergyLoss(NULL), sEgetX(NULL), sXgetE(NULL),
+    fTableLogEmin(0), fTableLogStep(0) { }
 
 
 TSRIM::TSRIM(const char *infilename, double emax, double emin, bool printfile)
@@ -208,6 +223,8 @@ void TSRIM::ReadEnergyLossFile(const char *filename, double emax, double emin, b
     fEgetX->GetXaxis()->SetTitle("Energy (keV)");
     sEgetX = new TSpline3(Form("%s_Espline",filename),fEgetX);
     sEgetX->SetName(Form("%s_Espline",filename));
+
+    BuildRangeTable(dataEmin, emax);
   }
 
   if(printfile){
@@ -231,8 +248,112 @@ double TSRIM::GetEnergy(double energy_keV,double dist_um) {
   return sXgetE->Eval(xbegin+dist_um);
 }
 
-// THIS FUNCTION DOES A MORE ACCURATE ENERGY LOSS CALCULATION BASED ON SMALL EXTRAPOLATIONS
-double TSRIM::GetAdjustedEnergy(double energy_keV,double thickness,double stepsize) {
+// Range R(E) = integral of dE/(dE/dx) from the lowest energy in the file up to E,
+// on a grid of equal steps in log(E).  The energy after a distance t is then
+// E' = R^-1(R(E) - t), two interpolations instead of one spline call per um.
+void TSRIM::BuildRangeTable(double emin, double emax) {
+  fTableE.clear();
+  fTableR.clear();
+  fTableDEdX.clear();
+  if(emin <= 0 || emax <= emin) {
+    return;
+  }
+
+  fTableLogEmin = std::log(emin);
+  fTableLogStep = (std::log(emax) - fTableLogEmin)/(range_table_points - 1);
+  fTableE.resize(range_table_points);
+  fTableR.resize(range_table_points);
+  fTableDEdX.resize(range_table_points);
+
+  for(int i=0; i<range_table_points; i++) {
+    fTableE[i] = std::exp(fTableLogEmin + i*fTableLogStep);
+    if(i == 0) {
+      fTableE[i] = emin;
+    } else if(i == range_table_points - 1) {
+      fTableE[i] = emax;
+    }
+    fTableDEdX[i] = sEnergyLoss->Eval(fTableE[i]);
+    if(!(fTableDEdX[i] > 0)) {
+      // The stepper is left to deal with a spline that is not positive.
+      printf("{TSRIM} WARNING: dE/dx <= 0 at %.03f keV, not using the range table.\n",fTableE[i]);
+      fTableE.clear();
+      fTableR.clear();
+      fTableDEdX.clear();
+      return;
+    }
+  }
+
+  // Simpson's rule on each interval.
+  fTableR[0] = 0;
+  for(int i=1; i<range_table_points; i++) {
+    double h = fTableE[i] - fTableE[i-1];
+    double mid = sEnergyLoss->Eval(0.5*(fTableE[i] + fTableE[i-1]));
+    fTableR[i] = fTableR[i-1] + h/6.0*(1.0/fTableDEdX[i-1] + 4.0/mid + 1.0/fTableDEdX[i]);
+  }
+}
+
+// Interval of the table holding energy_keV, which must be inside the table.
+int TSRIM::TableIndex(double energy_keV) const {
+  int last = fTableE.size() - 2;
+  int i = (std::log(energy_keV) - fTableLogEmin)/fTableLogStep;
+  // Rounding in exp/log can put energy_keV just outside interval i.
+  i = std::max(0, std::min(i, last));
+  if(energy_keV < fTableE[i] && i > 0) {
+    i--;
+  } else if(energy_keV > fTableE[i+1] && i < last) {
+    i++;
+  }
+  return i;
+}
+
+double TSRIM::GetRange(double energy_keV) const {
+  if(fTableE.empty() || !(energy_keV > fTableE.front())) {
+    return 0.0;
+  }
+  if(energy_keV >= fTableE.back()) {
+    return fTableR.back();
+  }
+
+  int i = TableIndex(energy_keV);
+  return Hermite(fTableE[i], fTableE[i+1], fTableR[i], fTableR[i+1],
+                 1.0/fTableDEdX[i], 1.0/fTableDEdX[i+1], energy_keV);
+}
+
+double TSRIM::GetEnergyAtRange(double range_um) const {
+  return EnergyAtRange(range_um, int(fTableE.size()) - 2);
+}
+
+// The interval is searched from hint, down for a target and up for a
+// negative thickness, usually only a few steps for a thin one, with a
+// binary search for the rest.
+double TSRIM::EnergyAtRange(double range_um, int hint) const {
+  if(fTableE.empty() || !(range_um > 0)) {
+    return fTableE.empty() ? 0.0 : fTableE.front();
+  }
+  if(range_um >= fTableR.back()) {
+    return fTableE.back();
+  }
+
+  int last = fTableE.size() - 2;
+  int i = std::max(0, std::min(hint, last));
+  for(int steps=0; ; steps++) {
+    bool below = fTableR[i] > range_um && i > 0;
+    bool above = fTableR[i+1] < range_um && i < last;
+    if(!below && !above) {
+      break;
+    }
+    if(steps == 8) {
+      i = std::upper_bound(fTableR.begin(), fTableR.end(), range_um) - fTableR.begin() - 1;
+      i = std::max(0, std::min(i, last));
+      break;
+    }
+    i += below ? -1 : 1;
+  }
+  return Hermite(fTableR[i], fTableR[i+1], fTableE[i], fTableE[i+1],
+                 fTableDEdX[i], fTableDEdX[i+1], range_um);
+}
+
+double TSRIM::GetAdjustedEnergy(double energy_keV,double thickness,double stepsize) const {
   if (fEnergyLoss == 0)         {
     printf("energy loss file has not yet been read in.\n");
     return 0.0;
@@ -242,6 +363,29 @@ double TSRIM::GetAdjustedEnergy(double energy_keV,double thickness,double stepsi
     return energy_keV;
   }
 
+  if(stepsize > 0 || fTableE.empty() ||
+     energy_keV > fTableE.back() || energy_keV < fTableE.front()) {
+    return GetSteppedEnergy(energy_keV, thickness, stepsize > 0 ? stepsize : dx);
+  }
+
+  int i = TableIndex(energy_keV);
+  double range = Hermite(fTableE[i], fTableE[i+1], fTableR[i], fTableR[i+1],
+                         1.0/fTableDEdX[i], 1.0/fTableDEdX[i+1], energy_keV) - thickness;
+  if(range <= 0) {
+    // Below the lowest energy in the file, step out the last bit as before.
+    return std::max(GetSteppedEnergy(fTableE.front(), -range, dx), 0.0);
+  }
+  return EnergyAtRange(range, i);
+}
+
+void TSRIM::GetAdjustedEnergy(size_t n, const double* energy_keV, const double* distance_um, double* output) const {
+  for(size_t i=0; i<n; i++) {
+    output[i] = GetAdjustedEnergy(energy_keV[i], distance_um[i]);
+  }
+}
+
+// THIS FUNCTION DOES A MORE ACCURATE ENERGY LOSS CALCULATION BASED ON SMALL EXTRAPOLATIONS
+double TSRIM::GetSteppedEnergy(double energy_keV,double thickness,double stepsize) const {
   double energy_temp = energy_keV;
   // MAKE XSTEP SMALLER FOR BETTER RESULTS. 1UM SHOULD BE FINE ... UNLESS YOU ARE AT THE BRAGG PEAK ??
   double xstep = stepsize, xtot = 0.0;
@@ -0,0 +1,262 @@
+// Gain matches every channel of a source run.
+//
+//   gainMatch run0042.root [more.root ...] -s co60 [-s eu152 ...] [options]
+//
+// The run is read from the EventTree of files sorted by grutinizer.  The
+// charge of every hit is histogrammed by address, each thread reading its
+// own share of the entries.  The peaks of every channel are then found,
+// matched against the lines of each source ($GRUTSYS/libraries/SourceData),
+// fit and calibrated by TCalibrator::CalibrateChannels.
+//
+// Channels are read from the --cal files first, so that their names and
+// pedestals are kept; addresses without a channel are given one, named by
+// the address.  Every channel is written to --output, and the residuals of
+// each channel and each line are printed, and written to --report if given.
+// --hist-file keeps the charge histograms, to look at the channels that
+// were not calibrated.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "TBranch.h"
+#include "TChain.h"
+#include "TClass.h"
+#include "TFile.h"
+#include "TH1D.h"
+#include "TObjArray.h"
+#include "TROOT.h"
+
+#include "ArgParser.h"
+#include "TCalibrator.h"
+#include "TChannel.h"
+#include "TDetector.h"
+
+namespace {
+  struct Config {
+    std::vector<std::string> files;
+    std::vector<std::string> skip;
+    int bins;
+    double max;
+  };
+
+  // Counts in each charge bin, by address.
+  typedef std::unordered_map<unsigned int, std::vector<double> > ChargeCounts;
+
+  // Histograms the charge of every hit in entries first to last of the run.
+  void FillCounts(const Config& cfg, long first, long last, ChargeCounts& counts) {
+    TChain chain("EventTree");
+    for(auto& file : cfg.files) {
+      chain.Add(file.c_str());
+    }
+
+    std::vector<std::unique_ptr<TDetector*> > detectors;
+    TObjArray *array = chain.GetListOfBranches();
+    for(int x=0; array && x<array->GetEntriesFast(); x++) {
+      TBranch *b = (TBranch*)array->At(x);
+      TClass *c = b ? TClass::GetClass(b->GetName()) : 0;
+      if(!c || !c->InheritsFrom(TDetector::Class()) ||
+         std::count(cfg.skip.begin(), cfg.skip.end(), b->GetName())) {
+        continue;
+      }
+      detectors.emplace_back(new TDetector*(0));
+      chain.SetBranchAddress(b->GetName(), detectors.back().get());
+    }
+
+    double scale = cfg.bins/cfg.max;
+    for(long entry=first; entry<last; entry++) {
+      chain.GetEntry(entry);
+      for(auto& det : detectors) {
+        if(!*det) {
+          continue;
+        }
+        for(size_t i=0; i<(*det)->Size(); i++) {
+          TDetectorHit& hit = (*det)->GetHit(i);
+          int bin = hit.Charge()*scale;
+          if(hit.Address()==-1 || bin<0 || bin>=cfg.bins) {
+            continue;
+          }
+          std::vector<double>& channel = counts[hit.Address()];
+          if(channel.empty()) {
+            channel.resize(cfg.bins);
+          }
+          channel[bin]++;
+        }
+      }
+    }
+
+    chain.ResetBranchAddresses();
+    for(auto& det : detectors) {
+      delete *det;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  if(!getenv("GRUTSYS")) {
+    std::cerr << "GRUTSYS is not set" << std::endl;
+    return 1;
+  }
+
+  Config cfg;
+  std::vector<std::string> sources;
+  std::vector<std::string> cal_files;
+  std::string output;
+  std::string report;
+  std::string hist_file;
+  int order = 1;
+  double sigma = 2.0;
+  double threshold = 0.05;
+  int threads = 0;
+  bool help = false;
+
+  ArgParser parser;
+  parser.default_option(&cfg.files)
+    .description("Root files of the sorted source run");
+  parser.option("s source", &sources)
+    .description("Source in the run, as a .sou file name (ex. co60, eu152)");
+  parser.option("c cal", &cal_files)
+    .description("Cal files to read before calibrating");
+  parser.option("o output", &output)
+    .description("Cal file written with every channel")
+    .default_value("gainmatch.cal");
+  parser.option("r report", &report)
+    .description("File for the residual report, printed in any case");
+  parser.option("hist-file", &hist_file)
+    .description("Root file for the charge histogram of every address");
+  parser.option("skip", &cfg.skip)
+    .description("Branches not to read, besides TS800 and the scalers");
+  parser.option("bins", &cfg.bins)
+    .description("Bins of each charge histogram")
+    .default_value(8192);
+  parser.option("max", &cfg.max)
+    .description("Upper edge of each charge histogram, from 0")
+    .default_value(8192);
+  parser.option("order", &order)
+    .description("Order of the calibration, 1 or 2")
+    .default_value(1);
+  parser.option("sigma", &sigma)
+    .description("Peak sigma in bins, for TSpectrum")
+    .default_value(2.0);
+  parser.option("threshold", &threshold)
+    .description("Smallest peak found, relative to the largest, for TSpectrum")
+    .default_value(0.05);
+  parser.option("j threads", &threads)
+    .description("Threads histogramming and fitting, 0 for every core")
+    .default_value(0);
+  parser.option("h help ?", &help)
+    .description("Show this help message");
+
+  try {
+    parser.parse(argc, argv);
+  } catch (ParseError& e) {
+    std::cerr << "ERROR: " << e.what() << "\n" << parser << std::endl;
+    return 1;
+  }
+  if(help || cfg.files.empty() || sources.empty()) {
+    std::cout << "Usage: " << argv[0] << " files... -s source [options]\n" << parser << std::endl;
+    return help ? 0 : 1;
+  }
+  if(cfg.bins < 1 || cfg.max <= 0) {
+    std::cerr << "--bins and --max must be positive" << std::endl;
+    return 1;
+  }
+
+  // These have no hits of their own.
+  cfg.skip.insert(cfg.skip.end(), {"TS800", "TS800Scaler", "TNSCLScalers"});
+
+  // Before any ROOT object is made, so that every one is made thread safe.
+  if(threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if(threads > 1) {
+    ROOT::EnableThreadSafety();
+  }
+
+  for(auto& cal_file : cal_files) {
+    TChannel::ReadCalFile(cal_file.c_str());
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  TChain chain("EventTree");
+  for(auto& file : cfg.files) {
+    chain.Add(file.c_str());
+  }
+  long entries = chain.GetEntries();
+  if(entries <= 0) {
+    std::cerr << "No EventTree entries in the files given" << std::endl;
+    return 1;
+  }
+
+  int readers = std::min(long(threads), entries);
+
+  std::vector<ChargeCounts> counts(readers);
+  if(readers == 1) {
+    FillCounts(cfg, 0, entries, counts[0]);
+  } else {
+    std::vector<std::thread> workers;
+    for(int i=0; i<readers; i++) {
+      workers.emplace_back(FillCounts, std::cref(cfg), entries*i/readers, entries*(i+1)/readers,
+                           std::ref(counts[i]));
+    }
+    for(auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  std::map<unsigned int, TH1*> hists;
+  for(auto& thread_counts : counts) {
+    for(auto& it : thread_counts) {
+      TH1*& hist = hists[it.first];
+      if(!hist) {
+        hist = new TH1D(Form("charge_%08x", it.first), Form("charge_%08x", it.first),
+                        cfg.bins, 0, cfg.max);
+        hist->SetDirectory(0);
+      }
+      for(int bin=0; bin<cfg.bins; bin++) {
+        hist->AddBinContent(bin+1, it.second[bin]);
+      }
+    }
+  }
+  counts.clear();
+
+  auto filled = std::chrono::steady_clock::now();
+  printf("Histogrammed %d addresses from %ld entries in %.1f s\n", int(hists.size()), entries,
+         std::chrono::duration<double>(filled - start).count());
+
+  for(auto& it : hists) {
+    if(!TChannel::GetChannel(it.first)) {
+      TChannel::AddChannel(new TChannel(Form("%08x", it.first), it.first));
+    }
+  }
+
+  std::vector<TCalibrator::ChannelFit> fits =
+    TCalibrator::CalibrateChannels(hists, sources, order, sigma, threshold, threads);
+  TCalibrator::ResidualReport(fits, report.c_str());
+
+  TChannel::WriteCalFile(output);
+  printf("Wrote %d channels to %s, calibrated in %.1f s\n", TChannel::Size(), output.c_str(),
+         std::chrono::duration<double>(std::chrono::steady_clock::now() - filled).count());
+
+  if(hist_file.length()) {
+    TFile file(hist_file.c_str(), "RECREATE");
+    for(auto& it : hists) {
+      it.second->Write();
+    }
+    file.Close();
+  }
+
+  for(auto& it : hists) {
+    delete it.second;
+  }
+  return 0;
+}